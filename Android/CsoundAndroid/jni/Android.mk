@@ -26,7 +26,8 @@ LOCAL_CFLAGS += -DPFFFT_SIMD_DISABLE
 endif # TARGET_ARCH_ABI == armeabi
 ###
 
-LOCAL_SRC_FILES := $(CSOUND_SRC_ROOT)/Engine/auxfd.c \
+LOCAL_SRC_FILES := $(CSOUND_SRC_ROOT)/Engine/asyncio.c \
+$(CSOUND_SRC_ROOT)/Engine/auxfd.c \
 $(CSOUND_SRC_ROOT)/Engine/cfgvar.c \
 $(CSOUND_SRC_ROOT)/Engine/corfiles.c \
 $(CSOUND_SRC_ROOT)/Engine/entry1.c \
@@ -40,9 +41,11 @@ $(CSOUND_SRC_ROOT)/Engine/memfiles.c \
 $(CSOUND_SRC_ROOT)/Engine/musmon.c \
 $(CSOUND_SRC_ROOT)/Engine/namedins.c \
 $(CSOUND_SRC_ROOT)/Engine/rdscor.c \
+$(CSOUND_SRC_ROOT)/Engine/scobin.c \
 $(CSOUND_SRC_ROOT)/Engine/scsort.c \
 $(CSOUND_SRC_ROOT)/Engine/scxtract.c \
 $(CSOUND_SRC_ROOT)/Engine/sort.c \
+$(CSOUND_SRC_ROOT)/Engine/sortrun.c \
 $(CSOUND_SRC_ROOT)/Engine/sread.c \
 $(CSOUND_SRC_ROOT)/Engine/swritestr.c \
 $(CSOUND_SRC_ROOT)/Engine/twarp.c \
@@ -61,6 +64,9 @@ $(CSOUND_SRC_ROOT)/InOut/window.c \
 $(CSOUND_SRC_ROOT)/InOut/winEPS.c \
 $(CSOUND_SRC_ROOT)/InOut/circularbuffer.c \
 $(CSOUND_SRC_ROOT)/OOps/aops.c \
+$(CSOUND_SRC_ROOT)/OOps/aops_simd.c \
+$(CSOUND_SRC_ROOT)/OOps/pvs_simd.c \
+$(CSOUND_SRC_ROOT)/OOps/tabosc_simd.c \
 $(CSOUND_SRC_ROOT)/OOps/bus.c \
 $(CSOUND_SRC_ROOT)/OOps/cmath.c \
 $(CSOUND_SRC_ROOT)/OOps/diskin2.c \
@@ -68,6 +74,8 @@ $(CSOUND_SRC_ROOT)/OOps/disprep.c \
 $(CSOUND_SRC_ROOT)/OOps/dumpf.c \
 $(CSOUND_SRC_ROOT)/OOps/fftlib.c \
 $(CSOUND_SRC_ROOT)/OOps/pffft.c \
+$(CSOUND_SRC_ROOT)/OOps/pffftd.c \
+$(CSOUND_SRC_ROOT)/OOps/pffftd_avx.c \
 $(CSOUND_SRC_ROOT)/OOps/goto_ops.c \
 $(CSOUND_SRC_ROOT)/OOps/midiinterop.c \
 $(CSOUND_SRC_ROOT)/OOps/midiops.c \
@@ -178,6 +186,7 @@ $(CSOUND_SRC_ROOT)/Opcodes/follow.c         \
 $(CSOUND_SRC_ROOT)/Opcodes/fout.c \
 $(CSOUND_SRC_ROOT)/Opcodes/freeverb.c       \
 $(CSOUND_SRC_ROOT)/Opcodes/ftconv.c         \
+$(CSOUND_SRC_ROOT)/Opcodes/nupconv.c        \
 $(CSOUND_SRC_ROOT)/Opcodes/ftgen.c \
 $(CSOUND_SRC_ROOT)/Opcodes/gab/gab.c        \
 $(CSOUND_SRC_ROOT)/Opcodes/gab/vectorial.c  \
@@ -237,6 +246,7 @@ $(CSOUND_SRC_ROOT)/Engine/csound_orc_compile.c \
 $(CSOUND_SRC_ROOT)/Engine/new_orc_parser.c \
 $(CSOUND_SRC_ROOT)/Engine/symbtab.c \
 $(CSOUND_SRC_ROOT)/Engine/cs_new_dispatch.c \
+$(CSOUND_SRC_ROOT)/Engine/cs_ws_dispatch.c \
 $(CSOUND_SRC_ROOT)/Engine/cs_par_base.c \
 $(CSOUND_SRC_ROOT)/Engine/cs_par_orc_semantic_analysis.c \
 $(CSOUND_SRC_ROOT)/Opcodes/mp3in.c \
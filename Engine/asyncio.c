@@ -0,0 +1,419 @@
+/*
+    asyncio.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "csoundCore.h"                                 /*   ASYNCIO.C  */
+#include "soundio.h"
+#include "asyncio.h"
+
+#define AIO_THREADS     (2)     /* workers if --io-threads is not given */
+#define AIO_AHEAD       (0.25)  /* seconds read ahead at the measured rate */
+#define AIO_BEHIND      (0.05)  /* seconds gathered for a write */
+#define AIO_RING_SECS   (0.5)   /* a ring holds at least this much at sr */
+#define AIO_CHUNK       (65536) /* most samples moved by one service */
+#define AIO_RATE_SECS   (0.05)  /* shortest time a rate is measured over */
+
+#if defined(HAVE_ATOMIC_BUILTIN)
+#define AIO_LOAD(var)         __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define AIO_STORE(var, val)   __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#else
+#define AIO_LOAD(var)         (var)
+#define AIO_STORE(var, val)   ((var) = (val))
+#endif
+
+struct asyncio_stream_s {
+    SNDFILE *sf;
+    int     write;
+    void    *rb;                /* ring to or from the workers */
+    int     size;               /* samples the ring holds */
+    int     maxreq;             /* largest request seen */
+    /* set by the performance thread, read by the workers */
+    volatile int target;        /* read-ahead depth, or write size */
+    volatile int speed;         /* samples per second, 0 if not known */
+    /* under the engine's lock; pending and eof are also read without it */
+    int     qpos;               /* position in the queue, or -1 */
+    int     busy;               /* a worker is serving it */
+    volatile int eof;
+    double  deadline;
+    void    *idle;              /* signalled when busy is cleared */
+    volatile int pending;       /* queued or busy */
+    /* samples moved by the performance thread, and by the workers */
+    volatile int64_t done, moved;
+    /* performance thread only */
+    int64_t asked, asked0;      /* samples requested, at t0 */
+    double  rate, t0;           /* samples per second, since t0 */
+};
+
+typedef struct asyncio_s {
+    void    *lock;
+    void    *work;              /* a stream is queued, or stop is set */
+    void    **threads;
+    int     nthreads, maxthreads, nstreams;
+    ASYNCIO_STREAM **queue;     /* heap, earliest deadline first */
+    int     nqueue, qsize;
+    int     stop;
+    RTCLOCK clock;
+} ASYNCIO;
+
+/* the queue */
+
+static void queue_set(ASYNCIO *aio, int i, ASYNCIO_STREAM *s)
+{
+    aio->queue[i] = s;
+    s->qpos = i;
+}
+
+static void queue_up(ASYNCIO *aio, int i)
+{
+    ASYNCIO_STREAM *s = aio->queue[i];
+    while (i > 0 && aio->queue[(i - 1) >> 1]->deadline > s->deadline) {
+      queue_set(aio, i, aio->queue[(i - 1) >> 1]);
+      i = (i - 1) >> 1;
+    }
+    queue_set(aio, i, s);
+}
+
+static void queue_down(ASYNCIO *aio, int i)
+{
+    ASYNCIO_STREAM *s = aio->queue[i];
+    int     j;
+    while ((j = 2 * i + 1) < aio->nqueue) {
+      if (j + 1 < aio->nqueue &&
+          aio->queue[j + 1]->deadline < aio->queue[j]->deadline)
+        j++;
+      if (aio->queue[j]->deadline >= s->deadline)
+        break;
+      queue_set(aio, i, aio->queue[j]);
+      i = j;
+    }
+    queue_set(aio, i, s);
+}
+
+static void queue_remove(ASYNCIO *aio, ASYNCIO_STREAM *s)
+{
+    int     i = s->qpos;
+    ASYNCIO_STREAM *last = aio->queue[--aio->nqueue];
+    s->qpos = -1;
+    if (last == s)
+      return;
+    queue_set(aio, i, last);
+    queue_up(aio, i);
+    queue_down(aio, last->qpos);
+}
+
+/* samples in the ring */
+
+static inline int stream_fill(ASYNCIO_STREAM *s)
+{
+    int64_t n = AIO_LOAD(s->moved) - AIO_LOAD(s->done);
+    return (int) (s->write ? -n : n);
+}
+
+/* whether s needs a worker */
+
+static inline int stream_due(ASYNCIO_STREAM *s)
+{
+    if (s->write)
+      return stream_fill(s) >= AIO_LOAD(s->target);
+    return !AIO_LOAD(s->eof) && stream_fill(s) < AIO_LOAD(s->target);
+}
+
+/* queue s, with the time it runs dry (or full) at its rate as its
+   deadline; the lock is held */
+
+static void stream_queue(CSOUND *csound, ASYNCIO *aio, ASYNCIO_STREAM *s)
+{
+    double  left;
+    int     speed = AIO_LOAD(s->speed);
+
+    if (s->qpos >= 0 || s->busy)
+      return;
+    if (aio->nqueue >= aio->qsize) {
+      aio->qsize = (aio->qsize ? aio->qsize * 2 : 16);
+      aio->queue = (ASYNCIO_STREAM**)
+        csound->ReAlloc(csound, aio->queue,
+                        aio->qsize * sizeof(ASYNCIO_STREAM*));
+    }
+    left = (s->write ? s->size - stream_fill(s) : stream_fill(s));
+    s->deadline = csoundGetRealTime(&aio->clock)
+      + (speed > 0 ? left / speed : 0.0);
+    AIO_STORE(s->pending, 1);
+    aio->queue[aio->nqueue] = s;
+    queue_up(aio, aio->nqueue++);
+    csoundCondSignal(aio->work);
+}
+
+/* move what s needs to or from the file; s is busy, or not shared */
+
+static void stream_serve(CSOUND *csound, ASYNCIO_STREAM *s, int all)
+{
+    void    *p;
+    int     n, m, r;
+
+    if (s->write) {
+      n = stream_fill(s);
+      if (!all && n > AIO_CHUNK)
+        n = AIO_CHUNK;
+      while (n > 0 &&
+             (m = csoundAcquireRingBuffer(csound, s->rb, &p, n)) > 0) {
+        sf_write_MYFLT(s->sf, (MYFLT*) p, m);
+        csoundReleaseRingBuffer(csound, s->rb, m);
+        AIO_STORE(s->moved, s->moved + m);
+        n -= m;
+      }
+    }
+    else {
+      n = AIO_LOAD(s->target) - stream_fill(s);
+      if (n > AIO_CHUNK)
+        n = AIO_CHUNK;
+      while (n > 0 &&
+             (m = csoundReserveRingBuffer(csound, s->rb, &p, n)) > 0) {
+        r = (int) sf_read_MYFLT(s->sf, (MYFLT*) p, m);
+        if (r > 0) {
+          csoundCommitRingBuffer(csound, s->rb, r);
+          AIO_STORE(s->moved, s->moved + r);
+          n -= r;
+        }
+        if (r < m) {                    /* end of the file */
+          AIO_STORE(s->eof, 1);
+          break;
+        }
+      }
+    }
+}
+
+static uintptr_t asyncio_worker(void *arg)
+{
+    CSOUND  *csound = (CSOUND*) arg;
+    ASYNCIO *aio = csound->asyncio;
+    ASYNCIO_STREAM *s;
+
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    csoundLockMutex(aio->lock);
+    while (1) {
+      while (aio->nqueue == 0 && !aio->stop)
+        csoundCondWait(aio->work, aio->lock);
+      if (aio->stop)
+        break;
+      s = aio->queue[0];
+      queue_remove(aio, s);
+      s->busy = 1;
+      csoundUnlockMutex(aio->lock);
+      stream_serve(csound, s, 0);
+      csoundLockMutex(aio->lock);
+      s->busy = 0;
+      if (stream_due(s))
+        stream_queue(csound, aio, s);
+      else
+        AIO_STORE(s->pending, 0);
+      csoundCondSignal(s->idle);
+    }
+    csoundUnlockMutex(aio->lock);
+    return (uintptr_t) 0;
+}
+
+/* take s away from the workers; the lock is held */
+
+static void stream_claim(ASYNCIO *aio, ASYNCIO_STREAM *s)
+{
+    if (s->qpos >= 0)
+      queue_remove(aio, s);
+    while (s->busy)
+      csoundCondWait(s->idle, aio->lock);
+    AIO_STORE(s->pending, 0);
+}
+
+/* measure how fast the performance thread uses s, and set the depth
+   read ahead (or the size written) from it */
+
+static void stream_account(ASYNCIO *aio, ASYNCIO_STREAM *s, int items)
+{
+    double  now, dt, r;
+    int     n, target;
+
+    s->asked += items;
+    if (items > s->maxreq)
+      s->maxreq = (items < s->size / 2 ? items : s->size / 2);
+    now = csoundGetRealTime(&aio->clock);
+    if ((dt = now - s->t0) < AIO_RATE_SECS)
+      return;
+    r = (double) (s->asked - s->asked0) / dt;
+    s->rate = (s->rate > 0.0 ? 0.75 * s->rate + 0.25 * r : r);
+    AIO_STORE(s->speed, (s->rate < 1.0e9 ? (int) s->rate : 1000000000));
+    s->t0 = now;
+    s->asked0 = s->asked;
+    if (s->write) {
+      n = (int) (s->rate * AIO_BEHIND);
+      if (n > s->size / 2) n = s->size / 2;
+    }
+    else {
+      n = (int) (s->rate * AIO_AHEAD);
+      if (n > s->size) n = s->size;
+    }
+    target = (n > 2 * s->maxreq ? n : 2 * s->maxreq);
+    AIO_STORE(s->target, (target > s->size ? s->size : target));
+}
+
+static void stream_request(CSOUND *csound, ASYNCIO *aio, ASYNCIO_STREAM *s)
+{
+    if (AIO_LOAD(s->pending) || !stream_due(s))
+      return;
+    csoundLockMutex(aio->lock);
+    stream_queue(csound, aio, s);
+    csoundUnlockMutex(aio->lock);
+}
+
+ASYNCIO_STREAM *asyncio_open(CSOUND *csound, SNDFILE *sf, int write,
+                             int size, int nchnls, double sr)
+{
+    ASYNCIO         *aio = csound->asyncio;
+    ASYNCIO_STREAM  *s;
+    void            *t;
+    int             n;
+
+    if (aio == NULL) {
+      aio = (ASYNCIO*) csound->Calloc(csound, sizeof(ASYNCIO));
+      aio->lock = csoundCreateMutex(0);
+      aio->work = csoundCreateCondVar();
+      aio->maxthreads = (csound->oparms->ioThreads > 0 ?
+                         csound->oparms->ioThreads : AIO_THREADS);
+      aio->threads = (void**) csound->Calloc(csound,
+                                             aio->maxthreads * sizeof(void*));
+      csoundInitTimerStruct(&aio->clock);
+      csound->asyncio = aio;
+    }
+    s = (ASYNCIO_STREAM*) csound->Calloc(csound, sizeof(ASYNCIO_STREAM));
+    n = (int) (sr * (nchnls > 0 ? nchnls : 1) * AIO_RING_SECS);
+    s->size = (size * 4 > n ? size * 4 : n);
+    if ((s->rb = csoundCreateRingBuffer(csound, s->size, sizeof(MYFLT)))
+        == NULL || (s->idle = csoundCreateCondVar()) == NULL) {
+      csoundDestroyRingBuffer(csound, s->rb);
+      csound->Free(csound, s);
+      return NULL;
+    }
+    s->sf = sf;
+    s->write = write;
+    s->maxreq = size;
+    s->target = (write ? size : 2 * size);
+    if (s->target > s->size) s->target = s->size;
+    s->qpos = -1;
+    s->t0 = csoundGetRealTime(&aio->clock);
+    csoundLockMutex(aio->lock);
+    if (++aio->nstreams > aio->nthreads && aio->nthreads < aio->maxthreads) {
+      if ((t = csound->CreateThread(asyncio_worker, (void*) csound)) != NULL)
+        aio->threads[aio->nthreads++] = t;
+      else if (aio->nthreads == 0) {    /* nothing would serve the stream */
+        aio->nstreams--;
+        csoundUnlockMutex(aio->lock);
+        csound->Warning(csound, Str("asyncio: could not start an I/O thread"));
+        csoundDestroyRingBuffer(csound, s->rb);
+        free(s->idle);
+        csound->Free(csound, s);
+        return NULL;
+      }
+    }
+    if (!write)
+      stream_queue(csound, aio, s);     /* start reading ahead now */
+    csoundUnlockMutex(aio->lock);
+    return s;
+}
+
+void asyncio_close(CSOUND *csound, ASYNCIO_STREAM *s)
+{
+    ASYNCIO *aio = csound->asyncio;
+
+    csoundLockMutex(aio->lock);
+    stream_claim(aio, s);
+    aio->nstreams--;
+    csoundUnlockMutex(aio->lock);
+    if (s->write)
+      stream_serve(csound, s, 1);
+    csoundDestroyRingBuffer(csound, s->rb);
+    free(s->idle);
+    csound->Free(csound, s);
+}
+
+int asyncio_read(CSOUND *csound, ASYNCIO_STREAM *s, MYFLT *buf, int items)
+{
+    int     n = csoundReadRingBuffer(csound, s->rb, buf, items);
+
+    AIO_STORE(s->done, s->done + n);
+    stream_account(csound->asyncio, s, items);
+    stream_request(csound, csound->asyncio, s);
+    return n;
+}
+
+int asyncio_write(CSOUND *csound, ASYNCIO_STREAM *s, const MYFLT *buf,
+                  int items)
+{
+    int     n = csoundWriteRingBuffer(csound, s->rb, buf, items);
+
+    AIO_STORE(s->done, s->done + n);
+    stream_account(csound->asyncio, s, items);
+    stream_request(csound, csound->asyncio, s);
+    return n;
+}
+
+int asyncio_seek(CSOUND *csound, ASYNCIO_STREAM *s, int pos, int whence)
+{
+    ASYNCIO *aio = csound->asyncio;
+    int     ret;
+
+    csoundLockMutex(aio->lock);
+    stream_claim(aio, s);
+    s->busy = 1;                        /* keep the workers off it */
+    csoundUnlockMutex(aio->lock);
+    if (s->write)
+      stream_serve(csound, s, 1);
+    else {
+      csoundFlushCircularBuffer(csound, s->rb);
+      AIO_STORE(s->done, s->moved);
+      AIO_STORE(s->eof, 0);
+    }
+    ret = (int) sf_seek(s->sf, (sf_count_t) pos, whence);
+    csoundLockMutex(aio->lock);
+    s->busy = 0;
+    if (stream_due(s))
+      stream_queue(csound, aio, s);
+    csoundUnlockMutex(aio->lock);
+    return ret;
+}
+
+void asyncio_shutdown(CSOUND *csound)
+{
+    ASYNCIO *aio = csound->asyncio;
+    int     i;
+
+    if (aio == NULL)
+      return;
+    csoundLockMutex(aio->lock);
+    aio->stop = 1;
+    for (i = 0; i < aio->nthreads; i++)
+      csoundCondSignal(aio->work);
+    csoundUnlockMutex(aio->lock);
+    for (i = 0; i < aio->nthreads; i++)
+      csound->JoinThread(aio->threads[i]);
+    csoundDestroyMutex(aio->lock);
+    free(aio->work);
+    csound->Free(csound, aio->threads);
+    csound->Free(csound, aio->queue);
+    csound->Free(csound, aio);
+    csound->asyncio = NULL;
+}
@@ -76,6 +76,27 @@
 #define INIT_SIZE (100)
 //static int task_max_size;
 
+int dag_instr_conflict(CSOUND *csound, int a, int b);
+void dag_reinit(CSOUND *csound);
+
+/* Whether task k has to finish before the later task j can run.  The
+   answers for the runs in the task map are all memoised by dag_build, so
+   worker threads only read them. */
+static inline int dag_depends(CSOUND *csound, int k, int j)
+{
+    INSDS **task_map = csound->dag_task_map;
+    if (task_map[k]->insno == task_map[j]->insno)
+      return csound->dag_groups[csound->dag_task_group[j]].self;
+    return dag_instr_conflict(csound, task_map[k]->insno, task_map[j]->insno);
+}
+
+/* Last task of the run that task k is in */
+static inline int dag_run_last(CSOUND *csound, int k)
+{
+    dagGroup *g = &csound->dag_groups[csound->dag_task_group[k]];
+    return g->first+g->cnt-1;
+}
+
 static void dag_print_state(CSOUND *csound)
 {
     int i;
@@ -104,10 +125,9 @@ static void dag_print_state(CSOUND *csound)
         break;
       case WAITING:
         {
-          char *tt = csound->dag_task_dep[i];
           int j;
           printf("status=WAITING for tasks [");
-          for (j=0; j<i; j++) if (tt[j]) printf("%d ", j);
+          for (j=0; j<i; j++) if (dag_depends(csound, j, i)) printf("%d ", j);
           printf("]\n");
         }
         break;
@@ -117,7 +137,7 @@ static void dag_print_state(CSOUND *csound)
     }
 }
 
-/* For now allocate a fixed maximum number of tasks; FIXME */
+/* Task vectors start at dag_task_max_size and grow in recreate_dag */
 static void create_dag(CSOUND *csound)
 {
     /* Allocate the main task status and watchlists */
@@ -125,7 +145,8 @@ static void create_dag(CSOUND *csound)
     csound->dag_task_status = csound->Calloc(csound, sizeof(stateWithPadding)*max);
     csound->dag_task_watch  = csound->Calloc(csound, sizeof(watchList*)*max);
     csound->dag_task_map    = csound->Calloc(csound, sizeof(INSDS*)*max);
-    csound->dag_task_dep    = (char **)csound->Calloc(csound, sizeof(char*)*max);
+    csound->dag_task_group  = (int *)csound->Calloc(csound, sizeof(int)*max);
+    csound->dag_groups = (dagGroup *)csound->Calloc(csound, sizeof(dagGroup)*max);
     csound->dag_wlmm = (watchList *)csound->Calloc(csound, sizeof(watchList)*max);
 }
 
@@ -141,8 +162,11 @@ static void recreate_dag(CSOUND *csound)
                sizeof(watchList*)*max);
     csound->dag_task_map    =
       csound->ReAlloc(csound, (INSDS *)csound->dag_task_map, sizeof(INSDS*)*max);
-    csound->dag_task_dep    =
-      (char **)csound->ReAlloc(csound, csound->dag_task_dep, sizeof(char*)*max);
+    csound->dag_task_group  =
+      (int *)csound->ReAlloc(csound, csound->dag_task_group, sizeof(int)*max);
+    csound->dag_groups      =
+      (dagGroup *)csound->ReAlloc(csound, csound->dag_groups,
+                                  sizeof(dagGroup)*max);
     csound->dag_wlmm        =
       (watchList *)csound->ReAlloc(csound, csound->dag_wlmm, sizeof(watchList)*max);
 }
@@ -183,11 +207,74 @@ static int dag_intersect(CSOUND *csound, struct set_t *current,
     return res;
 }
 
+/* Whether an instance of instrument a has to finish before a later
+   instance of instrument b can run.  This only depends on the two
+   instruments, so the answer is kept (0 unknown, 1 no, 2 yes) in rows of
+   csound->dag_conflicts until the next orchestra is merged. */
+int dag_instr_conflict(CSOUND *csound, int a, int b)
+{
+    int n = csound->engineState.maxinsno+1;
+    char *row;
+
+    if (csound->dag_conflicts_size < n) {  /* rows are n long, so restart */
+      int i;
+      for (i = 0; i < csound->dag_conflicts_size; i++)
+        csound->Free(csound, csound->dag_conflicts[i]);
+      csound->Free(csound, csound->dag_conflicts);
+      csound->dag_conflicts = (char **) csound->Calloc(csound, sizeof(char *)*n);
+      csound->dag_conflicts_size = n;
+    }
+    row = csound->dag_conflicts[a];
+    if (row == NULL)
+      row = csound->dag_conflicts[a] = (char *) csound->Calloc(csound, n);
+    if (row[b] == 0) {
+      INSTR_SEMANTICS *current_instr = dag_get_info(csound, a);
+      INSTR_SEMANTICS *later_instr = dag_get_info(csound, b);
+      int cnt = 0;
+      row[b] =
+        (dag_intersect(csound, current_instr->write,
+                       later_instr->read, cnt++)       ||
+         dag_intersect(csound, current_instr->read_write,
+                       later_instr->read, cnt++)       ||
+         dag_intersect(csound, current_instr->read,
+                       later_instr->write, cnt++)      ||
+         dag_intersect(csound, current_instr->write,
+                       later_instr->write, cnt++)      ||
+         dag_intersect(csound, current_instr->read_write,
+                       later_instr->write, cnt++)      ||
+         dag_intersect(csound, current_instr->read,
+                       later_instr->read_write, cnt++) ||
+         dag_intersect(csound, current_instr->write,
+                       later_instr->read_write, cnt++)) ? 2 : 1;
+    }
+    return row[b] == 2;
+}
+
+void dag_ws_invalidate(CSOUND *csound);
+
+/* New or redefined instruments change the read/write sets */
+void dag_conflicts_reset(CSOUND *csound)
+{
+    int i;
+    for (i = 0; i < csound->dag_conflicts_size; i++)
+      if (csound->dag_conflicts[i] != NULL) {
+        csound->Free(csound, csound->dag_conflicts[i]);
+        csound->dag_conflicts[i] = NULL;
+      }
+    dag_ws_invalidate(csound);
+    csound->dag_changed++;
+}
+
+/* Copy the chain into the task map and work out the dependencies of each
+   run of instances of one instrument.  Dependencies are per run, not per
+   pair of instances, so this is O(instances + runs^2) and starting or
+   stopping a note costs no more than a k-cycle of dag_reinit. */
 void dag_build(CSOUND *csound, INSDS *chain)
 {
     INSDS *save = chain;
     INSDS **task_map;
-    int i;
+    dagGroup *groups;
+    int i, g, h, ng;
 
     //printf("DAG BUILD***************************************\n");
     csound->dag_num_active = 0;
@@ -197,107 +284,79 @@ void dag_build(CSOUND *csound, INSDS *chain)
     }
     if (csound->dag_num_active>csound->dag_task_max_size) {
       //printf("**************need to extend task vector\n");
-      csound->dag_task_max_size = csound->dag_num_active+INIT_SIZE;
-      recreate_dag(csound);
+      /* grow geometrically so dense note streams do not realloc every build */
+      csound->dag_task_max_size =
+        csound->dag_num_active+(csound->dag_task_max_size > INIT_SIZE ?
+                                csound->dag_task_max_size : INIT_SIZE);
+      if (csound->dag_task_status != NULL) recreate_dag(csound);
     }
     if (csound->dag_task_status == NULL)
       create_dag(csound); /* Should move elsewhere */
-    else {
-      memset((void*)csound->dag_task_watch, '\0',
-             sizeof(watchList*)*csound->dag_task_max_size);
-      for (i=0; i<csound->dag_task_max_size; i++) {
-        if (csound->dag_task_dep[i]) {
-          csound->dag_task_dep[i]= NULL;
-        }
-        csound->dag_wlmm[i].id = INVALID;
-      }
-    }
     task_map = csound->dag_task_map;
-    for (i=0; i<csound->dag_num_active; i++) {
-      csound->dag_task_status[i].s = AVAILABLE;
-      csound->dag_wlmm[i].id=i;
-    }
+    groups = csound->dag_groups;
     csound->dag_changed = 0;
     if (UNLIKELY(csound->oparms->odebug))
       printf("dag_num_active = %d\n", csound->dag_num_active);
-    i = 0; chain = save;
-    while (chain != NULL) {     /* for each instance check against later */
-      int j = i+1;              /* count of instance */
-      if (UNLIKELY(csound->oparms->odebug))
-        printf("\nWho depends on %d (instr %d)?\n", i, chain->insno);
-      INSDS *next = chain->nxtact;
-      INSTR_SEMANTICS *current_instr = dag_get_info(csound, chain->insno);
-      //csp_set_print(csound, current_instr->read);
-      //csp_set_print(csound, current_instr->write);
-      while (next) {
-        INSTR_SEMANTICS *later_instr = dag_get_info(csound, next->insno);
-        int cnt = 0;
-        if (UNLIKELY(csound->oparms->odebug)) printf("%d ", j);
-        //csp_set_print(csound, later_instr->read);
-        //csp_set_print(csound, later_instr->write);
-        //csp_set_print(csound, later_instr->read_write);
-        if (dag_intersect(csound, current_instr->write,
-                          later_instr->read, cnt++)       ||
-            dag_intersect(csound, current_instr->read_write,
-                          later_instr->read, cnt++)       ||
-            dag_intersect(csound, current_instr->read,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->write,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->read_write,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->read,
-                          later_instr->read_write, cnt++) ||
-            dag_intersect(csound, current_instr->write,
-                          later_instr->read_write, cnt++)) {
-          char *tt = csound->dag_task_dep[j];
-          if (tt==NULL) {
-            /* get dep vector if missing and set watch first time */
-            tt = csound->dag_task_dep[j] =
-              (char*)csound->Calloc(csound, sizeof(char)*(j+1));
-            csound->dag_task_status[j].s = WAITING;
-            csound->dag_wlmm[j].next = csound->dag_task_watch[i];
-            csound->dag_wlmm[j].id = j;
-            csound->dag_task_watch[i] = &(csound->dag_wlmm[j]);
-            //printf("set watch %d to %d\n", j, i);
-          }
-          tt[i] = 1;
-          //printf("-yes ");
-        }
-        j++; next = next->nxtact;
+    /* the chain is in instrument order, so an instrument is usually one run */
+    i = 0; ng = 0; chain = save;
+    while (chain != NULL) {
+      if (ng == 0 || groups[ng-1].insno != chain->insno) {
+        groups[ng].insno = chain->insno;
+        groups[ng].first = i;
+        groups[ng].cnt = 0;
+        ng++;
       }
+      groups[ng-1].cnt++;
+      csound->dag_task_group[i] = ng-1;
       task_map[i] = chain;
       i++; chain = chain->nxtact;
     }
+    csound->dag_num_groups = ng;
+    for (g=0; g<ng; g++) {      /* each run against the earlier ones */
+      if (UNLIKELY(csound->oparms->odebug))
+        printf("\nWho does run %d (instr %d) depend on?\n", g, groups[g].insno);
+      groups[g].self = dag_instr_conflict(csound, groups[g].insno,
+                                          groups[g].insno);
+      groups[g].wait = INVALID;
+      /* every pair is looked at, so that dag_end_task finds them memoised */
+      for (h=0; h<g; h++)
+        if (dag_instr_conflict(csound, groups[h].insno, groups[g].insno)) {
+          if (UNLIKELY(csound->oparms->odebug)) printf("%d ", h);
+          if (groups[g].wait == INVALID) groups[g].wait = groups[h].first;
+        }
+    }
+    dag_reinit(csound);
     if (UNLIKELY(csound->oparms->odebug)) dag_print_state(csound);
 }
 
 void dag_reinit(CSOUND *csound)
 {
-    int i;
+    int i, g;
     int max = csound->dag_task_max_size;
     volatile stateWithPadding *task_status = csound->dag_task_status;
     watchList * volatile *task_watch = csound->dag_task_watch;
     watchList *wlmm = csound->dag_wlmm;
+    dagGroup *groups = csound->dag_groups;
     if (UNLIKELY(csound->oparms->odebug))
       printf("DAG REINIT************************\n");
     for (i=csound->dag_num_active; i<max; i++)
       task_status[i].s = DONE;
-    task_status[0].s = AVAILABLE;
-    task_watch[0] = NULL;
-    for (i=1; i<csound->dag_num_active; i++) {
-      int j;
+    for (i=0; i<csound->dag_num_active; i++) {
       task_status[i].s = AVAILABLE;
       task_watch[i] = NULL;
-      if (csound->dag_task_dep[i]==NULL) continue;
-      for (j=0; j<i; j++)
-        if (csound->dag_task_dep[i][j]) {
-          task_status[i].s = WAITING;
-          wlmm[i].id = i;
-          wlmm[i].next = task_watch[j];
-          task_watch[j] = &wlmm[i];
-          break;
-        }
+    }
+    for (g=0; g<csound->dag_num_groups; g++) {
+      int first = groups[g].first, last = first+groups[g].cnt;
+      for (i=first; i<last; i++) {
+        /* watch one task it depends on; dag_end_task moves the watch */
+        int j = groups[g].wait != INVALID ? groups[g].wait :
+                groups[g].self && i > first ? first : INVALID;
+        if (j == INVALID) continue;
+        task_status[i].s = WAITING;
+        wlmm[i].id = i;
+        wlmm[i].next = task_watch[j];
+        task_watch[j] = &wlmm[i];
+      }
     }
     //dag_print_state(csound);
 }
@@ -436,7 +495,10 @@ taskID dag_end_task(CSOUND *csound, taskID i)
       wait_on_current_tasks = 0;
 
       for (k=0; k<j; k++) {     /* seek next watch */
-        if (csound->dag_task_dep[j][k]==0) continue;
+        if (!dag_depends(csound, k, j)) {     /* skip the rest of its run */
+          k = dag_run_last(csound, k);
+          continue;
+        }
         current_task_status = ATOMIC_READ(csound->dag_task_status[k].s);
         //printf("investigating task %d (%d)\n", k, current_task_status);
 
@@ -466,7 +528,10 @@ taskID dag_end_task(CSOUND *csound, taskID i)
       // Try the same thing again but this time waiting on active or available task
       if (wait_on_current_tasks == 1) {
         for (k=0; k<j; k++) {     /* seek next watch */
-          if (csound->dag_task_dep[j][k]==0) continue;
+          if (!dag_depends(csound, k, j)) {   /* skip the rest of its run */
+            k = dag_run_last(csound, k);
+            continue;
+          }
           current_task_status = ATOMIC_READ(csound->dag_task_status[k].s);
           //printf("investigating task %d (%d)\n", k, current_task_status);
 
@@ -0,0 +1,491 @@
+/*
+**  cs_ws_dispatch.c
+**
+**    Work-stealing dispatcher for the instrument DAG
+**
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+
+
+** Alternative to the status-scanning dispatcher in cs_new_dispatch.c,
+** selected with --dispatcher=ws.
+**
+** Dependencies between instances only depend on their instruments (the
+** INSTR_SEMANTICS read/write sets) and on chain order, and the active chain
+** is kept sorted by instrument number.  So the graph is kept per instrument:
+** each one records how many instances it has in the chain, the later
+** instruments that conflict with it, and how many active instances of
+** earlier instruments it has to wait for.  Starting or stopping a note
+** updates these counts in O(conflicting instruments) through
+** dag_instance_added/removed; nothing is rebuilt per instance.  Instances of
+** an instrument that conflicts with itself run in chain order.
+**
+** Each k-cycle the chain is copied into the task map, instruments with
+** nothing to wait for are dealt round-robin into per-thread deques, and a
+** thread pops from the bottom of its own deque and steals from the top of
+** the others.  Finishing an instance counts down the later instruments
+** that wait on it and releases those that reach zero; one ready task is
+** kept by the finishing thread and the rest are pushed on its deque.  A
+** thread that finds no work spins for a bounded time and then parks on a
+** futex (a condition variable where futexes are not available) until more
+** work is pushed or the cycle is complete.
+**
+** All task storage grows on demand, so there is no limit on the number of
+** active instances.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "csoundCore.h"
+#include "cs_par_base.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define WS_HAVE_FUTEX
+#endif
+
+#define INVALID (-1)
+#define EMPTY   (-3)
+
+int dag_instr_conflict(CSOUND *csound, int a, int b);
+
+/* spins before a thread with nothing to do parks itself */
+#define WS_SPIN_COUNT (2000)
+
+#if defined(_MSC_VER)
+#define WS_LOAD(x)      (MemoryBarrier(), (x))
+#define WS_STORE(x,v)   { MemoryBarrier(); (x) = (v); }
+#define WS_FENCE()      MemoryBarrier()
+#define WS_CAS(x,c,n)   \
+  ((c) == InterlockedCompareExchange((volatile long *)(x), (n), (c)))
+#define WS_DECR(x)      InterlockedDecrement((volatile long *)&(x))
+#define WS_INCR(x)      InterlockedIncrement((volatile long *)&(x))
+#define WS_ADD(x,v)     InterlockedExchangeAdd((volatile long *)&(x), (v))
+#define WS_PAUSE()      YieldProcessor()
+#else
+#define WS_LOAD(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define WS_STORE(x,v)   __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define WS_FENCE()      __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define WS_CAS(x,c,n)   \
+  __sync_bool_compare_and_swap((x), (c), (n))
+#define WS_DECR(x)      __atomic_sub_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+#define WS_INCR(x)      __atomic_add_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+#define WS_ADD(x,v)     __atomic_add_fetch(&(x), (v), __ATOMIC_SEQ_CST)
+#if defined(__i386__) || defined(__x86_64__)
+#define WS_PAUSE()      __builtin_ia32_pause()
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH_7A__))
+#define WS_PAUSE()      __asm__ __volatile__("yield")
+#else
+#define WS_PAUSE()
+#endif
+#endif
+
+/* Chase-Lev deque without wrap-around: each task is pushed at most once per
+   k-cycle and indices are reset between cycles, so a buffer with one slot
+   per task can never overflow. */
+typedef struct {
+    volatile int  top;          /* stealing end */
+    uint8_t       pad1[CONCURRENTPADDING - sizeof(int)];
+    volatile int  bottom;       /* owner's end */
+    uint8_t       pad2[CONCURRENTPADDING - sizeof(int)];
+    taskID        *buf;
+    uint8_t       pad3[CONCURRENTPADDING - sizeof(taskID *)];
+} WS_DEQUE;
+
+/* Dependency and scheduling state of one instrument */
+typedef struct {
+    volatile int  count;        /* instances in the active chain */
+    volatile int  npred;        /* active instances of earlier instruments
+                                   that must finish first */
+    int           nsucc;        /* -1 until succ has been worked out */
+    int           *succ;        /* later instruments that wait on this one */
+    int           self;         /* instances wait on each other */
+    int           cycle;        /* k-cycle in which first and cnt are valid */
+    int           first, cnt;   /* tasks of this instrument in this cycle */
+    volatile int  pending;      /* npred still to finish this cycle */
+} WS_INSTR;
+
+typedef struct ws_dispatch_t {
+    int           nthreads;
+    int           ntasks;       /* tasks in the current cycle */
+    int           capacity;     /* task slots allocated */
+    WS_DEQUE      *deque;       /* one per thread, index 0 is the main thread */
+    taskID        *deque_buf;   /* nthreads*capacity slots */
+    INSDS         **task_map;   /* chain copied for this cycle */
+    int           *task_instr;  /* instrument number of each task */
+    int           *groups;      /* instruments active this cycle */
+    WS_INSTR      *instr;       /* indexed by instrument number */
+    int           ninstr;
+    volatile int  total;        /* instances added less removed */
+    volatile int  stale;        /* recount from the chain next cycle */
+    int           cycle;
+    uint8_t       pad0[CONCURRENTPADDING];
+    volatile int  remaining;    /* tasks not yet finished this cycle */
+    uint8_t       pad1[CONCURRENTPADDING - sizeof(int)];
+    volatile int  epoch;        /* bumped whenever work is published */
+    uint8_t       pad2[CONCURRENTPADDING - sizeof(int)];
+    volatile int  sleepers;     /* threads parked on epoch */
+    uint8_t       pad3[CONCURRENTPADDING - sizeof(int)];
+#ifndef WS_HAVE_FUTEX
+    void          *mutex;
+    void          *cond;
+#endif
+} WS_DISPATCH;
+
+#ifndef WS_HAVE_FUTEX
+static int ws_reset(CSOUND *csound, void *p)
+{
+    WS_DISPATCH *ws = (WS_DISPATCH *) p;
+    IGN(csound);
+    if (ws->mutex != NULL) csoundDestroyMutex(ws->mutex);
+    if (ws->cond != NULL) free(ws->cond);
+    ws->mutex = ws->cond = NULL;
+    return OK;
+}
+#endif
+
+static WS_DISPATCH *ws_get(CSOUND *csound)
+{
+    WS_DISPATCH *ws = csound->dag_ws;
+    if (ws == NULL) {
+      ws = (WS_DISPATCH *) csound->Calloc(csound, sizeof(WS_DISPATCH));
+      ws->nthreads = csound->oparms->numThreads;
+      if (ws->nthreads < 1) ws->nthreads = 1;
+      ws->deque = (WS_DEQUE *)
+        csound->Calloc(csound, sizeof(WS_DEQUE)*ws->nthreads);
+      ws->stale = 1;
+#ifndef WS_HAVE_FUTEX
+      ws->mutex = csoundCreateMutex(0);
+      ws->cond = csoundCreateCondVar();
+      csound->RegisterResetCallback(csound, (void *) ws, ws_reset);
+#endif
+      csound->dag_ws = ws;
+    }
+    return ws;
+}
+
+static void ws_grow(CSOUND *csound, WS_DISPATCH *ws, int n)
+{
+    int i, max = ws->capacity;
+    if (n <= max) return;
+    while (max < n) max = (max == 0 ? 64 : max*2);
+    ws->capacity = max;
+    ws->task_map = (INSDS **)
+      csound->ReAlloc(csound, ws->task_map, sizeof(INSDS *)*max);
+    ws->task_instr = (int *)
+      csound->ReAlloc(csound, ws->task_instr, sizeof(int)*max);
+    ws->groups = (int *) csound->ReAlloc(csound, ws->groups, sizeof(int)*max);
+    ws->deque_buf = (taskID *)
+      csound->ReAlloc(csound, ws->deque_buf,
+                      sizeof(taskID)*max*ws->nthreads);
+    for (i = 0; i < ws->nthreads; i++)
+      ws->deque[i].buf = ws->deque_buf + i*max;
+    /* nodePerf() runs tasks through the shared task map */
+    csound->dag_task_map = ws->task_map;
+}
+
+static void ws_grow_instr(CSOUND *csound, WS_DISPATCH *ws)
+{
+    int i, n = csound->engineState.maxinsno+1;
+    if (n <= ws->ninstr) return;
+    ws->instr = (WS_INSTR *)
+      csound->ReAlloc(csound, ws->instr, sizeof(WS_INSTR)*n);
+    memset(&ws->instr[ws->ninstr], 0, sizeof(WS_INSTR)*(n-ws->ninstr));
+    for (i = ws->ninstr; i < n; i++) ws->instr[i].nsucc = -1;
+    ws->ninstr = n;
+}
+
+/* Work out which later instruments must wait for instrument a */
+static void ws_instr_succ(CSOUND *csound, WS_DISPATCH *ws, int a)
+{
+    WS_INSTR *g = &ws->instr[a];
+    INSTRTXT **instrtxtp = csound->engineState.instrtxtp;
+    int b, n = 0, max = 0;
+
+    g->self = dag_instr_conflict(csound, a, a);
+    for (b = a+1; b < ws->ninstr; b++) {
+      if (instrtxtp[b] == NULL || !dag_instr_conflict(csound, a, b)) continue;
+      if (n == max) {
+        max = (max == 0 ? 8 : max*2);
+        g->succ = (int *) csound->ReAlloc(csound, g->succ, sizeof(int)*max);
+      }
+      g->succ[n++] = b;
+    }
+    g->nsucc = n;
+}
+
+/* Instrument-level counts from scratch, from the groups of this cycle */
+static void ws_recount(CSOUND *csound, WS_DISPATCH *ws, int *groups, int ng)
+{
+    int i, k;
+    if (UNLIKELY(csound->oparms->odebug))
+      csound->Message(csound, "work-stealing dispatcher: recount\n");
+    for (i = 0; i < ws->ninstr; i++)
+      ws->instr[i].count = ws->instr[i].npred = 0;
+    for (i = 0; i < ng; i++) {
+      WS_INSTR *g = &ws->instr[groups[i]];
+      g->count = g->cnt;
+      if (g->nsucc < 0) ws_instr_succ(csound, ws, groups[i]);
+    }
+    for (i = 0; i < ng; i++) {
+      WS_INSTR *g = &ws->instr[groups[i]];
+      for (k = 0; k < g->nsucc; k++)
+        ws->instr[g->succ[k]].npred += g->count;
+    }
+    ws->total = ws->ntasks;
+    ws->stale = 0;
+}
+
+/* Forget instrument dependencies, as after compiling new instruments */
+void dag_ws_invalidate(CSOUND *csound)
+{
+    WS_DISPATCH *ws = csound->dag_ws;
+    int i;
+    if (ws == NULL) return;
+    for (i = 0; i < ws->ninstr; i++) {
+      if (ws->instr[i].succ != NULL) csound->Free(csound, ws->instr[i].succ);
+      ws->instr[i].succ = NULL;
+      ws->instr[i].nsucc = -1;
+    }
+    ws->stale = 1;
+}
+
+/* Keep the instrument counts in step with the active chain; called as an
+   instance is spliced in or out.  O(instruments that conflict with it). */
+static void ws_adjust(CSOUND *csound, INSDS *ip, int d)
+{
+    WS_DISPATCH *ws;
+    WS_INSTR *g;
+    int k;
+    if (csound->oparms->dispatcher != DISPATCH_WS ||
+        csound->oparms->numThreads < 2) return;
+    ws = ws_get(csound);
+    WS_ADD(ws->total, d);
+    if (ws->stale) return;
+    if (ip->insno >= ws->ninstr || ws->instr[ip->insno].nsucc < 0) {
+      ws->stale = 1;            /* not seen before: next cycle recounts */
+      return;
+    }
+    g = &ws->instr[ip->insno];
+    WS_ADD(g->count, d);
+    for (k = 0; k < g->nsucc; k++)
+      WS_ADD(ws->instr[g->succ[k]].npred, d);
+}
+
+void dag_instance_added(CSOUND *csound, INSDS *ip)
+{
+    ws_adjust(csound, ip, 1);
+}
+
+void dag_instance_removed(CSOUND *csound, INSDS *ip)
+{
+    ws_adjust(csound, ip, -1);
+}
+
+/* Called by the main thread before releasing the workers for a k-cycle */
+void dag_ws_prepare(CSOUND *csound, INSDS *chain)
+{
+    WS_DISPATCH *ws = ws_get(csound);
+    int i, t, n = 0, ng = 0, recount;
+    int *groups;
+
+    ws_grow_instr(csound, ws);
+    ws->cycle++;
+    for (; chain != NULL; chain = chain->nxtact) {
+      if (n == ws->capacity) ws_grow(csound, ws, n+1);
+      ws->task_map[n] = chain;
+      ws->task_instr[n++] = chain->insno;
+    }
+    if (ws->capacity == 0) ws_grow(csound, ws, 1);
+    ws->ntasks = csound->dag_num_active = n;
+    /* the chain is in instrument order, so each instrument is one run of
+       tasks */
+    groups = ws->groups;
+    recount = ws->stale || ws->total != n;
+    for (t = 0; t < n; ) {
+      int a = ws->task_instr[t];
+      WS_INSTR *g = &ws->instr[a];
+      g->first = t;
+      while (t < n && ws->task_instr[t] == a) t++;
+      g->cnt = t - g->first;
+      g->cycle = ws->cycle;
+      if (g->cnt != g->count || g->nsucc < 0) recount = 1;
+      groups[ng++] = a;
+    }
+    if (recount) ws_recount(csound, ws, groups, ng);
+    ws->remaining = n;
+    for (i = 0; i < ng; i++) {
+      WS_INSTR *g = &ws->instr[groups[i]];
+      g->pending = g->npred;
+    }
+    for (i = 0; i < ws->nthreads; i++)
+      ws->deque[i].top = ws->deque[i].bottom = 0;
+    for (i = 0, t = 0; i < ng; i++) {
+      WS_INSTR *g = &ws->instr[groups[i]];
+      int k, last = g->self ? g->first+1 : g->first+g->cnt;
+      if (g->npred != 0) continue;
+      for (k = g->first; k < last; k++) {
+        WS_DEQUE *d = &ws->deque[t];
+        d->buf[d->bottom++] = k;
+        if (++t == ws->nthreads) t = 0;
+      }
+    }
+    /* the barrier that releases the workers orders these stores */
+}
+
+static void ws_push(WS_DEQUE *d, taskID task)
+{
+    int b = d->bottom;
+    d->buf[b] = task;
+    WS_STORE(d->bottom, b+1);
+}
+
+static taskID ws_pop(WS_DEQUE *d)
+{
+    int b = d->bottom - 1, t;
+    taskID task;
+    d->bottom = b;
+    WS_FENCE();
+    t = d->top;
+    if (t > b) {                /* empty */
+      d->bottom = b+1;
+      return EMPTY;
+    }
+    task = d->buf[b];
+    if (t == b) {               /* last one; race any thief for it */
+      if (!WS_CAS(&d->top, t, t+1)) task = EMPTY;
+      d->bottom = b+1;
+    }
+    return task;
+}
+
+static taskID ws_steal(WS_DEQUE *d)
+{
+    int t = WS_LOAD(d->top), b;
+    taskID task;
+    WS_FENCE();
+    b = WS_LOAD(d->bottom);
+    if (t >= b) return EMPTY;
+    task = d->buf[t];
+    if (!WS_CAS(&d->top, t, t+1)) return EMPTY;
+    return task;
+}
+
+static void ws_wake(WS_DISPATCH *ws, int all)
+{
+    WS_INCR(ws->epoch);
+    if (WS_LOAD(ws->sleepers) == 0) return;
+#ifdef WS_HAVE_FUTEX
+    syscall(SYS_futex, &ws->epoch, FUTEX_WAKE_PRIVATE,
+            all ? INT_MAX : 1, NULL, NULL, 0);
+#else
+    csoundLockMutex(ws->mutex);
+    {
+      int n = all ? ws->sleepers : 1;
+      while (n-- > 0) csoundCondSignal(ws->cond);
+    }
+    csoundUnlockMutex(ws->mutex);
+#endif
+}
+
+static void ws_park(WS_DISPATCH *ws, int epoch)
+{
+#ifdef WS_HAVE_FUTEX
+    WS_INCR(ws->sleepers);
+    if (WS_LOAD(ws->epoch) == epoch && WS_LOAD(ws->remaining) > 0)
+      syscall(SYS_futex, &ws->epoch, FUTEX_WAIT_PRIVATE,
+              epoch, NULL, NULL, 0);
+    WS_DECR(ws->sleepers);
+#else
+    csoundLockMutex(ws->mutex);
+    WS_INCR(ws->sleepers);
+    if (WS_LOAD(ws->epoch) == epoch && WS_LOAD(ws->remaining) > 0)
+      csoundCondWait(ws->cond, ws->mutex);
+    WS_DECR(ws->sleepers);
+    csoundUnlockMutex(ws->mutex);
+#endif
+}
+
+/* Returns a task to run or INVALID when the k-cycle is complete */
+taskID dag_ws_get_task(CSOUND *csound, int index, taskID next_task)
+{
+    WS_DISPATCH *ws = csound->dag_ws;
+    int nthreads = ws->nthreads;
+    int spins = 0;
+
+    if (next_task != INVALID) return next_task;
+    while (1) {
+      int epoch = WS_LOAD(ws->epoch);
+      int i, victim;
+      taskID task = ws_pop(&ws->deque[index]);
+      if (task != EMPTY) return task;
+      for (i = 1, victim = index+1; i < nthreads; i++, victim++) {
+        if (victim == nthreads) victim = 0;
+        task = ws_steal(&ws->deque[victim]);
+        if (task != EMPTY) return task;
+      }
+      if (WS_LOAD(ws->remaining) == 0) return INVALID;
+      if (++spins < WS_SPIN_COUNT) {
+        WS_PAUSE();
+        continue;
+      }
+      ws_park(ws, epoch);
+      spins = 0;
+    }
+}
+
+static inline void ws_ready(WS_DISPATCH *ws, int index, taskID task,
+                            taskID *next_task)
+{
+    if (*next_task == INVALID) *next_task = task;
+    else {
+      ws_push(&ws->deque[index], task);
+      ws_wake(ws, 0);
+    }
+}
+
+/* Count down the instruments waiting on a finished task and release those
+   that become ready.  One ready task is returned for the calling thread to
+   run next; others are published on its deque. */
+taskID dag_ws_end_task(CSOUND *csound, int index, taskID task)
+{
+    WS_DISPATCH *ws = csound->dag_ws;
+    WS_INSTR *g = &ws->instr[ws->task_instr[task]];
+    taskID next_task = INVALID;
+    int k, cycle = ws->cycle;
+
+    if (g->self && task+1 < g->first+g->cnt)
+      ws_ready(ws, index, task+1, &next_task);
+    for (k = 0; k < g->nsucc; k++) {
+      WS_INSTR *h = &ws->instr[g->succ[k]];
+      if (h->cycle != cycle) continue;  /* no instances this cycle */
+      if (WS_DECR(h->pending) == 0) {
+        int j, last = h->self ? h->first+1 : h->first+h->cnt;
+        for (j = h->first; j < last; j++)
+          ws_ready(ws, index, j, &next_task);
+      }
+    }
+    if (WS_DECR(ws->remaining) == 0) ws_wake(ws, 1);
+    return next_task;
+}
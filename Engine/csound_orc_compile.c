@@ -947,6 +947,7 @@ void close_instrument(CSOUND *csound, ENGINE_STATE *engineState, INSTRTXT *ip) {
 }
 
 void deleteVarPoolMemory(void *csound, CS_VAR_POOL *pool);
+void free_instance_image(CSOUND *csound, INSTRTXT *tp);   /* insert.c */
 
 /**
    This function deletes an inactive instrument which has been replaced
@@ -1000,6 +1001,7 @@ void free_instrtxt(CSOUND *csound, INSTRTXT *instrtxt) {
     csound->Free(csound, tmp->varName);
   }
 
+  free_instance_image(csound, ip);
   csoundFreeVarPool(csound, ip->varPool);
   csound->Free(csound, ip);
   if (UNLIKELY(csound->oparms->odebug))
@@ -1554,9 +1556,12 @@ static char *node2string(int type) {
 */
 void merge_state(CSOUND *csound, ENGINE_STATE *engineState,
                  TYPE_TABLE *typetable, OPDS *ids) {
+  void dag_conflicts_reset(CSOUND *csound);
   if (csound->init_pass_threadlock)
     csoundLockMutex(csound->init_pass_threadlock);
   engineState_merge(csound, engineState);
+  /* instrument dependencies may have changed */
+  dag_conflicts_reset(csound);
   engineState_free(csound, engineState);
   free_typetable(csound, typetable);
   /* run global i-time code */
@@ -438,3 +438,290 @@ TREE * csound_orc_optimize(CSOUND *csound, TREE *root)
     //return original;
     //#endif
 }
+
+/* Expression fusion.
+
+   verify_tree() expands an a-rate expression into one opcode per operator,
+   each writing a synthetic #a variable which the next one reads back.
+   Where a run of statements consists only of ##add/##sub/##mul/##div and
+   the one-argument functions that ##fused knows, and each #a variable
+   between them is written and read exactly once, the run is replaced by
+   one ##fused opcode carrying the expression in RPN, and the #a variables
+   are dropped from the instrument's pool.  Only runs that are contiguous
+   in the statement list are fused, so no other statement can observe the
+   change in evaluation order.                                           */
+
+#include "aops.h"
+
+extern int32_t fuse_function_id(const char *);
+extern OENTRIES* find_opcode2(CSOUND *, char*);
+
+#define FUSE_PROGLEN    (512)
+
+typedef struct {
+    TREE    *stmt;
+    int     nopnds;         /* 0 if the statement cannot be fused */
+    char    op[8];          /* RPN token: + - * / or a function name */
+    char    types[2];       /* 'a' or 'k' for each operand */
+    int     child[2];       /* statement computing each operand, or -1 */
+    int     user;           /* statement that absorbs this one, or -1 */
+} FUSE_NODE;
+
+static inline int is_synth_avar(TREE *t)
+{
+    return t != NULL && t->type == T_IDENT && t->value != NULL &&
+      t->value->lexeme[0] == '#' && t->value->lexeme[1] == 'a';
+}
+
+static void fuse_classify(FUSE_NODE *n)
+{
+    TREE    *stmt = n->stmt, *arg;
+    OENTRY  *ep = (OENTRY *) stmt->markup;
+    const char *nm, *dot;
+    int     i;
+
+    n->nopnds = 0;
+    if (stmt->type != T_OPCODE || ep == NULL || stmt->left == NULL ||
+        stmt->left->next != NULL || strcmp(ep->outypes, "a") != 0)
+      return;
+    nm = ep->opname;
+    if ((dot = strchr(nm, '.')) == NULL) return;
+    if (dot - nm == 5 && strlen(dot) == 3 && nm[0] == '#' && nm[1] == '#') {
+      if (!strncmp(nm + 2, "add", 3)) n->op[0] = '+';
+      else if (!strncmp(nm + 2, "sub", 3)) n->op[0] = '-';
+      else if (!strncmp(nm + 2, "mul", 3)) n->op[0] = '*';
+      else if (!strncmp(nm + 2, "div", 3)) n->op[0] = '/';
+      else return;
+      n->op[1] = '\0';
+      n->types[0] = dot[1];
+      n->types[1] = dot[2];
+      if ((n->types[0] != 'a' && n->types[0] != 'k') ||
+          (n->types[1] != 'a' && n->types[1] != 'k') ||
+          (n->types[0] == 'k' && n->types[1] == 'k'))
+        return;
+      n->nopnds = 2;
+    }
+    else if (!strcmp(dot, ".a") && dot - nm < (int) sizeof(n->op)) {
+      memcpy(n->op, nm, dot - nm);
+      n->op[dot - nm] = '\0';
+      if (fuse_function_id(n->op) < 0) return;
+      n->types[0] = 'a';
+      n->nopnds = 1;
+    }
+    else return;
+    /* operands must be plain variables, or numbers in a k slot */
+    for (i = 0, arg = stmt->right; arg != NULL; arg = arg->next, i++) {
+      if (i >= n->nopnds || arg->left != NULL || arg->right != NULL ||
+          arg->value == NULL ||
+          !(arg->type == T_IDENT ||
+            (n->types[i] == 'k' && (arg->type == NUMBER_TOKEN ||
+                                    arg->type == INTEGER_TOKEN)))) {
+        n->nopnds = 0;
+        return;
+      }
+    }
+    if (i != n->nopnds) n->nopnds = 0;
+}
+
+/* count reads of #a variables anywhere below t */
+static void fuse_count_uses(CSOUND *csound, CS_HASH_TABLE *uses, TREE *t)
+{
+    for ( ; t != NULL; t = t->next) {
+      if (is_synth_avar(t)) {
+        intptr_t c = (intptr_t) cs_hash_table_get(csound, uses,
+                                                  t->value->lexeme);
+        cs_hash_table_put(csound, uses, t->value->lexeme, (void *) (c + 1));
+      }
+      fuse_count_uses(csound, uses, t->left);
+      fuse_count_uses(csound, uses, t->right);
+    }
+}
+
+/* Append node j in RPN.  Returns the stack depth reached, or -1 if the
+   program, argument list or stack would overflow. */
+static int fuse_emit(FUSE_NODE *nodes, int j, int base, char *prog,
+                     TREE **args, int *nargs)
+{
+    TREE    *arg;
+    int     i, d, depth = base + 1;
+    size_t  len;
+
+    for (i = 0, arg = nodes[j].stmt->right; arg != NULL;
+         arg = arg->next, i++) {
+      if (nodes[j].child[i] >= 0)
+        d = fuse_emit(nodes, nodes[j].child[i], base + i, prog, args, nargs);
+      else {
+        char tok[16];
+        if (*nargs >= FUSE_MAXARGS) return -1;
+        snprintf(tok, 16, "%c%d ", nodes[j].types[i], *nargs);
+        if (strlen(prog) + strlen(tok) >= FUSE_PROGLEN) return -1;
+        strcat(prog, tok);
+        args[(*nargs)++] = arg;
+        d = base + i + 1;
+      }
+      if (d < 0) return -1;
+      if (d > depth) depth = d;
+    }
+    len = strlen(prog);
+    if (len + strlen(nodes[j].op) + 2 >= FUSE_PROGLEN) return -1;
+    snprintf(prog + len, FUSE_PROGLEN - len, "%s ", nodes[j].op);
+    return depth;
+}
+
+/* size and lowest statement index of the subtree rooted at j */
+static int fuse_extent(FUSE_NODE *nodes, int j, int *lo)
+{
+    int     i, size = 1;
+    if (j < *lo) *lo = j;
+    for (i = 0; i < nodes[j].nopnds; i++)
+      if (nodes[j].child[i] >= 0)
+        size += fuse_extent(nodes, nodes[j].child[i], lo);
+    return size;
+}
+
+static void fuse_drop_var(CSOUND *csound, CS_VAR_POOL *pool, char *name)
+{
+    CS_VARIABLE *var = pool->head, *prev = NULL;
+    while (var != NULL && strcmp(var->varName, name) != 0) {
+      prev = var;
+      var = var->next;
+    }
+    if (var == NULL) return;
+    if (prev == NULL) pool->head = var->next;
+    else prev->next = var->next;
+    if (pool->tail == var) pool->tail = prev;
+    pool->varCount--;
+    cs_hash_table_remove(csound, pool->table, name);
+}
+
+static TREE *fuse_body(CSOUND *csound, TREE *body, CS_VAR_POOL *pool,
+                       OENTRY *fusedop)
+{
+    CS_HASH_TABLE *uses, *defs;
+    FUSE_NODE *nodes;
+    TREE    *s, *arg;
+    int     n = 0, i, j;
+
+    for (s = body; s != NULL; s = s->next) n++;
+    if (n < 2) return body;
+    nodes = (FUSE_NODE *) csound->Calloc(csound, n * sizeof(FUSE_NODE));
+    uses = cs_hash_table_create(csound);
+    defs = cs_hash_table_create(csound);
+    for (i = 0, s = body; s != NULL; s = s->next, i++) {
+      nodes[i].stmt = s;
+      nodes[i].child[0] = nodes[i].child[1] = nodes[i].user = -1;
+      fuse_classify(&nodes[i]);
+      fuse_count_uses(csound, uses, s->right);
+      for (arg = s->left; arg != NULL; arg = arg->next)
+        if (is_synth_avar(arg)) {
+          char *nm = arg->value->lexeme;
+          /* a second definition makes the variable unfusable */
+          cs_hash_table_put(csound, defs, nm,
+                            cs_hash_table_get(csound, defs, nm) == NULL ?
+                            (void *) (intptr_t) (i + 1) : (void *) (intptr_t) -1);
+        }
+    }
+
+    /* link each single-use #a operand to the statement that computes it */
+    for (j = 0; j < n; j++) {
+      if (!nodes[j].nopnds) continue;
+      for (i = 0, arg = nodes[j].stmt->right; arg != NULL;
+           arg = arg->next, i++) {
+        intptr_t d;
+        if (nodes[j].types[i] != 'a' || !is_synth_avar(arg) ||
+            (intptr_t) cs_hash_table_get(csound, uses,
+                                         arg->value->lexeme) != 1)
+          continue;
+        d = (intptr_t) cs_hash_table_get(csound, defs, arg->value->lexeme) - 1;
+        if (d < 0 || d >= j || !nodes[d].nopnds || nodes[d].user >= 0)
+          continue;
+        nodes[d].user = j;
+        nodes[j].child[i] = (int) d;
+      }
+    }
+
+    for (j = 0; j < n; j++) {
+      char    prog[FUSE_PROGLEN];
+      TREE    *args[FUSE_MAXARGS], *root = nodes[j].stmt, *str, *prev;
+      int     lo = j, nargs = 0, k;
+
+      if (!nodes[j].nopnds || nodes[j].user >= 0 ||
+          (nodes[j].child[0] < 0 && nodes[j].child[1] < 0))
+        continue;
+      if (fuse_extent(nodes, j, &lo) != j - lo + 1)
+        continue;               /* interleaved with other statements */
+      prog[0] = '\0';
+      if ((k = fuse_emit(nodes, j, 0, prog, args, &nargs)) < 0 ||
+          k > FUSE_MAXDEPTH)
+        continue;
+      prog[strlen(prog) - 1] = '\0';
+
+      /* the root statement becomes  out ##fused "prog", args... */
+      {
+        size_t  len = strlen(prog) + 3;
+        char    *q = csound->Malloc(csound, len);
+        snprintf(q, len, "\"%s\"", prog);
+        str = make_leaf(csound, root->line, root->locn, STRING_TOKEN,
+                        make_token(csound, q));
+        csound->Free(csound, q);
+      }
+      /* the #a operands read inside the run are no longer needed */
+      for (k = lo; k <= j; k++) {
+        TREE *nxt;
+        for (i = 0, arg = nodes[k].stmt->right; arg != NULL;
+             arg = nxt, i++) {
+          nxt = arg->next;
+          if (nodes[k].child[i] >= 0)
+            csound->Free(csound, arg);
+        }
+      }
+      for (k = 0; k < nargs; k++)
+        args[k]->next = (k + 1 < nargs ? args[k + 1] : NULL);
+      str->next = args[0];
+      root->right = str;
+      root->value->lexeme = cs_strdup(csound, "##fused");
+      root->markup = fusedop;
+
+      /* unlink the absorbed statements and their #a variables */
+      prev = (lo > 0 ? nodes[lo - 1].stmt : NULL);
+      if (prev != NULL) prev->next = root;
+      else body = root;
+      for (k = lo; k < j; k++) {
+        fuse_drop_var(csound, pool, nodes[k].stmt->left->value->lexeme);
+        csound->Free(csound, nodes[k].stmt->left);
+        csound->Free(csound, nodes[k].stmt);
+        nodes[k].stmt = NULL;
+      }
+      if (UNLIKELY(PARSER_DEBUG))
+        csound->Message(csound, "fused %d statements: %s\n", j - lo + 1, prog);
+    }
+
+    cs_hash_table_free(csound, uses);
+    cs_hash_table_free(csound, defs);
+    csound->Free(csound, nodes);
+    return body;
+}
+
+/* Fuse a-rate expression chains in every instrument and UDO body */
+TREE *csound_orc_fuse(CSOUND *csound, TREE *root)
+{
+    OENTRIES *entries;
+    OENTRY  *fusedop;
+    TREE    *current;
+
+    if (csound->oparms->noFuse) return root;
+    entries = find_opcode2(csound, "##fused");
+    if (entries == NULL || entries->count == 0) {
+      if (entries != NULL) csound->Free(csound, entries);
+      return root;
+    }
+    fusedop = entries->entries[0];
+    csound->Free(csound, entries);
+    for (current = root; current != NULL; current = current->next) {
+      if ((current->type == INSTR_TOKEN || current->type == UDO_TOKEN) &&
+          current->markup != NULL)
+        current->right = fuse_body(csound, current->right,
+                                   (CS_VAR_POOL *) current->markup, fusedop);
+    }
+    return root;
+}
@@ -185,6 +185,7 @@ OENTRY opcodlst_1[] = {
   { "##mul.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   mulaa   },
   { "##div.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   divaa   },
   { "##mod.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   modaa   },
+  { "##fused",   S(FUSED),0,  3,      "a",    "SM",   fused_set, fused },
   { "##addin.i", S(ASSIGN),0, 1,      "i",    "i",    addin,  NULL    },
   { "##addin.k", S(ASSIGN),0, 2,      "k",    "k",    NULL,   addin   },
   { "##addin.K", S(ASSIGN),0, 2,      "a",    "k",    NULL,   addinak },
@@ -828,7 +829,7 @@ OENTRY opcodlst_1[] = {
     (SUBR)fassign_set, (SUBR)fassign },
   { "init.f",   S(FASSIGN),0, 1,    "f",   "f",
     (SUBR)fassign_set, NULL, NULL    },
-  { "pvsanal",  S(PVSANAL), 0, 3,   "f",   "aiiiioo",
+  { "pvsanal",  S(PVSANAL), 0, 3,   "f",   "aiiiioooo",
     pvsanalset, pvsanal   },
   { "pvsynth",  S(PVSYNTH),0, 3,    "a",   "fo",     pvsynthset, pvsynth },
   { "pvsadsyn", S(PVADS),0,   3,    "a",   "fikopo", pvadsynset, pvadsyn, NULL },
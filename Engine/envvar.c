@@ -24,6 +24,7 @@
 #include "csoundCore.h"
 #include "soundio.h"
 #include "envvar.h"
+#include "asyncio.h"
 #include <ctype.h>
 #include <math.h>
 
@@ -67,12 +68,7 @@ typedef struct CSFILE_ {
     int             fd;
     FILE            *f;
     SNDFILE         *sf;
-    void            *cb;
-    int             async_flag;
-    int             items;
-    int             pos;
-    MYFLT           *buf;
-    int             bufsize;
+    ASYNCIO_STREAM  *stream;    /* csoundFileOpenWithType_Async() */
     char            fullName[1];
 } CSFILE;
 
@@ -1179,10 +1175,7 @@ void *csoundFileOpenWithType(CSOUND *csound, void *fd, int type,
                                 writing, isTemporary);
     }
     /* return with opaque file handle */
-    p->cb = NULL;
-    p->async_flag = 0;
-    p->buf = NULL;
-    p->bufsize = 0;
+    p->stream = NULL;
     return (void*) p;
 
  err_return:
@@ -1236,7 +1229,7 @@ void *csoundCreateFileHandle(CSOUND *csound,
     p->fd = -1;
     p->f = (FILE*) NULL;
     p->sf = (SNDFILE*) NULL;
-    p->cb = NULL;
+    p->stream = NULL;
     strcpy(&(p->fullName[0]), fullName);
     /* open file */
     switch (type) {
@@ -1262,7 +1255,6 @@ void *csoundCreateFileHandle(CSOUND *csound,
       ((CSFILE*) csound->open_files)->prv = p;
     csound->open_files = (void*) p;
     /* return with opaque file handle */
-    p->cb = NULL;
     return (void*) p;
 }
 
@@ -1283,62 +1275,32 @@ int csoundFileClose(CSOUND *csound, void *fd)
 {
     CSFILE  *p = (CSFILE*) fd;
     int     retval = -1;
-    if (p->async_flag == ASYNC_GLOBAL) {
-      csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
-      /* close file */
-      switch (p->type) {
-      case CSFILE_FD_R:
-      case CSFILE_FD_W:
-        retval = close(p->fd);
-        break;
-      case CSFILE_STD:
-        retval = fclose(p->f);
-        break;
-      case CSFILE_SND_R:
-      case CSFILE_SND_W:
-        if (p->sf)
-          retval = sf_close(p->sf);
-        p->sf = NULL;
-        if (p->fd >= 0)
-          retval |= close(p->fd);
-        break;
-      }
-      /* unlink from chain of open files */
-      if (p->prv == NULL)
-        csound->open_files = (void*) p->nxt;
-      else
-        p->prv->nxt = p->nxt;
-      if (p->nxt != NULL)
-        p->nxt->prv = p->prv;
-      if (p->buf != NULL) csound->Free(csound, p->buf);
-      p->bufsize = 0;
-      csound->DestroyCircularBuffer(csound, p->cb);
-      csound->NotifyThreadLock(csound->file_io_threadlock);
-    } else {
-      /* close file */
-      switch (p->type) {
-      case CSFILE_FD_R:
-      case CSFILE_FD_W:
-        retval = close(p->fd);
-        break;
-      case CSFILE_STD:
-        retval = fclose(p->f);
-        break;
-      case CSFILE_SND_R:
-      case CSFILE_SND_W:
-        retval = sf_close(p->sf);
-        if (p->fd >= 0)
-          retval |= close(p->fd);
-        break;
-      }
-      /* unlink from chain of open files */
-      if (p->prv == NULL)
-        csound->open_files = (void*) p->nxt;
-      else
-        p->prv->nxt = p->nxt;
-      if (p->nxt != NULL)
-        p->nxt->prv = p->prv;
+
+    if (p->stream != NULL)              /* write out what is left */
+      asyncio_close(csound, p->stream);
+    /* close file */
+    switch (p->type) {
+    case CSFILE_FD_R:
+    case CSFILE_FD_W:
+      retval = close(p->fd);
+      break;
+    case CSFILE_STD:
+      retval = fclose(p->f);
+      break;
+    case CSFILE_SND_R:
+    case CSFILE_SND_W:
+      retval = sf_close(p->sf);
+      if (p->fd >= 0)
+        retval |= close(p->fd);
+      break;
     }
+    /* unlink from chain of open files */
+    if (p->prv == NULL)
+      csound->open_files = (void*) p->nxt;
+    else
+      p->prv->nxt = p->nxt;
+    if (p->nxt != NULL)
+      p->nxt->prv = p->prv;
     /* free allocated memory */
     csound->Free(csound, fd);
 
@@ -1352,13 +1314,7 @@ void close_all_files(CSOUND *csound)
 {
     while (csound->open_files != NULL)
       csoundFileClose(csound, csound->open_files);
-    if (csound->file_io_start) {
-#ifndef __EMSCRIPTEN__
-      csound->JoinThread(csound->file_io_thread);
-#endif
-      if (csound->file_io_threadlock != NULL)
-        csound->DestroyThreadLock(csound->file_io_threadlock);
-    }
+    asyncio_shutdown(csound);
 }
 
 /* The fromScore parameter should be 1 if opening a score include file,
@@ -1393,36 +1349,22 @@ void *fopen_path(CSOUND *csound, FILE **fp, char *name, char *basename,
     return fd;
 }
 
-uintptr_t file_iothread(void *p);
-
 void *csoundFileOpenWithType_Async(CSOUND *csound, void *fd, int type,
                                    const char *name, void *param, const char *env,
                                    int csFileType, int buffsize, int isTemporary)
 {
 #ifndef __EMSCRIPTEN__
-    CSFILE *p;
+    CSFILE  *p;
+    SF_INFO *sfinfo = (SF_INFO*) param;
+
     if ((p = (CSFILE *) csoundFileOpenWithType(csound,fd,type,name,param,env,
                                                csFileType,isTemporary)) == NULL)
       return NULL;
-
-    if (csound->file_io_start == 0) {
-      csound->file_io_start = 1;
-      csound->file_io_threadlock = csound->CreateThreadLock();
-      csound->NotifyThreadLock(csound->file_io_threadlock);
-      csound->file_io_thread =
-        csound->CreateThread(file_iothread, (void *) csound);
-    }
-    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
-    p->async_flag = ASYNC_GLOBAL;
-
-    p->cb = csound->CreateCircularBuffer(csound, buffsize*4, sizeof(MYFLT));
-    p->items = 0;
-    p->pos = 0;
-    p->bufsize = buffsize;
-    p->buf = (MYFLT *) csound->Calloc(csound, sizeof(MYFLT)*buffsize);
-    csound->NotifyThreadLock(csound->file_io_threadlock);
-
-    if (p->cb == NULL || p->buf == NULL) {
+    if (type == CSFILE_SND_R || type == CSFILE_SND_W)
+      p->stream = asyncio_open(csound, p->sf, (type == CSFILE_SND_W),
+                               buffsize, sfinfo->channels,
+                               (double) sfinfo->samplerate);
+    if (p->stream == NULL) {
       /* close file immediately */
       csoundFileClose(csound, (void *) p);
       return NULL;
@@ -1437,8 +1379,8 @@ unsigned int csoundReadAsync(CSOUND *csound, void *handle,
                              MYFLT *buf, int items)
 {
     CSFILE *p = handle;
-    if (p != NULL &&  p->cb != NULL)
-      return csound->ReadCircularBuffer(csound, p->cb, buf, items);
+    if (p != NULL && p->stream != NULL && p->type == CSFILE_SND_R)
+      return asyncio_read(csound, p->stream, buf, items);
     else return 0;
 }
 
@@ -1446,88 +1388,14 @@ unsigned int csoundWriteAsync(CSOUND *csound, void *handle,
                               MYFLT *buf, int items)
 {
     CSFILE *p = handle;
-    if (p != NULL &&  p->cb != NULL)
-      return csound->WriteCircularBuffer(csound, p->cb, buf, items);
+    if (p != NULL && p->stream != NULL && p->type == CSFILE_SND_W)
+      return asyncio_write(csound, p->stream, buf, items);
     else return 0;
 }
 
 int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence){
     CSFILE *p = handle;
-    int ret = 0;
-    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
-    switch (p->type) {
-    case CSFILE_FD_R:
-      break;
-    case CSFILE_FD_W:
-      break;
-    case CSFILE_STD:
-      break;
-    case CSFILE_SND_R:
-    case CSFILE_SND_W:
-      ret = sf_seek(p->sf,pos,whence);
-      //csoundMessage(csound, "seek set %d\n", pos);
-      csound->FlushCircularBuffer(csound, p->cb);
-      p->items = 0;
-      break;
-    }
-    csound->NotifyThreadLock(csound->file_io_threadlock);
-    return ret;
-}
-
-
-static int read_files(CSOUND *csound){
-    CSFILE *current = (CSFILE *) csound->open_files;
-    if (current == NULL) return 0;
-    while (current) {
-      if (current->async_flag == ASYNC_GLOBAL) {
-        int m = current->pos, l, n = current->items;
-        int items = current->bufsize;
-        MYFLT *buf = current->buf;
-        switch (current->type) {
-        case CSFILE_FD_R:
-          break;
-        case CSFILE_FD_W:
-          break;
-        case CSFILE_STD:
-          break;
-        case CSFILE_SND_R:
-          if (n == 0) {
-            n = sf_read_MYFLT(current->sf, buf, items);
-            m = 0;
-          }
-          l = csound->WriteCircularBuffer(csound,current->cb,&buf[m],n);
-          m += l;
-          n -= l;
-          current->items = n;
-          current->pos = m;
-          break;
-        case CSFILE_SND_W:
-          items = csound->ReadCircularBuffer(csound, current->cb, buf, items);
-          if (items == 0) { csoundSleep(10); break;}
-          sf_write_MYFLT(current->sf, buf, items);
-          break;
-        }
-      }
-      current = current->nxt;
-    }
-    return 1;
-}
-
-
-
-
-uintptr_t file_iothread(void *p){
-    int res = 1;
-    CSOUND *csound = p;
-    int wakeup = (int) (1000*csound->ksmps/csound->esr);
-    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
-    if (wakeup == 0) wakeup = 1;
-    while (res){
-      csoundSleep(wakeup);
-      csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
-      res = read_files(csound);
-      csound->NotifyThreadLock(csound->file_io_threadlock);
-    }
-    csound->file_io_start = 0;
-    return (uintptr_t)NULL;
+    if (p != NULL && p->stream != NULL)
+      return asyncio_seek(csound, p->stream, pos, whence);
+    return 0;
 }
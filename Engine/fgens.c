@@ -33,6 +33,13 @@
 #include "pstream.h"
 #include "pvfileio.h"
 #include <stdlib.h>
+#if !defined(WIN32)
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 /* #undef ISSTRCOD */
 
 
@@ -147,6 +154,7 @@ int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
     }
     msg_enabled = csound->oparms->msglevel & 7;
     ff.csound = csound;
+    ff.gen01cache = NULL;
     memcpy((char*) &(ff.e), (char*) evtblkp,
            (size_t) ((char*) &(evtblkp->p[2]) - (char*) evtblkp));
     ff.fno = (int) MYFLT2LRND(ff.e.p[1]);
@@ -294,6 +302,7 @@ int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
     }
     /* VL 11.01.05 for deferred GEN01, it's called in gen01raw */
     ftresdisp(&ff, ftp);                        /* rescale and display      */
+    csound->Free(csound, ff.gen01cache);
     *ftpp = ftp;
     /* keep original arguments, from GEN number  */
     ftp->argcnt = ff.e.pcnt - 3;
@@ -2288,6 +2297,209 @@ CS_NOINLINE int fterror(const FGDATA *ff, const char *s, ...)
 
 /* set guardpt, rescale the function, and display it */
 
+/* GEN01 cache (--gen01-cache=DIR).  Once read and rescaled, a GEN01
+   table is written to DIR, under a name hashed from a key made of the
+   full path, size and modification time of the sound file and the
+   GEN01 arguments the data depends on, and the file is then mapped
+   copy-on-write as the table data.  A later GEN01 with the same key,
+   in this run or another one, maps the file instead of reading the
+   sound file, so it loads at once and only the pages that are played
+   take memory.  Writes to a mapped table stay private to this run. */
+
+#define GEN01_CACHE_MAGIC   "CSGEN01"
+#define GEN01_CACHE_HDRSIZ  4096
+
+typedef struct {
+    char    magic[8];           /* GEN01_CACHE_MAGIC                */
+    int64_t audrem;             /* SOUNDIN audrem after reading     */
+    int32   inlocs;             /* samples read from the sound file */
+    int32   nlocs;              /* table values after the header    */
+    char    key[GEN01_CACHE_HDRSIZ - 24];
+} GEN01CACHE_HDR;
+
+typedef struct gen01map_s {     /* a table mapped from the cache    */
+    struct gen01map_s *nxt;
+    void    *base;
+    size_t  size;
+} GEN01MAP;
+
+typedef struct {                /* FGDATA.gen01cache                */
+    GEN01CACHE_HDR  hdr;        /* header of the cache file         */
+    int     mapped;             /* table data is the cache file     */
+    char    fname[1];           /* cache file name                  */
+} GEN01CACHE;
+
+#if !defined(WIN32)
+
+/* cache entry for a table of nlocs values read from p->fd, or NULL if
+   the sound file cannot be cached (a pipe or device, say) */
+
+static GEN01CACHE *gen01_cache_key(CSOUND *csound, const FGDATA *ff,
+                                   SOUNDIN *p, int32 nlocs)
+{
+    char        path[PATH_MAX];
+    const char  *s;
+    struct stat st;
+    GEN01CACHE  *c;
+    uint64_t    h = 0xCBF29CE484222325ULL;          /* FNV-1a */
+    int         n;
+
+    if (realpath(csound->GetFileName(p->fd), path) == NULL ||
+        stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+      return NULL;
+    c = (GEN01CACHE*) csound->Calloc(csound, sizeof(GEN01CACHE)
+                                     + strlen(csound->gen01_cache) + 24);
+    memcpy(c->hdr.magic, GEN01_CACHE_MAGIC, sizeof(GEN01_CACHE_MAGIC));
+    c->hdr.nlocs = nlocs;
+    n = snprintf(c->hdr.key, sizeof(c->hdr.key),
+                 "%s\n%lld %lld\n%d %d %d %d %.17g %.17g %.17g %.17g %d\n",
+                 path, (long long) st.st_size, (long long) st.st_mtime,
+                 (int) ff->flen, ff->guardreq, (int) nlocs,
+                 (int) (ff->e.p[4] > FL(0.0)), (double) ff->e.p[6],
+                 (double) ff->e.p[7], (double) ff->e.p[8],
+                 (double) csound->e0dbfs, (int) sizeof(MYFLT));
+    if (UNLIKELY(n < 0 || n >= (int) sizeof(c->hdr.key))) {
+      csound->Free(csound, c);
+      return NULL;
+    }
+    for (s = c->hdr.key; *s != '\0'; s++)
+      h = (h ^ (unsigned char) *s) * 0x100000001B3ULL;
+    sprintf(c->fname, "%s%c%016llx.gen01",
+            csound->gen01_cache, DIRSEP, (unsigned long long) h);
+    return c;
+}
+
+/* make the cache file of c the data of ftp, if it exists and matches */
+
+static int gen01_cache_map(CSOUND *csound, GEN01CACHE *c, FUNC *ftp)
+{
+    GEN01CACHE_HDR  hdr;
+    GEN01MAP        *m;
+    struct stat     st;
+    size_t  size = GEN01_CACHE_HDRSIZ + (size_t) c->hdr.nlocs * sizeof(MYFLT);
+    void    *base;
+    int     fd;
+
+    if ((fd = open(c->fname, O_RDONLY)) < 0)
+      return NOTOK;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size != size ||
+        read(fd, &hdr, sizeof(hdr)) != (ssize_t) sizeof(hdr) ||
+        memcmp(hdr.magic, c->hdr.magic, sizeof(hdr.magic)) != 0 ||
+        hdr.nlocs != c->hdr.nlocs ||
+        memcmp(hdr.key, c->hdr.key, sizeof(hdr.key)) != 0) {
+      close(fd);
+      return NOTOK;
+    }
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (UNLIKELY(base == MAP_FAILED))
+      return NOTOK;
+    m = (GEN01MAP*) csound->Malloc(csound, sizeof(GEN01MAP));
+    m->base = base;
+    m->size = size;
+    m->nxt = csound->gen01maps;
+    csound->gen01maps = m;
+    csound->Free(csound, ftp->ftable);
+    ftp->ftable = (MYFLT*) ((char*) base + GEN01_CACHE_HDRSIZ);
+    c->hdr.inlocs = hdr.inlocs;
+    c->hdr.audrem = hdr.audrem;
+    c->mapped = 1;
+    return OK;
+}
+
+/* write the table just read to the cache, and map it from there */
+
+static void gen01_cache_store(CSOUND *csound, GEN01CACHE *c, FUNC *ftp)
+{
+    char    *tmp;
+    FILE    *f;
+    size_t  n = (size_t) c->hdr.nlocs;
+    int     ok = 0;
+
+    tmp = (char*) csound->Malloc(csound, strlen(c->fname) + 32);
+    sprintf(tmp, "%s.%ld.tmp", c->fname, (long) getpid());
+    if ((f = fopen(tmp, "wb")) != NULL) {
+      ok = (fwrite(&(c->hdr), sizeof(GEN01CACHE_HDR), 1, f) == 1 &&
+            fwrite(ftp->ftable, sizeof(MYFLT), n, f) == n);
+      ok = (fclose(f) == 0 && ok);
+      /* renamed into place, so other runs never see part of a file */
+      ok = (ok && rename(tmp, c->fname) == 0);
+      if (!ok)
+        remove(tmp);
+    }
+    if (UNLIKELY(!ok))
+      csound->Warning(csound, Str("GEN01: could not write cache file %s"),
+                      c->fname);
+    else
+      gen01_cache_map(csound, c, ftp);      /* drop the copy in memory */
+    csound->Free(csound, tmp);
+}
+
+/* If the data of ftp is mapped from the cache, unmap it and give ftp
+   a copy of its own (or zeros); returns non-zero if it was mapped. */
+
+int gen01_cache_unmap(CSOUND *csound, FUNC *ftp, int copy)
+{
+    GEN01MAP    **mp, *m;
+    size_t      n;
+
+    for (mp = &(csound->gen01maps); (m = *mp) != NULL; mp = &(m->nxt)) {
+      if ((char*) ftp->ftable == (char*) m->base + GEN01_CACHE_HDRSIZ) {
+        n = m->size - GEN01_CACHE_HDRSIZ;
+        ftp->ftable = (MYFLT*) csound->Calloc(csound, n);
+        if (copy)
+          memcpy(ftp->ftable, (char*) m->base + GEN01_CACHE_HDRSIZ, n);
+        munmap(m->base, m->size);
+        *mp = m->nxt;
+        csound->Free(csound, m);
+        return 1;
+      }
+    }
+    return 0;
+}
+
+void gen01_cache_release(CSOUND *csound)
+{
+    GEN01MAP    *m;
+
+    for (m = csound->gen01maps; m != NULL; m = m->nxt)
+      munmap(m->base, m->size);
+    csound->gen01maps = NULL;           /* the list itself goes with */
+}                                       /*   the rest of the memory  */
+
+#else
+
+static GEN01CACHE *gen01_cache_key(CSOUND *csound, const FGDATA *ff,
+                                   SOUNDIN *p, int32 nlocs)
+{
+    (void) csound; (void) ff; (void) p; (void) nlocs;
+    return NULL;
+}
+
+static int gen01_cache_map(CSOUND *csound, GEN01CACHE *c, FUNC *ftp)
+{
+    (void) csound; (void) c; (void) ftp;
+    return NOTOK;
+}
+
+static void gen01_cache_store(CSOUND *csound, GEN01CACHE *c, FUNC *ftp)
+{
+    (void) csound; (void) c; (void) ftp;
+}
+
+int gen01_cache_unmap(CSOUND *csound, FUNC *ftp, int copy)
+{
+    (void) csound; (void) ftp; (void) copy;
+    return 0;
+}
+
+void gen01_cache_release(CSOUND *csound)
+{
+    (void) csound;
+}
+
+#endif  /* !WIN32 */
+
 static CS_NOINLINE void ftresdisp(const FGDATA *ff, FUNC *ftp)
 {
     CSOUND  *csound = ff->csound;
@@ -2295,10 +2507,12 @@ static CS_NOINLINE void ftresdisp(const FGDATA *ff, FUNC *ftp)
     MYFLT   abs, maxval;
     WINDAT  dwindow;
     char    strmsg[64];
+    GEN01CACHE *c = (GEN01CACHE*) ff->gen01cache;
 
     if (!ff->guardreq)                      /* if no guardpt yet, do it */
       ftp->ftable[ff->flen] = ftp->ftable[0];
-    if (ff->e.p[4] > FL(0.0)) {             /* if genum positve, rescale */
+    if (ff->e.p[4] > FL(0.0) &&             /* if genum positve, rescale */
+        (c == NULL || !c->mapped)) {        /*   unless cached that way */
       for (fp=ftp->ftable, maxval = FL(0.0); fp<=finp; ) {
         if ((abs = *fp++) < FL(0.0))
           abs = -abs;
@@ -2309,6 +2523,8 @@ static CS_NOINLINE void ftresdisp(const FGDATA *ff, FUNC *ftp)
         for (fp=ftp->ftable; fp<=finp; fp++)
           *fp /= maxval;
     }
+    if (c != NULL && !c->mapped)            /* GEN01 read from the file */
+      gen01_cache_store(csound, c, ftp);
     if (!csound->oparms->displays)
       return;
     memset(&dwindow, 0, sizeof(WINDAT));
@@ -2356,6 +2572,7 @@ static CS_NOINLINE FUNC *ftalloc(const FGDATA *ff)
 
     if (UNLIKELY(ftp != NULL)) {
       csound->Warning(csound, Str("replacing previous ftable %d"), ff->fno);
+      gen01_cache_unmap(csound, ftp, 0);
       if (ff->flen != (int32)ftp->flen) {       /* if redraw & diff len, */
         csound->Free(csound, ftp->ftable);
         csound->Free(csound, (void*) ftp);             /*   release old space   */
@@ -2611,6 +2828,8 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     int     truncmsg = 0;
     int32   inlocs = 0;
     int     def = 0, table_length = ff->flen + 1;
+    int32   nalloc = ff->flen + 1;            /* values in ftp->ftable */
+    GEN01CACHE *c = NULL;
 
     p = &tmpspace;
     memset(p, 0, sizeof(SOUNDIN));
@@ -2684,6 +2903,7 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
       ff->guardreq  = 1;                      /* presum this includes guard */
 /*ff->flen     -= 1;*/ /* VL: this was causing tables to exclude last point */
       ftp           = ftalloc(ff);            /*   alloc now, and           */
+      nalloc        = ff->flen + 1;
       ftp->lenmask  = 0L;                     /*   mark hdr partly filled   */
       /*if (p->channel==ALLCHNLS) ftp->nchanls  = p->nchanls;
       else ftp->nchanls  = 1;
@@ -2763,10 +2983,27 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
         ftp->end1 = ftp->flenfrms;      /* Greg Sullivan */
       }
     }
-    /* read sound with opt gain */
+    /* read sound with opt gain, or map it from the cache */
 
-    if (UNLIKELY((inlocs=getsndin(csound, fd, ftp->ftable, table_length, p)) < 0)) {
-      return fterror(ff, Str("GEN1 read error"));
+    if (csound->gen01_cache != NULL)
+      ff->gen01cache = c = gen01_cache_key(csound, ff, p, nalloc);
+    if (c != NULL && gen01_cache_map(csound, c, ftp) == OK) {
+      inlocs = c->hdr.inlocs;
+      p->audrem = c->hdr.audrem;
+      if (UNLIKELY(csound->oparms->msglevel & 7))
+        csoundMessage(csound, Str("  mapped from %s\n"), c->fname);
+    }
+    else {
+      if (UNLIKELY((inlocs=getsndin(csound, fd, ftp->ftable,
+                                    table_length, p)) < 0)) {
+        csound->Free(csound, c);
+        ff->gen01cache = NULL;
+        return fterror(ff, Str("GEN1 read error"));
+      }
+      if (c != NULL) {                        /* ftresdisp() stores it */
+        c->hdr.inlocs = inlocs;
+        c->hdr.audrem = p->audrem;
+      }
     }
 
     if (UNLIKELY(p->audrem > 0 && !truncmsg && p->framesrem > ff->flen)) {
@@ -2779,10 +3016,13 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     ftp->soundend = inlocs / ftp->nchanls;   /* record end of sound samps */
     csound->FileClose(csound, p->fd);
     if (def) {
-      MYFLT *tab = ftp->ftable;
+      MYFLT *tab;
       ftresdisp(ff, ftp);       /* VL: 11.01.05  for deferred alloc tables */
+      tab = ftp->ftable;        /* (may now be mapped from the cache) */
       tab[ff->flen] = tab[0];  /* guard point */
       ftp->flen -= 1;  /* exclude guard point */
+      csound->Free(csound, c);
+      ff->gen01cache = NULL;
     }
     /* save arguments */
     ftp->argcnt = ff->e.pcnt - 3;
@@ -3402,9 +3642,11 @@ int resize_table(CSOUND *csound, RESIZE *p)
     }
     if (UNLIKELY((ftp = csound->FTFind(csound, p->fn)) == NULL))
       return NOTOK;
-    if (ftp->flen<fsize)
+    if (ftp->flen<fsize) {
+      gen01_cache_unmap(csound, ftp, 1);
       ftp->ftable = (MYFLT *) csound->ReAlloc(csound, ftp->ftable,
                                               sizeof(MYFLT)*(fsize+1));
+    }
     ftp->flen = fsize+1;
     csound->flist[fno] = ftp;
     return OK;
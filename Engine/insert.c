@@ -45,6 +45,8 @@ extern int argsRequired(char* argString);
 static int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn,
                        MEVENT *mep);
 static int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp);
+void    dag_instance_added(CSOUND *, INSDS *);    /* cs_ws_dispatch.c */
+void    dag_instance_removed(CSOUND *, INSDS *);
 
 static void print_messages(CSOUND *csound, int attr, const char *str){
 #if defined(WIN32)
@@ -282,6 +284,218 @@ static void set_xtratim(CSOUND *csound, INSDS *ip)
   csound->engineState.instrtxtp[ip->insno]->pending_release++;
 }
 
+/* Index of the active chain.  Active instances are hashed on p1 so that
+   ties, infoff and turnoff by p1 do not walk every instance; buckets keep
+   insertion order (the head's prv points at the tail), which is also
+   their order in the active chain.  The bucket links live in a side
+   table, open-addressed on the INSDS address, so that INSDS keeps its
+   layout.  act_first[insno] is the head of the run of instances of insno
+   in the (insno-sorted) active chain.
+*/
+#define P1_INDEX_INIT 256
+
+typedef struct p1link {
+  INSDS   *ip;                  /* NULL in a free slot */
+  INSDS   *nxt, *prv;           /* bucket chain */
+  MYFLT   key;                  /* p1 it was indexed under */
+} P1LINK;
+
+static inline uint32_t p1_hash(MYFLT p1)
+{
+  uint64_t h = 0;
+  memcpy(&h, &p1, sizeof(MYFLT));
+  h *= UINT64_C(0x9E3779B97F4A7C15);
+  return (uint32_t) (h >> 32);
+}
+
+static inline uint32_t p1_ptr_hash(const INSDS *ip)
+{
+  uint64_t h = (uint64_t) (uintptr_t) ip;
+  h *= UINT64_C(0x9E3779B97F4A7C15);
+  return (uint32_t) (h >> 32);
+}
+
+/* the links of ip in a table of size slots, or NULL if it is not there */
+static inline P1LINK *p1_link_in(P1LINK *tab, int size, const INSDS *ip)
+{
+  uint32_t i = p1_ptr_hash(ip) & (size - 1);
+  while (tab[i].ip != ip) {
+    if (tab[i].ip == NULL)
+      return NULL;
+    i = (i + 1) & (size - 1);
+  }
+  return &tab[i];
+}
+
+static inline P1LINK *p1_link(CSOUND *csound, const INSDS *ip)
+{
+  if (csound->p1_links == NULL)
+    return NULL;
+  /* twice as many slots as buckets: never more than half full */
+  return p1_link_in((P1LINK*) csound->p1_links,
+                    2 * csound->p1_index_size, ip);
+}
+
+static P1LINK *p1_link_new(P1LINK *tab, int size, INSDS *ip)
+{
+  uint32_t i = p1_ptr_hash(ip) & (size - 1);
+  while (tab[i].ip != NULL)
+    i = (i + 1) & (size - 1);
+  tab[i].ip = ip;
+  return &tab[i];
+}
+
+/* free a slot, moving back later entries of its cluster that would no
+   longer be found past the hole */
+static void p1_link_delete(P1LINK *tab, int size, P1LINK *l)
+{
+  uint32_t mask = size - 1, i = (uint32_t) (l - tab), j = i, k;
+  for (;;) {
+    tab[i].ip = NULL;
+    do {
+      j = (j + 1) & mask;
+      if (tab[j].ip == NULL)
+        return;
+      k = p1_ptr_hash(tab[j].ip) & mask;
+    } while (i <= j ? (i < k && k <= j) : (i < k || k <= j));
+    tab[i] = tab[j];
+    i = j;
+  }
+}
+
+static void p1_bucket_add(P1LINK *tab, int size, INSDS **bucket, P1LINK *l)
+{
+  INSDS *head = *bucket;
+  l->nxt = NULL;
+  if (head == NULL) {
+    l->prv = l->ip;
+    *bucket = l->ip;
+  }
+  else {
+    P1LINK *h = p1_link_in(tab, size, head);
+    p1_link_in(tab, size, h->prv)->nxt = l->ip;
+    l->prv = h->prv;
+    h->prv = l->ip;
+  }
+}
+
+static void p1_index_add(CSOUND *csound, INSDS *ip, MYFLT p1)
+{
+  int insno = ip->insno;
+  P1LINK *tab;
+
+  if (UNLIKELY(csound->p1_index_count >= csound->p1_index_size)) {
+    /* grow and rehash, keeping each bucket in order */
+    int    i, size = csound->p1_index_size;
+    int    nsize = size ? size * 2 : P1_INDEX_INIT;
+    INSDS  **old = csound->p1_index, *p;
+    P1LINK *oldtab = (P1LINK*) csound->p1_links, *l;
+    csound->p1_index = (INSDS**) csound->Calloc(csound, nsize * sizeof(INSDS*));
+    tab = (P1LINK*) csound->Calloc(csound, 2 * nsize * sizeof(P1LINK));
+    for (i = 0; i < size; i++)
+      for (p = old[i]; p != NULL; p = l->nxt) {
+        l = p1_link_in(oldtab, 2 * size, p);
+        p1_link_new(tab, 2 * nsize, p)->key = l->key;
+      }
+    for (i = 0; i < size; i++)
+      for (p = old[i]; p != NULL; p = p1_link_in(oldtab, 2 * size, p)->nxt)
+        p1_bucket_add(tab, 2 * nsize,
+                      &csound->p1_index[p1_hash(p1_link_in(tab, 2 * nsize,
+                                                           p)->key)
+                                        & (nsize - 1)],
+                      p1_link_in(tab, 2 * nsize, p));
+    csound->p1_links = tab;
+    csound->p1_index_size = nsize;
+    csound->Free(csound, old);
+    csound->Free(csound, oldtab);
+  }
+  tab = (P1LINK*) csound->p1_links;
+  {
+    P1LINK *l = p1_link_new(tab, 2 * csound->p1_index_size, ip);
+    l->key = p1;
+    p1_bucket_add(tab, 2 * csound->p1_index_size,
+                  &csound->p1_index[p1_hash(p1) &
+                                    (csound->p1_index_size - 1)], l);
+  }
+  csound->p1_index_count++;
+
+  if (UNLIKELY(insno >= csound->act_first_size)) {
+    int n = insno + 1 > 2 * csound->act_first_size ?
+      insno + 1 : 2 * csound->act_first_size;
+    csound->act_first = (INSDS**) csound->ReAlloc(csound, csound->act_first,
+                                                  n * sizeof(INSDS*));
+    memset(csound->act_first + csound->act_first_size, 0,
+           (n - csound->act_first_size) * sizeof(INSDS*));
+    csound->act_first_size = n;
+  }
+  if (ip->prvact == &(csound->actanchor) || ip->prvact->insno != insno)
+    csound->act_first[insno] = ip;
+}
+
+static void p1_index_remove(CSOUND *csound, INSDS *ip)
+{
+  INSDS **bucket, *nxt, *prv;
+  P1LINK *l = p1_link(csound, ip);
+
+  if (l == NULL)                /* not indexed */
+    return;
+  nxt = l->nxt;
+  prv = l->prv;
+  bucket = &csound->p1_index[p1_hash(l->key) & (csound->p1_index_size - 1)];
+
+  if (ip == *bucket) {
+    if ((*bucket = nxt) != NULL)
+      p1_link(csound, nxt)->prv = prv;
+  }
+  else {
+    p1_link(csound, prv)->nxt = nxt;
+    if (nxt != NULL)
+      p1_link(csound, nxt)->prv = prv;
+    else
+      p1_link(csound, *bucket)->prv = prv;
+  }
+  p1_link_delete((P1LINK*) csound->p1_links, 2 * csound->p1_index_size, l);
+  csound->p1_index_count--;
+
+  if (csound->act_first[ip->insno] == ip)
+    csound->act_first[ip->insno] =
+      (ip->nxtact != NULL && ip->nxtact->insno == ip->insno) ?
+      ip->nxtact : NULL;
+}
+
+/* first active instance with p1 at or after ip in its bucket */
+static inline INSDS *p1_next(CSOUND *csound, INSDS *ip, MYFLT p1)
+{
+  P1LINK *l;
+  while (ip != NULL && (l = p1_link(csound, ip))->key != p1)
+    ip = l->nxt;
+  return ip;
+}
+
+/* the next active instance with the same p1 as ip */
+static inline INSDS *p1_after(CSOUND *csound, INSDS *ip)
+{
+  P1LINK *l = p1_link(csound, ip);
+  return l != NULL ? p1_next(csound, l->nxt, l->key) : NULL;
+}
+
+/* first active instance with this p1, in order of activation */
+static INSDS *find_active_p1(CSOUND *csound, MYFLT p1)
+{
+  if (csound->p1_index == NULL)
+    return NULL;
+  return p1_next(csound, csound->p1_index[p1_hash(p1) &
+                                          (csound->p1_index_size - 1)], p1);
+}
+
+/* first instance of insno in the active chain */
+INSDS *find_active_insno(CSOUND *csound, int insno)
+{
+  if (insno < 0 || insno >= csound->act_first_size)
+    return NULL;
+  return csound->act_first[insno];
+}
+
 /* insert an instr copy into active list */
 /*      then run an init pass            */
 int insert(CSOUND *csound, int insno, EVTBLK *newevtp) {
@@ -347,8 +561,9 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     return(0);
   }
   /* if find this insno, active, with indef (tie) & matching p1 */
-  for (ip = tp->instance; ip != NULL; ip = ip->nxtinstance) {
-    if (ip->actflg && ip->offtim < 0.0 && ip->p1.value == newevtp->p[1]) {
+  for (ip = find_active_p1(csound, newevtp->p[1]); ip != NULL;
+       ip = p1_after(csound, ip)) {
+    if (ip->insno == insno && ip->instr == tp && ip->offtim < 0.0) {
       csound->tieflag++;
       ip->tieflag = 1;
       tie = 1;
@@ -390,6 +605,8 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     tp->instcnt++;
     csound->dag_changed++;      /* Need to remake DAG */
     nxtp = &(csound->actanchor);    /* now splice into activ lst */
+    if ((prvp = find_active_insno(csound, insno)) != NULL)
+      nxtp = prvp->prvact;          /*   from the start of its run */
     while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
       if (nxtp->insno > insno ||
           (nxtp->insno == insno && nxtp->p1.value > newevtp->p[1])) {
@@ -400,6 +617,8 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
     ip->nxtact = nxtp;
     ip->prvact = prvp;
     prvp->nxtact = ip;
+    dag_instance_added(csound, ip);
+    p1_index_add(csound, ip, newevtp->p[1]);
     ip->tieflag = 0;
     ip->actflg++;                   /*    and mark the instr active */
   }
@@ -648,6 +867,8 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   ip->nxtolap = NULL;
 
   nxtp = &(csound->actanchor);          /* now splice into activ lst */
+  if ((prvp = find_active_insno(csound, insno)) != NULL)
+    nxtp = prvp->prvact;                /*   from the start of its run */
   while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
     if (nxtp->insno > insno) {
       nxtp->prvact = ip;
@@ -657,6 +878,8 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   ip->nxtact       = nxtp;
   ip->prvact       = prvp;
   prvp->nxtact     = ip;
+  dag_instance_added(csound, ip);
+  p1_index_add(csound, ip, (MYFLT) insno);
   ip->actflg++;                         /* and mark the instr active */
   ip->m_chnbp      = chn;               /* rec address of chnl ctrl blk */
   ip->m_pitch      = (unsigned char) mep->dat1;    /* rec MIDI data   */
@@ -917,8 +1140,12 @@ static void deact(CSOUND *csound, INSDS *ip)
       csound->Message(csound, Str("removed instance of instr %d\n"), ip->insno);
   }
   /* IV - Oct 24 2002: ip->prvact may be NULL, so need to check */
-  if (ip->prvact && (nxtp = ip->prvact->nxtact = ip->nxtact) != NULL)
-    nxtp->prvact = ip->prvact;
+  if (ip->prvact) {
+    if ((nxtp = ip->prvact->nxtact = ip->nxtact) != NULL)
+      nxtp->prvact = ip->prvact;
+    dag_instance_removed(csound, ip);
+    p1_index_remove(csound, ip);
+  }
   ip->actflg = 0;
   /* link into free instance chain */
   /* This also destroys ip->nxtact causing loops */
@@ -1098,21 +1325,20 @@ void infoff(CSOUND *csound, MYFLT p1)   /* turn off an indef copy of instr p1 */
   int   insno;
 
   insno = (int) p1;
-  if (LIKELY((ip = (csound->engineState.instrtxtp[insno])->instance) != NULL)) {
-    do {
-      if (ip->insno == insno          /* if find the insno */
-          && ip->actflg               /*      active       */
-          && ip->offtim < 0.0         /*  but indef, VL: currently this condition
-                                          cannot be removed, as it breaks turning
-                                          off extratime instances */
-          && ip->p1.value == p1) {
-        if (UNLIKELY(csound->oparms->odebug))
-          csound->Message(csound, "turning off inf copy of instr %d\n",
-                          insno);
-        xturnoff(csound, ip);
-        return;                       /*      turn it off  */
-      }
-    } while ((ip = ip->nxtinstance) != NULL);
+  /* active instances with this p1 */
+  for (ip = find_active_p1(csound, p1); ip != NULL;
+       ip = p1_after(csound, ip)) {
+    if (ip->insno == insno          /* if find the insno */
+        && ip->offtim < 0.0         /*  but indef, VL: currently this condition
+                                        cannot be removed, as it breaks turning
+                                        off extratime instances */
+        && ip->instr == csound->engineState.instrtxtp[insno]) {
+      if (UNLIKELY(csound->oparms->odebug))
+        csound->Message(csound, "turning off inf copy of instr %d\n",
+                        insno);
+      xturnoff(csound, ip);
+      return;                       /*      turn it off  */
+    }
   }
   csound->Message(csound,
                   Str("could not find playing instr %f\n"),
@@ -2313,17 +2539,70 @@ int findLabelMemOffset(CSOUND* csound, INSTRTXT* ip, char* labelName) {
   return offset;
 }
 
-/* create instance of an instr template */
-/*   allocates and sets up all pntrs    */
+/* A prebuilt instance of an instr template: the memory of a fresh
+   instance laid out at blob, with the offsets of every pointer in it
+   that points back into the block.  New instances are then a copy of
+   the blob plus a relocation pass.
+*/
+typedef struct instance_image {
+  size_t    size;
+  char      *blob;
+  int32     nreloc, maxreloc;
+  int32     *reloc;
+  int       nreinit;
+  CS_VARIABLE **reinit;         /* vars that cannot be copied (e.g. strings) */
+  CS_VARIABLE *ksmps, *kr;
+} INSTANCE_IMAGE;
+
+/* variables whose initialisation allocates, so must be run per instance */
+static int var_needs_init(CS_VARIABLE *var)
+{
+  const CS_TYPE *t = var->varType;
+  return var->initializeVariableMemory != NULL &&
+    !(t == &CS_VAR_TYPE_A || t == &CS_VAR_TYPE_K || t == &CS_VAR_TYPE_I ||
+      t == &CS_VAR_TYPE_P || t == &CS_VAR_TYPE_R || t == &CS_VAR_TYPE_C ||
+      t == &CS_VAR_TYPE_W || t == &CS_VAR_TYPE_F || t == &CS_VAR_TYPE_B ||
+      t == &CS_VAR_TYPE_b || t == &CS_VAR_TYPE_ARRAY);
+}
 
-static void instance(CSOUND *csound, int insno)
+/* note a pointer field of the image, if it points into the block */
+static void image_reloc(CSOUND *csound, INSTANCE_IMAGE *img, void *field)
 {
-  INSTRTXT  *tp;
+  uintptr_t p = (uintptr_t) *(void**) field;
+  if (p < (uintptr_t) img->blob || p >= (uintptr_t) img->blob + img->size)
+    return;
+  if (img->nreloc >= img->maxreloc) {
+    img->maxreloc = img->maxreloc ? img->maxreloc * 2 : 64;
+    img->reloc = (int32*) csound->ReAlloc(csound, img->reloc,
+                                          img->maxreloc * sizeof(int32));
+  }
+  img->reloc[img->nreloc++] = (int32) ((char*) field - img->blob);
+}
+
+void free_instance_image(CSOUND *csound, INSTRTXT *tp)
+{
+  INSTANCE_IMAGE *img = (INSTANCE_IMAGE*) tp->image;
+  if (img == NULL)
+    return;
+  csound->Free(csound, img->blob);
+  csound->Free(csound, img->reloc);
+  csound->Free(csound, img->reinit);
+  csound->Free(csound, img);
+  tp->image = NULL;
+}
+
+/* lay out an instance of an instr template, */
+/*   noting the pntrs that need relocating   */
+
+static INSTANCE_IMAGE *build_image(CSOUND *csound, INSTRTXT *tp, int insno,
+                                   size_t pextent, size_t size)
+{
+  INSTANCE_IMAGE *img;
   INSDS     *ip;
   OPTXT     *optxt;
   OPDS      *opds, *prvids, *prvpds;
   const OENTRY  *ep;
-  int       i, n, pextent, pextra, pextrab;
+  int       n;
   char      *nxtopds, *opdslim;
   MYFLT     **argpp, *lclbas;
   CS_VAR_MEM *lcloffbas; // start of pfields
@@ -2335,65 +2614,33 @@ static void instance(CSOUND *csound, int insno)
   int       argStringCount;
   CS_VARIABLE* current;
 
-  tp = csound->engineState.instrtxtp[insno];
-  n = 3;
-  if (O->midiKey>n) n = O->midiKey;
-  if (O->midiKeyCps>n) n = O->midiKeyCps;
-  if (O->midiKeyOct>n) n = O->midiKeyOct;
-  if (O->midiKeyPch>n) n = O->midiKeyPch;
-  if (O->midiVelocity>n) n = O->midiVelocity;
-  if (O->midiVelocityAmp>n) n = O->midiVelocityAmp;
-  pextra = n-3;
-  pextrab = ((i = tp->pmax - 3L) > 0 ? (int) i * sizeof(CS_VAR_MEM) : 0);
-  /* alloc new space,  */
-  pextent = sizeof(INSDS) + pextrab + pextra*sizeof(CS_VAR_MEM);
-  ip =
-    (INSDS*) csound->Calloc(csound,
-                            (size_t) pextent + tp->varPool->poolSize +
-                            (tp->varPool->varCount *
-                             CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)) +
-                            (tp->varPool->varCount * sizeof(CS_VARIABLE*)) +
-                            tp->opdstot);
+  free_instance_image(csound, tp);
+  img = (INSTANCE_IMAGE*) csound->Calloc(csound, sizeof(INSTANCE_IMAGE));
+  img->size = size;
+  img->blob = (char*) csound->Calloc(csound, size);
+  ip = (INSDS*) img->blob;
   ip->csound = csound;
-  ip->m_chnbp = (MCHNBLK*) NULL;
   ip->instr = tp;
-  /* IV - Oct 26 2002: replaced with faster version (no search) */
-  ip->prvinstance = tp->lst_instance;
-  if (tp->lst_instance)
-    tp->lst_instance->nxtinstance = ip;
-  else
-    tp->instance = ip;
-  tp->lst_instance = ip;
-  /* link into free instance chain */
-  ip->nxtact = tp->act_instance;
-  tp->act_instance = ip;
   ip->insno = insno;
-  if (UNLIKELY(csound->oparms->odebug))
-    csoundMessage(csound,"instance(): tp->act_instance = %p\n",
-                  tp->act_instance);
-
-
-  if (insno > csound->engineState.maxinsno) {
-    //      size_t pcnt = (size_t) tp->opcode_info->perf_incnt;
-    //      pcnt += (size_t) tp->opcode_info->perf_outcnt;
-    OPCODINFO* info = tp->opcode_info;
-    size_t pcnt = sizeof(OPCOD_IOBUFS) +
-      sizeof(MYFLT*) * (info->inchns + info->outchns);
-    ip->opcod_iobufs = (void*) csound->Malloc(csound, pcnt);
-  }
 
   /* gbloffbas = csound->globalVarPool; */
   lcloffbas = (CS_VAR_MEM*)&ip->p0;
   lclbas = (MYFLT*) ((char*) ip + pextent);   /* split local space */
-  initializeVarPool((void *)csound, lclbas, tp->varPool);
+  for (current = tp->varPool->head; current != NULL; current = current->next) {
+    if (var_needs_init(current)) {
+      img->reinit = (CS_VARIABLE**)
+        csound->ReAlloc(csound, img->reinit,
+                        (img->nreinit + 1) * sizeof(CS_VARIABLE*));
+      img->reinit[img->nreinit++] = current;
+    }
+    else if (current->initializeVariableMemory != NULL)
+      current->initializeVariableMemory(csound, current,
+                                        lclbas + current->memBlockIndex);
+  }
 
   opMemStart = nxtopds = (char*) lclbas + tp->varPool->poolSize +
     (tp->varPool->varCount * CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET));
   opdslim = nxtopds + tp->opdstot;
-  if (UNLIKELY(odebug))
-    csound->Message(csound,
-                    Str("instr %d allocated at %p\n\tlclbas %p, opds %p\n"),
-                    insno, ip, lclbas, nxtopds);
   optxt = (OPTXT*) tp;
   prvids = prvpds = (OPDS*) ip;
   //    prvids->insdshead = ip;
@@ -2419,36 +2666,47 @@ static void instance(CSOUND *csound, int insno)
       continue;
     }
     if (UNLIKELY(odebug))
-      csound->Message(csound, Str("op (%s) allocated at %p\n"),
-                      ep->opname, opds);
+      csound->Message(csound, Str("op (%s) laid out at offset %d\n"),
+                      ep->opname, (int) ((char*) opds - img->blob));
     opds->optext = optxt;                     /* set common headata */
     opds->insdshead = ip;
+    image_reloc(csound, img, &opds->insdshead);
     if (strcmp(ep->opname, "$label") == 0) {     /* LABEL:       */
       LBLBLK  *lblbp = (LBLBLK *) opds;
       lblbp->prvi = prvids;                   /*    save i/p links */
       lblbp->prvp = prvpds;
+      image_reloc(csound, img, &lblbp->prvi);
+      image_reloc(csound, img, &lblbp->prvp);
       continue;                               /*    for later refs */
     }
     // ******** This needs revisipn with no distinction between k- and a- rate ****
     if ((ep->thread & 03) == 0) {             /* thread 1 OR 2:  */
       if (ttp->pftype == 'b') {
-        prvids = prvids->nxti = opds;
+        prvids->nxti = opds;
+        image_reloc(csound, img, &prvids->nxti);
+        prvids = opds;
         opds->iopadr = ep->iopadr;
       }
       else {
-        prvpds = prvpds->nxtp = opds;
+        prvpds->nxtp = opds;
+        image_reloc(csound, img, &prvpds->nxtp);
+        prvpds = opds;
         opds->opadr = ep->kopadr;
       }
       goto args;
     }
     if ((ep->thread & 01) != 0) {             /* thread 1:        */
-      prvids = prvids->nxti = opds;           /* link into ichain */
+      prvids->nxti = opds;                    /* link into ichain */
+      image_reloc(csound, img, &prvids->nxti);
+      prvids = opds;
       opds->iopadr = ep->iopadr;              /*   & set exec adr */
       if (UNLIKELY(opds->iopadr == NULL))
         csoundDie(csound, Str("null iopadr"));
     }
     if ((n = ep->thread & 02) != 0) {         /* thread 2     :   */
-      prvpds = prvpds->nxtp = opds;           /* link into pchain */
+      prvpds->nxtp = opds;                    /* link into pchain */
+      image_reloc(csound, img, &prvpds->nxtp);
+      prvpds = opds;
       /* if (!(n & 04) || */
       /*     ((ttp->pftype == 'k' || ttp->pftype == 'c') && ep->kopadr != NULL)) */
         opds->opadr = ep->kopadr;             /*      krate or    */
@@ -2484,6 +2742,7 @@ static void instance(CSOUND *csound, int insno)
         fltp = NULL;
       }
       argpp[n] = fltp;
+      image_reloc(csound, img, &argpp[n]);
       arg = arg->next;
     }
 
@@ -2521,29 +2780,122 @@ static void instance(CSOUND *csound, int insno)
         csound->Message(csound, Str("FIXME: instance unexpected arg: %d\n"),
                         arg->type);
       }
+      image_reloc(csound, img, &argpp[n]);
     }
 
   }
+  image_reloc(csound, img, &ip->lclbas);
 
   /* VL 13-12-13: point the memory to the local ksmps & kr variables,
      and initialise them */
-  CS_VARIABLE* var = csoundFindVariableWithName(csound,
-                                                ip->instr->varPool, "ksmps");
-  if (var) {
-    char* temp = (char*)(lclbas + var->memBlockIndex);
-    var->memBlock = (CS_VAR_MEM*)(temp - CS_VAR_TYPE_OFFSET);
-    var->memBlock->value = csound->ksmps;
-  }
-  var = csoundFindVariableWithName(csound, ip->instr->varPool, "kr");
-  if (var) {
-    char* temp = (char*)(lclbas + var->memBlockIndex);
-    var->memBlock = (CS_VAR_MEM*)(temp - CS_VAR_TYPE_OFFSET);
-    var->memBlock->value = csound->ekr;
-  }
+  img->ksmps = csoundFindVariableWithName(csound, tp->varPool, "ksmps");
+  if (img->ksmps)
+    lclbas[img->ksmps->memBlockIndex] = csound->ksmps;
+  img->kr = csoundFindVariableWithName(csound, tp->varPool, "kr");
+  if (img->kr)
+    lclbas[img->kr->memBlockIndex] = csound->ekr;
 
   if (UNLIKELY(nxtopds > opdslim))
     csoundDie(csound, Str("inconsistent opds total"));
+  if (UNLIKELY(odebug))
+    csound->Message(csound, Str("instr %d image: %zu bytes, %d relocations\n"),
+                    insno, size, (int) img->nreloc);
+  tp->image = img;
+  return img;
+}
+
+/* create instance of an instr template */
+/*   copies its image and sets up all pntrs  */
+
+static void instance(CSOUND *csound, int insno)
+{
+  INSTRTXT  *tp;
+  INSDS     *ip;
+  INSTANCE_IMAGE *img;
+  int       i, n, pextent, pextra, pextrab;
+  size_t    size;
+  intptr_t  delta;
+  MYFLT     *lclbas;
+  OPARMS    *O = csound->oparms;
+
+  tp = csound->engineState.instrtxtp[insno];
+  n = 3;
+  if (O->midiKey>n) n = O->midiKey;
+  if (O->midiKeyCps>n) n = O->midiKeyCps;
+  if (O->midiKeyOct>n) n = O->midiKeyOct;
+  if (O->midiKeyPch>n) n = O->midiKeyPch;
+  if (O->midiVelocity>n) n = O->midiVelocity;
+  if (O->midiVelocityAmp>n) n = O->midiVelocityAmp;
+  pextra = n-3;
+  pextrab = ((i = tp->pmax - 3L) > 0 ? (int) i * sizeof(CS_VAR_MEM) : 0);
+  /* alloc new space,  */
+  pextent = sizeof(INSDS) + pextrab + pextra*sizeof(CS_VAR_MEM);
+  size = (size_t) pextent + tp->varPool->poolSize +
+    (tp->varPool->varCount * CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)) +
+    (tp->varPool->varCount * sizeof(CS_VARIABLE*)) +
+    tp->opdstot;
+  img = (INSTANCE_IMAGE*) tp->image;
+  if (img == NULL || img->size != size)
+    img = build_image(csound, tp, insno, pextent, size);
+
+  ip = (INSDS*) csound->Malloc(csound, size);
+  memcpy(ip, img->blob, size);
+  delta = (intptr_t) ((char*) ip - img->blob);
+  for (i = 0; i < img->nreloc; i++) {
+    char **field = (char**) ((char*) ip + img->reloc[i]);
+    *field += delta;
+  }
 
+  ip->csound = csound;
+  ip->m_chnbp = (MCHNBLK*) NULL;
+  ip->instr = tp;
+  /* IV - Oct 26 2002: replaced with faster version (no search) */
+  ip->prvinstance = tp->lst_instance;
+  if (tp->lst_instance)
+    tp->lst_instance->nxtinstance = ip;
+  else
+    tp->instance = ip;
+  tp->lst_instance = ip;
+  /* link into free instance chain */
+  ip->nxtact = tp->act_instance;
+  tp->act_instance = ip;
+  ip->insno = insno;
+  if (UNLIKELY(csound->oparms->odebug))
+    csoundMessage(csound,"instance(): tp->act_instance = %p\n",
+                  tp->act_instance);
+
+
+  if (insno > csound->engineState.maxinsno) {
+    //      size_t pcnt = (size_t) tp->opcode_info->perf_incnt;
+    //      pcnt += (size_t) tp->opcode_info->perf_outcnt;
+    OPCODINFO* info = tp->opcode_info;
+    size_t pcnt = sizeof(OPCOD_IOBUFS) +
+      sizeof(MYFLT*) * (info->inchns + info->outchns);
+    ip->opcod_iobufs = (void*) csound->Malloc(csound, pcnt);
+  }
+
+  lclbas = (MYFLT*) ((char*) ip + pextent);
+  for (i = 0; i < img->nreinit; i++) {
+    CS_VARIABLE *var = img->reinit[i];
+    var->initializeVariableMemory(csound, var, lclbas + var->memBlockIndex);
+  }
+  if (UNLIKELY(O->odebug))
+    csound->Message(csound,
+                    Str("instr %d allocated at %p\n\tlclbas %p, opds %p\n"),
+                    insno, ip, lclbas,
+                    (char*) lclbas + tp->varPool->poolSize +
+                    (tp->varPool->varCount *
+                     CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)));
+
+  /* the varPool memBlocks of ksmps & kr follow the latest instance */
+  if (img->ksmps) {
+    char* temp = (char*)(lclbas + img->ksmps->memBlockIndex);
+    img->ksmps->memBlock = (CS_VAR_MEM*)(temp - CS_VAR_TYPE_OFFSET);
+  }
+  if (img->kr) {
+    char* temp = (char*)(lclbas + img->kr->memBlockIndex);
+    img->kr->memBlock = (CS_VAR_MEM*)(temp - CS_VAR_TYPE_OFFSET);
+  }
 }
 
 int prealloc_(CSOUND *csound, AOP *p, int instname)
@@ -2641,16 +2993,23 @@ int delete_instr(CSOUND *csound, DELETEIN *p)
 
 
 void killInstance_enqueue(CSOUND *csound, MYFLT instr, int insno,
-                          INSDS *ip, int mode,
-                          int allow_release);
+                          int mode, int allow_release);
 
-void killInstance(CSOUND *csound, MYFLT instr, int insno, INSDS *ip,
+/* turn off instances of insno as selected by mode (see turnoff2) */
+void killInstance(CSOUND *csound, MYFLT instr, int insno,
                   int mode, int allow_release) {
-  INSDS *ip2 = NULL, *nip;
-  do {                        /* This loop does not terminate in mode=0 */
-    nip = ip->nxtact;
+  INSDS *ip, *ip2 = NULL, *nip;
+  /* with mode 4 only instances with p1 == instr qualify, so find them
+     through the p1 index; otherwise walk the run of insno */
+  ip = (mode & 4) ? find_active_p1(csound, instr) :
+                    find_active_insno(csound, insno);
+  while (ip != NULL) {
+    if (mode & 4)
+      nip = p1_after(csound, ip);
+    else if ((nip = ip->nxtact) != NULL && (int) nip->insno != insno)
+      nip = NULL;
     if (((mode & 8) && ip->offtim >= 0.0) ||
-        ((mode & 4) && ip->p1.value != instr) ||
+        (int) ip->insno != insno ||
         (allow_release && ip->relesing)) {
       ip = nip;
       continue;
@@ -2660,7 +3019,6 @@ void killInstance(CSOUND *csound, MYFLT instr, int insno, INSDS *ip,
         xturnoff(csound, ip);
       }
       else {
-        nip = ip->nxtact;
         xturnoff_now(csound, ip);
       }
     }
@@ -2670,7 +3028,7 @@ void killInstance(CSOUND *csound, MYFLT instr, int insno, INSDS *ip,
         break;
     }
     ip = nip;
-  } while (ip != NULL && (int) ip->insno == insno);
+  }
 
   if (ip2 != NULL) {
     if (allow_release) {
@@ -2685,7 +3043,6 @@ void killInstance(CSOUND *csound, MYFLT instr, int insno, INSDS *ip,
 int csoundKillInstanceInternal(CSOUND *csound, MYFLT instr, char *instrName,
                                int mode, int allow_release, int async)
 {
-  INSDS *ip;
   int   insno;
 
   if (instrName) {
@@ -2702,19 +3059,16 @@ int csoundKillInstanceInternal(CSOUND *csound, MYFLT instr, char *instrName,
     csoundUnlockMutex(csound->API_lock);
     return CSOUND_ERROR;
   }
-  ip = &(csound->actanchor);
-
-  while ((ip = ip->nxtact) != NULL && (int) ip->insno != insno);
-  if (UNLIKELY(ip == NULL)) {
+  if (UNLIKELY(find_active_insno(csound, insno) == NULL)) {
     return CSOUND_ERROR;
   }
 
   if (!async) {
     csoundLockMutex(csound->API_lock);
-    killInstance(csound, instr, insno, ip, mode, allow_release);
+    killInstance(csound, instr, insno, mode, allow_release);
     csoundUnlockMutex(csound->API_lock);
   }
   else
-    killInstance_enqueue(csound, instr, insno, ip, mode, allow_release);
+    killInstance_enqueue(csound, instr, insno, mode, allow_release);
   return CSOUND_SUCCESS;
 }
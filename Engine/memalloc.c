@@ -25,8 +25,8 @@
 #include "csoundCore.h"                 /*              MEMALLOC.C      */
 
 /* This code wraps malloc etc with maintaining a list of allocated memory
-   so it can be freed on a reset.  It would not be necessary with a zoned
-   allocator.
+   so it can be freed on a reset.  Small blocks are taken from a zoned
+   allocator (see below), which is freed a slab at a time.
 */
 #if defined(BETA) && !defined(MEMDEBUG)
 #define MEMDEBUG  1
@@ -53,6 +53,81 @@ typedef struct memAllocBlock_s {
 
 #define MEMALLOC_DB (csound->memalloc_db)
 
+/* Small blocks come from a size-class pool instead: slabs of equal sized
+   blocks carved out of large malloc()ed chunks, which memRESET() hands back
+   whole.  A pooled block is not in the chain; its nxt field points at its
+   size class instead, and prv links it into a free list.  Each thread keeps
+   a short free list per class so that most allocations take no lock.
+*/
+#define MEMPOOL_QUANTUM   16
+#define MEMPOOL_MAX       8192      /* larger requests go to malloc()     */
+#define MEMPOOL_NCLASSES  32
+#define MEMPOOL_SLAB      65536
+
+#if defined(MSVC)
+#  define MEMPOOL_TLS __declspec(thread)
+#elif defined(__GNUC__)
+#  define MEMPOOL_TLS __thread
+#endif
+
+typedef struct memSizeClass_s {
+    size_t                  size;       /* usable bytes of a block      */
+    size_t                  bsize;      /* block size including header  */
+    int                     batch;      /* blocks moved to/from caches  */
+    memAllocBlock_t         *free;      /* central free list            */
+} memSizeClass_t;
+
+typedef struct memSlab_s {
+    struct memSlab_s        *nxt;
+} memSlab_t;
+
+#define SLAB_HDR    (((int) sizeof(memSlab_t) + 15) & (~15))
+
+typedef struct memThreadCache_s {
+    void                    *owner;     /* identifies the thread        */
+    memAllocBlock_t         *free[MEMPOOL_NCLASSES];
+    int                     count[MEMPOOL_NCLASSES];
+    struct memThreadCache_s *nxt;
+} memThreadCache_t;
+
+typedef struct memPool_s {
+    memSizeClass_t          cls[MEMPOOL_NCLASSES];
+    unsigned char           index[MEMPOOL_MAX / MEMPOOL_QUANTUM];
+    long                    serial;
+    spin_lock_t             lock;       /* guards free lists and slabs  */
+    memSlab_t               *slabs;
+    memThreadCache_t        *caches;
+} memPool_t;
+
+#define MEMPOOL (csound->mem_pool)
+#define POOL_CLASS(pool, pp) \
+    ((memSizeClass_t*) (pp)->nxt - (pool)->cls)
+#define IS_POOLED(pool, pp)                                             \
+    ((pool) != NULL &&                                                  \
+     (uintptr_t) LINK_GET((pp)->nxt) - (uintptr_t) (pool)->cls <        \
+     sizeof((pool)->cls))
+
+/* IS_POOLED() reads nxt without the lock, while another thread may be
+   unlinking a neighbour of the same heap block; no value a heap block can
+   hold there looks pooled, but the accesses must still not tear */
+#if defined(__GNUC__)
+#  define LINK_GET(p)     __atomic_load_n(&(p), __ATOMIC_RELAXED)
+#  define LINK_SET(p, v)  __atomic_store_n(&(p), (v), __ATOMIC_RELAXED)
+#else
+#  define LINK_GET(p)     (p)
+#  define LINK_SET(p, v)  ((p) = (v))
+#endif
+
+static volatile long pool_serial = 0;
+
+#ifdef MEMPOOL_TLS
+/* the cache this thread used last, valid while its pool's serial matches */
+static MEMPOOL_TLS struct {
+    long                    serial;
+    memThreadCache_t        *cache;
+} mem_tls;
+#endif
+
 static void memdie(CSOUND *csound, size_t nbytes)
 {
     csound->ErrorMsg(csound, Str("memory allocate failure for %zd"),
@@ -60,6 +135,167 @@ static void memdie(CSOUND *csound, size_t nbytes)
     csound->LongJmp(csound, CSOUND_MEMORY);
 }
 
+static memPool_t *pool_create(CSOUND *csound)
+{
+    memPool_t *pool;
+    int       i, j;
+
+    CSOUND_MEM_SPINLOCK
+    if ((pool = (memPool_t*) MEMPOOL) == NULL) {
+      pool = (memPool_t*) calloc(1, sizeof(memPool_t));
+      if (UNLIKELY(pool == NULL)) {
+        CSOUND_MEM_SPINUNLOCK
+        memdie(csound, sizeof(memPool_t));
+      }
+      /* four classes per octave above 64 bytes */
+      for (i = 0; i < MEMPOOL_NCLASSES; i++) {
+        size_t base = (size_t) 64 << (i < 4 ? 0 : (i - 4) / 4);
+        size_t size = (i < 4 ? (size_t) (i + 1) * MEMPOOL_QUANTUM :
+                       base + (base / 4) * (size_t) (((i - 4) & 3) + 1));
+        pool->cls[i].size = size;
+        pool->cls[i].bsize = ALLOC_BYTES(size);
+        pool->cls[i].batch = (int) (8192 / pool->cls[i].bsize);
+        if (pool->cls[i].batch < 2) pool->cls[i].batch = 2;
+        if (pool->cls[i].batch > 32) pool->cls[i].batch = 32;
+      }
+      for (i = j = 0; i < MEMPOOL_MAX / MEMPOOL_QUANTUM; i++) {
+        while (pool->cls[j].size < (size_t) (i + 1) * MEMPOOL_QUANTUM) j++;
+        pool->index[i] = (unsigned char) j;
+      }
+      csoundSpinLockInit(&pool->lock);
+      pool->serial = ATOMIC_INCR(pool_serial);
+      MEMPOOL = (void*) pool;
+    }
+    CSOUND_MEM_SPINUNLOCK
+    return pool;
+}
+
+/* move up to n blocks of class c to *list; called with pool->lock held */
+static int pool_take(CSOUND *csound, memPool_t *pool, int c,
+                     memAllocBlock_t **list, int n)
+{
+    memSizeClass_t  *cl = &pool->cls[c];
+    memAllocBlock_t *pp;
+    int             i;
+
+    if (cl->free == NULL) {
+      /* carve a new slab */
+      size_t    nblk = MEMPOOL_SLAB / cl->bsize;
+      memSlab_t *slab;
+      char      *p;
+      if (nblk < 8) nblk = 8;
+      slab = (memSlab_t*) malloc(SLAB_HDR + nblk * cl->bsize);
+      if (UNLIKELY(slab == NULL))
+        return 0;
+      slab->nxt = pool->slabs;
+      pool->slabs = slab;
+      p = (char*) slab + SLAB_HDR + (nblk - 1) * cl->bsize;
+      for (i = 0; i < (int) nblk; i++, p -= cl->bsize) {
+        pp = (memAllocBlock_t*) p;
+        pp->nxt = (memAllocBlock_t*) cl;
+        pp->prv = cl->free;
+        cl->free = pp;
+      }
+    }
+    for (i = 0; i < n && (pp = cl->free) != NULL; i++) {
+      cl->free = pp->prv;
+      pp->prv = *list;
+      *list = pp;
+    }
+    return i;
+}
+
+#ifdef MEMPOOL_TLS
+static memThreadCache_t *pool_cache(CSOUND *csound, memPool_t *pool)
+{
+    memThreadCache_t *tc;
+
+    if (LIKELY(mem_tls.serial == pool->serial))
+      return mem_tls.cache;
+    /* first use of this pool by this thread, or switching instances */
+    csoundSpinLock(&pool->lock);
+    for (tc = pool->caches; tc != NULL; tc = tc->nxt)
+      if (tc->owner == (void*) &mem_tls)
+        break;
+    if (tc == NULL && (tc = (memThreadCache_t*)
+                       calloc(1, sizeof(memThreadCache_t))) != NULL) {
+      tc->owner = (void*) &mem_tls;
+      tc->nxt = pool->caches;
+      pool->caches = tc;
+    }
+    csoundSpinUnLock(&pool->lock);
+    if (tc != NULL) {
+      mem_tls.serial = pool->serial;
+      mem_tls.cache = tc;
+    }
+    return tc;
+}
+#endif
+
+static memAllocBlock_t *pool_alloc(CSOUND *csound, size_t size)
+{
+    memPool_t       *pool = (memPool_t*) MEMPOOL;
+    memAllocBlock_t *pp = NULL;
+    int             c;
+
+    if (UNLIKELY(pool == NULL))
+      pool = pool_create(csound);
+    c = pool->index[size ? (size - 1) / MEMPOOL_QUANTUM : 0];
+#ifdef MEMPOOL_TLS
+    {
+      memThreadCache_t *tc = pool_cache(csound, pool);
+      if (tc != NULL) {
+        if (UNLIKELY(tc->free[c] == NULL)) {
+          csoundSpinLock(&pool->lock);
+          tc->count[c] = pool_take(csound, pool, c, &tc->free[c],
+                                   pool->cls[c].batch);
+          csoundSpinUnLock(&pool->lock);
+        }
+        if (LIKELY((pp = tc->free[c]) != NULL)) {
+          tc->free[c] = pp->prv;
+          tc->count[c]--;
+        }
+        return pp;
+      }
+    }
+#endif
+    csoundSpinLock(&pool->lock);
+    pool_take(csound, pool, c, &pp, 1);
+    csoundSpinUnLock(&pool->lock);
+    return pp;
+}
+
+static void pool_free(CSOUND *csound, memPool_t *pool, memAllocBlock_t *pp)
+{
+    int c = (int) POOL_CLASS(pool, pp);
+    memSizeClass_t *cl = &pool->cls[c];
+#ifdef MEMPOOL_TLS
+    memThreadCache_t *tc = pool_cache(csound, pool);
+    if (tc != NULL) {
+      pp->prv = tc->free[c];
+      tc->free[c] = pp;
+      if (UNLIKELY(++tc->count[c] > 2 * cl->batch)) {
+        /* give a batch back so that other threads can have it */
+        int i;
+        csoundSpinLock(&pool->lock);
+        for (i = 0; i < cl->batch; i++) {
+          pp = tc->free[c];
+          tc->free[c] = pp->prv;
+          pp->prv = cl->free;
+          cl->free = pp;
+        }
+        csoundSpinUnLock(&pool->lock);
+        tc->count[c] -= cl->batch;
+      }
+      return;
+    }
+#endif
+    csoundSpinLock(&pool->lock);
+    pp->prv = cl->free;
+    cl->free = pp;
+    csoundSpinUnLock(&pool->lock);
+}
+
 void *mmalloc(CSOUND *csound, size_t size)
 {
     void  *p;
@@ -71,6 +307,14 @@ void *mmalloc(CSOUND *csound, size_t size)
       return NULL;
     }
 #endif
+    if (size <= MEMPOOL_MAX &&
+        LIKELY((p = (void*) pool_alloc(csound, size)) != NULL)) {
+#ifdef MEMDEBUG
+      ((memAllocBlock_t*) p)->magic = MEMALLOC_MAGIC;
+      ((memAllocBlock_t*) p)->ptr = DATA_PTR(p);
+#endif
+      return DATA_PTR(p);
+    }
     /* allocate memory */
     if (UNLIKELY((p = malloc(ALLOC_BYTES(size))) == NULL)) {
         memdie(csound, size);     /* does a long jump */
@@ -109,6 +353,15 @@ void *mcalloc(CSOUND *csound, size_t size)
       return NULL;
     }
 #endif
+    if (size <= MEMPOOL_MAX &&
+        LIKELY((p = (void*) pool_alloc(csound, size)) != NULL)) {
+#ifdef MEMDEBUG
+      ((memAllocBlock_t*) p)->magic = MEMALLOC_MAGIC;
+      ((memAllocBlock_t*) p)->ptr = DATA_PTR(p);
+#endif
+      memset(DATA_PTR(p), 0, size);
+      return DATA_PTR(p);
+    }
     /* allocate memory */
     if (UNLIKELY((p = calloc(ALLOC_BYTES(size), (size_t) 1)) == NULL)) {
       memdie(csound, size);     /* does longjump */
@@ -157,6 +410,10 @@ void mfree(CSOUND *csound, void *p)
     }
     pp->magic = 0;
  #endif
+    if (IS_POOLED((memPool_t*) MEMPOOL, pp)) {
+      pool_free(csound, (memPool_t*) MEMPOOL, pp);
+      return;
+    }
     CSOUND_MEM_SPINLOCK
     /* unlink from chain */
     {
@@ -164,7 +421,7 @@ void mfree(CSOUND *csound, void *p)
       if (nxt != NULL)
         nxt->prv = prv;
       if (prv != NULL)
-        prv->nxt = nxt;
+        LINK_SET(prv->nxt, nxt);
       else
         MEMALLOC_DB = (void*)nxt;
     }
@@ -184,6 +441,7 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
 {
     memAllocBlock_t *pp;
     void            *p;
+    int             failed;
 
     if (UNLIKELY(oldp == NULL))
       return mmalloc(csound, size);
@@ -200,40 +458,57 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
       /* as a result of a bug */
       exit(-1);
     }
+#endif
+    if (IS_POOLED((memPool_t*) MEMPOOL, pp)) {
+      /* pooled blocks move to a larger class, or stay put */
+      size_t oldsize = ((memPool_t*) MEMPOOL)->cls[
+                         POOL_CLASS((memPool_t*) MEMPOOL, pp)].size;
+      if (size <= oldsize)
+        return oldp;
+      p = mmalloc(csound, size);
+      memcpy(p, oldp, oldsize);
+      mfree(csound, oldp);
+      return p;
+    }
+#ifdef MEMDEBUG
     /* mark old header as invalid */
     pp->magic = 0;
     pp->ptr = NULL;
 #endif
-    /* allocate memory */
-    p = realloc((void*) pp, ALLOC_BYTES(size));
-    if (UNLIKELY(p == NULL)) {
-#ifdef MEMDEBUG
-      CSOUND_MEM_SPINLOCK
-      /* alloc failed, restore original header */
-      pp->magic = MEMALLOC_MAGIC;
-      pp->ptr = oldp;
-      CSOUND_MEM_SPINUNLOCK
-#endif
-      memdie(csound, size);
-      return NULL;
-    }
+    /* unlink while the block moves, so that other threads never
+       update its neighbours through a stale pointer */
     CSOUND_MEM_SPINLOCK
-    /* create new header and update chain pointers */
-    pp = (memAllocBlock_t*) p;
-#ifdef MEMDEBUG
-    pp->magic = MEMALLOC_MAGIC;
-    pp->ptr = DATA_PTR(pp);
-#endif
     {
       memAllocBlock_t *prv = pp->prv, *nxt = pp->nxt;
       if (nxt != NULL)
-        nxt->prv = pp;
+        nxt->prv = prv;
       if (prv != NULL)
-        prv->nxt = pp;
+        LINK_SET(prv->nxt, nxt);
       else
-        MEMALLOC_DB = (void*) pp;
+        MEMALLOC_DB = (void*) nxt;
     }
     CSOUND_MEM_SPINUNLOCK
+    /* allocate memory */
+    p = realloc((void*) pp, ALLOC_BYTES(size));
+    if (UNLIKELY((failed = (p == NULL))))
+      p = (void*) pp;       /* alloc failed, restore original block */
+    /* create new header and link it back into the chain */
+    pp = (memAllocBlock_t*) p;
+#ifdef MEMDEBUG
+    pp->magic = MEMALLOC_MAGIC;
+    pp->ptr = DATA_PTR(pp);
+#endif
+    CSOUND_MEM_SPINLOCK
+    pp->prv = (memAllocBlock_t*) NULL;
+    pp->nxt = (memAllocBlock_t*) MEMALLOC_DB;
+    if (MEMALLOC_DB != NULL)
+      ((memAllocBlock_t*) MEMALLOC_DB)->prv = pp;
+    MEMALLOC_DB = (void*) pp;
+    CSOUND_MEM_SPINUNLOCK
+    if (UNLIKELY(failed)) {
+      memdie(csound, size);
+      return NULL;
+    }
     /* return with data pointer */
     return DATA_PTR(pp);
 }
@@ -248,6 +523,23 @@ void *mreallocDebug(CSOUND *csound, void *oldp, size_t size, char *file, int lin
 void memRESET(CSOUND *csound)
 {
     memAllocBlock_t *pp, *nxtp;
+    memPool_t       *pool = (memPool_t*) MEMPOOL;
+
+    /* pooled blocks go with their slabs */
+    if (pool != NULL) {
+      memSlab_t        *slab, *nxtslab;
+      memThreadCache_t *tc, *nxttc;
+      MEMPOOL = NULL;
+      for (slab = pool->slabs; slab != NULL; slab = nxtslab) {
+        nxtslab = slab->nxt;
+        free((void*) slab);
+      }
+      for (tc = pool->caches; tc != NULL; tc = nxttc) {
+        nxttc = tc->nxt;
+        free((void*) tc);
+      }
+      free((void*) pool);
+    }
 
     pp = (memAllocBlock_t*) MEMALLOC_DB;
     MEMALLOC_DB = NULL;
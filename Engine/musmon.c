@@ -30,6 +30,8 @@
 #include "remote.h"
 #include <math.h>
 #include "corfile.h"
+#include "scobin.h"
+#include "sortrun.h"
 
 #include "csdebug.h"
 
@@ -510,6 +512,8 @@ PUBLIC int csoundCleanup(CSOUND *csound)
     orcompact(csound);
 
     corfile_rm(csound, &csound->scstr);
+    scobin_destroy(csound, &csound->scobin);
+    sortrun_destroy(csound, &csound->sortrun);
 
     /* print stats only if musmon was actually run */
     /* NOT SURE HOW   ************************** */
@@ -1459,6 +1463,10 @@ void musmon_rewind_score(CSOUND *csound)
   csound->advanceCnt = 0;
   if (csound->csoundScoreOffsetSeconds_ > FL(0.0))
     csoundSetScoreOffsetSeconds(csound, csound->csoundScoreOffsetSeconds_);
+  if (csound->scobin) {
+    scobin_rewind(csound->scobin);
+    sortrun_rewind(csound);
+  }
   if (csound->scstr)
     corfile_rewind(csound->scstr);
   else csound->Warning(csound, Str("cannot rewind score: no score in memory\n"));
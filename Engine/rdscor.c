@@ -24,6 +24,8 @@
 #include "csoundCore.h"         /*                  RDSCORSTR.C */
 #include "corfile.h"
 #include "insert.h"
+#include "scobin.h"
+#include "sortrun.h"
 
 char* get_arg_string(CSOUND *csound, MYFLT p)
 {
@@ -137,6 +139,95 @@ static void dumpline(CSOUND *csound)    /* print the line while flushing it */
     csound->Message(csound, Str("\n\tremainder of line flushed\n"));
 }
 
+/* rdscor() from the binary records of scsortbin(): each record holds the
+   values scanflt() would read from one line, used in the same way */
+static int rdscobin(CSOUND *csound, EVTBLK *e)
+{
+    const SCOBIN_REC *r;
+    const MYFLT *v, *vend;
+    MYFLT   *pp, *plim;
+    SCOBIN  *bin;
+
+    if ((r = sortrun_next(csound, &bin)) == NULL)
+      return 0;
+    v = scobin_vals(r);
+    vend = v + r->nvals;
+    switch (r->opcod) {
+    case 's':
+    case 't':
+    case 'y':
+      csound->warped = 0;
+      goto unwarped;
+    case 'w':
+      csound->warped = 1;       /* w statement is itself unwarped */
+    unwarped:
+      e->opcod = r->opcod;
+      pp = &e->p[0];
+      plim = &e->p[PMAX];
+      while (v < vend) {
+        *++pp = *v++;
+        if (UNLIKELY(pp >= plim)) {
+          csound->Message(csound, Str("ERROR: too many pfields: "));
+          csound->Message(csound, Str("\n\tremainder of line flushed\n"));
+          break;
+        }
+      }
+      e->p2orig = e->p[2];
+      e->p3orig = e->p[3];
+      e->c.extra = NULL;
+      break;
+    case 'e':
+      e->opcod = 'e';
+      e->pcnt = 0;
+      return 1;
+    default:
+      if (!csound->warped) goto unwarped;
+      e->opcod = r->opcod;
+      csound->Free(csound, e->c.extra);
+      e->c.extra = NULL;
+      pp = &e->p[0];
+      plim = &e->p[PMAX];
+      if (v < vend) *++pp = *v++;                       /* p1      */
+      if (v < vend) e->p2orig = *v++;                   /* p2 orig */
+      if (v < vend) *++pp = *v++;                       /* p2 warp */
+      if (v < vend) e->p3orig = *v++;                   /* p3 orig */
+      if (v < vend) *++pp = *v++;                       /* p3 warp */
+      while (v < vend) {                                /* p4....  */
+        *++pp = *v++;
+        if (pp >= plim) {
+          /* as rdscor(): extra[0] counts p[PMAX] and what follows */
+          int32 c = (int32) (vend - v) + 1;
+          e->c.extra = (MYFLT*) csound->Malloc(csound, sizeof(MYFLT)*(c + 1));
+          e->c.extra[0] = (MYFLT) c;
+          e->c.extra[1] = *pp;
+          memcpy(&e->c.extra[2], v, (c - 1) * sizeof(MYFLT));
+          break;
+        }
+      }
+    }
+    if (!csound->csoundIsScorePending_ && e->opcod == 'i') {
+      /* FIXME: should pause and not mute */
+      e->opcod = 'f'; e->p[1] = FL(0.0); e->pcnt = 2; e->scnt = 0;
+      return 1;
+    }
+    e->pcnt = pp - &e->p[0];                   /* count the pfields */
+    if (UNLIKELY(e->pcnt>=PMAX && e->c.extra != NULL))
+      e->pcnt += e->c.extra[0];                /* and overflow fields */
+    if (r->scnt) {              /* strings are shared, not copied */
+      e->strarg = scobin_strings(bin, r);
+      e->scnt = r->scnt;
+      if (bin != csound->scobin) {      /* but a merged batch is reused */
+        size_t  len = 0;
+        int     i;
+        for (i = 0; i < r->scnt; i++)
+          len += strlen(e->strarg + len) + 1;
+        e->strarg = memcpy(csound->Malloc(csound, len), e->strarg, len);
+      }
+    }
+    else { e->strarg = NULL; e->scnt = 0; }
+    return 1;
+}
+
 int rdscor(CSOUND *csound, EVTBLK *e) /* read next score-line from scorefile */
                                       /*  & maintain section warped status   */
 {                                     /*      presumes good format if warped */
@@ -144,6 +235,8 @@ int rdscor(CSOUND *csound, EVTBLK *e) /* read next score-line from scorefile */
     int     c;
 
     e->pinstance = NULL;
+    if (csound->scobin != NULL)         /* sorted to binary records */
+      return rdscobin(csound, e);
     if (csound->scstr == NULL ||
         csound->scstr->body[0] == '\0') {   /* if no concurrent scorefile  */
       e->opcod = 'f';             /*     return an 'f 0 3600'    */
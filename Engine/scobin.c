@@ -0,0 +1,438 @@
+/*
+    scobin.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "csoundCore.h"                                  /*    SCOBIN.C  */
+#include "scobin.h"
+
+#define SCOBIN_MAGIC    "CSSCOBIN"
+#define SCOBIN_VERSION  (1)
+
+struct scobin_s {
+    char        *body;          /* records */
+    size_t      len, size, pos;
+    char        *pool;          /* string blocks */
+    size_t      poolLen, poolSize;
+    uint32_t    *index;         /* pool offset + 1 of each block, hashed */
+    uint32_t    indexSize, indexCount;
+    int32_t     nrecs;
+    size_t      last;           /* offset of the last record */
+    /* the line being written */
+    int         opcod;          /* 0 at the start of a line */
+    MYFLT       *vals;
+    int32_t     nvals, valsSize;
+    char        *tok;           /* characters of the current p-field */
+    int32_t     tokLen, tokSize;
+    int         inStr, esc, bad;
+    char        *sbuf;          /* strings of the line */
+    int32_t     sLen, sSize, scnt;
+};
+
+typedef struct {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    flt_size;       /* sizeof(MYFLT) */
+    uint32_t    byte_order;     /* 0x01020304 as written */
+    uint32_t    nrecs;
+    uint64_t    len, poolLen;
+} SCOBIN_HDR;
+
+SCOBIN *scobin_create(CSOUND *csound)
+{
+    SCOBIN *b = (SCOBIN *) csound->Calloc(csound, sizeof(SCOBIN));
+    b->size = 65536;
+    b->body = (char *) csound->Malloc(csound, b->size);
+    return b;
+}
+
+void scobin_destroy(CSOUND *csound, SCOBIN **bb)
+{
+    SCOBIN *b = *bb;
+    if (b == NULL) return;
+    csound->Free(csound, b->body);
+    csound->Free(csound, b->pool);
+    csound->Free(csound, b->index);
+    csound->Free(csound, b->vals);
+    csound->Free(csound, b->tok);
+    csound->Free(csound, b->sbuf);
+    csound->Free(csound, b);
+    *bb = NULL;
+}
+
+static void *grow(CSOUND *csound, void *p, int32_t *size, size_t need,
+                  size_t elsize)
+{
+    if (need > (size_t) *size) {
+      int32_t n = (*size ? *size : 64);
+      while ((size_t) n < need) n <<= 1;
+      p = csound->ReAlloc(csound, p, n * elsize);
+      *size = n;
+    }
+    return p;
+}
+
+static uint32_t str_hash(const char *s, int32_t len)
+{
+    uint32_t h = 2166136261u;
+    while (len--)
+      h = (h ^ (unsigned char) *s++) * 16777619u;
+    return h;
+}
+
+/* offset + 1 of an identical block in the pool, adding it if new */
+static uint32_t intern(CSOUND *csound, SCOBIN *b, const char *s, int32_t len)
+{
+    uint32_t i, mask;
+
+    if (b->indexCount * 2 >= b->indexSize) {
+      uint32_t *old = b->index, oldSize = b->indexSize;
+      b->indexSize = (oldSize ? oldSize << 1 : 256);
+      b->index = (uint32_t *) csound->Calloc(csound,
+                                             b->indexSize * sizeof(uint32_t));
+      mask = b->indexSize - 1;
+      for (i = 0; i < oldSize; i++)
+        if (old[i]) {
+          const char *t = b->pool + old[i] - 1;
+          uint32_t j = str_hash(t, *(const int32_t *) (t - sizeof(int32_t)))
+                       & mask;
+          while (b->index[j]) j = (j + 1) & mask;
+          b->index[j] = old[i];
+        }
+      csound->Free(csound, old);
+    }
+    mask = b->indexSize - 1;
+    for (i = str_hash(s, len) & mask; b->index[i]; i = (i + 1) & mask) {
+      const char *t = b->pool + b->index[i] - 1;
+      if (*(const int32_t *) (t - sizeof(int32_t)) == len &&
+          memcmp(t, s, len) == 0)
+        return b->index[i];
+    }
+    /* each block is preceded by its length, aligned for that */
+    {
+      size_t off = (b->poolLen + sizeof(int32_t) + 3) & ~(size_t) 3;
+      size_t need = off + len + 1;
+      if (need > b->poolSize) {
+        size_t n = (b->poolSize ? b->poolSize : 4096);
+        while (n < need) n <<= 1;
+        b->pool = (char *) csound->ReAlloc(csound, b->pool, n);
+        b->poolSize = n;
+      }
+      *(int32_t *) (b->pool + off - sizeof(int32_t)) = len;
+      memcpy(b->pool + off, s, len);
+      b->pool[off + len] = '\0';
+      b->poolLen = need;
+      b->index[i] = (uint32_t) off + 1;
+      b->indexCount++;
+      return b->index[i];
+    }
+}
+
+static void push_val(CSOUND *csound, SCOBIN *b, MYFLT x)
+{
+    b->vals = (MYFLT *) grow(csound, b->vals, &b->valsSize, b->nvals + 1,
+                             sizeof(MYFLT));
+    b->vals[b->nvals++] = x;
+}
+
+/* convert a p-field as scanflt() in rdscor.c would */
+static void end_token(CSOUND *csound, SCOBIN *b)
+{
+    char    *t = b->tok;
+    int32_t n = b->tokLen;
+
+    b->tokLen = 0;
+    b->inStr = b->esc = 0;
+    if (n == 0 || b->bad)
+      return;
+    t[n] = '\0';
+    if (*t == '"') {
+      int32_t i;
+      union {
+        MYFLT d;
+        int32 i;
+      } ch;
+      b->sbuf = (char *) grow(csound, b->sbuf, &b->sSize, b->sLen + n + 1, 1);
+      for (i = 1; i < n && t[i] != '"'; i++) {
+        char c = t[i];
+        if (c == '\\' && i + 1 < n) {
+          c = t[++i];
+          switch (c) {
+          case 'a': c = '\a'; break;
+          case 'b': c = '\b'; break;
+          case 'f': c = '\f'; break;
+          case 'n': c = '\n'; break;
+          case 'r': c = '\r'; break;
+          case 't': c = '\t'; break;
+          case 'v': c = '\v'; break;
+          }
+        }
+        b->sbuf[b->sLen++] = c;
+      }
+      b->sbuf[b->sLen++] = '\0';
+      ch.d = SSTRCOD; ch.i += b->scnt++;
+      push_val(csound, b, ch.d);
+      return;
+    }
+    if (UNLIKELY(!((*t >= '0' && *t <= '9') ||
+                   *t == '+' || *t == '-' || *t == '.'))) {
+      csound->Message(csound,
+                      Str("ERROR: illegal character %c(%.2x) in scoreline: "),
+                      *t, *t);
+      csound->Message(csound, "%s", t);
+      csound->Message(csound, Str("\n\tremainder of line flushed\n"));
+      b->bad = 1;
+      return;
+    }
+    push_val(csound, b, (MYFLT) atof(t));
+}
+
+static void end_line(CSOUND *csound, SCOBIN *b)
+{
+    SCOBIN_REC  *r;
+    size_t      need;
+
+    end_token(csound, b);
+    need = sizeof(SCOBIN_REC) + (size_t) b->nvals * sizeof(MYFLT);
+    if (b->len + need > b->size) {
+      while (b->len + need > b->size) b->size <<= 1;
+      b->body = (char *) csound->ReAlloc(csound, b->body, b->size);
+    }
+    r = (SCOBIN_REC *) (b->body + b->len);
+    memset(r, 0, sizeof(SCOBIN_REC));
+    r->opcod = (char) b->opcod;
+    r->nvals = b->nvals;
+    if (b->scnt) {
+      r->scnt = b->scnt;
+      r->str = intern(csound, b, b->sbuf, b->sLen);
+    }
+    if (b->nvals)
+      memcpy(r + 1, b->vals, b->nvals * sizeof(MYFLT));
+    b->last = b->len;
+    b->len += need;
+    b->nrecs++;
+    b->opcod = 0;
+    b->nvals = b->sLen = b->scnt = 0;
+    b->bad = 0;
+}
+
+void scobin_putc(CSOUND *csound, SCOBIN *b, int c)
+{
+    if (b->opcod == 0) {                /* opcode starts each line */
+      if (c != ' ' && c != '\t' && c != '\n')
+        b->opcod = c;
+      return;
+    }
+    if (b->inStr) {                     /* quoted string: up to the '"' */
+      if (b->esc)
+        b->esc = 0;
+      else if (c == '\\')
+        b->esc = 1;
+      else if (c == '"')
+        b->inStr = 0;
+    }
+    else if (c == '\n') {
+      end_line(csound, b);
+      return;
+    }
+    else if (c == ' ' || c == '\t') {
+      end_token(csound, b);
+      return;
+    }
+    else if (c == '"' && b->tokLen == 0)
+      b->inStr = 1;
+    b->tok = (char *) grow(csound, b->tok, &b->tokSize, b->tokLen + 2, 1);
+    b->tok[b->tokLen++] = (char) c;
+}
+
+void scobin_puts(CSOUND *csound, SCOBIN *b, const char *s)
+{
+    while (*s)
+      scobin_putc(csound, b, *s++);
+}
+
+void scobin_putflt(CSOUND *csound, SCOBIN *b, MYFLT x)
+{
+    end_token(csound, b);
+    if (!b->bad)
+      push_val(csound, b, x);
+}
+
+void scobin_putrec(CSOUND *csound, SCOBIN *b, int opcod, MYFLT x)
+{
+    if (b->opcod != 0)
+      end_line(csound, b);
+    b->opcod = opcod;
+    push_val(csound, b, x);
+    end_line(csound, b);
+}
+
+void scobin_append(CSOUND *csound, SCOBIN *b, SCOBIN *src)
+{
+    size_t  pos;
+
+    if (b->opcod != 0)
+      end_line(csound, b);
+    if (b->len + src->len > b->size) {
+      while (b->len + src->len > b->size) b->size <<= 1;
+      b->body = (char *) csound->ReAlloc(csound, b->body, b->size);
+    }
+    for (pos = 0; pos < src->len; ) {
+      const SCOBIN_REC *r = (const SCOBIN_REC *) (src->body + pos);
+      size_t  need = sizeof(SCOBIN_REC) + (size_t) r->nvals * sizeof(MYFLT);
+      SCOBIN_REC *d = (SCOBIN_REC *) (b->body + b->len);
+      memcpy(d, r, need);
+      if (r->str) {                     /* the pool of b differs */
+        const char *t = src->pool + r->str - 1;
+        d->str = intern(csound, b, t, *(const int32_t *) (t - sizeof(int32_t)));
+      }
+      b->last = b->len;
+      b->len += need;
+      b->nrecs++;
+      pos += need;
+    }
+}
+
+int32_t scobin_count(SCOBIN *b)
+{
+    return b->nrecs;
+}
+
+int scobin_last_opcod(SCOBIN *b)
+{
+    return b->nrecs ? ((SCOBIN_REC *) (b->body + b->last))->opcod : 0;
+}
+
+void scobin_reset(SCOBIN *b)
+{
+    b->len = b->pos = 0;
+    b->nrecs = 0;
+    b->opcod = 0;
+    b->nvals = b->tokLen = b->sLen = b->scnt = 0;
+    b->inStr = b->esc = b->bad = 0;
+    b->poolLen = 0;
+    if (b->index != NULL)
+      memset(b->index, 0, b->indexSize * sizeof(uint32_t));
+    b->indexCount = 0;
+}
+
+void scobin_flush(CSOUND *csound, SCOBIN *b)
+{
+    if (b->opcod != 0)
+      end_line(csound, b);
+    csound->Free(csound, b->index); b->index = NULL;
+    b->indexSize = b->indexCount = 0;
+    csound->Free(csound, b->vals); b->vals = NULL;
+    csound->Free(csound, b->tok); b->tok = NULL;
+    csound->Free(csound, b->sbuf); b->sbuf = NULL;
+    b->valsSize = b->tokSize = b->sSize = 0;
+    b->pos = 0;
+}
+
+const SCOBIN_REC *scobin_next(SCOBIN *b)
+{
+    const SCOBIN_REC *r;
+    if (b->pos >= b->len)
+      return NULL;
+    r = (const SCOBIN_REC *) (b->body + b->pos);
+    b->pos += sizeof(SCOBIN_REC) + (size_t) r->nvals * sizeof(MYFLT);
+    return r;
+}
+
+char *scobin_strings(SCOBIN *b, const SCOBIN_REC *r)
+{
+    return r->str ? b->pool + r->str - 1 : NULL;
+}
+
+void scobin_rewind(SCOBIN *b)
+{
+    b->pos = 0;
+}
+
+int scobin_save(CSOUND *csound, SCOBIN *b, const char *name)
+{
+    SCOBIN_HDR  h;
+    FILE        *f;
+    int         ok;
+
+    if (UNLIKELY((f = fopen(name, "wb")) == NULL)) {
+      csound->Warning(csound, Str("cannot write sorted score %s"), name);
+      return NOTOK;
+    }
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SCOBIN_MAGIC, 8);
+    h.version = SCOBIN_VERSION;
+    h.flt_size = (uint32_t) sizeof(MYFLT);
+    h.byte_order = 0x01020304;
+    h.nrecs = (uint32_t) b->nrecs;
+    h.len = b->len;
+    h.poolLen = b->poolLen;
+    ok = (fwrite(&h, sizeof(h), 1, f) == 1 &&
+          fwrite(b->body, 1, b->len, f) == b->len &&
+          fwrite(b->pool, 1, b->poolLen, f) == b->poolLen);
+    if (fclose(f) != 0) ok = 0;
+    if (UNLIKELY(!ok)) {
+      csound->Warning(csound, Str("error writing sorted score %s"), name);
+      return NOTOK;
+    }
+    csoundNotifyFileOpened(csound, name, CSFTYPE_SCORE_OUT, 1, 0);
+    return OK;
+}
+
+SCOBIN *scobin_load(CSOUND *csound, const char *name)
+{
+    SCOBIN_HDR  h;
+    SCOBIN      *b;
+    FILE        *f;
+
+    if (UNLIKELY((f = fopen(name, "rb")) == NULL)) {
+      csound->ErrorMsg(csound, Str("cannot open sorted score %s"), name);
+      return NULL;
+    }
+    if (UNLIKELY(fread(&h, sizeof(h), 1, f) != 1 ||
+                 memcmp(h.magic, SCOBIN_MAGIC, 8) != 0 ||
+                 h.version != SCOBIN_VERSION)) {
+      csound->ErrorMsg(csound, Str("%s is not a sorted score"), name);
+      fclose(f);
+      return NULL;
+    }
+    if (UNLIKELY(h.flt_size != sizeof(MYFLT) || h.byte_order != 0x01020304)) {
+      csound->ErrorMsg(csound, Str("sorted score %s was written by a "
+                                   "different build of Csound"), name);
+      fclose(f);
+      return NULL;
+    }
+    b = (SCOBIN *) csound->Calloc(csound, sizeof(SCOBIN));
+    b->size = b->len = (size_t) h.len;
+    b->body = (char *) csound->Malloc(csound, b->size + 1);
+    b->poolSize = b->poolLen = (size_t) h.poolLen;
+    if (b->poolLen)
+      b->pool = (char *) csound->Malloc(csound, b->poolSize);
+    b->nrecs = (int32_t) h.nrecs;
+    if (UNLIKELY(fread(b->body, 1, b->len, f) != b->len ||
+                 fread(b->pool, 1, b->poolLen, f) != b->poolLen)) {
+      csound->ErrorMsg(csound, Str("sorted score %s is truncated"), name);
+      fclose(f);
+      scobin_destroy(csound, &b);
+      return NULL;
+    }
+    fclose(f);
+    csoundNotifyFileOpened(csound, name, CSFTYPE_SCORE, 0, 0);
+    return b;
+}
@@ -23,15 +23,264 @@
 
 #include "csoundCore.h"                                  /*   SCSORT.C  */
 #include "corfile.h"
+#include "scobin.h"
+#include "sortrun.h"
 #include <ctype.h>
 
 extern void sort(CSOUND*);
+extern void sortsect(CSOUND*, SRTBLK **frstbp);
 extern void twarp(CSOUND*);
+extern void twarpsect(CSOUND*, SRTBLK *bp, void **tseg, void **tpsave);
 extern void swritestr(CSOUND*, CORFIL *sco, int first);
+extern void swritebin(CSOUND*, SCOBIN *bin);
+extern void swritesect(CSOUND*, SRTBLK *bp, CORFIL *sco, SCOBIN *bin,
+                       int first, int sectcnt);
 extern void sfree(CSOUND *csound);
 //extern void sread_init(CSOUND *csound);
 extern int  sread(CSOUND *csound);
 
+/*
+  With --score-sort-threads, sections are sorted, warped and written on
+  other threads.  sread() still reads the sections in turn, since macros
+  and carried p-fields depend on what came before, but the section it
+  returns is then independent: its blocks are handed over with the memory
+  sread() read them into, and written to a buffer of the section.  The
+  buffers are added to the sorted score in section order, and sread() is
+  held back when too many sections are waiting for that.
+  A section with '~' ramps, whose random values must be drawn in score
+  order, and a section sorted in runs (sortrun.c) are written by the
+  reading thread as before, but to their buffer all the same.
+*/
+
+#define SCPAR_AHEAD (4)                 /* sections in flight per thread */
+
+typedef struct {
+    SRTBLK  *frstbp;
+    char    *mem;                       /* sread() memory of the section */
+    CORFIL  *sco;                       /* where it is written: text, */
+    SCOBIN  *bin;                       /*   or binary records */
+    int     sectcnt;
+    int     done;
+} SCSECT;
+
+typedef struct {
+    CSOUND  *csound;
+    SCSECT  *sect;                      /* ring of sections in flight */
+    int     size;
+    int     head, next, tail;           /* next section to add to the
+                                           score, to sort, to read */
+    int     first, quit;
+    void    *mutex;                     /* guards next, tail, quit, done */
+    void    *work, *written;            /* thread locks signalled when there
+                                           is a section to sort, and when
+                                           one has been written */
+    void    **threads;
+    int     nthreads;
+} SCPAR;
+
+static uintptr_t scpar_thread(void *arg)
+{
+    SCPAR   *p = (SCPAR *) arg;
+    CSOUND  *csound = p->csound;
+    void    *tseg = NULL, *tpsave = NULL;
+    SCSECT  *s;
+    int     more;
+
+    for (;;) {
+      s = NULL;
+      csoundLockMutex(p->mutex);
+      while (p->next < p->tail && p->sect[p->next % p->size].done)
+        p->next++;                      /* written by the reading thread */
+      if (p->next < p->tail)
+        s = &p->sect[p->next++ % p->size];
+      else if (p->quit) {
+        csoundUnlockMutex(p->mutex);
+        break;
+      }
+      more = (p->next < p->tail);
+      csoundUnlockMutex(p->mutex);
+      if (more)                         /* pass the work on */
+        csoundNotifyThreadLock(p->work);
+      if (s == NULL) {
+        csoundWaitThreadLockNoTimeout(p->work);
+        continue;
+      }
+      sortsect(csound, &s->frstbp);
+      twarpsect(csound, s->frstbp, &tseg, &tpsave);
+      swritesect(csound, s->frstbp, s->sco, s->bin, p->first, s->sectcnt);
+      csound->Free(csound, s->mem);
+      s->mem = NULL;
+      csoundLockMutex(p->mutex);
+      s->done = 1;
+      csoundUnlockMutex(p->mutex);
+      csoundNotifyThreadLock(p->written);
+    }
+    csound->Free(csound, tseg);
+    csoundNotifyThreadLock(p->work);    /* the next thread sees quit too */
+    return 0;
+}
+
+static SCPAR *scpar_create(CSOUND *csound, int nthreads, int first, int binary)
+{
+    SCPAR   *p = (SCPAR *) csound->Calloc(csound, sizeof(SCPAR));
+    int     i;
+
+    p->csound = csound;
+    p->first = first;
+    p->size = nthreads * SCPAR_AHEAD;
+    p->sect = (SCSECT *) csound->Calloc(csound, p->size * sizeof(SCSECT));
+    for (i = 0; i < p->size; i++) {
+      if (binary)
+        p->sect[i].bin = scobin_create(csound);
+      else
+        p->sect[i].sco = corfile_create_w(csound);
+    }
+    p->mutex = csoundCreateMutex(0);
+    p->work = csoundCreateThreadLock();
+    p->written = csoundCreateThreadLock();
+    p->threads = (void **) csound->Calloc(csound, nthreads * sizeof(void *));
+    for (i = 0; i < nthreads; i++) {
+      if (UNLIKELY((p->threads[i] =
+                    csoundCreateThread(scpar_thread, (void *) p)) == NULL))
+        break;
+      p->nthreads++;
+    }
+    if (UNLIKELY(p->nthreads == 0)) {
+      csound->Warning(csound,
+                      Str("cannot start score sort threads, sorting in turn"));
+      /* every section is then written by the reading thread */
+    }
+    return p;
+}
+
+/* add the sections written at the head of the ring to the score; if wait
+   is non-zero, wait for the first of them */
+static void scpar_write(CSOUND *csound, SCPAR *p, CORFIL *sco, SCOBIN *bin,
+                        int wait)
+{
+    SCSECT  *s;
+    int     done;
+
+    while (p->head < p->tail) {
+      s = &p->sect[p->head % p->size];
+      csoundLockMutex(p->mutex);
+      done = s->done;
+      csoundUnlockMutex(p->mutex);
+      if (!done) {
+        if (!wait)
+          return;
+        csoundWaitThreadLockNoTimeout(p->written);
+        continue;
+      }
+      if (bin != NULL) {
+        scobin_append(csound, bin, s->bin);
+        scobin_reset(s->bin);
+      }
+      else {
+        corfile_puts(csound, corfile_body(s->sco), sco);
+        corfile_reset(s->sco);
+      }
+      p->head++;
+      wait = 0;
+    }
+}
+
+/* whether swrite() would draw random numbers for the section ('~' ramps) */
+static int uses_random(SRTBLK *bp)
+{
+    char    *p, c;
+    int     n;
+
+    for ( ; bp != NULL; bp = bp->nxtblk) {
+      p = bp->text;
+      c = *p;
+      if (c != 'i' && c != 'f' && c != 'q' && c != 'd' && c != 'a')
+        continue;
+      p += 2;
+      for (n = 1; (c = *p) != LF && c != '\0'; n++) {
+        if (n > 3 && c == '~')
+          return 1;
+        if (c == '"') {
+          for (p++; *p != '"' && *p != '\0'; p++)
+            if (*p == '\\' && p[1] != '\0') p++;
+          if (*p != '\0') p++;
+        }
+        while (*p != SP && *p != LF && *p != '\0') p++;
+        if (*p == SP) p++;
+      }
+    }
+    return 0;
+}
+
+/* hand the section sread() has just read to the threads, or write it
+   here if it cannot be */
+static void scpar_section(CSOUND *csound, SCPAR *p, CORFIL *sco, SCOBIN *bin)
+{
+    SCSECT  *s;
+
+    if (!sortrun_spilled(csound) &&
+        csound->frstbp->text[0] == 's') // ignore empty segment
+      return;
+    while (p->tail - p->head >= p->size)  /* too far ahead */
+      scpar_write(csound, p, sco, bin, 1);
+    s = &p->sect[p->tail % p->size];
+    s->sectcnt = csound->sectcnt;
+    s->done = 0;
+    if (sortrun_spilled(csound)) {      // merged as it is performed
+      sortrun_section(csound, s->bin);
+      s->done = 1;
+    }
+    else if (p->nthreads == 0 || uses_random(csound->frstbp)) {
+      sort(csound);
+      twarp(csound);
+      swritesect(csound, csound->frstbp, s->sco, s->bin, p->first,
+                 s->sectcnt);
+      s->done = 1;
+    }
+    else {                              /* sread() gets new memory */
+      s->frstbp = csound->frstbp;
+      s->mem = csound->sread.curmem;
+      csound->sread.curmem = NULL;
+      csound->frstbp = NULL;
+    }
+    csoundLockMutex(p->mutex);
+    p->tail++;
+    csoundUnlockMutex(p->mutex);
+    if (!s->done)
+      csoundNotifyThreadLock(p->work);
+    scpar_write(csound, p, sco, bin, 0);
+}
+
+/* write the sections still in flight and stop the threads */
+static void scpar_destroy(CSOUND *csound, SCPAR **pp, CORFIL *sco,
+                          SCOBIN *bin)
+{
+    SCPAR   *p = *pp;
+    int     i;
+
+    while (p->head < p->tail)
+      scpar_write(csound, p, sco, bin, 1);
+    csoundLockMutex(p->mutex);
+    p->quit = 1;
+    csoundUnlockMutex(p->mutex);
+    csoundNotifyThreadLock(p->work);
+    for (i = 0; i < p->nthreads; i++)
+      csoundJoinThread(p->threads[i]);
+    for (i = 0; i < p->size; i++) {
+      if (p->sect[i].bin != NULL)
+        scobin_destroy(csound, &p->sect[i].bin);
+      if (p->sect[i].sco != NULL)
+        corfile_rm(csound, &p->sect[i].sco);
+    }
+    csoundDestroyThreadLock(p->written);
+    csoundDestroyThreadLock(p->work);
+    csoundDestroyMutex(p->mutex);
+    csound->Free(csound, p->threads);
+    csound->Free(csound, p->sect);
+    csound->Free(csound, p);
+    *pp = NULL;
+}
+
 /* called from smain.c or some other main */
 /* reads,sorts,timewarps each score sect in turn */
 
@@ -41,6 +290,7 @@ char *scsortstr(CSOUND *csound, CORFIL *scin)
     int     n;
     int     first = 0;
     CORFIL *sco;
+    SCPAR   *par = NULL;
 
     csound->scoreout = NULL;
     if (csound->scstr == NULL && (csound->engineStatus & CS_STATE_COMP) == 0) {
@@ -50,8 +300,14 @@ char *scsortstr(CSOUND *csound, CORFIL *scin)
     else sco = corfile_create_w(csound);
     csound->sectcnt = 0;
     sread_initstr(csound, scin);
+    if (csound->oparms->scoreSortThreads > 0)
+      par = scpar_create(csound, csound->oparms->scoreSortThreads, first, 0);
 
     while ((n = sread(csound)) > 0) {
+      if (par != NULL) {                // sorted on other threads
+        scpar_section(csound, par, sco, NULL);
+        continue;
+      }
       if (csound->frstbp->text[0] == 's') { // ignore empty segment
         // should this free memory?
         //printf("repeated 's'\n");
@@ -62,6 +318,8 @@ char *scsortstr(CSOUND *csound, CORFIL *scin)
       swritestr(csound, sco, first);
       //printf("sorted: >>>%s<<<\n", sco->body);
     }
+    if (par != NULL)
+      scpar_destroy(csound, &par, sco, NULL);
     //printf("**** first = %d body = >>%s<<\n", first, sco->body);
     if (first) {
       int i = 0;
@@ -85,3 +343,65 @@ char *scsortstr(CSOUND *csound, CORFIL *scin)
     }
 }
 
+/* As scsortstr(), for the score to be performed, but written as binary
+   records to csound->scobin for rdscor(); csound->scstr is left empty.
+   Falls back to scsortstr() when the sorted text is needed: a score given
+   after the first compilation (sent as real-time events), --no-binary-score,
+   keeping score.srt, extracting, or cscore.
+   A section larger than --score-sort-memory is sorted in runs through a
+   temporary file and merged as it is performed (sortrun.c), unless the
+   sorted score is to be saved.  Sections are sorted on other threads as
+   in scsortstr(). */
+char *scsortbin(CSOUND *csound, CORFIL *scin)
+{
+    int     n;
+    SCOBIN  *bin;
+    SCPAR   *par = NULL;
+
+    if (csound->scstr != NULL || (csound->engineStatus & CS_STATE_COMP) != 0 ||
+        csound->oparms->noBinaryScore || csound->oparms->usingcscore ||
+        csound->keep_tmp || csound->xfilename != NULL)
+      return scsortstr(csound, scin);
+    csound->scoreout = NULL;
+    csound->scstr = corfile_create_w(csound);
+    scobin_destroy(csound, &csound->scobin);
+    bin = csound->scobin = scobin_create(csound);
+    sortrun_destroy(csound, &csound->sortrun);
+    if (csound->oparms->scoreSortMem > 0 && csound->scobin_out == NULL)
+      csound->sortrun =
+        sortrun_create(csound, (size_t) csound->oparms->scoreSortMem << 20);
+    csound->sectcnt = 0;
+    sread_initstr(csound, scin);
+    if (csound->oparms->scoreSortThreads > 0)
+      par = scpar_create(csound, csound->oparms->scoreSortThreads, 1, 1);
+
+    while ((n = sread(csound)) > 0) {
+      if (par != NULL) {                // sorted on other threads
+        scpar_section(csound, par, NULL, bin);
+        continue;
+      }
+      if (sortrun_spilled(csound)) {    // merged as it is performed
+        sortrun_section(csound, bin);
+        continue;
+      }
+      if (csound->frstbp->text[0] == 's') // ignore empty segment
+        continue;
+      sort(csound);
+      twarp(csound);
+      swritebin(csound, bin);
+    }
+    if (par != NULL)
+      scpar_destroy(csound, &par, NULL, bin);
+    if (scobin_count(bin) == 1 && scobin_last_opcod(bin) == 'e') {
+      scobin_reset(bin);
+      scobin_puts(csound, bin, "f0 800000000000.0\ne\n"); /* ~25367 years */
+    }
+    else scobin_puts(csound, bin, "e\n");
+    scobin_flush(csound, bin);
+    corfile_flush(csound, csound->scstr);
+    sortrun_done(csound);
+    sfree(csound);
+    if (csound->scobin_out != NULL)
+      scobin_save(csound, bin, csound->scobin_out);
+    return NULL;
+}
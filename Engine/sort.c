@@ -232,53 +232,60 @@ static void smoothsort(SRTBLK *A[], const int N)
 }
 
 
-void sort(CSOUND *csound)
+/* set the precedence used by ordering(); returns 0 for a block that is
+   not sorted */
+static int setpreced(CSOUND *csound, SRTBLK *bp)
+{
+    switch ((int) bp->text[0]) {
+    case 'd':
+    case 'i':
+      if (bp->insno < 0)
+        bp->preced = 'b';
+      else bp->preced = 'd';
+      break;
+    case 'f':
+      bp->preced = 'c';
+      break;
+    case 'a':
+      bp->preced = 'e';
+      break;
+    case 'e':
+      //        bp->newp2 ;
+    case 'q':
+    case 'w':
+    case 't':
+    case 's':
+      bp->preced = 'a';
+      break;
+    case 'x':
+      return 0;
+    case -1:
+    case 'y':
+      break;
+    default:
+      csound->Message(csound, Str("sort: illegal opcode %c(%.2x)\n"),
+                              bp->text[0], bp->text[0]);
+      break;
+    }
+    return 1;
+}
+
+/* sort the section from *frstbp, relinking its blocks and setting *frstbp
+   to the first in order */
+void sortsect(CSOUND *csound, SRTBLK **frstbp)
 {
     SRTBLK *bp;
     SRTBLK **A;
     int i, n = 0;
-    if (UNLIKELY((bp = csound->frstbp) == NULL))
+    if (UNLIKELY((bp = *frstbp) == NULL))
       return;
     do {
-      n++;                      /* Need to count to alloc the array */
-      switch ((int) bp->text[0]) {
-      case 'd':
-      case 'i':
-        if (bp->insno < 0)
-          bp->preced = 'b';
-        else bp->preced = 'd';
-        break;
-      case 'f':
-        bp->preced = 'c';
-        break;
-      case 'a':
-        bp->preced = 'e';
-        break;
-      case 'e':
-        //        bp->newp2 ;
-      case 'q':
-      case 'w':
-      case 't':
-      case 's':
-        bp->preced = 'a';
-        break;
-      case 'x':
-        n--;
-        break;
-      case -1:
-      case 'y':
-        break;
-      default:
-        csound->Message(csound, Str("sort: illegal opcode %c(%.2x)\n"),
-                                bp->text[0], bp->text[0]);
-        break;
-      }
+      n += setpreced(csound, bp); /* Need to count to alloc the array */
     } while ((bp = bp->nxtblk) != NULL);
-
     if (n>1) {
       /* Get a temporary array and populate it */
       A = ((SRTBLK**) csound->Malloc(csound, n*sizeof(SRTBLK*)));
-      bp = csound->frstbp;
+      bp = *frstbp;
       for (i=0; i<n; i++,bp = bp->nxtblk) {
         A[i] = bp;
         if (bp->text[0]=='x') i--; /* try to ignore x opcode */
@@ -288,7 +295,7 @@ void sort(CSOUND *csound)
       else
         smoothsort(A, n);
       /* Relink list in order; first and last different */
-      csound->frstbp = bp = A[0]; bp->prvblk = NULL; bp->nxtblk = A[1];
+      *frstbp = bp = A[0]; bp->prvblk = NULL; bp->nxtblk = A[1];
       for (i=1; i<n-1; i++ ) {
         bp = A[i]; bp->prvblk = A[i-1]; bp->nxtblk = A[i+1];
       }
@@ -298,3 +305,27 @@ void sort(CSOUND *csound)
 
     }
 }
+
+void sort(CSOUND *csound)
+{
+    sortsect(csound, &csound->frstbp);
+}
+
+/* sort an array of blocks in place, in the order of sort(); the blocks are
+   not relinked.  Used for the runs of a section too large to be sorted in
+   memory (sortrun.c), so the array must not hold 'x' blocks. */
+void sortblks(CSOUND *csound, SRTBLK **A, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+      setpreced(csound, A[i]);
+    if (n > 1)
+      smoothsort(A, n);
+}
+
+/* non-zero if block x goes before block y; blocks already have their
+   precedence set by sortblks() */
+int sortorder(SRTBLK *x, SRTBLK *y)
+{
+    return ordering(x, y);
+}
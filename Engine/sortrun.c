@@ -0,0 +1,621 @@
+/*
+    sortrun.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#define _FILE_OFFSET_BITS 64    /* runs of a large score pass 2 GB */
+
+#include "csoundCore.h"                                 /*   SORTRUN.C  */
+#include "scobin.h"
+#include "sortrun.h"
+
+extern void sortblks(CSOUND *, SRTBLK **, int);
+extern int  sortorder(SRTBLK *, SRTBLK *);
+extern int  realtset(CSOUND *, SRTBLK *);
+extern void twarpblk(CSOUND *, SRTBLK *);
+extern void swriteblks(CSOUND *, SRTBLK *, SCOBIN *, int cont);
+
+#define SRT_CARRY   (1)         /* preced of a block kept for carrying only */
+#define SRIN_BUF    (65536)     /* read buffer of each run being merged */
+#define SR_BATCH    (512)       /* blocks merged at a time */
+#define ALIGN8(n)   (((n) + 7) & ~(size_t) 7)
+
+/* long is 32 bits on Windows, so offsets are int64_t and seeks 64 bit */
+#if defined(WIN32) && !defined(__CYGWIN__)
+#  define SR_SEEK(f, pos)   _fseeki64(f, (__int64) (pos), SEEK_SET)
+#else
+#  define SR_SEEK(f, pos)   fseeko(f, (off_t) (pos), SEEK_SET)
+#endif
+
+/* In the file each block is preceded by its size, padded to 8 bytes */
+typedef struct {
+    int32_t     size;
+    int32_t     pad;
+} SRHDR;
+
+typedef struct {
+    int64_t     start, end;     /* bytes of the run in the file */
+} SRUN;
+
+typedef struct {
+    int32_t     frst, nruns;    /* its runs */
+    SRTBLK      *tblk;          /* its t statement, or NULL */
+    SRTBLK      *eblk;          /* the s or e statement ending it, or NULL */
+    size_t      esize;
+} SRSECT;
+
+typedef struct {                /* a run being merged */
+    char        *buf;
+    size_t      size, len, pos; /* of buf, bytes in it, next block */
+    int64_t     next, end;      /* the rest of the run in the file */
+    SRTBLK      *bp;            /* current block, in buf */
+    size_t      bsize;
+} SRIN;
+
+struct sortrun_s {
+    char        *name;          /* the file of runs */
+    FILE        *f;
+    int64_t     flen;
+    size_t      limit;
+    int         reading;        /* set while scsortbin() reads the score */
+    SRUN        *runs;
+    int32_t     nruns, runsSize;
+    SRSECT      *sects;
+    int32_t     nsects, sectsSize;
+    /* the section being read */
+    int32_t     frst;           /* its first run, -1 if none */
+    int         refs;           /* has p-fields referring to other notes */
+    SRTBLK      *tblk;
+    size_t      carryLen;       /* bytes of carry blocks in the arena */
+    SRTBLK      **R, **A, **K;  /* blocks in read order, to sort, to keep */
+    int32_t     Rsize;
+    char        *carry;
+    size_t      carrySize;
+    unsigned char seen[8192];   /* insno already kept */
+    /* the section being merged */
+    SRSECT      *cur;
+    SRIN        *in;
+    int32_t     nin, inSize;
+    int32_t     *heap;
+    int32_t     nheap;
+    int         warp, started, ended;
+    char        *arena;         /* blocks of the batch */
+    size_t      arenaSize;
+    size_t      offs[SR_BATCH + 1];
+    SCOBIN      *batch;
+};
+
+SORTRUN *sortrun_create(CSOUND *csound, size_t limit)
+{
+    SORTRUN *s = (SORTRUN *) csound->Calloc(csound, sizeof(SORTRUN));
+    s->limit = limit;
+    s->reading = 1;
+    s->frst = -1;
+    s->batch = scobin_create(csound);
+    return s;
+}
+
+static void close_sect(CSOUND *csound, SORTRUN *s)
+{
+    int32_t i;
+    for (i = 0; i < s->nin; i++) {
+      csound->Free(csound, s->in[i].buf);
+      s->in[i].buf = NULL;
+    }
+    s->nin = s->nheap = 0;
+    s->cur = NULL;
+    scobin_reset(s->batch);
+}
+
+void sortrun_destroy(CSOUND *csound, SORTRUN **ss)
+{
+    SORTRUN *s = *ss;
+    int32_t i;
+
+    if (s == NULL) return;
+    close_sect(csound, s);
+    if (s->f != NULL) {
+      fclose(s->f);
+      remove(s->name);
+    }
+    csound->Free(csound, s->name);
+    for (i = 0; i < s->nsects; i++) {
+      csound->Free(csound, s->sects[i].tblk);
+      csound->Free(csound, s->sects[i].eblk);
+    }
+    csound->Free(csound, s->tblk);
+    csound->Free(csound, s->runs);
+    csound->Free(csound, s->sects);
+    csound->Free(csound, s->R);
+    csound->Free(csound, s->A);
+    csound->Free(csound, s->K);
+    csound->Free(csound, s->carry);
+    csound->Free(csound, s->in);
+    csound->Free(csound, s->heap);
+    csound->Free(csound, s->arena);
+    scobin_destroy(csound, &s->batch);
+    csound->Free(csound, s);
+    *ss = NULL;
+}
+
+void sortrun_done(CSOUND *csound)
+{
+    SORTRUN *s = csound->sortrun;
+    if (s == NULL) return;
+    s->reading = 0;
+    csound->Free(csound, s->R); s->R = NULL;
+    csound->Free(csound, s->A); s->A = NULL;
+    csound->Free(csound, s->K); s->K = NULL;
+    csound->Free(csound, s->carry); s->carry = NULL;
+    s->Rsize = 0; s->carrySize = 0;
+    if (s->nsects == 0)                 /* nothing was too large */
+      sortrun_destroy(csound, &csound->sortrun);
+}
+
+/* whether swrite() would resolve a p-field of the block from the notes
+   around it in sorted order (np, pp, ramps) */
+static int uses_neighbours(SRTBLK *bp)
+{
+    char    *p = bp->text, c = *p;
+    int     n;
+
+    if (c != 'i' && c != 'f' && c != 'q' && c != 'd' && c != 'a')
+      return 0;
+    p += 2;
+    for (n = 1; (c = *p) != LF && c != '\0'; n++) {
+      if (n > 3 && (c == 'n' || c == 'p' || c == '<' || c == '>' ||
+                    c == '(' || c == ')' || c == '~'))
+        return 1;
+      if (c == '"') {
+        for (p++; *p != '"' && *p != '\0'; p++)
+          if (*p == '\\' && p[1] != '\0') p++;
+        if (*p != '\0') p++;
+      }
+      while (*p != SP && *p != LF && *p != '\0') p++;
+      if (*p == SP) p++;
+    }
+    return 0;
+}
+
+/* bytes of block R[j]: blocks are contiguous in read order */
+static size_t blksize(CSOUND *csound, SORTRUN *s, int32_t j, int32_t n)
+{
+    char *next = (j + 1 < n ? (char *) s->R[j + 1] : csound->sread.nxp);
+    return (size_t) (next - (char *) s->R[j]);
+}
+
+/* index of bp in R, which is in increasing address order */
+static int32_t blkindex(SORTRUN *s, SRTBLK *bp, int32_t n)
+{
+    int32_t lo = 0, hi = n - 1;
+    while (lo < hi) {
+      int32_t mid = (lo + hi) >> 1;
+      if ((uintptr_t) s->R[mid] < (uintptr_t) bp) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+}
+
+static SRTBLK *copyblk(CSOUND *csound, SRTBLK *bp, size_t size)
+{
+    SRTBLK *cp = (SRTBLK *) csound->Calloc(csound, ALIGN8(size));
+    memcpy(cp, bp, size);
+    cp->nxtblk = cp->prvblk = NULL;
+    return cp;
+}
+
+static void open_file(CSOUND *csound, SORTRUN *s)
+{
+    s->name = csoundTmpFileName(csound, ".srt");
+    if (UNLIKELY((s->f = fopen(s->name, "w+b")) == NULL))
+      csound->Die(csound, Str("cannot create score sort file %s"), s->name);
+    s->flen = 0;
+}
+
+/* sort the blocks read so far to a run, leaving the carry blocks; if
+   endp is not NULL the section is complete and its final s or e block is
+   copied to *endp instead.  Returns the number of blocks, in s->R. */
+static int32_t write_run(CSOUND *csound, SORTRUN *s, SRTBLK **endp,
+                         size_t *esize)
+{
+    SRTBLK  *bp;
+    int32_t i, n = 0, na = 0;
+    static const char zeros[8] = { 0 };
+
+    for (bp = csound->frstbp; bp != NULL; bp = bp->nxtblk)
+      n++;
+    if (n > s->Rsize) {
+      s->Rsize = n + (n >> 1);
+      s->R = (SRTBLK **) csound->ReAlloc(csound, s->R,
+                                         s->Rsize * sizeof(SRTBLK *));
+      s->A = (SRTBLK **) csound->ReAlloc(csound, s->A,
+                                         s->Rsize * sizeof(SRTBLK *));
+      s->K = (SRTBLK **) csound->ReAlloc(csound, s->K,
+                                         s->Rsize * sizeof(SRTBLK *));
+    }
+    for (i = 0, bp = csound->frstbp; bp != NULL; bp = bp->nxtblk)
+      s->R[i++] = bp;
+    for (i = 0; i < n; i++) {
+      bp = s->R[i];
+      if (bp->preced == SRT_CARRY || bp->text[0] == 'x')
+        continue;
+      if (endp != NULL && i == n - 1 &&
+          (bp->text[0] == 's' || bp->text[0] == 'e')) {
+        *esize = blksize(csound, s, i, n);
+        *endp = copyblk(csound, bp, *esize);
+        *esize = ALIGN8(*esize);
+        continue;
+      }
+      if (bp->text[0] == 't' && s->tblk == NULL) {
+        /* as twarp(): the first t is used, and written as a w */
+        s->tblk = copyblk(csound, bp, blksize(csound, s, i, n));
+        bp->text[0] = 'w';
+      }
+      if (!s->refs && uses_neighbours(bp))
+        s->refs = 1;
+      s->A[na++] = bp;
+    }
+    if (na == 0)
+      return n;
+    sortblks(csound, s->A, na);
+    if (s->f == NULL)
+      open_file(csound, s);
+    if (s->nruns >= s->runsSize) {
+      s->runsSize = (s->runsSize ? s->runsSize << 1 : 16);
+      s->runs = (SRUN *) csound->ReAlloc(csound, s->runs,
+                                         s->runsSize * sizeof(SRUN));
+    }
+    if (s->frst < 0)
+      s->frst = s->nruns;
+    s->runs[s->nruns].start = s->flen;
+    SR_SEEK(s->f, s->flen);
+    for (i = 0; i < na; i++) {
+      SRHDR   h;
+      size_t  size = blksize(csound, s, blkindex(s, s->A[i], n), n);
+      h.size = (int32_t) ALIGN8(size);
+      h.pad = 0;
+      if (UNLIKELY(fwrite(&h, sizeof(SRHDR), 1, s->f) != 1 ||
+                   fwrite(s->A[i], 1, size, s->f) != size ||
+                   fwrite(zeros, 1, h.size - size, s->f) != h.size - size))
+        csound->Die(csound, Str("error writing score sort file %s"), s->name);
+      s->flen += (int64_t) (sizeof(SRHDR) + h.size);
+    }
+    s->runs[s->nruns++].end = s->flen;
+    return n;
+}
+
+void sortrun_spill(CSOUND *csound)
+{
+    SORTRUN *s = csound->sortrun;
+    SRTBLK  *bp, *last, *prv, *cp, *cprv;
+    int32_t i, n, nk = 0;
+    size_t  len = 0;
+
+    if (!s->reading || (last = csound->sread.bp) == NULL ||
+        (size_t) (csound->sread.nxp - csound->sread.curmem) <
+        s->carryLen + s->limit)
+      return;
+    prv = csound->sread.prvibp;
+    n = write_run(csound, s, NULL, NULL);
+    /* keep what later lines may carry from: the last block, and the
+       latest of each insno, as setprv() finds them */
+    memset(s->seen, 0, sizeof(s->seen));
+    for (bp = last; bp != NULL; bp = bp->prvblk) {
+      uint16_t u = (uint16_t) bp->insno;
+      if (bp == last || bp == prv || !(s->seen[u >> 3] & (1 << (u & 7))))
+        s->K[nk++] = bp;
+      s->seen[u >> 3] |= (unsigned char) (1 << (u & 7));
+    }
+    for (i = nk - 1; i >= 0; i--) {
+      size_t size = blksize(csound, s, blkindex(s, s->K[i], n), n);
+      if (len + ALIGN8(size) > s->carrySize) {
+        s->carrySize = (len + ALIGN8(size)) * 2;
+        s->carry = (char *) csound->ReAlloc(csound, s->carry, s->carrySize);
+      }
+      memcpy(s->carry + len, s->K[i], size);
+      len += ALIGN8(size);
+    }
+    /* and move it to the start of the arena, in read order */
+    memcpy(csound->sread.curmem, s->carry, len);
+    csound->sread.prvibp = NULL;
+    cprv = NULL;
+    cp = (SRTBLK *) csound->sread.curmem;
+    for (i = nk - 1; i >= 0; i--) {
+      size_t size = blksize(csound, s, blkindex(s, s->K[i], n), n);
+      cp->preced = SRT_CARRY;
+      cp->prvblk = cprv;
+      cp->nxtblk = NULL;
+      if (cprv != NULL) cprv->nxtblk = cp;
+      if (s->K[i] == prv) csound->sread.prvibp = cp;
+      cprv = cp;
+      cp = (SRTBLK *) ((char *) cp + ALIGN8(size));
+    }
+    csound->frstbp = (SRTBLK *) csound->sread.curmem;
+    csound->sread.bp = cprv;
+    csound->sread.sp = NULL;
+    csound->sread.nxp = csound->sread.curmem + len;
+    s->carryLen = len;
+}
+
+int sortrun_spilled(CSOUND *csound)
+{
+    return (csound->sortrun != NULL && csound->sortrun->frst >= 0);
+}
+
+static int32_t read_runs(CSOUND *csound, SORTRUN *s, SRSECT *sc,
+                         char **bufp, SRTBLK ***Ap);
+
+void sortrun_section(CSOUND *csound, SCOBIN *bin)
+{
+    SORTRUN *s = csound->sortrun;
+    SRSECT  *sc;
+    SRTBLK  *eblk = NULL;
+    size_t  esize = 0;
+
+    write_run(csound, s, &eblk, &esize);
+    if (s->nsects >= s->sectsSize) {
+      s->sectsSize = (s->sectsSize ? s->sectsSize << 1 : 8);
+      s->sects = (SRSECT *) csound->ReAlloc(csound, s->sects,
+                                            s->sectsSize * sizeof(SRSECT));
+    }
+    sc = &s->sects[s->nsects];
+    sc->frst = s->frst;
+    sc->nruns = s->nruns - s->frst;
+    sc->tblk = s->tblk;
+    sc->eblk = eblk;
+    sc->esize = esize;
+    s->frst = -1;
+    s->tblk = NULL;
+    s->carryLen = 0;
+    csound->Message(csound, Str("score section sorted in %d runs\n"),
+                    (int) sc->nruns);
+    if (!s->refs) {                     /* merged as it is read */
+      scobin_putrec(csound, bin, SCOBIN_RUNS, (MYFLT) s->nsects);
+      s->nsects++;
+    }
+    else {                              /* sorted in memory after all */
+      char    *buf;
+      SRTBLK  **A;
+      int32_t i, n = read_runs(csound, s, sc, &buf, &A);
+      sortblks(csound, A, n);
+      if (eblk != NULL)
+        A[n++] = eblk;
+      for (i = 0; i < n; i++) {
+        A[i]->prvblk = (i > 0 ? A[i - 1] : NULL);
+        A[i]->nxtblk = (i < n - 1 ? A[i + 1] : NULL);
+      }
+      if (sc->tblk != NULL && realtset(csound, sc->tblk))
+        for (i = 0; i < n; i++)
+          twarpblk(csound, A[i]);
+      if (n > 0)
+        swriteblks(csound, A[0], bin, 0);
+      csound->Free(csound, buf);
+      csound->Free(csound, A);
+      csound->Free(csound, sc->tblk);
+      csound->Free(csound, eblk);
+      s->flen = s->runs[sc->frst].start;  /* the runs are not needed */
+      s->nruns = sc->frst;
+      s->refs = 0;
+    }
+}
+
+/* all blocks of the runs of a section, in memory */
+static int32_t read_runs(CSOUND *csound, SORTRUN *s, SRSECT *sc,
+                         char **bufp, SRTBLK ***Ap)
+{
+    SRUN    *r = &s->runs[sc->frst];
+    int64_t total = s->runs[sc->frst + sc->nruns - 1].end - r->start;
+    char    *buf, *p;
+    SRTBLK  **A;
+    int32_t n = 0;
+
+    buf = (char *) csound->Malloc(csound, (size_t) total + 1);
+    SR_SEEK(s->f, r->start);
+    if (UNLIKELY(fread(buf, 1, (size_t) total, s->f) != (size_t) total))
+      csound->Die(csound, Str("error reading score sort file %s"), s->name);
+    for (p = buf; p < buf + total; p += sizeof(SRHDR) + ((SRHDR *) p)->size)
+      n++;
+    A = (SRTBLK **) csound->Malloc(csound, (n + 1) * sizeof(SRTBLK *));
+    n = 0;
+    for (p = buf; p < buf + total; p += sizeof(SRHDR) + ((SRHDR *) p)->size)
+      A[n++] = (SRTBLK *) (p + sizeof(SRHDR));
+    *bufp = buf;
+    *Ap = A;
+    return n;
+}
+
+/* make need bytes of a run available from in->pos */
+static int srin_fill(CSOUND *csound, SORTRUN *s, SRIN *in, size_t need)
+{
+    size_t  rest = in->len - in->pos, n;
+
+    if (rest >= need)
+      return 1;
+    memmove(in->buf, in->buf + in->pos, rest);
+    in->len = rest;
+    in->pos = 0;
+    if (need > in->size) {
+      while (in->size < need) in->size <<= 1;
+      in->buf = (char *) csound->ReAlloc(csound, in->buf, in->size);
+    }
+    n = in->size - rest;
+    if ((int64_t) n > in->end - in->next)
+      n = (size_t) (in->end - in->next);
+    if (n > 0) {
+      SR_SEEK(s->f, in->next);
+      if (UNLIKELY(fread(in->buf + rest, 1, n, s->f) != n)) {
+        csound->ErrorMsg(csound, Str("error reading score sort file %s"),
+                         s->name);
+        in->next = in->end;
+        return 0;
+      }
+      in->next += (int64_t) n;
+      in->len += n;
+    }
+    return (in->len >= need);
+}
+
+static SRTBLK *srin_next(CSOUND *csound, SORTRUN *s, SRIN *in)
+{
+    SRHDR h;
+    if (!srin_fill(csound, s, in, sizeof(SRHDR)))
+      return NULL;
+    memcpy(&h, in->buf + in->pos, sizeof(SRHDR));
+    if (!srin_fill(csound, s, in, sizeof(SRHDR) + h.size))
+      return NULL;
+    in->bp = (SRTBLK *) (in->buf + in->pos + sizeof(SRHDR));
+    in->bsize = (size_t) h.size;
+    in->pos += sizeof(SRHDR) + h.size;
+    return in->bp;
+}
+
+/* the heap orders runs by their current blocks; ties go to the earlier
+   run, so the merge is stable */
+static inline int before(SORTRUN *s, int32_t i, int32_t j)
+{
+    SRTBLK  *a = s->in[i].bp, *b = s->in[j].bp;
+    int     ab = sortorder(a, b), ba = sortorder(b, a);
+    return (ab != ba ? ab : i < j);
+}
+
+static void sift_down(SORTRUN *s, int32_t k)
+{
+    int32_t *h = s->heap, n = s->nheap;
+    for (;;) {
+      int32_t c = 2 * k + 1, t;
+      if (c >= n) break;
+      if (c + 1 < n && before(s, h[c + 1], h[c])) c++;
+      if (!before(s, h[c], h[k])) break;
+      t = h[c]; h[c] = h[k]; h[k] = t;
+      k = c;
+    }
+}
+
+static void open_sect(CSOUND *csound, SORTRUN *s, int32_t k)
+{
+    SRSECT  *sc = &s->sects[k];
+    int32_t i;
+
+    close_sect(csound, s);
+    if (sc->nruns > s->inSize) {
+      s->inSize = sc->nruns;
+      s->in = (SRIN *) csound->ReAlloc(csound, s->in,
+                                       s->inSize * sizeof(SRIN));
+      s->heap = (int32_t *) csound->ReAlloc(csound, s->heap,
+                                            s->inSize * sizeof(int32_t));
+    }
+    for (i = 0; i < sc->nruns; i++) {
+      SRIN *in = &s->in[i];
+      memset(in, 0, sizeof(SRIN));
+      in->size = SRIN_BUF;
+      in->buf = (char *) csound->Malloc(csound, in->size);
+      in->next = s->runs[sc->frst + i].start;
+      in->end = s->runs[sc->frst + i].end;
+      if (srin_next(csound, s, in) != NULL)
+        s->heap[s->nheap++] = i;
+    }
+    s->nin = sc->nruns;
+    for (i = s->nheap / 2 - 1; i >= 0; i--)
+      sift_down(s, i);
+    s->cur = sc;
+    s->warp = (sc->tblk != NULL && realtset(csound, sc->tblk));
+    s->started = s->ended = 0;
+}
+
+/* merge the next batch of blocks of the current section into s->batch;
+   returns 0 at the end of the section */
+static int merge_batch(CSOUND *csound, SORTRUN *s)
+{
+    SRTBLK  *bp;
+    size_t  len = 0;
+    int32_t i, n = 0;
+
+    while (n < SR_BATCH && s->nheap > 0) {
+      SRIN  *in = &s->in[s->heap[0]];
+      if (len + in->bsize > s->arenaSize) {
+        s->arenaSize = (len + in->bsize) * 2;
+        s->arena = (char *) csound->ReAlloc(csound, s->arena, s->arenaSize);
+      }
+      memcpy(s->arena + len, in->bp, in->bsize);
+      s->offs[n++] = len;
+      len += in->bsize;
+      if (srin_next(csound, s, in) == NULL)
+        s->heap[0] = s->heap[--s->nheap];
+      sift_down(s, 0);
+    }
+    if (s->nheap == 0 && !s->ended) {
+      s->ended = 1;
+      if ((bp = s->cur->eblk) != NULL) {
+        size_t size = s->cur->esize;
+        if (len + size > s->arenaSize) {
+          s->arenaSize = (len + size) * 2;
+          s->arena = (char *) csound->ReAlloc(csound, s->arena, s->arenaSize);
+        }
+        memcpy(s->arena + len, bp, size);
+        s->offs[n++] = len;
+        len += size;
+      }
+    }
+    if (n == 0)
+      return 0;
+    /* twarp() the batch, as the tempo map may have been replaced since */
+    if (s->warp && s->started)
+      realtset(csound, s->cur->tblk);
+    for (i = 0; i < n; i++) {
+      bp = (SRTBLK *) (s->arena + s->offs[i]);
+      bp->prvblk = (i > 0 ? (SRTBLK *) (s->arena + s->offs[i - 1]) : NULL);
+      bp->nxtblk = (i < n - 1 ? (SRTBLK *) (s->arena + s->offs[i + 1]) : NULL);
+      if (s->warp)
+        twarpblk(csound, bp);
+    }
+    scobin_reset(s->batch);
+    swriteblks(csound, (SRTBLK *) s->arena, s->batch, s->started);
+    scobin_flush(csound, s->batch);
+    s->started = 1;
+    return 1;
+}
+
+const SCOBIN_REC *sortrun_next(CSOUND *csound, SCOBIN **bin)
+{
+    SORTRUN *s = csound->sortrun;
+    const SCOBIN_REC *r;
+
+    for (;;) {
+      if (s != NULL && s->cur != NULL) {
+        if ((r = scobin_next(s->batch)) != NULL) {
+          *bin = s->batch;
+          return r;
+        }
+        if (merge_batch(csound, s))
+          continue;
+        close_sect(csound, s);
+      }
+      *bin = csound->scobin;
+      if ((r = scobin_next(csound->scobin)) == NULL || r->opcod != SCOBIN_RUNS)
+        return r;
+      if (LIKELY(s != NULL))
+        open_sect(csound, s, (int32_t) scobin_vals(r)[0]);
+    }
+}
+
+void sortrun_rewind(CSOUND *csound)
+{
+    if (csound->sortrun != NULL)
+      close_sect(csound, csound->sortrun);
+}
@@ -28,6 +28,8 @@
 #include "namedins.h"           /* IV - Oct 31 2002 */
 #include "corfile.h"
 #include "Engine/score_param.h"
+#include "scobin.h"
+#include "sortrun.h"
 
 #define MEMSIZ  16384           /* size of memory requests from system  */
 #define MARGIN  4096            /* minimum remaining before new request */
@@ -903,6 +905,8 @@ static void salcblk(CSOUND *csound)
 {                               /* alloc a srtblk from current mem space:   */
     SRTBLK  *prvbp;             /*   align following *nxp, set new bp, nxp  */
                                 /*   set srtblk lnks, put op+blank in text  */
+    if (csound->sortrun != NULL)  /* sort to a run what was read, if too much */
+      sortrun_spill(csound);
     if (csound->sread.nxp >= csound->sread.memend) /* if this memblk exhausted */
       expand_nxp(csound);
     /* now allocate a srtblk from this space: */
@@ -917,6 +921,9 @@ static void salcblk(CSOUND *csound)
     (csound->sread.bp)->prvblk = prvbp;
     (csound->sread.bp)->insno = 0;
     (csound->sread.bp)->pcnt = 0;
+    (csound->sread.bp)->preced = 0;
+    (csound->sread.bp)->p2val = (csound->sread.bp)->p3val = FL(0.0);
+    (csound->sread.bp)->newp2 = (csound->sread.bp)->newp3 = FL(0.0);
     (csound->sread.bp)->lineno = (csound->sread.lincnt);
     (csound->sread.nxp) = &((csound->sread.bp)->text[0]);
     *(csound->sread.nxp)++ = (csound->sread.op); /* place op, blank into text    */
@@ -26,24 +26,52 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include "corfile.h"
+#include "scobin.h"
+
+/* where the sorted score goes: text, or the binary event stream */
+typedef struct {
+    CORFIL  *sco;
+    SCOBIN  *bin;
+    int     sectcnt;                    /* for messages */
+} SWSINK;
 
 static SRTBLK *nxtins(SRTBLK *), *prvins(SRTBLK *);
-static char   *pfout(CSOUND *,SRTBLK *, char *, int, int, CORFIL *sco);
-static char   *nextp(CSOUND *,SRTBLK *, char *, int, int, CORFIL *sco);
-static char   *prevp(CSOUND *,SRTBLK *, char *, int, int, CORFIL *sco);
-static char   *ramp(CSOUND *,SRTBLK *, char *, int, int, CORFIL *sco);
-static char   *expramp(CSOUND *,SRTBLK *, char *, int, int,CORFIL *sco);
-static char   *randramp(CSOUND *,SRTBLK *, char *, int, int, CORFIL *sco);
-static char   *pfStr(CSOUND *,char *, int, int, CORFIL *sco);
-static char   *fpnum(CSOUND *,char *, int, int, CORFIL *sco);
-
-static void fltout(CSOUND *csound, MYFLT n, CORFIL *sco)
+static char   *pfout(CSOUND *,SRTBLK *, char *, int, int, SWSINK *sco);
+static char   *nextp(CSOUND *,SRTBLK *, char *, int, int, SWSINK *sco);
+static char   *prevp(CSOUND *,SRTBLK *, char *, int, int, SWSINK *sco);
+static char   *ramp(CSOUND *,SRTBLK *, char *, int, int, SWSINK *sco);
+static char   *expramp(CSOUND *,SRTBLK *, char *, int, int,SWSINK *sco);
+static char   *randramp(CSOUND *,SRTBLK *, char *, int, int, SWSINK *sco);
+static char   *pfStr(CSOUND *,char *, int, int, SWSINK *sco);
+static char   *fpnum(CSOUND *,char *, int, int, SWSINK *sco);
+
+static void sw_putc(CSOUND *csound, int c, SWSINK *sco)
+{
+    if (sco->bin != NULL)
+      scobin_putc(csound, sco->bin, c);
+    else
+      corfile_putc(csound, c, sco->sco);
+}
+
+static void sw_puts(CSOUND *csound, const char *s, SWSINK *sco)
+{
+    if (sco->bin != NULL)
+      scobin_puts(csound, sco->bin, s);
+    else
+      corfile_puts(csound, s, sco->sco);
+}
+
+static void fltout(CSOUND *csound, MYFLT n, SWSINK *sco)
 {
     char *c, buffer[1024];
+    if (sco->bin != NULL) {             /* no need to go through text */
+      scobin_putflt(csound, sco->bin, n);
+      return;
+    }
     CS_SPRINTF(buffer, "%a", (double)n);
     /* corfile_puts(buffer, sco); */
     for (c = buffer; *c != '\0'; c++)
-      corfile_putc(csound, *c, sco);
+      corfile_putc(csound, *c, sco->sco);
 }
 
 /*
@@ -61,20 +89,20 @@ static void fltout(CSOUND *csound, MYFLT n, CORFIL *sco)
    VL - new in Csound 6.
 */
 
-void swritestr(CSOUND *csound, CORFIL *sco, int first)
+static void swrite(CSOUND *csound, SRTBLK *bp, SWSINK *sco, int first,
+                   int cont)
 {
-    SRTBLK *bp;
     char   *p, c, isntAfunc;
     int    lincnt, pcnt=0;
 
-    if (UNLIKELY((bp = csound->frstbp) == NULL))
+    if (UNLIKELY(bp == NULL))
       return;
 
     lincnt = 0;
     if ((c = bp->text[0]) != 'w'
         && c != 's' && c != 'e') {      /*   if no warp stmnt but real data,  */
       /* create warp-format indicator */
-      if (first) corfile_puts(csound, "w 0 60\n", sco);
+      if (first && !cont) sw_puts(csound, "w 0 60\n", sco);
       lincnt++;
     }
  nxtlin:
@@ -94,24 +122,24 @@ void swritestr(CSOUND *csound, CORFIL *sco, int first)
     case 'i':
     case 'd':
     case 'a':
-      corfile_putc(csound, c, sco);
-      corfile_putc(csound, *p++, sco);
+      sw_putc(csound, c, sco);
+      sw_putc(csound, *p++, sco);
       while ((c = *p++) != SP && c != LF)
-        corfile_putc(csound, c, sco);                /* put p1       */
-      corfile_putc(csound, c, sco);
+        sw_putc(csound, c, sco);                /* put p1       */
+      sw_putc(csound, c, sco);
       if (c == LF)
         break;
       fltout(csound, bp->p2val, sco);                        /* put p2val,   */
-      corfile_putc(csound, SP, sco);
+      sw_putc(csound, SP, sco);
       if (first) fltout(csound, bp->newp2, sco);             /*   newp2,     */
       while ((c = *p++) != SP && c != LF)
         ;
-      corfile_putc(csound, c, sco);                /*   and delim  */
+      sw_putc(csound, c, sco);                /*   and delim  */
       if (c == LF)
         break;
       if (isntAfunc) {
         fltout(csound, bp->p3val, sco);                      /* put p3val,   */
-        corfile_putc(csound, SP, sco);
+        sw_putc(csound, SP, sco);
         if (first) fltout(csound, bp->newp3, sco);           /*   newp3,     */
         while ((c = *p++) != SP && c != LF)
           ;
@@ -120,7 +148,7 @@ void swritestr(CSOUND *csound, CORFIL *sco, int first)
         char temp[256];
         snprintf(temp,256,"%d ",(int32)bp->p3val);   /* put p3val  */
         fpnum(csound,temp, lincnt, pcnt, sco);
-        corfile_putc(csound, SP, sco);
+        sw_putc(csound, SP, sco);
         if (first) {
           snprintf(temp,256,"%d ",(int32)bp->newp3);   /* put newp3  */
           fpnum(csound,temp, lincnt, pcnt, sco);
@@ -131,28 +159,28 @@ void swritestr(CSOUND *csound, CORFIL *sco, int first)
       pcnt = 3;
       while (c != LF) {
         pcnt++;
-        corfile_putc(csound, SP, sco);
+        sw_putc(csound, SP, sco);
         p = pfout(csound,bp,p,lincnt,pcnt, sco);     /* now put each pfield  */
         c = *p++;
       }
-      corfile_putc(csound, '\n', sco);
+      sw_putc(csound, '\n', sco);
       break;
     case 's':
     case 'e':
       if (bp->pcnt > 0) {
         char buffer[80];
         CS_SPRINTF(buffer, "f 0 %f %f\n", bp->p2val, bp->newp2);
-        corfile_puts(csound, buffer, sco);
+        sw_puts(csound, buffer, sco);
       }
-      corfile_putc(csound, c, sco);
-      corfile_putc(csound, LF, sco);
+      sw_putc(csound, c, sco);
+      sw_putc(csound, LF, sco);
       break;
     case 'w':
     case 't':
-      corfile_putc(csound, c, sco);
+      sw_putc(csound, c, sco);
       while ((c = *p++) != LF)        /* put entire line      */
-        corfile_putc(csound, c, sco);
-      corfile_putc(csound, LF, sco);
+        sw_putc(csound, c, sco);
+      sw_putc(csound, LF, sco);
       break;
     case 'x':
     case 'y':
@@ -161,15 +189,57 @@ void swritestr(CSOUND *csound, CORFIL *sco, int first)
     default:
       csound->Message(csound,
                       Str("swrite: unexpected opcode %c, section %d line %d\n"),
-                      c, csound->sectcnt, lincnt);
+                      c, sco->sectcnt, lincnt);
       break;
     }
     if ((bp = bp->nxtblk) != NULL)
       goto nxtlin;
 }
 
+void swritestr(CSOUND *csound, CORFIL *sco, int first)
+{
+    SWSINK  out;
+    out.sco = sco;
+    out.bin = NULL;
+    out.sectcnt = csound->sectcnt;
+    swrite(csound, csound->frstbp, &out, first, 0);
+}
+
+/* the same as swritestr(csound, sco, 1), as binary records */
+void swritebin(CSOUND *csound, SCOBIN *bin)
+{
+    SWSINK  out;
+    out.sco = NULL;
+    out.bin = bin;
+    out.sectcnt = csound->sectcnt;
+    swrite(csound, csound->frstbp, &out, 1, 0);
+}
+
+/* as swritebin(), for the list of blocks from bp; if cont is non-zero they
+   continue a section already written, so no warp indicator is added */
+void swriteblks(CSOUND *csound, SRTBLK *bp, SCOBIN *bin, int cont)
+{
+    SWSINK  out;
+    out.sco = NULL;
+    out.bin = bin;
+    out.sectcnt = csound->sectcnt;
+    swrite(csound, bp, &out, 1, cont);
+}
+
+/* swritestr() or, if bin is not NULL, swritebin() of the sorted section
+   sectcnt from bp, which need not be csound->frstbp */
+void swritesect(CSOUND *csound, SRTBLK *bp, CORFIL *sco, SCOBIN *bin,
+                int first, int sectcnt)
+{
+    SWSINK  out;
+    out.sco = sco;
+    out.bin = bin;
+    out.sectcnt = sectcnt;
+    swrite(csound, bp, &out, bin != NULL ? 1 : first, 0);
+}
+
 static char *pfout(CSOUND *csound, SRTBLK *bp, char *p,
-                   int lincnt, int pcnt, CORFIL *sco)
+                   int lincnt, int pcnt, SWSINK *sco)
 {
     switch (*p) {
     case 'n':
@@ -222,7 +292,7 @@ static SRTBLK *prvins(SRTBLK *bp) /* find prv note with same p1 */
 }
 
 static char *nextp(CSOUND *csound, SRTBLK *bp, char *p,
-                   int lincnt, int pcnt, CORFIL *sco)
+                   int lincnt, int pcnt, SWSINK *sco)
 {
     char *q;
     int n;
@@ -250,19 +320,19 @@ static char *nextp(CSOUND *csound, SRTBLK *bp, char *p,
     error:
       csound->Message(csound,Str("swrite: output, sect%d line%d p%d makes"
                       " illegal reference to "),
-        csound->sectcnt,lincnt,pcnt);
+        sco->sectcnt,lincnt,pcnt);
       while (q < p)
         csound->Message(csound,"%c", *q++);
       while (*p != SP && *p != LF)
         csound->Message(csound,"%c", *p++);
       csound->Message(csound,Str("   Zero substituted\n"));
-      corfile_putc(csound, '0', sco);
+      sw_putc(csound, '0', sco);
     }
     return(p);
 }
 
 static char *prevp(CSOUND *csound, SRTBLK *bp, char *p,
-                   int lincnt, int pcnt, CORFIL *sco)
+                   int lincnt, int pcnt, SWSINK *sco)
 {
     char *q;
     int n;
@@ -290,19 +360,19 @@ static char *prevp(CSOUND *csound, SRTBLK *bp, char *p,
     error:
       csound->Message(csound,
           Str("swrite: output, sect%d line%d p%d makes illegal reference to "),
-          csound->sectcnt,lincnt,pcnt);
+          sco->sectcnt,lincnt,pcnt);
       while (q < p)
         csound->Message(csound,"%c", *q++);
       while (*p != SP && *p != LF)
         csound->Message(csound,"%c", *p++);
       csound->Message(csound,Str("   Zero substituted\n"));
-      corfile_putc(csound, '0', sco);
+      sw_putc(csound, '0', sco);
     }
     return(p);
 }
 
 static char *ramp(CSOUND *csound, SRTBLK *bp, char *p,
-                  int lincnt, int pcnt, CORFIL *sco)
+                  int lincnt, int pcnt, SWSINK *sco)
   /* NB np's may reference a ramp but ramps must terminate in valid nums */
 {
     char    *q;
@@ -355,19 +425,19 @@ static char *ramp(CSOUND *csound, SRTBLK *bp, char *p,
  error1:
     csound->Message(csound,
         Str("swrite: output, sect%d line%d p%d has illegal ramp symbol\n"),
-        csound->sectcnt,lincnt,pcnt);
+        sco->sectcnt,lincnt,pcnt);
     goto put0;
  error2:
     csound->Message(csound, Str("swrite: output, sect%d line%d p%d ramp "
                                 "has illegal forward or backward ref\n"),
-                            csound->sectcnt, lincnt, pcnt);
+                            sco->sectcnt, lincnt, pcnt);
  put0:
-    corfile_putc(csound, '0', sco);
+    sw_putc(csound, '0', sco);
     return(psav);
 }
 
 static char *expramp(CSOUND *csound, SRTBLK *bp, char *p,
-                     int lincnt, int pcnt, CORFIL *sco)
+                     int lincnt, int pcnt, SWSINK *sco)
   /* NB np's may reference a ramp but ramps must terminate in valid nums */
 {
     char    *q;
@@ -424,19 +494,19 @@ static char *expramp(CSOUND *csound, SRTBLK *bp, char *p,
  error1:
     csound->Message(csound,Str("swrite: output, sect%d line%d p%d has illegal"
                    " expramp symbol\n"),
-               csound->sectcnt,lincnt,pcnt);
+               sco->sectcnt,lincnt,pcnt);
     goto put0;
  error2:
     csound->Message(csound, Str("swrite: output, sect%d line%d p%d expramp "
                                 "has illegal forward or backward ref\n"),
-                            csound->sectcnt, lincnt, pcnt);
+                            sco->sectcnt, lincnt, pcnt);
  put0:
-    corfile_putc(csound, '0', sco);
+    sw_putc(csound, '0', sco);
     return(psav);
 }
 
 static char *randramp(CSOUND *csound, SRTBLK *bp, char *p,
-                      int lincnt, int pcnt, CORFIL *sco)
+                      int lincnt, int pcnt, SWSINK *sco)
   /* NB np's may reference a ramp but ramps must terminate in valid nums */
 {
     char    *q;
@@ -489,30 +559,30 @@ static char *randramp(CSOUND *csound, SRTBLK *bp, char *p,
  error1:
     csound->Message(csound,Str("swrite: output, sect%d line%d p%d has illegal"
                    " expramp symbol\n"),
-               csound->sectcnt,lincnt,pcnt);
+               sco->sectcnt,lincnt,pcnt);
     goto put0;
  error2:
     csound->Message(csound,Str("swrite: output, sect%d line%d p%d expramp has"
                                " illegal forward or backward ref\n"),
-               csound->sectcnt,lincnt,pcnt);
+               sco->sectcnt,lincnt,pcnt);
  put0:
-    corfile_putc(csound, '0', sco);
+    sw_putc(csound, '0', sco);
     return(psav);
 }
 
-static char *pfStr(CSOUND *csound, char *p, int lincnt, int pcnt, CORFIL *sco)
+static char *pfStr(CSOUND *csound, char *p, int lincnt, int pcnt, SWSINK *sco)
 {                             /* moves quoted ascii string to SCOREOUT file */
     char *q = p;              /*   with no internal format chk              */
-    corfile_putc(csound, *p++, sco);
+    sw_putc(csound, *p++, sco);
     while (*p != '"') {
-      corfile_putc(csound, *p++, sco);
-      if (*(p-1)=='\\') corfile_putc(csound, *p++, sco);
+      sw_putc(csound, *p++, sco);
+      if (*(p-1)=='\\') sw_putc(csound, *p++, sco);
     }
-    corfile_putc(csound, *p++, sco);
+    sw_putc(csound, *p++, sco);
     if (UNLIKELY(*p != SP && *p != LF)) {
       csound->Message(csound, Str("swrite: output, sect%d line%d p%d "
                                   "has illegally terminated string   "),
-                              csound->sectcnt, lincnt, pcnt);
+                              sco->sectcnt, lincnt, pcnt);
       while (q < p)
         csound->Message(csound,"%c", *q++);
       while (*p != SP && *p != LF)
@@ -523,7 +593,7 @@ static char *pfStr(CSOUND *csound, char *p, int lincnt, int pcnt, CORFIL *sco)
 }
 
 static char *fpnum(CSOUND *csound, char *p,
-                   int lincnt, int pcnt, CORFIL *sco) /* moves ascii string */
+                   int lincnt, int pcnt, SWSINK *sco) /* moves ascii string */
   /* to SCOREOUT file with fpnum format chk */
 /* CONSIDER USING SIMPLER CODE */
 {
@@ -534,36 +604,36 @@ static char *fpnum(CSOUND *csound, char *p,
     if (*p == '+')
       p++;
     if (*p == '-')
-      corfile_putc(csound, *p++, sco);
+      sw_putc(csound, *p++, sco);
     if (*p=='0' && *(p+1)=='x') {
       while (!isspace(*p)) {
-        corfile_putc(csound, *p++, sco);
+        sw_putc(csound, *p++, sco);
         //dcnt++;                 /* Not used so delete? */
       }
       return p;
     }
     while (isdigit(*p)) {
       //      printf("*p=%c\n", *p);
-      corfile_putc(csound, *p++, sco);
+      sw_putc(csound, *p++, sco);
       dcnt++;
     }
     //    printf("%d:output: %s<<\n", __LINE__, sco);
     if (*p == '.')
-      corfile_putc(csound, *p++, sco);
+      sw_putc(csound, *p++, sco);
     while (isdigit(*p)) {
-      corfile_putc(csound, *p++, sco);
+      sw_putc(csound, *p++, sco);
       dcnt++;
     }
     //    printf("%d:output: %s<<\n", __LINE__, sco);
     if (*p == 'E' || *p == 'e') { /* Allow exponential notation */
-      corfile_putc(csound, *p++, sco);
+      sw_putc(csound, *p++, sco);
       dcnt++;
       if (*p == '+' || *p == '-') {
-        corfile_putc(csound, *p++, sco);
+        sw_putc(csound, *p++, sco);
         dcnt++;
       }
       while (isdigit(*p)) {
-        corfile_putc(csound, *p++, sco);
+        sw_putc(csound, *p++, sco);
         dcnt++;
       }
     }
@@ -571,14 +641,14 @@ static char *fpnum(CSOUND *csound, char *p,
     if (UNLIKELY((*p != SP && *p != LF) || !dcnt)) {
       csound->Message(csound,Str("swrite: output, sect%d line%d p%d has "
                                  "illegal number  "),
-                      csound->sectcnt,lincnt,pcnt);
+                      sco->sectcnt,lincnt,pcnt);
       while (q < p)
         csound->Message(csound,"%c", *q++);
       while (*p != SP && *p != LF)
         csound->Message(csound,"%c", *p++);
       csound->Message(csound,Str("    String truncated\n"));
       if (!dcnt)
-        corfile_putc(csound, '0', sco);
+        sw_putc(csound, '0', sco);
     }
     return(p);
 }
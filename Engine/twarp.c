@@ -32,78 +32,107 @@ typedef struct {
 
 int     realtset(CSOUND *, SRTBLK *);
 MYFLT   realt(CSOUND *, MYFLT);
+static int   warpset(CSOUND *, SRTBLK *, void **tseg, void **tpsave);
+static MYFLT warpt(void **tpsave, MYFLT);
 
-void twarp(CSOUND *csound) /* time-warp a score section acc to T-statement */
+/* warp the times of one block by the t-array of *tpsave, the segment last
+   used */
+static void warpblk(CSOUND *csound, SRTBLK *bp, void **tpsave)
 {
-    SRTBLK  *bp;
     MYFLT   absp3;
     MYFLT   endtime;
-    int     negp3;
 
-    if (UNLIKELY((bp = csound->frstbp) == NULL))      /* if null file,         */
+    switch (bp->text[0]) {
+    case 'i':
+      absp3 = bp->newp3;
+      if (UNLIKELY(absp3 < 0))
+        absp3 = -absp3;
+      endtime = bp->newp2 + absp3;
+      bp->newp2 = warpt(tpsave, bp->newp2);
+      if (bp->newp3 < 0)
+        bp->newp3 = bp->newp2 - warpt(tpsave, endtime);
+      else
+        bp->newp3 = warpt(tpsave, endtime) - bp->newp2;
+      break;
+    case 'a':
+      endtime = bp->newp2 + bp->newp3;
+      bp->newp2 = warpt(tpsave, bp->newp2);
+      bp->newp3 = warpt(tpsave, endtime) - bp->newp2;
+      break;
+    case 'f':
+    case 'q':
+      bp->newp2 = warpt(tpsave, bp->newp2);
+      break;
+    case 't':
+    case 'w':
+      break;
+    case 's':
+    case 'e':
+      if (bp->pcnt > 0)
+        bp->newp2 = warpt(tpsave, bp->p2val);
+      break;
+    default:
+      csound->Message(csound, Str("twarp: illegal opcode\n"));
+      break;
+    }
+}
+
+/* warp the times of one block by the t-array set by realtset() */
+void twarpblk(CSOUND *csound, SRTBLK *bp)
+{
+    warpblk(csound, bp, &csound->tpsave);
+}
+
+/* twarp() for the sorted section from bp, with its t-array in *tseg and
+   *tpsave; these start NULL and *tseg is freed by the caller.  Sections
+   warped on different threads each need their own. */
+void twarpsect(CSOUND *csound, SRTBLK *bp, void **tseg, void **tpsave)
+{
+    SRTBLK  *frstbp = bp;
+
+    if (UNLIKELY(bp == NULL))               /* if null file,         */
       return;
     while (bp->text[0] != 't')              /*  or cannot find a t,  */
       if (UNLIKELY((bp = bp->nxtblk) == NULL))
         return;                             /*      we are done      */
     bp->text[0] = 'w';                      /* else mark the t used  */
-    if (!realtset(csound, bp))              /*  and init the t-array */
+    if (!warpset(csound, bp, tseg, tpsave)) /*  and init the t-array */
       return;                               /* (done if t0 60 or err) */
-    bp  = csound->frstbp;
-    negp3 = 0;
-    do {
-      switch (bp->text[0]) {                /* else warp all timvals */
-      case 'i':
-        absp3 = bp->newp3;
-        if (UNLIKELY(absp3 < 0)) {
-          absp3 = -absp3;
-          negp3++;
-        }
-        endtime = bp->newp2 + absp3;
-        bp->newp2 = realt(csound, bp->newp2);
-        bp->newp3 = realt(csound, endtime) - bp->newp2;
-        if (negp3) {
-          bp->newp3 = -bp->newp3;
-          negp3--;
-        }
-        break;
-      case 'a':
-        endtime = bp->newp2 + bp->newp3;
-        bp->newp2 = realt(csound, bp->newp2);
-        bp->newp3 = realt(csound, endtime) - bp->newp2;
-        break;
-      case 'f':
-      case 'q':
-        bp->newp2 = realt(csound, bp->newp2);
-        break;
-      case 't':
-      case 'w':
-        break;
-      case 's':
-      case 'e':
-        if (bp->pcnt > 0)
-          bp->newp2 = realt(csound, bp->p2val);
-        break;
-      default:
-        csound->Message(csound, Str("twarp: illegal opcode\n"));
-        break;
-      }
+    bp  = frstbp;
+    do {                                    /* else warp all timvals */
+      warpblk(csound, bp, tpsave);
     } while ((bp = bp->nxtblk) != NULL);
 }
 
+void twarp(CSOUND *csound) /* time-warp a score section acc to T-statement */
+{
+    twarpsect(csound, csound->frstbp, &csound->tseg, &csound->tpsave);
+}
+
 int realtset(CSOUND *csound, SRTBLK *bp)
+{
+    return warpset(csound, bp, &csound->tseg, &csound->tpsave);
+}
+
+MYFLT realt(CSOUND *csound, MYFLT srctim)
+{
+    return warpt(&csound->tpsave, srctim);
+}
+
+static int warpset(CSOUND *csound, SRTBLK *bp, void **tsegp, void **tpsave)
 {
     char    *p;
     char    c;
     MYFLT   tempo, betspan, durbas, avgdur, stof(CSOUND *, char *);
     TSEG    *tp, *prvtp;
-    TSEG    *tseg = (TSEG*)csound->tseg;
+    TSEG    *tseg = (TSEG*)*tsegp;
 
-    csound->tseg =
+    *tsegp =
       tseg = (TSEG*)csound->ReAlloc(csound,
                                     tseg, (1+bp->pcnt/2) * sizeof(TSEG));
     //tplim = &tseg[(bp->pcnt/2)];
     //csound->tseglen = 1+bp->pcnt/2;
-    tp = (TSEG*) (csound->tpsave = tseg);
+    tp = (TSEG*) (*tpsave = tseg);
     if (UNLIKELY(bp->pcnt < 2))
       goto error1;
     p = bp->text;                             /* first go to p1        */
@@ -154,17 +183,17 @@ int realtset(CSOUND *csound, SRTBLK *bp)
     return(0);
 }
 
-MYFLT realt(CSOUND *csound, MYFLT srctim)
+static MYFLT warpt(void **tpsave, MYFLT srctim)
 {
     TSEG *tp;
     MYFLT diff;
 
-    tp = (TSEG*) csound->tpsave;
+    tp = (TSEG*) *tpsave;
     while (srctim >= (tp+1)->betbas)
       tp++;
     while ((diff = srctim - tp->betbas) < FL(0.0))
       tp--;
-    csound->tpsave = tp;
+    *tpsave = tp;
     return ((tp->durslp * diff + tp->durbas) * diff + tp->timbas);
 }
 
@@ -88,6 +88,24 @@ typedef struct {
     MYFLT   *r, *a, *b, *def;
 } DIVZ;
 
+/* A fused a-rate expression, built by the optimiser from a chain of
+   ##add/##sub/##mul/##div and one-argument maths functions.  prog is the
+   expression in RPN ("a0 k1 * sin" etc.), aN and kN naming the N'th of
+   args as an audio or scalar operand.  It is evaluated FUSE_TILE samples
+   at a time, so intermediate values never leave a small stack buffer.  */
+#define FUSE_MAXARGS    (32)
+#define FUSE_MAXDEPTH   (8)
+#define FUSE_TILE       (32)
+
+typedef struct {
+    OPDS    h;
+    MYFLT   *r;
+    STRINGDAT *prog;
+    MYFLT   *args[FUSE_MAXARGS];
+    AUXCH   code;
+    int32_t ncode;
+} FUSED;
+
 typedef struct {
     OPDS    h;
     MYFLT   *r, *a;
@@ -0,0 +1,66 @@
+/*
+    aops_simd.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef AOPS_SIMD_H
+#define AOPS_SIMD_H
+
+/* Vector kernels behind the a-rate arithmetic opcodes.  Each kernel
+   writes r[offset] .. r[nsmps-1] and nothing if offset >= nsmps; the
+   opcodes still clear the samples outside that range themselves.  r may
+   be the same buffer as an input, but must not partially overlap one.
+   All kernels give bit-identical results to the scalar loops.         */
+
+enum { AOP_ADD = 0, AOP_SUB, AOP_MUL, AOP_DIV, AOP_NOPS };
+
+enum {
+    AOPS_SIMD_SCALAR = 0,
+    AOPS_SIMD_SSE2,
+    AOPS_SIMD_AVX2,
+    AOPS_SIMD_NEON,
+    AOPS_SIMD_LEVELS
+};
+
+typedef void (*AOPS_VV)(MYFLT *r, const MYFLT *a, const MYFLT *b,
+                        uint32_t offset, uint32_t nsmps);
+typedef void (*AOPS_SV)(MYFLT *r, MYFLT a, const MYFLT *b,
+                        uint32_t offset, uint32_t nsmps);
+typedef void (*AOPS_VS)(MYFLT *r, const MYFLT *a, MYFLT b,
+                        uint32_t offset, uint32_t nsmps);
+typedef void (*AOPS_FILL)(MYFLT *r, MYFLT a, uint32_t offset, uint32_t nsmps);
+
+typedef struct {
+    const char  *name;
+    AOPS_VV     vv[AOP_NOPS];           /* r[i] = a[i] OP b[i] */
+    AOPS_SV     sv[AOP_NOPS];           /* r[i] = a    OP b[i] */
+    AOPS_VS     vs[AOP_NOPS];           /* r[i] = a[i] OP b    */
+    AOPS_FILL   fill;                   /* r[i] = a            */
+} AOPS_KERNELS;
+
+/* the kernel set in use; scalar until aops_simd_init() has run */
+extern const AOPS_KERNELS *aops_kernels;
+
+/* pick the best kernels this CPU supports, or the ones named by the
+   CS_SIMD environment variable (scalar, sse2, avx2, neon) */
+void aops_simd_init(void);
+/* kernels for a given level, or NULL if not built or not supported */
+const AOPS_KERNELS *aops_simd_kernels(int level);
+
+#endif  /* AOPS_SIMD_H */
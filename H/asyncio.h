@@ -0,0 +1,61 @@
+/*
+    asyncio.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+/*
+  Sound file streams read ahead or written behind by a pool of worker
+  threads (--io-threads=N), for csoundReadAsync(), csoundWriteAsync()
+  and csoundFSeekAsync().  Each stream has a ring between the
+  performance thread and the workers.  The performance thread measures
+  how fast it uses a stream and, when the ring of a reading stream falls
+  below the read-ahead depth that rate calls for (or the ring of a
+  writing stream has a write's worth in it), queues the stream with the
+  time it would run dry (or full) as its deadline.  Idle workers sleep
+  until a stream is queued and take the one with the earliest deadline,
+  so a slow file only ever holds up one worker.  Only one worker serves
+  a stream at a time.
+*/
+
+typedef struct asyncio_stream_s ASYNCIO_STREAM;
+
+/* Start streaming sf, which is read if write is 0, through a ring of at
+   least size samples.  nchnls and sr give the rate it is likely to be
+   used at, for sizing the ring. */
+ASYNCIO_STREAM *asyncio_open(CSOUND *, SNDFILE *sf, int write, int size,
+                             int nchnls, double sr);
+/* Stop streaming, writing out what is left first; the file is left
+   open. */
+void    asyncio_close(CSOUND *, ASYNCIO_STREAM *);
+
+/* never wait on the file: return what the ring has (or has room for) */
+int     asyncio_read(CSOUND *, ASYNCIO_STREAM *, MYFLT *buf, int items);
+int     asyncio_write(CSOUND *, ASYNCIO_STREAM *, const MYFLT *buf,
+                      int items);
+/* seek the file, dropping what was read ahead (or writing out what was
+   written behind) first */
+int     asyncio_seek(CSOUND *, ASYNCIO_STREAM *, int pos, int whence);
+
+/* stop the workers; all streams must be closed */
+void    asyncio_shutdown(CSOUND *);
+
+#endif  /* ASYNCIO_H */
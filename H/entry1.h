@@ -86,6 +86,7 @@ int32_t modak(CSOUND *, void *);
 int32_t addaa(CSOUND *, void *), subaa(CSOUND *, void *);
 int32_t mulaa(CSOUND *, void *), divaa(CSOUND *, void *);
 int32_t modaa(CSOUND *, void *);
+int32_t fused_set(CSOUND *, void *), fused(CSOUND *, void *);
 int32_t addin(CSOUND *, void *), addina(CSOUND *, void *);
 int32_t subin(CSOUND *, void *), subina(CSOUND *, void *);
 int32_t addinak(CSOUND *, void *), subinak(CSOUND *, void *);
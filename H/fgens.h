@@ -48,5 +48,10 @@ int csoundFTAlloc(CSOUND *csound, int tableNum, int len);
  */
 int csoundFTDelete(CSOUND *csound, int tableNum);
 
+/* tables mapped from the --gen01-cache directory: give one a copy of
+   its own (csound->FTUnmap), or unmap them all at reset */
+int gen01_cache_unmap(CSOUND *csound, FUNC *ftp, int copy);
+void gen01_cache_release(CSOUND *csound);
+
 #endif  /* CSOUND_FGENS_H */
 
@@ -0,0 +1,72 @@
+/*
+    pffftd.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef PFFFTD_H
+#define PFFFTD_H
+
+/* Double precision instances of pffft (OOps/pffft.c), used by the
+   PFFT_LIB backend of csoundRealFFT2() and csoundDCT() when MYFLT is
+   double, so the transforms run on the signal without a float copy.
+
+   pffftd_scalar_* is plain C and takes any even size the fftpack radices
+   (2, 3, 4, 5) can factor.  pffftd_avx_* works on 4 doubles per __m256d,
+   needs sizes that are multiples of 32 and buffers aligned to 32 bytes,
+   and may only be called if the CPU has AVX.  Input and output may be
+   the same buffer; work must hold N doubles.                          */
+
+#include "pffft.h"
+
+#if (defined(__x86_64__) || defined(_M_X64) ||                          \
+     defined(__i386__) || defined(_M_IX86)) &&                          \
+    (((defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 ||     \
+       (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))) && !defined(__MINGW32__)) \
+     || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#  define PFFFTD_HAVE_AVX
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct PFFFTD_Setup PFFFTD_Setup;
+
+  PFFFTD_Setup *pffftd_scalar_new_setup(int N,
+                                        pffft_transform_t transform);
+  void pffftd_scalar_destroy_setup(PFFFTD_Setup *);
+  void pffftd_scalar_transform_ordered(PFFFTD_Setup *setup,
+                                       const double *input, double *output,
+                                       double *work,
+                                       pffft_direction_t direction);
+
+#ifdef PFFFTD_HAVE_AVX
+  PFFFTD_Setup *pffftd_avx_new_setup(int N, pffft_transform_t transform);
+  void pffftd_avx_destroy_setup(PFFFTD_Setup *);
+  void pffftd_avx_transform_ordered(PFFFTD_Setup *setup,
+                                    const double *input, double *output,
+                                    double *work,
+                                    pffft_direction_t direction);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* PFFFTD_H */
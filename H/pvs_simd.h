@@ -0,0 +1,69 @@
+/*
+    pvs_simd.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef PVS_SIMD_H
+#define PVS_SIMD_H
+
+/* Rectangular/polar conversion kernels behind pvsanal, pvsynth and
+   pvadsyn.  Each converts n bins held in separate arrays; an output may
+   be the same array as an input, but must not partially overlap one.
+   The scalar set calls libm as the opcodes always have.  The vector sets
+   use polynomials: phases are within 5e-16 (double) or 3e-7 (float) of
+   atan2(), sines and cosines within 2.5e-16 or 1e-7 of libm over one
+   turn, the double ones within 1.5e-15 up to PVS_SINCOS_MAX.  Larger
+   arguments, infinities and NaNs are handed to libm.  The sliding DFT
+   step works in double whatever MYFLT is.                             */
+
+#include "aops_simd.h"
+
+/* largest argument the vector sines and cosines reduce themselves */
+#ifdef USE_DOUBLE
+#  define PVS_SINCOS_MAX    1.0e6
+#else
+#  define PVS_SINCOS_MAX    6000.0f
+#endif
+
+typedef struct {
+    const char  *name;
+    /* mag[i] = hypot(re[i], im[i]), ph[i] = atan2(im[i], re[i]) */
+    void  (*polar)(MYFLT *mag, MYFLT *ph, const MYFLT *re, const MYFLT *im,
+                   int32_t n);
+    /* s[i] = sin(x[i]), c[i] = cos(x[i]) */
+    void  (*sincos)(MYFLT *s, MYFLT *c, const MYFLT *x, int32_t n);
+    /* s[i] = sin(x[i]) */
+    void  (*sin)(MYFLT *s, const MYFLT *x, int32_t n);
+    /* one sample of a sliding DFT: re[i] += dx, then (re[i], im[i]) is
+       rotated by (c[i], s[i]) */
+    void  (*slide)(double *re, double *im, const double *c, const double *s,
+                   double dx, int32_t n);
+} PVS_KERNELS;
+
+/* the kernel set in use; scalar until pvs_simd_init() has run */
+extern const PVS_KERNELS *pvs_kernels;
+
+/* use the kernels of the instruction set aops_simd_init() chose, so
+   CS_SIMD selects both */
+void pvs_simd_init(void);
+/* kernels for an AOPS_SIMD_* level, or NULL if not built or not
+   supported */
+const PVS_KERNELS *pvs_simd_kernels(int level);
+
+#endif  /* PVS_SIMD_H */
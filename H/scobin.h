@@ -0,0 +1,78 @@
+/*
+    scobin.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef SCOBIN_H
+#define SCOBIN_H
+
+/*
+  Binary form of the sorted score.  The sorter writes the same characters
+  it would write to the text score, but every line becomes one record of
+  already converted p-field values, so rdscor() need not parse anything.
+  Values are stored in the order they appear in the text line (for a
+  warped event: p1, p2orig, p2, p3orig, p3, p4 ...).  The strings of a
+  line are kept as one block of NUL-terminated strings, as in
+  EVTBLK.strarg, and identical blocks are stored once.
+*/
+
+typedef struct {
+    int32_t     nvals;          /* MYFLT values following the record */
+    int32_t     scnt;           /* strings in the string block */
+    uint32_t    str;            /* offset + 1 of the block, 0 if none */
+    char        opcod;
+    char        pad[3];
+} SCOBIN_REC;
+
+/* opcode of a record standing for a section that is merged from sorted
+   runs as it is read (sortrun.c); its one value is the section number */
+#define SCOBIN_RUNS     ('\001')
+
+typedef struct scobin_s SCOBIN;
+
+SCOBIN  *scobin_create(CSOUND *);
+void    scobin_destroy(CSOUND *, SCOBIN **);
+/* writing: characters of the text score, or a value in place of the
+   characters of one number */
+void    scobin_putc(CSOUND *, SCOBIN *, int c);
+void    scobin_puts(CSOUND *, SCOBIN *, const char *s);
+void    scobin_putflt(CSOUND *, SCOBIN *, MYFLT x);
+/* a whole record of one value */
+void    scobin_putrec(CSOUND *, SCOBIN *, int opcod, MYFLT x);
+/* add the records of src, whose last line has ended */
+void    scobin_append(CSOUND *, SCOBIN *, SCOBIN *src);
+/* number of records written so far, and the opcode of the last one */
+int32_t scobin_count(SCOBIN *);
+int     scobin_last_opcod(SCOBIN *);
+/* discard all records and strings */
+void    scobin_reset(SCOBIN *);
+/* end writing, release the string index */
+void    scobin_flush(CSOUND *, SCOBIN *);
+
+/* reading: the next record or NULL at the end, its values and strings */
+const SCOBIN_REC *scobin_next(SCOBIN *);
+#define scobin_vals(r)  ((const MYFLT *) ((r) + 1))
+char    *scobin_strings(SCOBIN *, const SCOBIN_REC *);
+void    scobin_rewind(SCOBIN *);
+
+/* save to and load from a file; only read back by the same build */
+int     scobin_save(CSOUND *, SCOBIN *, const char *name);
+SCOBIN  *scobin_load(CSOUND *, const char *name);
+
+#endif  /* SCOBIN_H */
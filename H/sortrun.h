@@ -0,0 +1,58 @@
+/*
+    sortrun.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef SORTRUN_H
+#define SORTRUN_H
+
+/*
+  External sort of score sections too large to sort in memory.  While
+  scsortbin() reads the score, the sort blocks of a section are sorted
+  to a run in a temporary file each time they exceed the limit, keeping
+  only the blocks needed to carry p-fields to later lines.  Such a
+  section is written to the binary score as a single SCOBIN_RUNS
+  record, and its runs are merged a batch of events at a time as
+  rdscor() reaches it.  A section using np, pp or ramps, which need the
+  notes around them in sorted order, is merged back into memory and
+  written as usual.
+*/
+
+typedef struct sortrun_s SORTRUN;
+
+/* limit is the bytes of sort blocks read before a run is written */
+SORTRUN *sortrun_create(CSOUND *, size_t limit);
+void    sortrun_destroy(CSOUND *, SORTRUN **);
+/* the score has been read: no more runs */
+void    sortrun_done(CSOUND *);
+
+/* called by sread() before each new block: writes a run if over the
+   limit */
+void    sortrun_spill(CSOUND *);
+/* whether the section just read has runs, and if so, write it */
+int     sortrun_spilled(CSOUND *);
+void    sortrun_section(CSOUND *, SCOBIN *);
+
+/* next record of csound->scobin, with the sections of runs merged in;
+   *bin is set to where the record's strings are.  Strings of a merged
+   section are only valid until the next call. */
+const SCOBIN_REC *sortrun_next(CSOUND *, SCOBIN **bin);
+void    sortrun_rewind(CSOUND *);
+
+#endif  /* SORTRUN_H */
@@ -0,0 +1,63 @@
+/*
+    tabosc_simd.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef TABOSC_SIMD_H
+#define TABOSC_SIMD_H
+
+/* Table oscillator kernels behind oscbnk and adsynt.  Each adds n
+   samples of one oscillator to out, stepping a fixed point phase by a
+   fixed increment, and returns the phase after the last sample.  The
+   vector sets work on several samples of the oscillator at once, so the
+   oscillators of a bank are still added to each sample in order, and
+   all sets give bit-identical results.                               */
+
+#include "aops_simd.h"
+
+typedef struct {
+    const MYFLT *ft;            /* table (with guard point for lin)   */
+    uint32  lobits;             /* phase >> lobits = index            */
+    uint32  mask;               /* phase & mask = fraction            */
+    MYFLT   pfrac;              /* scales the fraction to [0, 1)      */
+    uint32  phsmsk;             /* phase wraps at phsmsk + 1          */
+} TABOSC;
+
+typedef struct {
+    const char  *name;
+    /* out[i] += k * amp[i], or out[i] += k if amp is NULL, where k is
+       ft[ph >> lobits] interpolated linearly by (ph & mask) * pfrac */
+    uint32  (*lin)(MYFLT *out, const MYFLT *amp, const TABOSC *t,
+                   uint32 ph, uint32 inc, uint32_t n);
+    /* out[i] += ft[ph >> lobits] * amp */
+    uint32  (*trunc)(MYFLT *out, MYFLT amp, const TABOSC *t,
+                     uint32 ph, uint32 inc, uint32_t n);
+} TABOSC_KERNELS;
+
+/* the kernel set in use; scalar until tabosc_simd_init() has run */
+extern const TABOSC_KERNELS *tabosc_kernels;
+
+/* use the kernels of the instruction set aops_simd_init() chose, so
+   CS_SIMD selects both */
+void tabosc_simd_init(void);
+/* kernels for an AOPS_SIMD_* level, or NULL if not built or not
+   supported */
+const TABOSC_KERNELS *tabosc_simd_kernels(int level);
+
+#endif  /* TABOSC_SIMD_H */
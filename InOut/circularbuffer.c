@@ -21,158 +21,388 @@
   02110-1301 USA
 */
 
+#if defined(LINUX)
+#define _GNU_SOURCE
+#endif
 #include <csoundCore.h>
+#include <limits.h>
+#if defined(LINUX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <time.h>
+#endif
+
+/*
+  Single-reader single-writer ring of fixed size elements.  Each side
+  copies at most two contiguous segments per call, publishes its index
+  with a release store and reads the other side's with an acquire load.
+  The indices live on separate cache lines, each next to the writer's
+  last seen copy of the other index, so neither side touches the
+  other's line unless the ring looks full or empty.  A reader may block
+  in csoundWaitRingBuffer(); on Linux it sleeps on a futex the writer
+  only wakes while someone is waiting.
+
+  The circular buffer API is kept as a thin layer over it.
+*/
+
+#define RB_LINE 64
+
+#if defined(MSVC)
+#define RB_LOAD_ACQ(var)  \
+  InterlockedCompareExchange((volatile long *) &(var), 0, 0)
+#define RB_STORE_REL(var, val)  \
+  InterlockedExchange((volatile long *) &(var), (val))
+#define RB_FENCE()              MemoryBarrier()
+#define RB_SWAP(var, val)  \
+  InterlockedExchange((volatile long *) &(var), (val))
+#elif defined(HAVE_ATOMIC_BUILTIN)
+#define RB_LOAD_ACQ(var)        __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define RB_STORE_REL(var, val)  __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#define RB_FENCE()              __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define RB_SWAP(var, val)       __atomic_exchange_n(&(var), (val), \
+                                                    __ATOMIC_SEQ_CST)
+#else
+#define RB_LOAD_ACQ(var)        (var)
+#define RB_STORE_REL(var, val)  ((var) = (val))
+#define RB_FENCE()
+#define RB_SWAP(var, val)       rb_swap(&(var), (val))
+static inline int rb_swap(volatile int *var, int val)
+{
+    int old = *var;
+    *var = val;
+    return old;
+}
+#endif
+
+typedef struct ring_buffer_ {
+    char    *buffer;
+    int     size;               /* elements in buffer, one more than fit */
+    int     elemsize;           /* in number of bytes */
+    char    pad0[RB_LINE];
+    /* written by the writer */
+    volatile long wp;
+    long    rpSeen;
+    char    pad1[RB_LINE - 2 * sizeof(long)];
+    /* written by the reader */
+    volatile long rp;
+    long    wpSeen;
+    char    pad2[RB_LINE - 2 * sizeof(long)];
+    /* a reader is in csoundWaitRingBuffer(); event counts wakeups;
+       wake is set by csoundWakeRingBuffer() until a wait returns for it */
+    volatile long waiting;
+    volatile int  event;
+    volatile int  wake;
+    char    pad3[RB_LINE - sizeof(long) - 2 * sizeof(int)];
+} ring_buffer;
 
-typedef struct _circular_buffer {
-  char *buffer;
-  int  wp;
-  int rp;
-  int numelem;
-  int elemsize; /* in number of bytes */
-} circular_buffer;
-
-void *csoundCreateCircularBuffer(CSOUND *csound, int numelem, int elemsize){
-    circular_buffer *p;
-    if ((p = (circular_buffer *)
-         csound->Malloc(csound, sizeof(circular_buffer))) == NULL) {
+void *csoundCreateRingBuffer(CSOUND *csound, int numelem, int elemsize)
+{
+    ring_buffer *p;
+    if (UNLIKELY(numelem < 1 || elemsize < 1))
+      return NULL;
+    if ((p = (ring_buffer *) csound->Calloc(csound, sizeof(ring_buffer)))
+        == NULL) {
       return NULL;
     }
-    p->numelem = numelem;
-    p->wp = p->rp = 0;
+    p->size = numelem + 1;
     p->elemsize = elemsize;
-
-    if ((p->buffer = (char *) csound->Malloc(csound, numelem*elemsize)) == NULL) {
+    if ((p->buffer = (char *) csound->Calloc(csound,
+                                             (size_t) p->size * elemsize))
+        == NULL) {
+      csound->Free(csound, p);
       return NULL;
     }
-    memset(p->buffer, 0, numelem*elemsize);
-    return (void *)p;
+    return (void *) p;
 }
 
-static int checkspace(circular_buffer *p, int writeCheck){
-    int wp = p->wp, rp = p->rp, numelem = p->numelem;
-    if(writeCheck){
-      if (wp > rp) return rp - wp + numelem - 1;
-      else if (wp < rp) return rp - wp - 1;
-      else return numelem - 1;
+void csoundDestroyRingBuffer(CSOUND *csound, void *rb)
+{
+    if (rb == NULL) return;
+    csound->Free(csound, ((ring_buffer *) rb)->buffer);
+    csound->Free(csound, rb);
+}
+
+/* elements the reader at rp can take; the writer's index is only
+   loaded again when the last one seen does not give want of them */
+static inline int rb_readable(ring_buffer *p, long rp, int want)
+{
+    long wp = p->wpSeen;
+    int  n = (int) (wp >= rp ? wp - rp : wp - rp + p->size);
+    if (n < want) {
+      p->wpSeen = wp = RB_LOAD_ACQ(p->wp);
+      n = (int) (wp >= rp ? wp - rp : wp - rp + p->size);
     }
-    else {
-      if (wp > rp) return wp - rp;
-      else if (wp < rp) return wp - rp + numelem;
-      else return 0;
+    return n;
+}
+
+static inline int rb_writable(ring_buffer *p, long wp, int want)
+{
+    long rp = p->rpSeen;
+    int  n = (int) (rp > wp ? rp - wp - 1 : rp - wp + p->size - 1);
+    if (n < want) {
+      p->rpSeen = rp = RB_LOAD_ACQ(p->rp);
+      n = (int) (rp > wp ? rp - wp - 1 : rp - wp + p->size - 1);
     }
+    return n;
 }
 
-int csoundReadCircularBuffer(CSOUND *csound, void *p, void *out, int items)
+#if defined(LINUX)
+static void rb_futex_wake(volatile int *addr)
 {
-    IGN(csound);
-    if (p == NULL) return 0;
-    {
-      int remaining;
-      int itemsread, numelem = ((circular_buffer *)p)->numelem;
-      int elemsize = ((circular_buffer *)p)->elemsize;
-      int i=0, rp = ((circular_buffer *)p)->rp;
-      char *buffer = ((circular_buffer *)p)->buffer;
-      if ((remaining = checkspace(p, 0)) == 0) {
-        return 0;
-      }
-      itemsread = items > remaining ? remaining : items;
-      for (i=0; i < itemsread; i++){
-        memcpy((char *) out + (i * elemsize),
-               &(buffer[elemsize * rp++]),  elemsize);
-        if (rp == numelem) {
-          rp = 0;
-        }
-      }
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+/* the writer has moved wp: wake a waiting reader */
+static inline void rb_signal(ring_buffer *p)
+{
+    /* orders the store of wp before the load of waiting, against the
+       reader storing waiting before it loads wp */
+    RB_FENCE();
+    if (UNLIKELY(RB_LOAD_ACQ(p->waiting))) {
 #if defined(MSVC)
-      InterlockedExchange(&((circular_buffer *)p)->rp, rp);
+      InterlockedIncrement((volatile long *) &p->event);
 #elif defined(HAVE_ATOMIC_BUILTIN)
-      __atomic_exchange_n(&((circular_buffer *)p)->rp,rp, __ATOMIC_SEQ_CST);
+      __atomic_add_fetch(&p->event, 1, __ATOMIC_SEQ_CST);
 #else
-      ((circular_buffer *)p)->rp = rp;
+      p->event++;
+#endif
+#if defined(LINUX)
+      rb_futex_wake(&p->event);
 #endif
-      return itemsread;
     }
 }
 
-int csoundPeekCircularBuffer(CSOUND *csound, void *p, void *out, int items)
+int csoundWriteRingBuffer(CSOUND *csound, void *rb, const void *in, int items)
 {
+    ring_buffer *p = (ring_buffer *) rb;
+    long    wp;
+    int     n, n1, elemsize;
     IGN(csound);
-    if (p == NULL) return 0;
-    int remaining;
-    int itemsread, numelem = ((circular_buffer *)p)->numelem;
-    int elemsize = ((circular_buffer *)p)->elemsize;
-    int i=0, rp = ((circular_buffer *)p)->rp;
-    char *buffer = ((circular_buffer *)p)->buffer;
-    if ((remaining = checkspace(p, 0)) == 0) {
-        return 0;
-    }
-    itemsread = items > remaining ? remaining : items;
-    for(i=0; i < itemsread; i++){
-        memcpy((char *) out + (i * elemsize),
-               &(buffer[elemsize * rp++]),  elemsize);
-        if (rp == numelem) {
-            rp = 0;
-        }
-    }
-    return itemsread;
+    if (UNLIKELY(p == NULL || items <= 0)) return 0;
+    wp = p->wp;
+    if ((n = rb_writable(p, wp, items)) == 0)
+      return 0;
+    if (n > items) n = items;
+    elemsize = p->elemsize;
+    n1 = p->size - (int) wp;
+    if (n1 > n) n1 = n;
+    memcpy(p->buffer + (size_t) wp * elemsize, in, (size_t) n1 * elemsize);
+    if (n > n1)
+      memcpy(p->buffer, (const char *) in + (size_t) n1 * elemsize,
+             (size_t) (n - n1) * elemsize);
+    wp += n;
+    if (wp >= p->size) wp -= p->size;
+    RB_STORE_REL(p->wp, wp);
+    rb_signal(p);
+    return n;
 }
 
-void csoundFlushCircularBuffer(CSOUND *csound, void *p)
+static int rb_copy_out(ring_buffer *p, long rp, void *out, int items)
+{
+    int     n, n1, elemsize;
+    if ((n = rb_readable(p, rp, items)) == 0)
+      return 0;
+    if (n > items) n = items;
+    elemsize = p->elemsize;
+    n1 = p->size - (int) rp;
+    if (n1 > n) n1 = n;
+    memcpy(out, p->buffer + (size_t) rp * elemsize, (size_t) n1 * elemsize);
+    if (n > n1)
+      memcpy((char *) out + (size_t) n1 * elemsize, p->buffer,
+             (size_t) (n - n1) * elemsize);
+    return n;
+}
+
+int csoundReadRingBuffer(CSOUND *csound, void *rb, void *out, int items)
 {
+    ring_buffer *p = (ring_buffer *) rb;
+    long    rp;
+    int     n;
     IGN(csound);
-    if (p == NULL) return;
-    int remaining;
-    int itemsread, numelem = ((circular_buffer *)p)->numelem;
-    int i=0, rp = ((circular_buffer *)p)->rp;
-    //MYFLT *buffer = ((circular_buffer *)p)->buffer;
-    if ((remaining = checkspace(p, 0)) == 0) {
-        return;
+    if (UNLIKELY(p == NULL || items <= 0)) return 0;
+    rp = p->rp;
+    if ((n = rb_copy_out(p, rp, out, items)) != 0) {
+      rp += n;
+      if (rp >= p->size) rp -= p->size;
+      RB_STORE_REL(p->rp, rp);
     }
-    itemsread = numelem > remaining ? remaining: numelem;
-    for (i=0; i < itemsread; i++){
-        rp++;
-        if(rp == numelem) rp = 0;
+    return n;
+}
+
+int csoundReserveRingBuffer(CSOUND *csound, void *rb, void **data, int items)
+{
+    ring_buffer *p = (ring_buffer *) rb;
+    long    wp;
+    int     n;
+    IGN(csound);
+    if (UNLIKELY(p == NULL || items <= 0)) return 0;
+    wp = p->wp;
+    n = rb_writable(p, wp, items);
+    if (n > p->size - (int) wp) n = p->size - (int) wp;
+    if (n > items) n = items;
+    *data = p->buffer + (size_t) wp * p->elemsize;
+    return n;
+}
+
+void csoundCommitRingBuffer(CSOUND *csound, void *rb, int items)
+{
+    ring_buffer *p = (ring_buffer *) rb;
+    long    wp;
+    IGN(csound);
+    if (UNLIKELY(p == NULL || items <= 0)) return;
+    wp = p->wp + items;
+    if (wp >= p->size) wp -= p->size;
+    RB_STORE_REL(p->wp, wp);
+    rb_signal(p);
+}
+
+int csoundAcquireRingBuffer(CSOUND *csound, void *rb, void **data, int items)
+{
+    ring_buffer *p = (ring_buffer *) rb;
+    long    rp;
+    int     n;
+    IGN(csound);
+    if (UNLIKELY(p == NULL || items <= 0)) return 0;
+    rp = p->rp;
+    n = rb_readable(p, rp, items);
+    if (n > p->size - (int) rp) n = p->size - (int) rp;
+    if (n > items) n = items;
+    *data = p->buffer + (size_t) rp * p->elemsize;
+    return n;
+}
+
+void csoundReleaseRingBuffer(CSOUND *csound, void *rb, int items)
+{
+    ring_buffer *p = (ring_buffer *) rb;
+    long    rp;
+    IGN(csound);
+    if (UNLIKELY(p == NULL || items <= 0)) return;
+    rp = p->rp + items;
+    if (rp >= p->size) rp -= p->size;
+    RB_STORE_REL(p->rp, rp);
+}
+
+int csoundWaitRingBuffer(CSOUND *csound, void *rb, int items, int timeout)
+{
+    ring_buffer *p = (ring_buffer *) rb;
+    int     n, event;
+#if defined(LINUX)
+    struct timespec now, end, ts;
+#endif
+    IGN(csound);
+    if (UNLIKELY(p == NULL)) return 0;
+    if (items > p->size - 1) items = p->size - 1;
+    if ((n = rb_readable(p, p->rp, items)) >= items || timeout == 0)
+      return n;
+#if defined(LINUX)
+    if (timeout > 0) {
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      end.tv_sec += timeout / 1000;
+      end.tv_nsec += (long) (timeout % 1000) * 1000000L;
+      if (end.tv_nsec >= 1000000000L) {
+        end.tv_sec++;
+        end.tv_nsec -= 1000000000L;
+      }
     }
+#endif
 #if defined(MSVC)
-      InterlockedExchange(&((circular_buffer *)p)->rp, rp);
+    InterlockedExchange((volatile long *) &p->waiting, 1);
 #elif defined(HAVE_ATOMIC_BUILTIN)
-      __atomic_store_n(&((circular_buffer *)p)->rp,rp, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&p->waiting, 1, __ATOMIC_SEQ_CST);
 #else
-      ((circular_buffer *)p)->rp = rp;
+    p->waiting = 1;
 #endif
+    RB_FENCE();
+    for (;;) {
+      /* load event before looking at the ring, so that a write after the
+         look changes it and the wait below returns at once */
+      event = RB_LOAD_ACQ(p->event);
+      if ((n = rb_readable(p, p->rp, items)) >= items)
+        break;
+      if (RB_LOAD_ACQ(p->wake) && RB_SWAP(p->wake, 0))
+        break;
+#if defined(LINUX)
+      if (timeout > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ts.tv_sec = end.tv_sec - now.tv_sec;
+        ts.tv_nsec = end.tv_nsec - now.tv_nsec;
+        if (ts.tv_nsec < 0) {
+          ts.tv_sec--;
+          ts.tv_nsec += 1000000000L;
+        }
+        if (ts.tv_sec < 0)
+          break;
+      }
+      syscall(SYS_futex, &p->event, FUTEX_WAIT_PRIVATE, event,
+              timeout > 0 ? &ts : NULL, NULL, 0);
+#else
+      /* no futex: sleep a millisecond at a time */
+      IGN(event);
+      csoundSleep(1);
+      if (timeout > 0 && --timeout == 0) {
+        n = rb_readable(p, p->rp, items);
+        break;
+      }
+#endif
+    }
+    RB_STORE_REL(p->waiting, 0);
+    return n;
 }
 
-
-int csoundWriteCircularBuffer(CSOUND *csound, void *p, const void *in, int items)
+void csoundWakeRingBuffer(CSOUND *csound, void *rb)
 {
+    ring_buffer *p = (ring_buffer *) rb;
     IGN(csound);
-    if (p == NULL) return 0;
-    int remaining;
-    int itemswrite, numelem = ((circular_buffer *)p)->numelem;
-    int elemsize = ((circular_buffer *)p)->elemsize;
-    int i=0, wp = ((circular_buffer *)p)->wp;
-    char *buffer = ((circular_buffer *)p)->buffer;
-    if ((remaining = checkspace(p, 1)) == 0) {
-        return 0;
-    }
-    itemswrite = items > remaining ? remaining : items;
-    for(i=0; i < itemswrite; i++){
-        memcpy(&(buffer[elemsize * wp++]),
-                ((char *) in) + (i * elemsize),  elemsize);
-        if(wp == numelem) wp = 0;
-    }
+    if (UNLIKELY(p == NULL)) return;
+    RB_STORE_REL(p->wake, 1);
 #if defined(MSVC)
-      InterlockedExchange(&((circular_buffer *)p)->wp, wp);
+    InterlockedIncrement((volatile long *) &p->event);
 #elif defined(HAVE_ATOMIC_BUILTIN)
-      __atomic_store_n(&((circular_buffer *)p)->wp,wp, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&p->event, 1, __ATOMIC_SEQ_CST);
 #else
-      ((circular_buffer *)p)->wp = wp;
+    p->event++;
+#endif
+#if defined(LINUX)
+    rb_futex_wake(&p->event);
 #endif
-    return itemswrite;
 }
 
-void csoundDestroyCircularBuffer(CSOUND *csound, void *p){
-    if(p == NULL) return;
-    csound->Free(csound, ((circular_buffer *)p)->buffer);
-    csound->Free(csound, p);
+/* circular buffer: a ring holding numelem - 1 elements */
+
+void *csoundCreateCircularBuffer(CSOUND *csound, int numelem, int elemsize)
+{
+    return csoundCreateRingBuffer(csound, numelem - 1, elemsize);
+}
+
+int csoundReadCircularBuffer(CSOUND *csound, void *p, void *out, int items)
+{
+    return csoundReadRingBuffer(csound, p, out, items);
+}
+
+int csoundPeekCircularBuffer(CSOUND *csound, void *p, void *out, int items)
+{
+    IGN(csound);
+    if (p == NULL || items <= 0) return 0;
+    return rb_copy_out((ring_buffer *) p, ((ring_buffer *) p)->rp, out, items);
+}
+
+void csoundFlushCircularBuffer(CSOUND *csound, void *p)
+{
+    IGN(csound);
+    if (p == NULL) return;
+    csoundReleaseRingBuffer(csound, p,
+                            rb_readable((ring_buffer *) p,
+                                        ((ring_buffer *) p)->rp, INT_MAX));
+}
+
+int csoundWriteCircularBuffer(CSOUND *csound, void *p, const void *in, int items)
+{
+    return csoundWriteRingBuffer(csound, p, in, items);
+}
+
+void csoundDestroyCircularBuffer(CSOUND *csound, void *p)
+{
+    csoundDestroyRingBuffer(csound, p);
 }
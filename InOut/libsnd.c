@@ -158,22 +158,180 @@ static void spoutsf_noscale(CSOUND *csound)
     csound->libsndStatics.nframes = nframes;
 }
 
-/* diskfile write option for audtran's */
-/*      assigned during sfopenout()    */
+/* background disk writer (--async-write): audtran only copies the
+   samples to a ring, and a thread writes them to the file in large
+   chunks, rewriting the header once a second with -R */
 
-static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+typedef struct {
+    CSOUND  *csound;
+    SNDFILE *outfile;
+    void    *ring;                /* of MYFLT                     */
+    void    *thread;
+    void    *space;               /* notified as the ring empties */
+    int     chunk;                /* samples per write            */
+    int     rewrt_hdr;
+    volatile long done, error;
+    int     nret, nput;           /* of the write that failed     */
+    long    writes;               /* counted by the writer        */
+    double  written;              /* samples                      */
+    long    stalls;               /* times audtran found it full  */
+    double  stallTime;
+    RTCLOCK clk;
+} SNDWRITER;
+
+static uintptr_t sndwriter_thread(void *wp)
 {
-    OPARMS  *O = csound->oparms;
+    SNDWRITER *w = (SNDWRITER*) wp;
+    CSOUND  *csound = w->csound;
+    double  hdrTime = 0.0;
+    int     avail, n, m;
+    void    *data;
+
+    for (;;) {
+      long  done = ATOMIC_GET(w->done);
+      /* wait for a whole chunk, or write what there is now and then */
+      avail = csound->WaitRingBuffer(csound, w->ring, w->chunk,
+                                     done ? 0 : 250);
+      while (avail > 0) {
+        n = csound->AcquireRingBuffer(csound, w->ring, &data, avail);
+        if (LIKELY(!w->error)) {
+          m = (int) sf_write_MYFLT(w->outfile, (MYFLT*) data, n);
+          if (UNLIKELY(m < n)) {
+            w->nret = m * (int) sizeof(MYFLT);
+            w->nput = n * (int) sizeof(MYFLT);
+            ATOMIC_SET(w->error, 1);
+          }
+          w->writes++;
+          w->written += n;
+        }
+        csound->ReleaseRingBuffer(csound, w->ring, n);
+        csound->NotifyThreadLock(w->space);
+        avail -= n;
+      }
+      if (w->rewrt_hdr && !w->error &&
+          csoundGetRealTime(&w->clk) - hdrTime >= 1.0) {
+        rewriteheader((void *) w->outfile);
+        hdrTime = csoundGetRealTime(&w->clk);
+      }
+      if (done && csound->WaitRingBuffer(csound, w->ring, 1, 0) == 0)
+        break;
+    }
+    return (uintptr_t) 0;
+}
+
+static void sndwriter_start(CSOUND *csound)
+{
+    OPARMS    *O = csound->oparms;
+    SNDWRITER *w;
+    int       size;
+
+    size = (int) (((int64_t) O->asyncWrite << 20) / (int64_t) sizeof(MYFLT));
+    if (size < 4 * (int) O->outbufsamps)
+      size = 4 * (int) O->outbufsamps;
+    w = (SNDWRITER*) csound->Calloc(csound, sizeof(SNDWRITER));
+    w->csound = csound;
+    w->outfile = STA(outfile);
+    w->ring = csound->CreateRingBuffer(csound, size, sizeof(MYFLT));
+    w->space = csound->CreateThreadLock();
+    w->chunk = size / 8;
+    w->rewrt_hdr = O->rewrt_hdr;
+    csoundInitTimerStruct(&w->clk);
+    if (UNLIKELY(w->ring == NULL || w->space == NULL ||
+                 (w->thread = csound->CreateThread(sndwriter_thread,
+                                                   (void*) w)) == NULL)) {
+      csound->Warning(csound, "%s", Str("cannot start the disk writer thread, "
+                                        "writing synchronously"));
+      if (w->space != NULL) csound->DestroyThreadLock(w->space);
+      csound->DestroyRingBuffer(csound, w->ring);
+      csound->Free(csound, w);
+      return;
+    }
+    STA(writer) = w;
+}
+
+/* write everything still queued and report how the writer kept up;
+   returns nonzero if a write failed */
+static int sndwriter_stop(CSOUND *csound)
+{
+    SNDWRITER *w = (SNDWRITER*) STA(writer);
+    int       err;
+
+    STA(writer) = NULL;
+    ATOMIC_SET(w->done, 1);
+    csound->WakeRingBuffer(csound, w->ring);
+    csound->JoinThread(w->thread);
+    if ((err = (int) w->error) == 1)
+      csound->ErrorMsg(csound,
+                       Str("soundfile write returned bytecount of %d, not %d"),
+                       w->nret, w->nput);
+    csound->Message(csound,
+                    Str("disk writer: %ld writes of %.0f kB on average, "
+                        "waited %.3f s for it in %ld stalls\n"),
+                    w->writes,
+                    (w->writes ? w->written * sizeof(MYFLT) / w->writes
+                                 / 1024.0 : 0.0),
+                    w->stallTime, w->stalls);
+    csound->DestroyThreadLock(w->space);
+    csound->DestroyRingBuffer(csound, w->ring);
+    csound->Free(csound, w);
+    return err;
+}
+
+/* queue samples for the writer, waiting while the ring is full */
+static void sndwriter_put(CSOUND *csound, SNDWRITER *w,
+                          const MYFLT *buf, int nsmps)
+{
+    double  t0 = 0.0;
     int     n;
 
-    if (UNLIKELY(STA(outfile) == NULL))
+    while (1) {
+      if (UNLIKELY(ATOMIC_GET(w->error))) {
+        ATOMIC_SET(w->error, 2);        /* reported here */
+        sndwrterr(csound, w->nret, w->nput);
+        return;
+      }
+      n = csound->WriteRingBuffer(csound, w->ring, buf, nsmps);
+      buf += n;
+      if ((nsmps -= n) == 0)
+        break;
+      if (t0 == 0.0) {
+        t0 = csoundGetRealTime(&w->clk);
+        w->stalls++;
+      }
+      csound->WaitThreadLock(w->space, (size_t) 10);
+    }
+    if (t0 != 0.0)
+      w->stallTime += csoundGetRealTime(&w->clk) - t0;
+}
+
+static inline void sndwrite(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    int     n;
+
+    if (STA(writer) != NULL) {
+      sndwriter_put(csound, (SNDWRITER*) STA(writer), outbuf,
+                    nbytes / (int) sizeof(MYFLT));
       return;
+    }
     n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
                              nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
     if (UNLIKELY(n < nbytes))
       sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
+    if (UNLIKELY(csound->oparms->rewrt_hdr))
       rewriteheader((void *)STA(outfile));
+}
+
+/* diskfile write option for audtran's */
+/*      assigned during sfopenout()    */
+
+static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    OPARMS  *O = csound->oparms;
+    int     n;
+
+    if (UNLIKELY(STA(outfile) == NULL))
+      return;
+    sndwrite(csound, outbuf, nbytes);
     switch (O->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
@@ -222,12 +380,7 @@ static void writesf_dither_16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
+    sndwrite(csound, outbuf, nbytes);
     switch (O->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
@@ -276,12 +429,7 @@ static void writesf_dither_8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
+    sndwrite(csound, outbuf, nbytes);
     switch (O->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
@@ -328,12 +476,7 @@ static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
+    sndwrite(csound, outbuf, nbytes);
     switch (O->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
@@ -380,12 +523,7 @@ static void writesf_dither_u8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       buf[n] += result;
     }
     STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
+    sndwrite(csound, outbuf, nbytes);
     switch (O->heartbeat) {
       case 1:
         csound->MessageS(csound, CSOUNDMSG_REALTIME,
@@ -860,6 +998,8 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
       sf_set_string(STA(outfile), SF_STR_DATE, s);
     /* file is now open */
     STA(osfopen) = 1;
+    if (O->asyncWrite > 0)
+      sndwriter_start(csound);
 
  outset:
     O->sfsampsize = (int) sfsampsize(FORMAT2SF(O->outformat));
@@ -927,6 +1067,8 @@ void sfcloseout(CSOUND *csound)
     }
     if (STA(pipdevout) == 2)
       goto report;
+    if (STA(writer) != NULL)
+      sndwriter_stop(csound);
     if (STA(outfile) != NULL) {
       if (!STA(pipdevout) && O->outformat != AE_VORBIS)
         sf_command(STA(outfile), SFC_UPDATE_HEADER_NOW, NULL, 0);
@@ -1184,8 +1184,8 @@ int MidiInProcessCallback(jack_nframes_t nframes, void *userData){
     while(jack_midi_event_get(&event,
                               jack_port_get_buffer(dev->port,nframes),
                               n++) == 0) {
-      if (UNLIKELY(csound->WriteCircularBuffer(csound,dev->cb,
-                                              event.buffer,event.size)
+      if (UNLIKELY(csound->WriteRingBuffer(csound,dev->cb,
+                                            event.buffer,event.size)
                   != (int) event.size)){
         csound->Warning(csound, "%s", Str("Jack MIDI module: buffer overflow"));
         return 1;
@@ -1234,15 +1234,15 @@ static int midi_in_open(CSOUND *csound,
     dev->client = jack_client;
     dev->port = jack_port;
     dev->csound = csound;
-    dev->cb = csound->CreateCircularBuffer(csound,
-                                           JACK_MIDI_BUFFSIZE,
-                                           sizeof(char));
+    dev->cb = csound->CreateRingBuffer(csound,
+                                       JACK_MIDI_BUFFSIZE,
+                                       sizeof(char));
 
     if (UNLIKELY(jack_set_process_callback(jack_client,
                                           MidiInProcessCallback,
                                           (void*) dev) != 0)){
       jack_client_close(jack_client);
-      csound->DestroyCircularBuffer(csound, dev->cb);
+      csound->DestroyRingBuffer(csound, dev->cb);
       csound->Free(csound, dev);
       csound->ErrorMsg(csound,
                        "%s", Str("Jack MIDI module: failed to set input"
@@ -1252,7 +1252,7 @@ static int midi_in_open(CSOUND *csound,
 
     if (UNLIKELY(jack_activate(jack_client) != 0)){
       jack_client_close(jack_client);
-      csound->DestroyCircularBuffer(csound, dev->cb);
+      csound->DestroyRingBuffer(csound, dev->cb);
       csound->Free(csound, dev);
       *userData = NULL;
       csound->ErrorMsg(csound, "%s",
@@ -1276,7 +1276,7 @@ static int midi_in_read(CSOUND *csound,
                         void *userData, unsigned char *buf, int nbytes)
 {
     jackMidiDevice *dev = (jackMidiDevice *) userData;
-    return csound->ReadCircularBuffer(csound,dev->cb,buf,nbytes);
+    return csound->ReadRingBuffer(csound,dev->cb,buf,nbytes);
 }
 
 static int midi_in_close(CSOUND *csound, void *userData){
@@ -1284,7 +1284,7 @@ static int midi_in_close(CSOUND *csound, void *userData){
     if(dev != NULL) {
       jack_port_disconnect(dev->client, dev->port);
       jack_client_close(dev->client);
-      csound->DestroyCircularBuffer(csound, dev->cb);
+      csound->DestroyRingBuffer(csound, dev->cb);
       csound->Free(csound, dev);
     }
     return OK;
@@ -1294,17 +1294,19 @@ int MidiOutProcessCallback(jack_nframes_t nframes, void *userData){
 
     jackMidiDevice *dev = (jackMidiDevice *) userData;
     CSOUND *csound = dev->csound;
-    jack_midi_data_t buf[JACK_MIDI_BUFFSIZE];
+    void *buf;
     int n;
     jack_midi_clear_buffer(jack_port_get_buffer(dev->port,nframes));
-    while((n = csound->ReadCircularBuffer(csound,dev->cb,
-                                          buf,
-                                          JACK_MIDI_BUFFSIZE)) != 0) {
+    /* pass the bytes to jack in place, in at most two spans */
+    while((n = csound->AcquireRingBuffer(csound,dev->cb,
+                                         &buf,
+                                         JACK_MIDI_BUFFSIZE)) != 0) {
       if(UNLIKELY(jack_midi_event_write(jack_port_get_buffer(dev->port,nframes),
-                                        0, buf,n) != 0)){
+                                        0, (jack_midi_data_t*) buf,n) != 0)){
         csound->Warning(csound, "%s", Str("Jack MIDI module: out buffer overflow"));
         return 1;
       }
+      csound->ReleaseRingBuffer(csound,dev->cb,n);
     }
     return 0;
 }
@@ -1347,15 +1349,15 @@ static int midi_out_open(CSOUND *csound, void **userData,
     dev->client = jack_client;
     dev->port = jack_port;
     dev->csound = csound;
-    dev->cb = csound->CreateCircularBuffer(csound,
-                                           JACK_MIDI_BUFFSIZE,
-                                           sizeof(char));
+    dev->cb = csound->CreateRingBuffer(csound,
+                                       JACK_MIDI_BUFFSIZE,
+                                       sizeof(char));
 
     if(UNLIKELY(jack_set_process_callback(jack_client,
                                           MidiOutProcessCallback,
                                           (void*) dev) != 0)){
       jack_client_close(jack_client);
-      csound->DestroyCircularBuffer(csound, dev->cb);
+      csound->DestroyRingBuffer(csound, dev->cb);
       csound->Free(csound, dev);
       csound->ErrorMsg(csound,
                        "%s", Str("Jack MIDI module: failed to set input"
@@ -1365,7 +1367,7 @@ static int midi_out_open(CSOUND *csound, void **userData,
 
     if(UNLIKELY(jack_activate(jack_client) != 0)){
       jack_client_close(jack_client);
-      csound->DestroyCircularBuffer(csound, dev->cb);
+      csound->DestroyRingBuffer(csound, dev->cb);
       csound->Free(csound, dev);
       *userData = NULL;
       csound->ErrorMsg(csound, "%s",
@@ -1390,7 +1392,7 @@ static int midi_out_write(CSOUND *csound,
                           void *userData, const unsigned char *buf, int nbytes)
 {
     jackMidiDevice *dev = (jackMidiDevice *) userData;
-    return csound->WriteCircularBuffer(csound,dev->cb,buf,nbytes);
+    return csound->WriteRingBuffer(csound,dev->cb,buf,nbytes);
 }
 
 static int midi_out_close(CSOUND *csound, void *userData){
@@ -1398,7 +1400,7 @@ static int midi_out_close(CSOUND *csound, void *userData){
     if(dev != NULL) {
       jack_port_disconnect(dev->client, dev->port);
       jack_client_close(dev->client);
-      csound->DestroyCircularBuffer(csound, dev->cb);
+      csound->DestroyRingBuffer(csound, dev->cb);
       csound->Free(csound, dev);
     }
     return OK;
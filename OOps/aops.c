@@ -22,6 +22,7 @@
 
 #include "csoundCore.h" /*                                      AOPS.C  */
 #include "aops.h"
+#include "aops_simd.h"
 #include <math.h>
 #include <time.h>
 
@@ -123,14 +124,13 @@ int32_t ainit(CSOUND *csound, ASSIGN *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     MYFLT aa = *p->a;
-    int32_t   n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
     if (UNLIKELY(offset)) memset(p->r, '\0', offset*sizeof(MYFLT));
     if (UNLIKELY(early)) {
       nsmps -= early;
       memset(&p->r[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++)
-      p->r[n] = aa;
+    aops_kernels->fill(p->r, aa, offset, nsmps);
     return OK;
 }
 
@@ -275,9 +275,9 @@ int32_t modkk(CSOUND *csound, AOP *p)
     return OK;
 }
 
-#define KA(OPNAME,OP)                                  \
+#define KA(OPNAME,OP,IDX)                              \
   int32_t OPNAME(CSOUND *csound, AOP *p) {             \
-    uint32_t n, nsmps = CS_KSMPS;                      \
+    uint32_t nsmps = CS_KSMPS;                         \
     IGN(csound);                                       \
     if (LIKELY(nsmps!=1)) {                            \
       MYFLT   *r, a, *b;                               \
@@ -291,8 +291,7 @@ int32_t modkk(CSOUND *csound, AOP *p)
         nsmps -= early;                                \
         memset(&r[nsmps], '\0', early*sizeof(MYFLT));  \
       }                                                \
-      for (n=offset; n<nsmps; n++)                     \
-        r[n] = a OP b[n];                              \
+      aops_kernels->sv[IDX](r, a, b, offset, nsmps);  \
       return OK;                                       \
     }                                                  \
     else {                                             \
@@ -302,10 +301,10 @@ int32_t modkk(CSOUND *csound, AOP *p)
   }
 
 
-KA(addka,+)
-KA(subka,-)
-KA(mulka,*)
-KA(divka,/)
+KA(addka,+,AOP_ADD)
+KA(subka,-,AOP_SUB)
+KA(mulka,*,AOP_MUL)
+KA(divka,/,AOP_DIV)
 
 int32_t modka(CSOUND *csound, AOP *p)
 {
@@ -328,9 +327,9 @@ int32_t modka(CSOUND *csound, AOP *p)
     return OK;
 }
 
-#define AK(OPNAME,OP)                           \
+#define AK(OPNAME,OP,IDX)                       \
   int32_t OPNAME(CSOUND *csound, AOP *p) {      \
-    uint32_t n, nsmps = CS_KSMPS;               \
+    uint32_t nsmps = CS_KSMPS;                  \
     IGN(csound);                                \
     if (LIKELY(nsmps != 1)) {                   \
       MYFLT   *r, *a, b;                        \
@@ -345,8 +344,7 @@ int32_t modka(CSOUND *csound, AOP *p)
         nsmps -= early;                         \
         memset(&r[nsmps], '\0', early*sizeof(MYFLT)); \
       }                                         \
-      for (n=offset; n<nsmps; n++)              \
-        r[n] = a[n] OP b;                       \
+      aops_kernels->vs[IDX](r, a, b, offset, nsmps); \
       return OK;                                \
     }                                           \
     else {                                      \
@@ -355,12 +353,12 @@ int32_t modka(CSOUND *csound, AOP *p)
     }                                           \
 }
 
-AK(addak,+)
-AK(subak,-)
-AK(mulak,*)
+AK(addak,+,AOP_ADD)
+AK(subak,-,AOP_SUB)
+AK(mulak,*,AOP_MUL)
 //AK(divak,/)
 int32_t divak(CSOUND *csound, AOP *p) {
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
     MYFLT b = *p->b;
     if (LIKELY(nsmps != 1)) {
       MYFLT   *r, *a;
@@ -377,8 +375,7 @@ int32_t divak(CSOUND *csound, AOP *p) {
         nsmps -= early;
         memset(&r[nsmps], '\0', early*sizeof(MYFLT));
       }
-      for (n=offset; n<nsmps; n++)
-        r[n] = a[n] / b;
+      aops_kernels->vs[AOP_DIV](r, a, b, offset, nsmps);
       return OK;
     }
     else {
@@ -411,11 +408,11 @@ int32_t modak(CSOUND *csound, AOP *p)
     return OK;
 }
 
-#define AA(OPNAME,OP)                           \
+#define AA(OPNAME,OP,IDX)                       \
   int32_t OPNAME(CSOUND *csound, AOP *p) {      \
   MYFLT   *r, *a, *b;                           \
   IGN(csound);                                  \
-  uint32_t n, nsmps = CS_KSMPS;                 \
+  uint32_t nsmps = CS_KSMPS;                    \
   if (LIKELY(nsmps!=1)) {                       \
     uint32_t offset = p->h.insdshead->ksmps_offset;  \
     uint32_t early  = p->h.insdshead->ksmps_no_end;  \
@@ -427,8 +424,7 @@ int32_t modak(CSOUND *csound, AOP *p)
       nsmps -= early;                           \
       memset(&r[nsmps], '\0', early*sizeof(MYFLT)); \
     }                                           \
-    for (n=offset; n<nsmps; n++)                \
-      r[n] = a[n] OP b[n];                      \
+    aops_kernels->vv[IDX](r, a, b, offset, nsmps); \
     return OK;                                  \
   }                                             \
     else {                                      \
@@ -437,52 +433,10 @@ int32_t modak(CSOUND *csound, AOP *p)
     }                                           \
   }
 
-/* VL
-   experimental code using SSE for operations
-   needs memory alignment - 16 bytes
-*/
-#ifdef USE_SSE
-#include "emmintrin.h"
-#define AA_VEC(OPNAME,OP)                   \
-int32_t OPNAME(CSOUND *csound, AOP *p){     \
-  MYFLT   *r, *a, *b;                       \
-  __m128d va, vb;                           \
-  uint32_t n, nsmps = CS_KSMPS, end;        \
-  if (LIKELY(nsmps!=1)) {                   \
-  uint32_t offset = p->h.insdshead->ksmps_offset; \
-  uint32_t early  = p->h.insdshead->ksmps_no_end; \
-  r = p->r; a = p->a; b = p->b;             \
-  if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT)); \
-  if (UNLIKELY(early)) {                    \
-      nsmps -= early;                       \
-      memset(&r[nsmps], '\0', early*sizeof(MYFLT));  \
-  } \
-  end = nsmps; \
-  for (n=offset; n<end; n+=2) { \
-   va = _mm_loadu_pd(&a[n]); \
-   vb = _mm_loadu_pd(&b[n]); \
-   va = OP(va,vb);\
-   _mm_storeu_pd(&r[n],va); \
-  }     \
-  return OK; \
-  } \
-   else { \
-     *p->r = *p->a + *p->b;\
-      return OK; \
-   }             \
-} \
-
-AA_VEC(addaa,_mm_add_pd)
-AA_VEC(subaa,_mm_sub_pd)
-AA_VEC(mulaa,_mm_mul_pd)
-AA_VEC(divaa,_mm_div_pd)
-
-#else
-AA(addaa,+)
-AA(subaa,-)
-AA(mulaa,*)
-AA(divaa,/)
-#endif
+AA(addaa,+,AOP_ADD)
+AA(subaa,-,AOP_SUB)
+AA(mulaa,*,AOP_MUL)
+AA(divaa,/,AOP_DIV)
 
 int32_t modaa(CSOUND *csound, AOP *p)
 {
@@ -505,6 +459,188 @@ int32_t modaa(CSOUND *csound, AOP *p)
     return OK;
 }
 
+/* Fused expressions.  The program text is compiled once per instance into
+   (op, arg) pairs; each k-cycle runs it over tiles of FUSE_TILE samples
+   with the same kernels and libm calls as the separate opcodes, so the
+   result is sample-for-sample identical.                                */
+
+enum { FOP_VEC, FOP_SCAL, FOP_BIN, FOP_FN };
+enum { FFN_ABS, FFN_EXP, FFN_LOG, FFN_SQRT, FFN_SIN, FFN_COS, FFN_TAN,
+       FFN_SININV, FFN_COSINV, FFN_TANINV, FFN_SINH, FFN_COSH, FFN_TANH,
+       FFN_LOG10, FFN_LOG2 };
+
+static const char *fuse_fn_names[] = {
+    "abs", "exp", "log", "sqrt", "sin", "cos", "tan", "sininv", "cosinv",
+    "taninv", "sinh", "cosh", "tanh", "log10", "log2", NULL
+};
+
+typedef struct {
+    uint8_t op, arg;
+} FUSE_CODE;
+
+/* Index of a one-argument function the fused opcode can evaluate, or -1.
+   Used by the optimiser to decide which "fn.a" opcodes it may absorb.  */
+int32_t fuse_function_id(const char *name)
+{
+    int32_t i;
+    for (i = 0; fuse_fn_names[i] != NULL; i++)
+      if (strcmp(fuse_fn_names[i], name) == 0) return i;
+    return -1;
+}
+
+int32_t fused_set(CSOUND *csound, FUSED *p)
+{
+    const char *s = p->prog->data;
+    int32_t   nargs = p->INOCOUNT - 1, n = 0, depth = 0, maxdepth = 0;
+    FUSE_CODE *code;
+
+    if (p->code.auxp != NULL && p->ncode > 0)
+      return OK;                /* program text is constant */
+    csound->AuxAlloc(csound, (strlen(s) / 2 + 1) * sizeof(FUSE_CODE),
+                     &p->code);
+    code = (FUSE_CODE *) p->code.auxp;
+    while (*s != '\0') {
+      char    tok[16];
+      int32_t len = 0, idx;
+      while (*s == ' ') s++;
+      if (*s == '\0') break;
+      while (s[len] != ' ' && s[len] != '\0' && len < 15) {
+        tok[len] = s[len]; len++;
+      }
+      tok[len] = '\0';
+      s += len;
+      if ((tok[0] == 'a' || tok[0] == 'k') &&
+          tok[1] >= '0' && tok[1] <= '9') {
+        idx = atoi(tok + 1);
+        if (UNLIKELY(idx >= nargs))
+          return csound->InitError(csound, Str("fused expression: "
+                                               "bad argument %s"), tok);
+        code[n].op = (tok[0] == 'a' ? FOP_VEC : FOP_SCAL);
+        code[n].arg = (uint8_t) idx;
+        if (++depth > maxdepth) maxdepth = depth;
+      }
+      else if (len == 1 && strchr("+-*/", tok[0]) != NULL) {
+        code[n].op = FOP_BIN;
+        code[n].arg = (tok[0] == '+' ? AOP_ADD : tok[0] == '-' ? AOP_SUB :
+                       tok[0] == '*' ? AOP_MUL : AOP_DIV);
+        if (UNLIKELY(--depth < 1)) goto bad;
+      }
+      else if ((idx = fuse_function_id(tok)) >= 0) {
+        code[n].op = FOP_FN;
+        code[n].arg = (uint8_t) idx;
+        if (UNLIKELY(depth < 1)) goto bad;
+      }
+      else
+        return csound->InitError(csound, Str("fused expression: "
+                                             "unknown token %s"), tok);
+      n++;
+    }
+    if (UNLIKELY(depth != 1 || maxdepth > FUSE_MAXDEPTH || n == 0)) goto bad;
+    p->ncode = n;
+    return OK;
+ bad:
+    return csound->InitError(csound, Str("fused expression: bad program %s"),
+                             p->prog->data);
+}
+
+#define FUSE_FN(ID, LIBNAME)                                            \
+    case ID: for (i = 0; i < len; i++) dst[i] = LIBNAME(src[i]); break;
+
+int32_t fused(CSOUND *csound, FUSED *p)
+{
+    const FUSE_CODE *code = (const FUSE_CODE *) p->code.auxp;
+    const AOPS_KERNELS *kern = aops_kernels;
+    MYFLT   tmp[FUSE_MAXDEPTH][FUSE_TILE];
+    struct { MYFLT *v; MYFLT s; } stk[FUSE_MAXDEPTH];
+    MYFLT   *r = p->r;
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t t, i, nsmps = CS_KSMPS;
+    int32_t  pc, ncode = p->ncode, sp;
+
+    if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT));
+    if (UNLIKELY(early)) {
+      nsmps -= early;
+      memset(&r[nsmps], '\0', early*sizeof(MYFLT));
+    }
+    /* as divak, warn about a k-rate divisor of zero */
+    for (pc = 1; pc < ncode; pc++)
+      if (code[pc].op == FOP_BIN && code[pc].arg == AOP_DIV &&
+          code[pc-1].op == FOP_SCAL && *p->args[code[pc-1].arg] == FL(0.0))
+        csound->Warning(csound, Str("Division by zero"));
+
+    for (t = offset; t < nsmps; t += FUSE_TILE) {
+      uint32_t len = (nsmps - t < FUSE_TILE ? nsmps - t : FUSE_TILE);
+      sp = 0;
+      for (pc = 0; pc < ncode; pc++) {
+        MYFLT *dst;
+        switch (code[pc].op) {
+        case FOP_VEC:
+          stk[sp++].v = p->args[code[pc].arg] + t;
+          break;
+        case FOP_SCAL:
+          stk[sp].v = NULL;
+          stk[sp++].s = *p->args[code[pc].arg];
+          break;
+        case FOP_BIN:
+          {
+            int32_t op = code[pc].arg;
+            sp--;
+            dst = (pc == ncode - 1 ? r + t : tmp[sp-1]);
+            if (stk[sp-1].v != NULL && stk[sp].v != NULL)
+              kern->vv[op](dst, stk[sp-1].v, stk[sp].v, 0, len);
+            else if (stk[sp-1].v != NULL)
+              kern->vs[op](dst, stk[sp-1].v, stk[sp].s, 0, len);
+            else if (stk[sp].v != NULL)
+              kern->sv[op](dst, stk[sp-1].s, stk[sp].v, 0, len);
+            else {
+              MYFLT a = stk[sp-1].s, b = stk[sp].s;
+              stk[sp-1].s = (op == AOP_ADD ? a + b : op == AOP_SUB ? a - b :
+                             op == AOP_MUL ? a * b : a / b);
+              if (pc == ncode - 1) kern->fill(dst, stk[sp-1].s, 0, len);
+              break;
+            }
+            stk[sp-1].v = dst;
+          }
+          break;
+        case FOP_FN:
+          {
+            MYFLT *src = stk[sp-1].v, sval = stk[sp-1].s;
+            dst = (pc == ncode - 1 ? r + t : tmp[sp-1]);
+            if (src == NULL) {          /* function of a scalar */
+              kern->fill(dst, sval, 0, len);
+              src = dst;
+            }
+            switch (code[pc].arg) {
+              FUSE_FN(FFN_ABS, FABS)
+              FUSE_FN(FFN_EXP, EXP)
+              FUSE_FN(FFN_LOG, LOG)
+              FUSE_FN(FFN_SQRT, SQRT)
+              FUSE_FN(FFN_SIN, SIN)
+              FUSE_FN(FFN_COS, COS)
+              FUSE_FN(FFN_TAN, TAN)
+              FUSE_FN(FFN_SININV, ASIN)
+              FUSE_FN(FFN_COSINV, ACOS)
+              FUSE_FN(FFN_TANINV, ATAN)
+              FUSE_FN(FFN_SINH, SINH)
+              FUSE_FN(FFN_COSH, COSH)
+              FUSE_FN(FFN_TANH, TANH)
+              FUSE_FN(FFN_LOG10, LOG10)
+              FUSE_FN(FFN_LOG2, LOG2)
+            }
+            stk[sp-1].v = dst;
+          }
+          break;
+        }
+      }
+      if (UNLIKELY(code[ncode-1].op < FOP_BIN)) {   /* bare operand */
+        if (stk[0].v != NULL) memcpy(r + t, stk[0].v, len*sizeof(MYFLT));
+        else kern->fill(r + t, stk[0].s, 0, len);
+      }
+    }
+    return OK;
+}
+
 int32_t divzkk(CSOUND *csound, DIVZ *p)
 {
     IGN(csound);
@@ -2052,12 +2188,11 @@ int32_t addina(CSOUND *csound, ASSIGN *p)
     MYFLT* val = p->a;
     MYFLT* ans = p->r;
     uint32_t    offset = p->h.insdshead->ksmps_offset;
-    uint32_t    nsmps = CS_KSMPS, n;
+    uint32_t    nsmps = CS_KSMPS;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
     CSOUND_SPOUT_SPINLOCK
-    for (n=offset; n<early; n++)
-      ans[n] += val[n];
+    aops_kernels->vv[AOP_ADD](ans, ans, val, offset, early);
     CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
@@ -2067,13 +2202,12 @@ int32_t addinak(CSOUND *csound, ASSIGN *p)
     MYFLT val;
     MYFLT* ans = p->r;
     uint32_t    offset = p->h.insdshead->ksmps_offset;
-    uint32_t    nsmps = CS_KSMPS, n;
+    uint32_t    nsmps = CS_KSMPS;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
     CSOUND_SPOUT_SPINLOCK
     val = *p->a;
-    for (n=offset; n<early; n++)
-      ans[n] += val;
+    aops_kernels->vs[AOP_ADD](ans, ans, val, offset, early);
     CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
@@ -2099,12 +2233,11 @@ int32_t subina(CSOUND *csound, ASSIGN *p)
     MYFLT* val = p->a;
     MYFLT* ans = p->r;
     uint32_t    offset = p->h.insdshead->ksmps_offset;
-    uint32_t    nsmps = CS_KSMPS, n;
+    uint32_t    nsmps = CS_KSMPS;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
     CSOUND_SPOUT_SPINLOCK
-    for (n=offset; n<early; n++)
-      ans[n] -= val[n];
+    aops_kernels->vv[AOP_SUB](ans, ans, val, offset, early);
     CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
@@ -2114,13 +2247,12 @@ int32_t subinak(CSOUND *csound, ASSIGN *p)
     MYFLT val;
     MYFLT* ans = p->r;
     uint32_t    offset = p->h.insdshead->ksmps_offset;
-    uint32_t    nsmps = CS_KSMPS, n;
+    uint32_t    nsmps = CS_KSMPS;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
     CSOUND_SPOUT_SPINLOCK
     val = *p->a;
-    for (n=offset; n<early; n++)
-      ans[n] -= val;
+    aops_kernels->vs[AOP_SUB](ans, ans, val, offset, early);
     CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
@@ -0,0 +1,274 @@
+/*
+    aops_simd.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Vectorised kernels for the a-rate arithmetic in aops.c.  Every
+   instruction set that the compiler can target is built into the
+   library; aops_simd_init() picks one at start-up from what the CPU
+   reports, so a generic x86-64 build still runs AVX2 code where it can.
+   Only plain loads/stores and one arithmetic op per sample are used, so
+   each set gives exactly the same samples as the scalar loops.         */
+
+#include "csoundCore.h"
+#include "aops_simd.h"
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    defined(__i386__) || defined(_M_IX86)
+#  if defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define AOPS_HAVE_SSE2
+#    include <emmintrin.h>
+#  endif
+/* GCC on Windows does not keep the stack 32-byte aligned for AVX spills */
+#  if (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 ||      \
+       (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))) && !defined(__MINGW32__)
+#    define AOPS_HAVE_AVX2
+#    define AVX2_ATTR __attribute__((target("avx2")))
+#    include <immintrin.h>
+#  elif defined(_MSC_VER) && _MSC_VER >= 1700
+#    define AOPS_HAVE_AVX2
+#    define AVX2_ATTR
+#    include <immintrin.h>
+#    include <intrin.h>
+#  endif
+#endif
+
+#if (defined(__aarch64__) || defined(_M_ARM64)) && \
+    (defined(__ARM_NEON) || defined(_M_ARM64))
+#  define AOPS_HAVE_NEON
+#  include <arm_neon.h>
+#endif
+
+#define NO_ATTR
+
+/* scalar kernels */
+
+#define SCALAR_OP(NAME, OP)                                             \
+static void vv_##NAME##_scalar(MYFLT *r, const MYFLT *a,                \
+                               const MYFLT *b,                          \
+                               uint32_t offset, uint32_t nsmps)         \
+{                                                                       \
+    uint32_t i;                                                         \
+    for (i = offset; i < nsmps; i++) r[i] = a[i] OP b[i];               \
+}                                                                       \
+static void sv_##NAME##_scalar(MYFLT *r, MYFLT a,                       \
+                               const MYFLT *b,                          \
+                               uint32_t offset, uint32_t nsmps)         \
+{                                                                       \
+    uint32_t i;                                                         \
+    for (i = offset; i < nsmps; i++) r[i] = a OP b[i];                  \
+}                                                                       \
+static void vs_##NAME##_scalar(MYFLT *r, const MYFLT *a,                \
+                               MYFLT b,                                 \
+                               uint32_t offset, uint32_t nsmps)         \
+{                                                                       \
+    uint32_t i;                                                         \
+    for (i = offset; i < nsmps; i++) r[i] = a[i] OP b;                  \
+}
+
+SCALAR_OP(add, +)
+SCALAR_OP(sub, -)
+SCALAR_OP(mul, *)
+SCALAR_OP(div, /)
+
+static void fill_scalar(MYFLT *r, MYFLT a, uint32_t offset, uint32_t nsmps)
+{
+    uint32_t i;
+    for (i = offset; i < nsmps; i++) r[i] = a;
+}
+
+static const AOPS_KERNELS kernels_scalar = {
+    "scalar",
+    { vv_add_scalar, vv_sub_scalar, vv_mul_scalar, vv_div_scalar },
+    { sv_add_scalar, sv_sub_scalar, sv_mul_scalar, sv_div_scalar },
+    { vs_add_scalar, vs_sub_scalar, vs_mul_scalar, vs_div_scalar },
+    fill_scalar
+};
+
+/* vector kernels: two registers per iteration, then one, then a scalar
+   tail; loads of an iteration happen before its stores so r == a or
+   r == b is safe */
+
+#define VEC_OP(SFX, ATTR, VT, W, LD, ST, SET1, NAME, VOP, OP)           \
+ATTR static void vv_##NAME##_##SFX(MYFLT *r, const MYFLT *a,            \
+                                   const MYFLT *b,                      \
+                                   uint32_t offset, uint32_t nsmps)     \
+{                                                                       \
+    uint32_t i = offset;                                                \
+    for (; i + 2*(W) <= nsmps; i += 2*(W)) {                            \
+      VT x0 = VOP(LD(a + i), LD(b + i));                                \
+      VT x1 = VOP(LD(a + i + (W)), LD(b + i + (W)));                    \
+      ST(r + i, x0);                                                    \
+      ST(r + i + (W), x1);                                              \
+    }                                                                   \
+    for (; i + (W) <= nsmps; i += (W))                                  \
+      ST(r + i, VOP(LD(a + i), LD(b + i)));                             \
+    for (; i < nsmps; i++) r[i] = a[i] OP b[i];                         \
+}                                                                       \
+ATTR static void sv_##NAME##_##SFX(MYFLT *r, MYFLT a,                   \
+                                   const MYFLT *b,                      \
+                                   uint32_t offset, uint32_t nsmps)     \
+{                                                                       \
+    uint32_t i = offset;                                                \
+    VT va = SET1(a);                                                    \
+    for (; i + 2*(W) <= nsmps; i += 2*(W)) {                            \
+      VT x0 = VOP(va, LD(b + i));                                       \
+      VT x1 = VOP(va, LD(b + i + (W)));                                 \
+      ST(r + i, x0);                                                    \
+      ST(r + i + (W), x1);                                              \
+    }                                                                   \
+    for (; i + (W) <= nsmps; i += (W))                                  \
+      ST(r + i, VOP(va, LD(b + i)));                                    \
+    for (; i < nsmps; i++) r[i] = a OP b[i];                            \
+}                                                                       \
+ATTR static void vs_##NAME##_##SFX(MYFLT *r, const MYFLT *a,            \
+                                   MYFLT b,                             \
+                                   uint32_t offset, uint32_t nsmps)     \
+{                                                                       \
+    uint32_t i = offset;                                                \
+    VT vb = SET1(b);                                                    \
+    for (; i + 2*(W) <= nsmps; i += 2*(W)) {                            \
+      VT x0 = VOP(LD(a + i), vb);                                       \
+      VT x1 = VOP(LD(a + i + (W)), vb);                                 \
+      ST(r + i, x0);                                                    \
+      ST(r + i + (W), x1);                                              \
+    }                                                                   \
+    for (; i + (W) <= nsmps; i += (W))                                  \
+      ST(r + i, VOP(LD(a + i), vb));                                    \
+    for (; i < nsmps; i++) r[i] = a[i] OP b;                            \
+}
+
+#define VEC_KERNELS(SFX, ATTR, VT, W, LD, ST, SET1, VADD, VSUB, VMUL, VDIV) \
+VEC_OP(SFX, ATTR, VT, W, LD, ST, SET1, add, VADD, +)                    \
+VEC_OP(SFX, ATTR, VT, W, LD, ST, SET1, sub, VSUB, -)                    \
+VEC_OP(SFX, ATTR, VT, W, LD, ST, SET1, mul, VMUL, *)                    \
+VEC_OP(SFX, ATTR, VT, W, LD, ST, SET1, div, VDIV, /)                    \
+ATTR static void fill_##SFX(MYFLT *r, MYFLT a,                          \
+                            uint32_t offset, uint32_t nsmps)            \
+{                                                                       \
+    uint32_t i = offset;                                                \
+    VT va = SET1(a);                                                    \
+    for (; i + (W) <= nsmps; i += (W)) ST(r + i, va);                   \
+    for (; i < nsmps; i++) r[i] = a;                                    \
+}                                                                       \
+static const AOPS_KERNELS kernels_##SFX = {                             \
+    #SFX,                                                               \
+    { vv_add_##SFX, vv_sub_##SFX, vv_mul_##SFX, vv_div_##SFX },         \
+    { sv_add_##SFX, sv_sub_##SFX, sv_mul_##SFX, sv_div_##SFX },         \
+    { vs_add_##SFX, vs_sub_##SFX, vs_mul_##SFX, vs_div_##SFX },         \
+    fill_##SFX                                                          \
+};
+
+#ifdef USE_DOUBLE
+
+#ifdef AOPS_HAVE_SSE2
+VEC_KERNELS(sse2, NO_ATTR, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd,
+            _mm_set1_pd, _mm_add_pd, _mm_sub_pd, _mm_mul_pd, _mm_div_pd)
+#endif
+#ifdef AOPS_HAVE_AVX2
+VEC_KERNELS(avx2, AVX2_ATTR, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd,
+            _mm256_set1_pd, _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd,
+            _mm256_div_pd)
+#endif
+#ifdef AOPS_HAVE_NEON
+VEC_KERNELS(neon, NO_ATTR, float64x2_t, 2, vld1q_f64, vst1q_f64,
+            vdupq_n_f64, vaddq_f64, vsubq_f64, vmulq_f64, vdivq_f64)
+#endif
+
+#else   /* float MYFLT */
+
+#ifdef AOPS_HAVE_SSE2
+VEC_KERNELS(sse2, NO_ATTR, __m128, 4, _mm_loadu_ps, _mm_storeu_ps,
+            _mm_set1_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps)
+#endif
+#ifdef AOPS_HAVE_AVX2
+VEC_KERNELS(avx2, AVX2_ATTR, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps,
+            _mm256_set1_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps,
+            _mm256_div_ps)
+#endif
+#ifdef AOPS_HAVE_NEON
+VEC_KERNELS(neon, NO_ATTR, float32x4_t, 4, vld1q_f32, vst1q_f32,
+            vdupq_n_f32, vaddq_f32, vsubq_f32, vmulq_f32, vdivq_f32)
+#endif
+
+#endif  /* USE_DOUBLE */
+
+const AOPS_KERNELS *aops_kernels = &kernels_scalar;
+
+#ifdef AOPS_HAVE_AVX2
+static int cpu_has_avx2(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return 0;
+    __cpuid(info, 1);
+    /* OSXSAVE and AVX, then the OS must save the YMM state */
+    if ((info[2] & (3 << 27)) != (3 << 27)) return 0;
+    if ((_xgetbv(0) & 6) != 6) return 0;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+const AOPS_KERNELS *aops_simd_kernels(int level)
+{
+    switch (level) {
+    case AOPS_SIMD_SCALAR:
+      return &kernels_scalar;
+#ifdef AOPS_HAVE_SSE2
+    case AOPS_SIMD_SSE2:
+      return &kernels_sse2;
+#endif
+#ifdef AOPS_HAVE_AVX2
+    case AOPS_SIMD_AVX2:
+      return cpu_has_avx2() ? &kernels_avx2 : NULL;
+#endif
+#ifdef AOPS_HAVE_NEON
+    case AOPS_SIMD_NEON:
+      return &kernels_neon;
+#endif
+    default:
+      return NULL;
+    }
+}
+
+void aops_simd_init(void)
+{
+    const AOPS_KERNELS *k = NULL;
+    const char *want = getenv("CS_SIMD");
+    int level;
+
+    if (want != NULL) {
+      for (level = 0; level < AOPS_SIMD_LEVELS && k == NULL; level++) {
+        const AOPS_KERNELS *kk = aops_simd_kernels(level);
+        if (kk != NULL && strcmp(kk->name, want) == 0) k = kk;
+      }
+    }
+    for (level = AOPS_SIMD_LEVELS - 1; level >= 0 && k == NULL; level--)
+      k = aops_simd_kernels(level);
+    aops_kernels = k;
+}
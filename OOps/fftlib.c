@@ -34,6 +34,10 @@
 #include "csound.h"
 #include "fftlib.h"
 #include "pffft.h"
+#ifdef USE_DOUBLE
+#include "pffftd.h"
+#include "aops_simd.h"
+#endif
 
 
 
@@ -3355,6 +3359,64 @@ void csoundRealFFTMult(CSOUND *csound, MYFLT *outbuf,
   New FFT interface
   VL, 2016
 */
+#ifdef USE_DOUBLE
+/* In the double build PFFT_LIB runs a double precision pffft, AVX if the
+   CPU has it and the aops kernels are not limited below AVX2 (CS_SIMD),
+   directly on the caller's buffer.  setup->buffer holds N samples of
+   staging space, used only if the signal is not aligned for AVX,
+   followed by N samples of pffft work space. */
+typedef struct {
+  PFFFTD_Setup *setup;
+  void (*transform)(PFFFTD_Setup *, const double *, double *, double *,
+                    pffft_direction_t);
+  void (*destroy)(PFFFTD_Setup *);
+  uintptr_t align;            /* alignment mask for in place transforms */
+} PFFFTD_PLAN;
+
+static PFFFTD_PLAN *pffftd_plan(CSOUND *csound, int32_t N)
+{
+  PFFFTD_PLAN *plan = (PFFFTD_PLAN *)
+    csound->Calloc(csound, sizeof(PFFFTD_PLAN));
+#ifdef PFFFTD_HAVE_AVX
+  if ((N % 32) == 0 && aops_kernels != NULL &&
+      aops_kernels == aops_simd_kernels(AOPS_SIMD_AVX2) &&
+      (plan->setup = pffftd_avx_new_setup(N, PFFFT_REAL)) != NULL) {
+    plan->transform = pffftd_avx_transform_ordered;
+    plan->destroy = pffftd_avx_destroy_setup;
+    plan->align = 31;
+    return plan;
+  }
+#endif
+  if ((N % 2) == 0 &&
+      (plan->setup = pffftd_scalar_new_setup(N, PFFFT_REAL)) != NULL) {
+    plan->transform = pffftd_scalar_transform_ordered;
+    plan->destroy = pffftd_scalar_destroy_setup;
+    plan->align = 0;
+    return plan;
+  }
+  csound->Free(csound, plan);
+  return NULL;
+}
+
+static
+void pffft_execute(CSOUND_FFT_SETUP *setup,
+                   MYFLT *sig) {
+  int32_t i, N = setup->N;
+  PFFFTD_PLAN *plan = (PFFFTD_PLAN *) setup->setup;
+  MYFLT *buf = sig, *work = setup->buffer + N;
+  if (((uintptr_t) sig & plan->align) != 0) {
+    buf = setup->buffer;
+    memcpy(buf, sig, N*sizeof(MYFLT));
+  }
+  plan->transform(plan->setup, buf, buf, work, setup->d);
+  if (setup->d == PFFFT_BACKWARD) {
+    for(i=0;i<N;i++)
+      sig[i] = buf[i]/N;
+  }
+  else if (buf != sig)
+    memcpy(sig, buf, N*sizeof(MYFLT));
+}
+#else
 static
 void pffft_execute(CSOUND_FFT_SETUP *setup,
                    MYFLT *sig) {
@@ -3371,6 +3433,7 @@ void pffft_execute(CSOUND_FFT_SETUP *setup,
   for(i=0;i<N;i++)
     sig[i] = buf[i]/s;
 }
+#endif
 
 #if defined(__MACH__)
 /* vDSP FFT implementation */
@@ -3435,7 +3498,12 @@ int32_t setupDispose(CSOUND *csound, void *pp){
     break;
 #endif
   case PFFT_LIB:
+#ifdef USE_DOUBLE
+    ((PFFFTD_PLAN *) setup->setup)->destroy(
+                       ((PFFFTD_PLAN *) setup->setup)->setup);
+#else
     pffft_destroy_setup((PFFFT_Setup *)setup->setup);
+#endif
     break;
   }
   return OK;
@@ -3479,8 +3547,18 @@ void *csoundRealFFT2Setup(CSOUND *csound,
     break;
 #endif
   case PFFT_LIB:
+#ifdef USE_DOUBLE
+    setup->setup = (void *) pffftd_plan(csound, FFTsize);
+    if (setup->setup == NULL) {
+      /* no factorisation pffft can do, use fftlib */
+      setup->lib = 0;
+      setup->d = d;
+      return (void *) setup;
+    }
+#else
     setup->setup = (void *)
       pffft_new_setup(FFTsize,PFFFT_REAL);
+#endif
     setup->d = (d ==  FFT_FWD ?
                 PFFFT_FORWARD :
                 PFFFT_BACKWARD);
@@ -3491,6 +3569,11 @@ void *csoundRealFFT2Setup(CSOUND *csound,
     setup->d = d;
     return (void *) setup;
   }
+#ifdef USE_DOUBLE
+  if (lib == PFFT_LIB)   /* staging and work space, see pffft_execute() */
+    setup->buffer = (MYFLT *) align_alloc(csound, 2*sizeof(MYFLT)*FFTsize);
+  else
+#endif
   setup->buffer = (MYFLT *) align_alloc(csound, sizeof(MYFLT)*FFTsize);
   csound->RegisterResetCallback(csound, (void*) setup,
                                 (int32_t (*)(CSOUND *, void *))
@@ -3536,13 +3619,34 @@ void *csoundDCTSetup(CSOUND *csound,
 }
 
 
+#ifdef USE_DOUBLE
+#define DCT_BUFTYPE MYFLT
+#else
+#define DCT_BUFTYPE float
+#endif
+
+/* transform setup->buffer in place */
+static inline void pffft_DCT_transform(CSOUND_FFT_SETUP *setup,
+                                       DCT_BUFTYPE *buffer, int32_t d)
+{
+#ifdef USE_DOUBLE
+  PFFFTD_PLAN *plan = (PFFFTD_PLAN *) setup->setup;
+  plan->transform(plan->setup, buffer, buffer, buffer + setup->N, d);
+#else
+  pffft_transform_ordered((PFFFT_Setup *)
+                          setup->setup,
+                          buffer,buffer,
+                          NULL,d);
+#endif
+}
+
 void pffft_DCT_execute(CSOUND *csound,
                      void *p, MYFLT *sig){
   IGN(csound);
   CSOUND_FFT_SETUP *setup =
         (CSOUND_FFT_SETUP *) p;
   int32_t i,j, N= setup->N;
-  float *buffer = (float *)setup->buffer;
+  DCT_BUFTYPE *buffer = (DCT_BUFTYPE *)setup->buffer;
   if(setup->d == FFT_FWD){
   for(i=j = 0; i < N/2; i+=2, j++){
     buffer[i] = FL(0.0);
@@ -3552,10 +3656,7 @@ void pffft_DCT_execute(CSOUND *csound,
     buffer[i] = FL(0.0);
     buffer[i+1] = sig[j];
   }
-  pffft_transform_ordered((PFFFT_Setup *)
-                          setup->setup,
-                          buffer,buffer,
-                          NULL,PFFFT_FORWARD);
+  pffft_DCT_transform(setup, buffer, PFFFT_FORWARD);
   for(i=j=0; i < N/2; i+=2, j++){
     sig[j] = buffer[i];
   }
@@ -3571,15 +3672,13 @@ void pffft_DCT_execute(CSOUND *csound,
     buffer[i] = -sig[j];
     buffer[i+1] = FL(0.0);
   }
-  pffft_transform_ordered((PFFFT_Setup *)
-                          setup->setup,
-                          buffer,buffer,
-                          NULL,PFFFT_BACKWARD);
+  pffft_DCT_transform(setup, buffer, PFFFT_BACKWARD);
   for(i=j=0; i < N/2; i+=2, j++){
     sig[j] = buffer[i+1]/N;
   }
   }
 }
+#undef DCT_BUFTYPE
 
 #if defined(__MACH__)
 void vDSP_DCT_execute(CSOUND *csound,
@@ -196,7 +196,6 @@ int32_t turnoff(CSOUND *csound, LINK *p)/* terminate the current instrument  */
 int32_t turnoff2(CSOUND *csound, TURNOFF2 *p, int32_t isStringArg)
 {
     MYFLT p1;
-    INSDS *ip, *ip2, *nip;
     int32_t   mode, insno, allow_release;
 
     if (isStringArg) {
@@ -222,47 +221,7 @@ int32_t turnoff2(CSOUND *csound, TURNOFF2 *p, int32_t isStringArg)
       return csoundPerfError(csound, &(p->h),
                              Str("turnoff2: invalid mode parameter"));
     }
-    ip = &(csound->actanchor);
-    ip2 = NULL;
-/*     if ((mode & 4) && !ip->p1){ */
-/*       return csoundPerfError(csound, &(p->h), */
-/*                              Str("turnoff2: invalid instrument number")); */
-/*     }   */
-    while ((ip = ip->nxtact) != NULL && (int32_t) ip->insno != insno);
-    if (ip == NULL)
-      return OK;
-    do {                        /* This loop does not terminate in mode=0 */
-      nip = ip->nxtact;
-      if (((mode & 8) && ip->offtim >= 0.0) ||
-          ((mode & 4) && ip->p1.value != p1) ||
-          (allow_release && ip->relesing)) {
-        ip = nip;
-        continue;
-      }
-      if (!(mode & 3)) {
-        if (allow_release) {
-          xturnoff(csound, ip);
-        }
-        else {
-          nip = ip->nxtact;
-          xturnoff_now(csound, ip);
-        }
-      }
-      else {
-        ip2 = ip;
-        if ((mode & 3) == 1)
-          break;
-      }
-      ip = nip;
-    } while (ip != NULL && (int32_t) ip->insno == insno);
-    if (ip2 != NULL) {
-      if (allow_release) {
-        xturnoff(csound, ip2);
-      }
-      else {
-        xturnoff_now(csound, ip2);
-      }
-    }
+    killInstance(csound, p1, insno, mode, allow_release);
     if (!p->h.insdshead->actflg) {  /* if current note was deactivated: */
       while (CS_PDS->nxtp != NULL)
         CS_PDS = CS_PDS->nxtp;            /* loop to last opds */
@@ -64,6 +64,35 @@
 #include <assert.h>
 #include <stdint.h>
 
+/*
+  Csound: this file is also compiled in double precision, by including it
+  from pffftd.c and pffftd_avx.c with PFFFT_DOUBLE defined.  Those give
+  every external function a PFFFT_NAME() prefix so the instances can be
+  linked together; see H/pffftd.h.
+*/
+#ifdef PFFFT_DOUBLE
+#include "pffftd.h"
+typedef double pffft_float;
+#  define PFFFT_Setup                      PFFFTD_Setup
+#  define validate_pffft_simd              PFFFT_NAME(validate_simd)
+#  define pffft_aligned_malloc             PFFFT_NAME(aligned_malloc)
+#  define pffft_aligned_free               PFFFT_NAME(aligned_free)
+#  define pffft_simd_size                  PFFFT_NAME(simd_size)
+#  define pffft_new_setup                  PFFFT_NAME(new_setup)
+#  define pffft_destroy_setup              PFFFT_NAME(destroy_setup)
+#  define pffft_zreorder                   PFFFT_NAME(zreorder)
+#  define pffft_cplx_finalize              PFFFT_NAME(cplx_finalize)
+#  define pffft_cplx_preprocess            PFFFT_NAME(cplx_preprocess)
+#  define pffft_transform_internal         PFFFT_NAME(transform_internal)
+#  define pffft_zconvolve_accumulate       PFFFT_NAME(zconvolve_accumulate)
+#  define pffft_transform                  PFFFT_NAME(transform)
+#  define pffft_transform_ordered          PFFFT_NAME(transform_ordered)
+#  define cffti1_ps                        PFFFT_NAME(cffti1_ps)
+#  define cfftf1_ps                        PFFFT_NAME(cfftf1_ps)
+#else
+typedef float pffft_float;
+#endif
+
 /* detect compiler flavour */
 #if defined(_MSC_VER)
 #  define COMPILER_MSVC
@@ -99,10 +128,49 @@
 // define PFFFT_SIMD_DISABLE if you want to use scalar code instead of simd code
 //#define PFFFT_SIMD_DISABLE
 
+/*
+   AVX support macros, double precision only: a __m256d holds 4 doubles,
+   so the rest of the code is unchanged
+*/
+#if !defined(PFFFT_SIMD_DISABLE) && defined(PFFFT_DOUBLE) && defined(PFFFT_DOUBLE_AVX)
+#include <immintrin.h>
+typedef __m256d v4sf;
+#  define SIMD_SZ 4
+#  define VZERO() _mm256_setzero_pd()
+#  define VMUL(a,b) _mm256_mul_pd(a,b)
+#  define VADD(a,b) _mm256_add_pd(a,b)
+#  define VMADD(a,b,c) _mm256_add_pd(_mm256_mul_pd(a,b), c)
+#  define VSUB(a,b) _mm256_sub_pd(a,b)
+#  define LD_PS1(p) _mm256_set1_pd(p)
+#  define INTERLEAVE2(in1, in2, out1, out2) {                           \
+    v4sf lo__ = _mm256_unpacklo_pd(in1, in2);                           \
+    v4sf hi__ = _mm256_unpackhi_pd(in1, in2);                           \
+    out1 = _mm256_permute2f128_pd(lo__, hi__, 0x20);                    \
+    out2 = _mm256_permute2f128_pd(lo__, hi__, 0x31);                    \
+  }
+#  define UNINTERLEAVE2(in1, in2, out1, out2) {                         \
+    v4sf lo__ = _mm256_permute2f128_pd(in1, in2, 0x20);                 \
+    v4sf hi__ = _mm256_permute2f128_pd(in1, in2, 0x31);                 \
+    out1 = _mm256_unpacklo_pd(lo__, hi__);                              \
+    out2 = _mm256_unpackhi_pd(lo__, hi__);                              \
+  }
+#  define VTRANSPOSE4(x0,x1,x2,x3) {                                    \
+    v4sf t0__ = _mm256_unpacklo_pd(x0, x1);                             \
+    v4sf t1__ = _mm256_unpackhi_pd(x0, x1);                             \
+    v4sf t2__ = _mm256_unpacklo_pd(x2, x3);                             \
+    v4sf t3__ = _mm256_unpackhi_pd(x2, x3);                             \
+    x0 = _mm256_permute2f128_pd(t0__, t2__, 0x20);                      \
+    x1 = _mm256_permute2f128_pd(t1__, t3__, 0x20);                      \
+    x2 = _mm256_permute2f128_pd(t0__, t2__, 0x31);                      \
+    x3 = _mm256_permute2f128_pd(t1__, t3__, 0x31);                      \
+  }
+#  define VSWAPHL(a,b) _mm256_permute2f128_pd(b, a, 0x30)
+#  define VALIGNED(ptr) ((((uintptr_t)(ptr)) & 0x1F) == 0)
+
 /*
    Altivec support macros
 */
-#if !defined(PFFFT_SIMD_DISABLE) && (defined(__ppc__) || defined(__ppc64__))
+#elif !defined(PFFFT_SIMD_DISABLE) && !defined(PFFFT_DOUBLE) && (defined(__ppc__) || defined(__ppc64__))
 typedef vector float v4sf;
 #  define SIMD_SZ 4
 #  define VZERO() ((vector float) vec_splat_u8(0))
@@ -134,7 +202,7 @@ inline v4sf ld_ps1(const float *p) { v4sf v=vec_lde(0,p); return vec_splat(vec_p
 /*
   SSE1 support macros
 */
-#elif !defined(PFFFT_SIMD_DISABLE) && (defined(__x86_64__) || defined(_M_X64) || defined(i386) || defined(_M_IX86))
+#elif !defined(PFFFT_SIMD_DISABLE) && !defined(PFFFT_DOUBLE) && (defined(__x86_64__) || defined(_M_X64) || defined(i386) || defined(_M_IX86))
 
 #include <xmmintrin.h>
 typedef __m128 v4sf;
@@ -154,7 +222,7 @@ typedef __m128 v4sf;
 /*
   ARM NEON support macros
 */
-#elif !defined(PFFFT_SIMD_DISABLE) && (defined(__arm__) || defined(IOS))
+#elif !defined(PFFFT_SIMD_DISABLE) && !defined(PFFFT_DOUBLE) && (defined(__arm__) || defined(IOS))
 #  include <arm_neon.h>
 typedef float32x4_t v4sf;
 #  define SIMD_SZ 4
@@ -186,9 +254,9 @@ typedef float32x4_t v4sf;
 
 // fallback mode for situations where SSE/Altivec are not available, use scalar mode instead
 #ifdef PFFFT_SIMD_DISABLE
-typedef float v4sf;
+typedef pffft_float v4sf;
 #  define SIMD_SZ 1
-#  define VZERO() 0.f
+#  define VZERO() 0.
 #  define VMUL(a,b) ((a)*(b))
 #  define VADD(a,b) ((a)+(b))
 #  define VMADD(a,b,c) ((a)*(b)+(c))
@@ -208,7 +276,7 @@ typedef float v4sf;
 #if !defined(PFFFT_SIMD_DISABLE)
 typedef union v4sf_union {
   v4sf  v;
-  float f[4];
+  pffft_float f[4];
 } v4sf_union;
 
 #include <string.h>
@@ -217,12 +285,12 @@ typedef union v4sf_union {
 
 /* detect bugs with the vector support macros */
 void validate_pffft_simd(void) {
-  float f[16] = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 };
+  pffft_float f[16] = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 };
   v4sf_union a0, a1, a2, a3, t, u;
-  memcpy(a0.f, f, 4*sizeof(float));
-  memcpy(a1.f, f+4, 4*sizeof(float));
-  memcpy(a2.f, f+8, 4*sizeof(float));
-  memcpy(a3.f, f+12, 4*sizeof(float));
+  memcpy(a0.f, f, 4*sizeof(pffft_float));
+  memcpy(a1.f, f+4, 4*sizeof(pffft_float));
+  memcpy(a2.f, f+8, 4*sizeof(pffft_float));
+  memcpy(a3.f, f+12, 4*sizeof(pffft_float));
 
   t = a0; u = a1; t.v = VZERO();
   printf("VZERO=[%2g %2g %2g %2g]\n", t.f[0], t.f[1], t.f[2], t.f[3]); assertv4(t, 0, 0, 0, 0);
@@ -273,7 +341,7 @@ int32_t pffft_simd_size(void) { return SIMD_SZ; }
 /*
   passf2 and passb2 has been merged here, fsign = -1 for passf2, +1 for passb2
 */
-static NEVER_INLINE(void) passf2_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch, const float *wa1, float fsign) {
+static NEVER_INLINE(void) passf2_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch, const pffft_float *wa1, pffft_float fsign) {
   int32_t k, i;
   int32_t l1ido = l1*ido;
   if (ido <= 2) {
@@ -303,13 +371,13 @@ static NEVER_INLINE(void) passf2_ps(int32_t ido, int32_t l1, const v4sf *cc, v4s
   passf3 and passb3 has been merged here, fsign = -1 for passf3, +1 for passb3
 */
 static NEVER_INLINE(void) passf3_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch,
-                                    const float *wa1, const float *wa2, float fsign) {
-  static const float taur = -0.5f;
-  float taui = 0.866025403784439f*fsign;
+                                    const pffft_float *wa1, const pffft_float *wa2, pffft_float fsign) {
+  static const pffft_float taur = -0.5;
+  pffft_float taui = 0.866025403784439*fsign;
   int32_t i, k;
   v4sf tr2, ti2, cr2, ci2, cr3, ci3, dr2, di2, dr3, di3;
   int32_t l1ido = l1*ido;
-  float wr1, wi1, wr2, wi2;
+  pffft_float wr1, wi1, wr2, wi2;
   assert(ido > 2);
   for (k=0; k< l1ido; k += ido, cc+= 3*ido, ch +=ido) {
     for (i=0; i<ido-1; i+=2) {
@@ -337,7 +405,7 @@ static NEVER_INLINE(void) passf3_ps(int32_t ido, int32_t l1, const v4sf *cc, v4s
 } /* passf3 */
 
 static NEVER_INLINE(void) passf4_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch,
-                                    const float *wa1, const float *wa2, const float *wa3, float fsign) {
+                                    const pffft_float *wa1, const pffft_float *wa2, const pffft_float *wa3, pffft_float fsign) {
   /* isign == -1 for forward transform and +1 for backward transform */
 
   int32_t i, k;
@@ -366,7 +434,7 @@ static NEVER_INLINE(void) passf4_ps(int32_t ido, int32_t l1, const v4sf *cc, v4s
   } else {
     for (k=0; k < l1ido; k += ido, ch+=ido, cc += 4*ido) {
       for (i=0; i<ido-1; i+=2) {
-        float wr1, wi1, wr2, wi2, wr3, wi3;
+        pffft_float wr1, wi1, wr2, wi2, wr3, wi3;
         tr1 = VSUB(cc[i + 0], cc[i + 2*ido + 0]);
         tr2 = VADD(cc[i + 0], cc[i + 2*ido + 0]);
         ti1 = VSUB(cc[i + 1], cc[i + 2*ido + 1]);
@@ -408,19 +476,19 @@ static NEVER_INLINE(void) passf4_ps(int32_t ido, int32_t l1, const v4sf *cc, v4s
   passf5 and passb5 has been merged here, fsign = -1 for passf5, +1 for passb5
 */
 static NEVER_INLINE(void) passf5_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch,
-                                    const float *wa1, const float *wa2,
-                                    const float *wa3, const float *wa4, float fsign) {
-  static const float tr11 = .309016994374947f;
-  const float ti11 = .951056516295154f*fsign;
-  static const float tr12 = -.809016994374947f;
-  const float ti12 = .587785252292473f*fsign;
+                                    const pffft_float *wa1, const pffft_float *wa2,
+                                    const pffft_float *wa3, const pffft_float *wa4, pffft_float fsign) {
+  static const pffft_float tr11 = .309016994374947;
+  const pffft_float ti11 = .951056516295154*fsign;
+  static const pffft_float tr12 = -.809016994374947;
+  const pffft_float ti12 = .587785252292473*fsign;
 
   /* Local variables */
   int32_t i, k;
   v4sf ci2, ci3, ci4, ci5, di3, di4, di5, di2, cr2, cr3, cr5, cr4, ti2, ti3,
     ti4, ti5, dr3, dr4, dr5, dr2, tr2, tr3, tr4, tr5;
 
-  float wr1, wi1, wr2, wi2, wr3, wi3, wr4, wi4;
+  pffft_float wr1, wi1, wr2, wi2, wr3, wi3, wr4, wi4;
 
 #define cc_ref(a_1,a_2) cc[(a_2-1)*ido + a_1 + 1]
 #define ch_ref(a_1,a_3) ch[(a_3-1)*l1*ido + a_1 + 1]
@@ -474,8 +542,8 @@ static NEVER_INLINE(void) passf5_ps(int32_t ido, int32_t l1, const v4sf *cc, v4s
 #undef cc_ref
 }
 
-static NEVER_INLINE(void) radf2_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch, const float *wa1) {
-  static const float minus_one = -1.f;
+static NEVER_INLINE(void) radf2_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch, const pffft_float *wa1) {
+  static const pffft_float minus_one = -1.;
   int32_t i, k, l1ido = l1*ido;
   for (k=0; k < l1ido; k += ido) {
     v4sf a = cc[k], b = cc[k + l1ido];
@@ -504,8 +572,8 @@ static NEVER_INLINE(void) radf2_ps(int32_t ido, int32_t l1, const v4sf * RESTRIC
 } /* radf2 */
 
 
-static NEVER_INLINE(void) radb2_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch, const float *wa1) {
-  static const float minus_two=-2;
+static NEVER_INLINE(void) radb2_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf *ch, const pffft_float *wa1) {
+  static const pffft_float minus_two=-2;
   int32_t i, k, l1ido = l1*ido;
   v4sf a,b,c,d, tr2, ti2;
   for (k=0; k < l1ido; k += ido) {
@@ -538,9 +606,9 @@ static NEVER_INLINE(void) radb2_ps(int32_t ido, int32_t l1, const v4sf *cc, v4sf
 } /* radb2 */
 
 static void radf3_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch,
-                     const float *wa1, const float *wa2) {
-  static const float taur = -0.5f;
-  static const float taui = 0.866025403784439f;
+                     const pffft_float *wa1, const pffft_float *wa2) {
+  static const pffft_float taur = -0.5;
+  static const pffft_float taui = 0.866025403784439;
   int32_t i, k, ic;
   v4sf ci2, di2, di3, cr2, dr2, dr3, ti2, ti3, tr2, tr3, wr1, wi1, wr2, wi2;
   for (k=0; k<l1; k++) {
@@ -579,11 +647,11 @@ static void radf3_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * R
 
 
 static void radb3_ps(int32_t ido, int32_t l1, const v4sf *RESTRICT cc, v4sf *RESTRICT ch,
-                     const float *wa1, const float *wa2)
+                     const pffft_float *wa1, const pffft_float *wa2)
 {
-  static const float taur = -0.5f;
-  static const float taui = 0.866025403784439f;
-  static const float taui_2 = 0.866025403784439f*2;
+  static const pffft_float taur = -0.5;
+  static const pffft_float taui = 0.866025403784439;
+  static const pffft_float taui_2 = 0.866025403784439*2;
   int32_t i, k, ic;
   v4sf ci2, ci3, di2, di3, cr2, cr3, dr2, dr3, ti2, tr2;
   for (k=0; k<l1; k++) {
@@ -621,9 +689,9 @@ static void radb3_ps(int32_t ido, int32_t l1, const v4sf *RESTRICT cc, v4sf *RES
 } /* radb3 */
 
 static NEVER_INLINE(void) radf4_ps(int32_t ido, int32_t l1, const v4sf *RESTRICT cc, v4sf * RESTRICT ch,
-                                   const float * RESTRICT wa1, const float * RESTRICT wa2, const float * RESTRICT wa3)
+                                   const pffft_float * RESTRICT wa1, const pffft_float * RESTRICT wa2, const pffft_float * RESTRICT wa3)
 {
-  static const float minus_hsqt2 = (float)-0.7071067811865475;
+  static const pffft_float minus_hsqt2 = (pffft_float)-0.7071067811865475;
   int32_t i, k, l1ido = l1*ido;
   {
     const v4sf *RESTRICT cc_ = cc, * RESTRICT cc_end = cc + l1ido;
@@ -705,10 +773,10 @@ static NEVER_INLINE(void) radf4_ps(int32_t ido, int32_t l1, const v4sf *RESTRICT
 
 
 static NEVER_INLINE(void) radb4_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch,
-                                   const float * RESTRICT wa1, const float * RESTRICT wa2, const float *RESTRICT wa3)
+                                   const pffft_float * RESTRICT wa1, const pffft_float * RESTRICT wa2, const pffft_float *RESTRICT wa3)
 {
-  static const float minus_sqrt2 = (float)-1.414213562373095;
-  static const float two = 2.f;
+  static const pffft_float minus_sqrt2 = (pffft_float)-1.414213562373095;
+  static const pffft_float two = 2.;
   int32_t i, k, l1ido = l1*ido;
   v4sf ci2, ci3, ci4, cr2, cr3, cr4, ti1, ti2, ti3, ti4, tr1, tr2, tr3, tr4;
   {
@@ -785,12 +853,12 @@ static NEVER_INLINE(void) radb4_ps(int32_t ido, int32_t l1, const v4sf * RESTRIC
 } /* radb4 */
 
 static void radf5_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * RESTRICT ch,
-                     const float *wa1, const float *wa2, const float *wa3, const float *wa4)
+                     const pffft_float *wa1, const pffft_float *wa2, const pffft_float *wa3, const pffft_float *wa4)
 {
-  static const float tr11 = .309016994374947f;
-  static const float ti11 = .951056516295154f;
-  static const float tr12 = -.809016994374947f;
-  static const float ti12 = .587785252292473f;
+  static const pffft_float tr11 = .309016994374947;
+  static const pffft_float ti11 = .951056516295154;
+  static const pffft_float tr12 = -.809016994374947;
+  static const pffft_float ti12 = .587785252292473;
 
   /* System generated locals */
   int32_t cc_offset, ch_offset;
@@ -872,12 +940,12 @@ static void radf5_ps(int32_t ido, int32_t l1, const v4sf * RESTRICT cc, v4sf * R
 } /* radf5 */
 
 static void radb5_ps(int32_t ido, int32_t l1, const v4sf *RESTRICT cc, v4sf *RESTRICT ch,
-                  const float *wa1, const float *wa2, const float *wa3, const float *wa4)
+                  const pffft_float *wa1, const pffft_float *wa2, const pffft_float *wa3, const pffft_float *wa4)
 {
-  static const float tr11 = .309016994374947f;
-  static const float ti11 = .951056516295154f;
-  static const float tr12 = -.809016994374947f;
-  static const float ti12 = .587785252292473f;
+  static const pffft_float tr11 = .309016994374947;
+  static const pffft_float ti11 = .951056516295154;
+  static const pffft_float tr12 = -.809016994374947;
+  static const pffft_float ti12 = .587785252292473;
 
   int32_t cc_offset, ch_offset;
 
@@ -961,7 +1029,7 @@ static void radb5_ps(int32_t ido, int32_t l1, const v4sf *RESTRICT cc, v4sf *RES
 } /* radb5 */
 
 static NEVER_INLINE(v4sf *) rfftf1_ps(int32_t n, const v4sf *input_readonly, v4sf *work1, v4sf *work2,
-                                      const float *wa, const int32_t *ifac) {
+                                      const pffft_float *wa, const int32_t *ifac) {
   v4sf *in  = (v4sf*)input_readonly;
   v4sf *out = (in == work2 ? work1 : work2);
   int32_t nf = ifac[1], k1;
@@ -1008,7 +1076,7 @@ static NEVER_INLINE(v4sf *) rfftf1_ps(int32_t n, const v4sf *input_readonly, v4s
 } /* rfftf1 */
 
 static NEVER_INLINE(v4sf *) rfftb1_ps(int32_t n, const v4sf *input_readonly, v4sf *work1, v4sf *work2,
-                                      const float *wa, const int32_t *ifac) {
+                                      const pffft_float *wa, const int32_t *ifac) {
   v4sf *in  = (v4sf*)input_readonly;
   v4sf *out = (in == work2 ? work1 : work2);
   int32_t nf = ifac[1], k1;
@@ -1081,13 +1149,13 @@ static int32_t decompose(int32_t n, int32_t *ifac, const int32_t *ntryh) {
 
 
 
-static void rffti1_ps(int32_t n, float *wa, int32_t *ifac)
+static void rffti1_ps(int32_t n, pffft_float *wa, int32_t *ifac)
 {
   static const int32_t ntryh[] = { 4,2,3,5,0 };
   int32_t k1, j, ii;
 
   int32_t nf = decompose(n,ifac,ntryh);
-  float argh = (2*M_PI) / n;
+  pffft_float argh = (2*M_PI) / n;
   int32_t is = 0;
   int32_t nfm1 = nf - 1;
   int32_t l1 = 1;
@@ -1098,7 +1166,7 @@ static void rffti1_ps(int32_t n, float *wa, int32_t *ifac)
     int32_t ido = n / l2;
     int32_t ipm = ip - 1;
     for (j = 1; j <= ipm; ++j) {
-      float argld;
+      pffft_float argld;
       int32_t i = is, fi=0;
       ld += l1;
       argld = ld*argh;
@@ -1114,13 +1182,13 @@ static void rffti1_ps(int32_t n, float *wa, int32_t *ifac)
   }
 } /* rffti1 */
 
-void cffti1_ps(int32_t n, float *wa, int32_t *ifac)
+void cffti1_ps(int32_t n, pffft_float *wa, int32_t *ifac)
 {
   static const int32_t ntryh[] = { 5,3,4,2,0 };
   int32_t k1, j, ii;
 
   int32_t nf = decompose(n,ifac,ntryh);
-  float argh = (2*M_PI)/(float)n;
+  pffft_float argh = (2*M_PI)/(pffft_float)n;
   int32_t i = 1;
   int32_t l1 = 1;
   for (k1=1; k1<=nf; k1++) {
@@ -1131,7 +1199,7 @@ void cffti1_ps(int32_t n, float *wa, int32_t *ifac)
     int32_t idot = ido + ido + 2;
     int32_t ipm = ip - 1;
     for (j=1; j<=ipm; j++) {
-      float argld;
+      pffft_float argld;
       int32_t i1 = i, fi = 0;
       wa[i-1] = 1;
       wa[i] = 0;
@@ -1153,7 +1221,7 @@ void cffti1_ps(int32_t n, float *wa, int32_t *ifac)
 } /* cffti1 */
 
 
-v4sf *cfftf1_ps(int32_t n, const v4sf *input_readonly, v4sf *work1, v4sf *work2, const float *wa, const int32_t *ifac, int32_t isign) {
+v4sf *cfftf1_ps(int32_t n, const v4sf *input_readonly, v4sf *work1, v4sf *work2, const pffft_float *wa, const int32_t *ifac, int32_t isign) {
   v4sf *in  = (v4sf*)input_readonly;
   v4sf *out = (in == work2 ? work1 : work2);
   int32_t nf = ifac[1], k1;
@@ -1206,8 +1274,8 @@ struct PFFFT_Setup {
   int32_t ifac[15];
   pffft_transform_t transform;
   v4sf *data; // allocated room for twiddle coefs
-  float *e;    // points into 'data' , N/4*3 elements
-  float *twiddle; // points into 'data', N/4 elements
+  pffft_float *e;    // points into 'data' , N/4*3 elements
+  pffft_float *twiddle; // points into 'data', N/4 elements
 };
 
 PFFFT_Setup *pffft_new_setup(int32_t N, pffft_transform_t transform) {
@@ -1224,15 +1292,15 @@ PFFFT_Setup *pffft_new_setup(int32_t N, pffft_transform_t transform) {
   /* nb of complex simd vectors */
   s->Ncvec = (transform == PFFFT_REAL ? N/2 : N)/SIMD_SZ;
   s->data = (v4sf*)pffft_aligned_malloc(2*s->Ncvec * sizeof(v4sf));
-  s->e = (float*)s->data;
-  s->twiddle = (float*)(s->data + (2*s->Ncvec*(SIMD_SZ-1))/SIMD_SZ);
+  s->e = (pffft_float*)s->data;
+  s->twiddle = (pffft_float*)(s->data + (2*s->Ncvec*(SIMD_SZ-1))/SIMD_SZ);
 
   if (transform == PFFFT_REAL) {
     for (k=0; k < s->Ncvec; ++k) {
       int32_t i = k/SIMD_SZ;
       int32_t j = k%SIMD_SZ;
       for (m=0; m < SIMD_SZ-1; ++m) {
-        float A = -2*M_PI*(m+1)*k / N;
+        pffft_float A = -2*M_PI*(m+1)*k / N;
         s->e[(2*(i*3 + m) + 0) * SIMD_SZ + j] = cos(A);
         s->e[(2*(i*3 + m) + 1) * SIMD_SZ + j] = sin(A);
       }
@@ -1243,7 +1311,7 @@ PFFFT_Setup *pffft_new_setup(int32_t N, pffft_transform_t transform) {
       int32_t i = k/SIMD_SZ;
       int32_t j = k%SIMD_SZ;
       for (m=0; m < SIMD_SZ-1; ++m) {
-        float A = -2*M_PI*(m+1)*k / N;
+        pffft_float A = -2*M_PI*(m+1)*k / N;
         s->e[(2*(i*3 + m) + 0)*SIMD_SZ + j] = cos(A);
         s->e[(2*(i*3 + m) + 1)*SIMD_SZ + j] = sin(A);
       }
@@ -1302,7 +1370,7 @@ static void unreversed_copy(int32_t N, const v4sf *in, v4sf *out, int32_t out_st
   UNINTERLEAVE2(h0, g1, out[0], out[1]);
 }
 
-void pffft_zreorder(PFFFT_Setup *setup, const float *in, float *out, pffft_direction_t direction) {
+void pffft_zreorder(PFFFT_Setup *setup, const pffft_float *in, pffft_float *out, pffft_direction_t direction) {
   int32_t k, N = setup->N, Ncvec = setup->Ncvec;
   const v4sf *vin = (const v4sf*)in;
   v4sf *vout = (v4sf*)out;
@@ -1480,8 +1548,8 @@ static NEVER_INLINE(void) pffft_real_finalize(int32_t Ncvec, const v4sf *in, v4s
 
   v4sf_union cr, ci, *uout = (v4sf_union*)out;
   v4sf save = in[7], zero=VZERO();
-  float xr0, xi0, xr1, xi1, xr2, xi2, xr3, xi3;
-  static const float s = (float) M_SQRT2/2;
+  pffft_float xr0, xi0, xr1, xi1, xr2, xi2, xr3, xi3;
+  static const pffft_float s = (pffft_float) M_SQRT2/2;
 
   cr.v = in[0]; ci.v = in[Ncvec*2-1];
   assert(in != out);
@@ -1572,12 +1640,12 @@ static NEVER_INLINE(void) pffft_real_preprocess(int32_t Ncvec, const v4sf *in, v
   /* fftpack order is f0r f1r f1i f2r f2i ... f(n-1)r f(n-1)i f(n)r */
 
   v4sf_union Xr, Xi, *uout = (v4sf_union*)out;
-  float cr0, ci0, cr1, ci1, cr2, ci2, cr3, ci3;
-  static const float s = (float) M_SQRT2;
+  pffft_float cr0, ci0, cr1, ci1, cr2, ci2, cr3, ci3;
+  static const pffft_float s = (pffft_float) M_SQRT2;
   assert(in != out);
   for (k=0; k < 4; ++k) {
-    Xr.f[k] = ((float*)in)[8*k];
-    Xi.f[k] = ((float*)in)[8*k+4];
+    Xr.f[k] = ((pffft_float*)in)[8*k];
+    Xi.f[k] = ((pffft_float*)in)[8*k+4];
   }
 
   pffft_real_preprocess_4x4(in, e, out+1, 1); // will write only 6 values
@@ -1609,7 +1677,7 @@ static NEVER_INLINE(void) pffft_real_preprocess(int32_t Ncvec, const v4sf *in, v
 }
 
 
-void pffft_transform_internal(PFFFT_Setup *setup, const float *finput, float *foutput, v4sf *scratch,
+void pffft_transform_internal(PFFFT_Setup *setup, const pffft_float *finput, pffft_float *foutput, v4sf *scratch,
                              pffft_direction_t direction, int32_t ordered) {
   int32_t k, Ncvec   = setup->Ncvec;
   int32_t nf_odd = (setup->ifac[1] & 1);
@@ -1642,14 +1710,14 @@ void pffft_transform_internal(PFFFT_Setup *setup, const float *finput, float *fo
       pffft_cplx_finalize(Ncvec, buff[ib], buff[!ib], (v4sf*)setup->e);
     }
     if (ordered) {
-      pffft_zreorder(setup, (float*)buff[!ib], (float*)buff[ib], PFFFT_FORWARD);
+      pffft_zreorder(setup, (pffft_float*)buff[!ib], (pffft_float*)buff[ib], PFFFT_FORWARD);
     } else ib = !ib;
   } else {
     if (vinput == buff[ib]) {
       ib = !ib; // may happen when finput == foutput
     }
     if (ordered) {
-      pffft_zreorder(setup, (float*)vinput, (float*)buff[ib], PFFFT_BACKWARD);
+      pffft_zreorder(setup, (pffft_float*)vinput, (pffft_float*)buff[ib], PFFFT_BACKWARD);
       vinput = buff[ib]; ib = !ib;
     }
     if (setup->transform == PFFFT_REAL) {
@@ -1678,7 +1746,7 @@ void pffft_transform_internal(PFFFT_Setup *setup, const float *finput, float *fo
   assert(buff[ib] == voutput);
 }
 
-void pffft_zconvolve_accumulate(PFFFT_Setup *s, const float *a, const float *b, float *ab, float scaling) {
+void pffft_zconvolve_accumulate(PFFFT_Setup *s, const pffft_float *a, const pffft_float *b, pffft_float *ab, pffft_float scaling) {
   int32_t Ncvec = s->Ncvec;
   const v4sf * RESTRICT va = (const v4sf*)a;
   const v4sf * RESTRICT vb = (const v4sf*)b;
@@ -1702,7 +1770,7 @@ void pffft_zconvolve_accumulate(PFFFT_Setup *s, const float *a, const float *b,
 # endif
 #endif
 
-  float ar, ai, br, bi, abr, abi;
+  pffft_float ar, ai, br, bi, abr, abi;
 #ifndef ZCONVOLVE_USING_INLINE_ASM
   v4sf vscal = LD_PS1(scaling);
   int32_t i;
@@ -1717,7 +1785,7 @@ void pffft_zconvolve_accumulate(PFFFT_Setup *s, const float *a, const float *b,
   abi = ((v4sf_union*)vab)[1].f[0];
 
 #ifdef ZCONVOLVE_USING_INLINE_ASM // inline asm version, unfortunately miscompiled by clang 3.2, at least on ubuntu.. so this will be restricted to gcc
-  const float *a_ = a, *b_ = b; float *ab_ = ab;
+  const pffft_float *a_ = a, *b_ = b; pffft_float *ab_ = ab;
   int32_t N = Ncvec;
   asm volatile("mov         r8, %2                  \n"
                "vdup.f32    q15, %4                 \n"
@@ -1777,19 +1845,19 @@ void pffft_zconvolve_accumulate(PFFFT_Setup *s, const float *a, const float *b,
 // standard routine using scalar floats, without SIMD stuff.
 
 #define pffft_zreorder_nosimd pffft_zreorder
-void pffft_zreorder_nosimd(PFFFT_Setup *setup, const float *in, float *out, pffft_direction_t direction) {
+void pffft_zreorder_nosimd(PFFFT_Setup *setup, const pffft_float *in, pffft_float *out, pffft_direction_t direction) {
   int32_t k, N = setup->N;
   if (setup->transform == PFFFT_COMPLEX) {
     for (k=0; k < 2*N; ++k) out[k] = in[k];
     return;
   }
   else if (direction == PFFFT_FORWARD) {
-    float x_N = in[N-1];
+    pffft_float x_N = in[N-1];
     for (k=N-1; k > 1; --k) out[k] = in[k-1];
     out[0] = in[0];
     out[1] = x_N;
   } else {
-    float x_N = in[1];
+    pffft_float x_N = in[1];
     for (k=1; k < N-1; ++k) out[k] = in[k+1];
     out[0] = in[0];
     out[N-1] = x_N;
@@ -1797,7 +1865,7 @@ void pffft_zreorder_nosimd(PFFFT_Setup *setup, const float *in, float *out, pfff
 }
 
 #define pffft_transform_internal_nosimd pffft_transform_internal
-void pffft_transform_internal_nosimd(PFFFT_Setup *setup, const float *input, float *output, float *scratch,
+void pffft_transform_internal_nosimd(PFFFT_Setup *setup, const pffft_float *input, pffft_float *output, pffft_float *scratch,
                                     pffft_direction_t direction, int32_t ordered) {
   int32_t Ncvec   = setup->Ncvec;
   int32_t nf_odd = (setup->ifac[1] & 1);
@@ -1805,7 +1873,7 @@ void pffft_transform_internal_nosimd(PFFFT_Setup *setup, const float *input, flo
   // temporary buffer is allocated on the stack if the scratch pointer is NULL
   int32_t stack_allocate = (scratch == 0 ? Ncvec*2 : 1);
   VLA_ARRAY_ON_STACK(v4sf, scratch_on_stack, stack_allocate);
-  float *buff[2];
+  pffft_float *buff[2];
   int32_t ib;
   if (scratch == 0) scratch = scratch_on_stack;
   buff[0] = output; buff[1] = scratch;
@@ -1845,7 +1913,7 @@ void pffft_transform_internal_nosimd(PFFFT_Setup *setup, const float *input, flo
     // extra copy required -- this situation should happens only when finput == foutput
     assert(input==output);
     for (k=0; k < Ncvec; ++k) {
-      float a = buff[ib][2*k], b = buff[ib][2*k+1];
+      pffft_float a = buff[ib][2*k], b = buff[ib][2*k+1];
       output[2*k] = a; output[2*k+1] = b;
     }
     ib = !ib;
@@ -1854,8 +1922,8 @@ void pffft_transform_internal_nosimd(PFFFT_Setup *setup, const float *input, flo
 }
 
 #define pffft_zconvolve_accumulate_nosimd pffft_zconvolve_accumulate
-void pffft_zconvolve_accumulate_nosimd(PFFFT_Setup *s, const float *a, const float *b,
-                                       float *ab, float scaling) {
+void pffft_zconvolve_accumulate_nosimd(PFFFT_Setup *s, const pffft_float *a, const pffft_float *b,
+                                       pffft_float *ab, pffft_float scaling) {
   int32_t i, Ncvec = s->Ncvec;
 
   if (s->transform == PFFFT_REAL) {
@@ -1865,7 +1933,7 @@ void pffft_zconvolve_accumulate_nosimd(PFFFT_Setup *s, const float *a, const flo
     ++ab; ++a; ++b; --Ncvec;
   }
   for (i=0; i < Ncvec; ++i) {
-    float ar, ai, br, bi;
+    pffft_float ar, ai, br, bi;
     ar = a[2*i+0]; ai = a[2*i+1];
     br = b[2*i+0]; bi = b[2*i+1];
     VCPLXMUL(ar, ai, br, bi);
@@ -1876,10 +1944,10 @@ void pffft_zconvolve_accumulate_nosimd(PFFFT_Setup *s, const float *a, const flo
 
 #endif // defined(PFFFT_SIMD_DISABLE)
 
-void pffft_transform(PFFFT_Setup *setup, const float *input, float *output, float *work, pffft_direction_t direction) {
+void pffft_transform(PFFFT_Setup *setup, const pffft_float *input, pffft_float *output, pffft_float *work, pffft_direction_t direction) {
   pffft_transform_internal(setup, input, output, (v4sf*)work, direction, 0);
 }
 
-void pffft_transform_ordered(PFFFT_Setup *setup, const float *input, float *output, float *work, pffft_direction_t direction) {
+void pffft_transform_ordered(PFFFT_Setup *setup, const pffft_float *input, pffft_float *output, pffft_float *work, pffft_direction_t direction) {
   pffft_transform_internal(setup, input, output, (v4sf*)work, direction, 1);
 }
@@ -0,0 +1,32 @@
+/*
+    pffftd.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Scalar double precision pffft, the fallback for CPUs without AVX and
+   for sizes the AVX version cannot take. */
+
+#include "sysdep.h"
+
+#ifdef USE_DOUBLE
+#define PFFFT_DOUBLE
+#define PFFFT_SIMD_DISABLE
+#define PFFFT_NAME(n) pffftd_scalar_##n
+#include "pffft.c"
+#endif
@@ -0,0 +1,47 @@
+/*
+    pffftd_avx.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* AVX double precision pffft.  The whole file is compiled for AVX, so
+   nothing in it may run before fftlib.c has checked the CPU. */
+
+#include "sysdep.h"
+#include "pffftd.h"
+
+#if defined(USE_DOUBLE) && defined(PFFFTD_HAVE_AVX)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), \
+                              apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx")
+#endif
+
+#define PFFFT_DOUBLE
+#define PFFFT_DOUBLE_AVX
+#define PFFFT_NAME(n) pffftd_avx_##n
+#include "pffft.c"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
@@ -29,6 +29,7 @@
 #include "csoundCore.h"
 #include "pstream.h"
 #include "pvfileio.h"
+#include "pvs_simd.h"
 
 #ifdef _DEBUG
 #include <assert.h>
@@ -224,8 +225,12 @@ static void adsyn_frame(CSOUND *csound, PVADS *p)
       /* kill stuff over Nyquist. Need to worry about vlf values? */
       if (freqs[i] > nyquist)
         amps[i] = FL(0.0);
-      a[i] = FL(2.0) * SIN(freqs[i] * csound->pidsr);
+      a[i] = freqs[i] * csound->pidsr;
     }
+    /* the bins skipped by binoffset stay at 0 */
+    pvs_kernels->sin(a + startbin, a + startbin, lastbin - startbin);
+    for (i=startbin;i < lastbin;i+= binoffset)
+      a[i] *= FL(2.0);
 
     /* we need to interp amplitude, but seems we can avoid doing freqs too,
        for pvoc so can use direct calc for speed.
@@ -0,0 +1,562 @@
+/*
+    pvs_simd.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Vectorised rectangular/polar conversion for the phase vocoder
+   opcodes.  The kernels are written once in terms of the PV_ operations
+   below, which each instruction set defines before instantiating them,
+   and are built for every set that aops_simd.c builds.  atan2() uses
+   the rational approximation of the Cephes library after reducing the
+   ratio of the smaller to the larger component to [0, 1], sin() and
+   cos() Cephes polynomials on [-pi/4, pi/4] after a three-part
+   reduction by multiples of pi/2.  A partial block at the end of an
+   array is run through the same code, padded, so every bin gets the
+   same approximation.  The sliding DFT step needs no approximation, so
+   its vector versions only finish their arrays with the scalar one.   */
+
+#include "csoundCore.h"
+#include "pvs_simd.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    defined(__i386__) || defined(_M_IX86)
+#  if defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define PVS_HAVE_SSE2
+#    include <emmintrin.h>
+#  endif
+/* as in aops_simd.c */
+#  if (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 ||      \
+       (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))) && !defined(__MINGW32__)
+#    define PVS_HAVE_AVX2
+#    define AVX2_ATTR __attribute__((target("avx2")))
+#    include <immintrin.h>
+#  elif defined(_MSC_VER) && _MSC_VER >= 1700
+#    define PVS_HAVE_AVX2
+#    define AVX2_ATTR
+#    include <immintrin.h>
+#  endif
+#endif
+
+#if (defined(__aarch64__) || defined(_M_ARM64)) && \
+    (defined(__ARM_NEON) || defined(_M_ARM64))
+#  define PVS_HAVE_NEON
+#  include <arm_neon.h>
+#endif
+
+#define NO_ATTR
+
+/* scalar kernels */
+
+static void polar_scalar(MYFLT *mag, MYFLT *ph, const MYFLT *re,
+                         const MYFLT *im, int32_t n)
+{
+    int32_t i;
+    for (i = 0; i < n; i++) {
+      MYFLT x = re[i], y = im[i];
+      mag[i] = HYPOT(x, y);
+      ph[i] = (MYFLT) atan2((double) y, (double) x);
+    }
+}
+
+static void sincos_scalar(MYFLT *s, MYFLT *c, const MYFLT *x, int32_t n)
+{
+    int32_t i;
+    for (i = 0; i < n; i++) {
+      double v = (double) x[i];
+      s[i] = (MYFLT) sin(v);
+      c[i] = (MYFLT) cos(v);
+    }
+}
+
+static void sin_scalar(MYFLT *s, const MYFLT *x, int32_t n)
+{
+    int32_t i;
+    for (i = 0; i < n; i++)
+      s[i] = SIN(x[i]);
+}
+
+static void slide_scalar(double *re, double *im, const double *c,
+                         const double *s, double dx, int32_t n)
+{
+    int32_t i;
+    for (i = 0; i < n; i++) {
+      double x = re[i] + dx, y = im[i];
+      re[i] = c[i]*x - s[i]*y;
+      im[i] = c[i]*y + s[i]*x;
+    }
+}
+
+static const PVS_KERNELS kernels_scalar = {
+    "scalar", polar_scalar, sincos_scalar, sin_scalar, slide_scalar
+};
+
+/* approximations, in terms of the PV_ operations */
+
+#ifdef USE_DOUBLE
+
+/* atan(t) for t in [-0.21, 0.66] */
+#define PV_ATAN_SPLIT   0.66
+#define PV_ATAN(t, z)                                                   \
+    PV_ADD(t, PV_DIV(PV_MUL(PV_MUL(t, z),                               \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(          \
+        PV_SET1(-8.750608600031904122785e-1), z),                       \
+        PV_SET1(-1.615753718733365076637e1)), z),                       \
+        PV_SET1(-7.500855792314704667340e1)), z),                       \
+        PV_SET1(-1.228866684490136173410e2)), z),                       \
+        PV_SET1(-6.485021904942025371773e1))),                          \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(   \
+        z, PV_SET1(2.485846490142306297962e1)), z),                     \
+        PV_SET1(1.650270098316988542046e2)), z),                        \
+        PV_SET1(4.328810604912902668951e2)), z),                        \
+        PV_SET1(4.853903996359136964868e2)), z),                        \
+        PV_SET1(1.945506571482613964425e2))))
+
+/* sin(r) and cos(r) for r in [-pi/4, pi/4] */
+#define PV_SIN(r, z)                                                    \
+    PV_ADD(r, PV_MUL(PV_MUL(r, z),                                      \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(   \
+        PV_MUL(PV_SET1(1.58962301576546568060e-10), z),                 \
+        PV_SET1(-2.50507477628578072866e-8)), z),                       \
+        PV_SET1(2.75573136213857245213e-6)), z),                        \
+        PV_SET1(-1.98412698295895385996e-4)), z),                       \
+        PV_SET1(8.33333333332211858878e-3)), z),                        \
+        PV_SET1(-1.66666666666666307295e-1))))
+#define PV_COS(z)                                                       \
+    PV_ADD(PV_SUB(PV_SET1(1.0), PV_MUL(PV_SET1(0.5), z)),               \
+      PV_MUL(PV_MUL(z, z),                                              \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(   \
+        PV_MUL(PV_SET1(-1.13585365213876817300e-11), z),                \
+        PV_SET1(2.08757008419747316778e-9)), z),                        \
+        PV_SET1(-2.75573141792967388112e-7)), z),                       \
+        PV_SET1(2.48015872888517045348e-5)), z),                        \
+        PV_SET1(-1.38888888888730564116e-3)), z),                       \
+        PV_SET1(4.16666666666665929218e-2))))
+
+/* pi/2 in three parts, the first two short enough for j * part to be
+   exact while |j| < 2^20 */
+#define PV_PIO2_1       1.57079632673412561417e+00
+#define PV_PIO2_2       6.07710050650619224932e-11
+#define PV_PIO2_3       2.02226624879595063154e-21
+
+#else   /* float MYFLT */
+
+/* atan(t) for t in [-0.42, 0.42] */
+#define PV_ATAN_SPLIT   0.41421356f
+#define PV_ATAN(t, z)                                                   \
+    PV_ADD(t, PV_MUL(PV_MUL(t, z),                                      \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(PV_ADD(PV_MUL(                        \
+        PV_SET1(8.05374449538e-2f), z),                                 \
+        PV_SET1(-1.38776856032e-1f)), z),                               \
+        PV_SET1(1.99777106478e-1f)), z),                                \
+        PV_SET1(-3.33329491539e-1f))))
+
+#define PV_SIN(r, z)                                                    \
+    PV_ADD(r, PV_MUL(PV_MUL(r, z),                                      \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(                                      \
+        PV_SET1(-1.9515295891e-4f), z),                                 \
+        PV_SET1(8.3321608736e-3f)), z),                                 \
+        PV_SET1(-1.6666654611e-1f))))
+#define PV_COS(z)                                                       \
+    PV_ADD(PV_SUB(PV_SET1(1.0f), PV_MUL(PV_SET1(0.5f), z)),             \
+      PV_MUL(PV_MUL(z, z),                                              \
+      PV_ADD(PV_MUL(PV_ADD(PV_MUL(                                      \
+        PV_SET1(2.443315711809948e-5f), z),                             \
+        PV_SET1(-1.388731625493765e-3f)), z),                           \
+        PV_SET1(4.166664568298827e-2f))))
+
+/* exact products while |j| < 2^12 */
+#define PV_PIO2_1       1.5703125f
+#define PV_PIO2_2       4.837512969970703125e-4f
+#define PV_PIO2_3       7.54978995489188216e-8f
+
+#endif  /* USE_DOUBLE */
+
+#define PV_ABS(x)       PV_ANDNOT(PV_SET1(-FL(0.0)), x)
+
+/* The kernels of one instruction set.  Each PV_W bins go through
+   polar1_ and sincos1_, which return 0 if any argument of a sincos
+   block is beyond PVS_SINCOS_MAX (or not a number); the block is then
+   done by libm. */
+
+#define PVS_KERNEL_SET(SFX, ATTR)                                       \
+ATTR static inline void polar1_##SFX(MYFLT *mag, MYFLT *ph,             \
+                                     const MYFLT *re, const MYFLT *im)  \
+{                                                                       \
+    PV_T x = PV_LD(re), y = PV_LD(im);                                  \
+    PV_T ax = PV_ABS(x), ay = PV_ABS(y), zero = PV_SET1(FL(0.0));       \
+    PV_T one = PV_SET1(FL(1.0)), hi = PV_MAX(ax, ay);                   \
+    PV_T t = PV_DIV(PV_MIN(ax, ay), PV_SEL(PV_GT(hi, zero), hi, one));  \
+    PV_T big = PV_GT(t, PV_SET1(PV_ATAN_SPLIT)), z, r;                  \
+    t = PV_SEL(big, PV_DIV(PV_SUB(t, one), PV_ADD(t, one)), t);         \
+    z = PV_MUL(t, t);                                                   \
+    r = PV_ADD(PV_ATAN(t, z), PV_AND(big, PV_SET1((MYFLT) (PI/4.0))));  \
+    r = PV_SEL(PV_GT(ay, ax),                                           \
+               PV_SUB(PV_SET1((MYFLT) (PI/2.0)), r), r);                \
+    r = PV_SEL(PV_LT(x, zero), PV_SUB(PV_SET1((MYFLT) PI), r), r);      \
+    PV_ST(mag, PV_SQRT(PV_ADD(PV_MUL(x, x), PV_MUL(y, y))));            \
+    PV_ST(ph, PV_OR(r, PV_AND(PV_SET1(-FL(0.0)), y)));                  \
+}                                                                       \
+ATTR static inline int sincos1_##SFX(MYFLT *s, MYFLT *c, const MYFLT *x) \
+{                                                                       \
+    PV_T v = PV_LD(x), sgn = PV_SET1(-FL(0.0)), j, q, r, z, ps, pc;     \
+    PV_T swap, sneg, cneg, half = PV_SET1(FL(0.5));                     \
+    if (!PV_ALL(PV_LT(PV_ABS(v), PV_SET1(PVS_SINCOS_MAX))))             \
+      return 0;                                                         \
+    j = PV_ROUND(PV_MUL(v, PV_SET1((MYFLT) (2.0/PI))));                 \
+    r = PV_SUB(PV_SUB(PV_SUB(v, PV_MUL(j, PV_SET1(PV_PIO2_1))),         \
+                      PV_MUL(j, PV_SET1(PV_PIO2_2))),                   \
+               PV_MUL(j, PV_SET1(PV_PIO2_3)));                          \
+    z = PV_MUL(r, r);                                                   \
+    ps = PV_SIN(r, z); pc = PV_COS(z);                                  \
+    /* quadrant, as -2 .. 2 */                                          \
+    q = PV_SUB(j, PV_MUL(PV_SET1(FL(4.0)),                              \
+                         PV_ROUND(PV_MUL(j, PV_SET1(FL(0.25))))));      \
+    swap = PV_AND(PV_GT(PV_ABS(q), half),                               \
+                  PV_LT(PV_ABS(q), PV_SET1(FL(1.5))));                  \
+    sneg = PV_OR(PV_LT(q, PV_SET1(-FL(0.5))), PV_GT(q, PV_SET1(FL(1.5)))); \
+    cneg = PV_OR(PV_GT(q, half), PV_LT(q, PV_SET1(-FL(1.5))));          \
+    if (s != NULL)                                                      \
+      PV_ST(s, PV_XOR(PV_SEL(swap, pc, ps), PV_AND(sneg, sgn)));        \
+    if (c != NULL)                                                      \
+      PV_ST(c, PV_XOR(PV_SEL(swap, ps, pc), PV_AND(cneg, sgn)));        \
+    return 1;                                                           \
+}                                                                       \
+ATTR static void polar_##SFX(MYFLT *mag, MYFLT *ph, const MYFLT *re,    \
+                             const MYFLT *im, int32_t n)                \
+{                                                                       \
+    MYFLT   b[4][PV_W];                                                 \
+    int32_t i;                                                          \
+    for (i = 0; i + PV_W <= n; i += PV_W)                               \
+      polar1_##SFX(mag + i, ph + i, re + i, im + i);                    \
+    if (i < n) {                                                        \
+      memset(b, 0, sizeof(b));                                          \
+      memcpy(b[0], re + i, (n - i) * sizeof(MYFLT));                    \
+      memcpy(b[1], im + i, (n - i) * sizeof(MYFLT));                    \
+      polar1_##SFX(b[2], b[3], b[0], b[1]);                             \
+      memcpy(mag + i, b[2], (n - i) * sizeof(MYFLT));                   \
+      memcpy(ph + i, b[3], (n - i) * sizeof(MYFLT));                    \
+    }                                                                   \
+}                                                                       \
+ATTR static void sincos_##SFX(MYFLT *s, MYFLT *c, const MYFLT *x,       \
+                              int32_t n)                                \
+{                                                                       \
+    MYFLT   b[3][PV_W];                                                 \
+    int32_t i;                                                          \
+    for (i = 0; i + PV_W <= n; i += PV_W)                               \
+      if (!sincos1_##SFX(s == NULL ? NULL : s + i,                      \
+                         c == NULL ? NULL : c + i, x + i)) {            \
+        if (c == NULL) sin_scalar(s + i, x + i, PV_W);                  \
+        else sincos_scalar(s + i, c + i, x + i, PV_W);                  \
+      }                                                                 \
+    if (i < n) {                                                        \
+      memset(b, 0, sizeof(b));                                          \
+      memcpy(b[0], x + i, (n - i) * sizeof(MYFLT));                     \
+      if (!sincos1_##SFX(b[1], b[2], b[0]))                             \
+        sincos_scalar(b[1], b[2], b[0], PV_W);                          \
+      memcpy(s + i, b[1], (n - i) * sizeof(MYFLT));                     \
+      if (c != NULL)                                                    \
+        memcpy(c + i, b[2], (n - i) * sizeof(MYFLT));                   \
+    }                                                                   \
+}                                                                       \
+ATTR static void sin_##SFX(MYFLT *s, const MYFLT *x, int32_t n)         \
+{                                                                       \
+    sincos_##SFX(s, NULL, x, n);                                        \
+}                                                                       \
+static const PVS_KERNELS kernels_##SFX = {                              \
+    #SFX, polar_##SFX, sincos_##SFX, sin_##SFX, slide_##SFX             \
+};
+
+#ifdef PVS_HAVE_SSE2
+static void slide_sse2(double *re, double *im, const double *c,
+                       const double *s, double dx, int32_t n)
+{
+    __m128d d = _mm_set1_pd(dx);
+    int32_t i;
+    for (i = 0; i + 2 <= n; i += 2) {
+      __m128d x = _mm_add_pd(_mm_loadu_pd(re + i), d);
+      __m128d y = _mm_loadu_pd(im + i);
+      __m128d ci = _mm_loadu_pd(c + i), si = _mm_loadu_pd(s + i);
+      _mm_storeu_pd(re + i, _mm_sub_pd(_mm_mul_pd(ci, x), _mm_mul_pd(si, y)));
+      _mm_storeu_pd(im + i, _mm_add_pd(_mm_mul_pd(ci, y), _mm_mul_pd(si, x)));
+    }
+    slide_scalar(re + i, im + i, c + i, s + i, dx, n - i);
+}
+#ifdef USE_DOUBLE
+#define PV_T            __m128d
+#define PV_W            2
+#define PV_LD           _mm_loadu_pd
+#define PV_ST           _mm_storeu_pd
+#define PV_SET1         _mm_set1_pd
+#define PV_ADD          _mm_add_pd
+#define PV_SUB          _mm_sub_pd
+#define PV_MUL          _mm_mul_pd
+#define PV_DIV          _mm_div_pd
+#define PV_SQRT         _mm_sqrt_pd
+#define PV_MIN          _mm_min_pd
+#define PV_MAX          _mm_max_pd
+#define PV_AND          _mm_and_pd
+#define PV_OR           _mm_or_pd
+#define PV_XOR          _mm_xor_pd
+#define PV_ANDNOT       _mm_andnot_pd
+#define PV_LT           _mm_cmplt_pd
+#define PV_GT           _mm_cmpgt_pd
+#define PV_SEL(m, a, b) _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b))
+#define PV_ROUND(a)     _mm_cvtepi32_pd(_mm_cvtpd_epi32(a))
+#define PV_ALL(m)       (_mm_movemask_pd(m) == 3)
+#else
+#define PV_T            __m128
+#define PV_W            4
+#define PV_LD           _mm_loadu_ps
+#define PV_ST           _mm_storeu_ps
+#define PV_SET1         _mm_set1_ps
+#define PV_ADD          _mm_add_ps
+#define PV_SUB          _mm_sub_ps
+#define PV_MUL          _mm_mul_ps
+#define PV_DIV          _mm_div_ps
+#define PV_SQRT         _mm_sqrt_ps
+#define PV_MIN          _mm_min_ps
+#define PV_MAX          _mm_max_ps
+#define PV_AND          _mm_and_ps
+#define PV_OR           _mm_or_ps
+#define PV_XOR          _mm_xor_ps
+#define PV_ANDNOT       _mm_andnot_ps
+#define PV_LT           _mm_cmplt_ps
+#define PV_GT           _mm_cmpgt_ps
+#define PV_SEL(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define PV_ROUND(a)     _mm_cvtepi32_ps(_mm_cvtps_epi32(a))
+#define PV_ALL(m)       (_mm_movemask_ps(m) == 15)
+#endif
+PVS_KERNEL_SET(sse2, NO_ATTR)
+#undef PV_T
+#undef PV_W
+#undef PV_LD
+#undef PV_ST
+#undef PV_SET1
+#undef PV_ADD
+#undef PV_SUB
+#undef PV_MUL
+#undef PV_DIV
+#undef PV_SQRT
+#undef PV_MIN
+#undef PV_MAX
+#undef PV_AND
+#undef PV_OR
+#undef PV_XOR
+#undef PV_ANDNOT
+#undef PV_LT
+#undef PV_GT
+#undef PV_SEL
+#undef PV_ROUND
+#undef PV_ALL
+#endif  /* PVS_HAVE_SSE2 */
+
+#ifdef PVS_HAVE_AVX2
+AVX2_ATTR static void slide_avx2(double *re, double *im, const double *c,
+                                 const double *s, double dx, int32_t n)
+{
+    __m256d d = _mm256_set1_pd(dx);
+    int32_t i;
+    for (i = 0; i + 4 <= n; i += 4) {
+      __m256d x = _mm256_add_pd(_mm256_loadu_pd(re + i), d);
+      __m256d y = _mm256_loadu_pd(im + i);
+      __m256d ci = _mm256_loadu_pd(c + i), si = _mm256_loadu_pd(s + i);
+      _mm256_storeu_pd(re + i, _mm256_sub_pd(_mm256_mul_pd(ci, x),
+                                             _mm256_mul_pd(si, y)));
+      _mm256_storeu_pd(im + i, _mm256_add_pd(_mm256_mul_pd(ci, y),
+                                             _mm256_mul_pd(si, x)));
+    }
+    slide_scalar(re + i, im + i, c + i, s + i, dx, n - i);
+}
+#ifdef USE_DOUBLE
+#define PV_T            __m256d
+#define PV_W            4
+#define PV_LD           _mm256_loadu_pd
+#define PV_ST           _mm256_storeu_pd
+#define PV_SET1         _mm256_set1_pd
+#define PV_ADD          _mm256_add_pd
+#define PV_SUB          _mm256_sub_pd
+#define PV_MUL          _mm256_mul_pd
+#define PV_DIV          _mm256_div_pd
+#define PV_SQRT         _mm256_sqrt_pd
+#define PV_MIN          _mm256_min_pd
+#define PV_MAX          _mm256_max_pd
+#define PV_AND          _mm256_and_pd
+#define PV_OR           _mm256_or_pd
+#define PV_XOR          _mm256_xor_pd
+#define PV_ANDNOT       _mm256_andnot_pd
+#define PV_LT(a, b)     _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define PV_GT(a, b)     _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define PV_SEL(m, a, b) _mm256_blendv_pd(b, a, m)
+#define PV_ROUND(a)     _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT |  \
+                                        _MM_FROUND_NO_EXC)
+#define PV_ALL(m)       (_mm256_movemask_pd(m) == 15)
+#else
+#define PV_T            __m256
+#define PV_W            8
+#define PV_LD           _mm256_loadu_ps
+#define PV_ST           _mm256_storeu_ps
+#define PV_SET1         _mm256_set1_ps
+#define PV_ADD          _mm256_add_ps
+#define PV_SUB          _mm256_sub_ps
+#define PV_MUL          _mm256_mul_ps
+#define PV_DIV          _mm256_div_ps
+#define PV_SQRT         _mm256_sqrt_ps
+#define PV_MIN          _mm256_min_ps
+#define PV_MAX          _mm256_max_ps
+#define PV_AND          _mm256_and_ps
+#define PV_OR           _mm256_or_ps
+#define PV_XOR          _mm256_xor_ps
+#define PV_ANDNOT       _mm256_andnot_ps
+#define PV_LT(a, b)     _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define PV_GT(a, b)     _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define PV_SEL(m, a, b) _mm256_blendv_ps(b, a, m)
+#define PV_ROUND(a)     _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT |  \
+                                        _MM_FROUND_NO_EXC)
+#define PV_ALL(m)       (_mm256_movemask_ps(m) == 255)
+#endif
+PVS_KERNEL_SET(avx2, AVX2_ATTR)
+#undef PV_T
+#undef PV_W
+#undef PV_LD
+#undef PV_ST
+#undef PV_SET1
+#undef PV_ADD
+#undef PV_SUB
+#undef PV_MUL
+#undef PV_DIV
+#undef PV_SQRT
+#undef PV_MIN
+#undef PV_MAX
+#undef PV_AND
+#undef PV_OR
+#undef PV_XOR
+#undef PV_ANDNOT
+#undef PV_LT
+#undef PV_GT
+#undef PV_SEL
+#undef PV_ROUND
+#undef PV_ALL
+#endif  /* PVS_HAVE_AVX2 */
+
+#ifdef PVS_HAVE_NEON
+static void slide_neon(double *re, double *im, const double *c,
+                       const double *s, double dx, int32_t n)
+{
+    float64x2_t d = vdupq_n_f64(dx);
+    int32_t i;
+    for (i = 0; i + 2 <= n; i += 2) {
+      float64x2_t x = vaddq_f64(vld1q_f64(re + i), d);
+      float64x2_t y = vld1q_f64(im + i);
+      float64x2_t ci = vld1q_f64(c + i), si = vld1q_f64(s + i);
+      vst1q_f64(re + i, vsubq_f64(vmulq_f64(ci, x), vmulq_f64(si, y)));
+      vst1q_f64(im + i, vaddq_f64(vmulq_f64(ci, y), vmulq_f64(si, x)));
+    }
+    slide_scalar(re + i, im + i, c + i, s + i, dx, n - i);
+}
+#ifdef USE_DOUBLE
+#define PV_T            float64x2_t
+#define PV_W            2
+#define PV_LD           vld1q_f64
+#define PV_ST           vst1q_f64
+#define PV_SET1         vdupq_n_f64
+#define PV_ADD          vaddq_f64
+#define PV_SUB          vsubq_f64
+#define PV_MUL          vmulq_f64
+#define PV_DIV          vdivq_f64
+#define PV_SQRT         vsqrtq_f64
+#define PV_MIN          vminq_f64
+#define PV_MAX          vmaxq_f64
+#define PV_U(a)         vreinterpretq_u64_f64(a)
+#define PV_F(a)         vreinterpretq_f64_u64(a)
+#define PV_AND(a, b)    PV_F(vandq_u64(PV_U(a), PV_U(b)))
+#define PV_OR(a, b)     PV_F(vorrq_u64(PV_U(a), PV_U(b)))
+#define PV_XOR(a, b)    PV_F(veorq_u64(PV_U(a), PV_U(b)))
+#define PV_ANDNOT(a, b) PV_F(vbicq_u64(PV_U(b), PV_U(a)))
+#define PV_LT(a, b)     PV_F(vcltq_f64(a, b))
+#define PV_GT(a, b)     PV_F(vcgtq_f64(a, b))
+#define PV_SEL(m, a, b) vbslq_f64(PV_U(m), a, b)
+#define PV_ROUND        vrndnq_f64
+#define PV_ALL(m)       (vminvq_u32(vreinterpretq_u32_f64(m)) != 0)
+#else
+#define PV_T            float32x4_t
+#define PV_W            4
+#define PV_LD           vld1q_f32
+#define PV_ST           vst1q_f32
+#define PV_SET1         vdupq_n_f32
+#define PV_ADD          vaddq_f32
+#define PV_SUB          vsubq_f32
+#define PV_MUL          vmulq_f32
+#define PV_DIV          vdivq_f32
+#define PV_SQRT         vsqrtq_f32
+#define PV_MIN          vminq_f32
+#define PV_MAX          vmaxq_f32
+#define PV_U(a)         vreinterpretq_u32_f32(a)
+#define PV_F(a)         vreinterpretq_f32_u32(a)
+#define PV_AND(a, b)    PV_F(vandq_u32(PV_U(a), PV_U(b)))
+#define PV_OR(a, b)     PV_F(vorrq_u32(PV_U(a), PV_U(b)))
+#define PV_XOR(a, b)    PV_F(veorq_u32(PV_U(a), PV_U(b)))
+#define PV_ANDNOT(a, b) PV_F(vbicq_u32(PV_U(b), PV_U(a)))
+#define PV_LT(a, b)     PV_F(vcltq_f32(a, b))
+#define PV_GT(a, b)     PV_F(vcgtq_f32(a, b))
+#define PV_SEL(m, a, b) vbslq_f32(PV_U(m), a, b)
+#define PV_ROUND        vrndnq_f32
+#define PV_ALL(m)       (vminvq_u32(PV_U(m)) != 0)
+#endif
+PVS_KERNEL_SET(neon, NO_ATTR)
+#endif  /* PVS_HAVE_NEON */
+
+const PVS_KERNELS *pvs_kernels = &kernels_scalar;
+
+const PVS_KERNELS *pvs_simd_kernels(int level)
+{
+    switch (level) {
+    case AOPS_SIMD_SCALAR:
+      return &kernels_scalar;
+#ifdef PVS_HAVE_SSE2
+    case AOPS_SIMD_SSE2:
+      return &kernels_sse2;
+#endif
+#ifdef PVS_HAVE_AVX2
+    case AOPS_SIMD_AVX2:
+      /* aops_simd.c knows whether the CPU has it */
+      return aops_simd_kernels(level) != NULL ? &kernels_avx2 : NULL;
+#endif
+#ifdef PVS_HAVE_NEON
+    case AOPS_SIMD_NEON:
+      return &kernels_neon;
+#endif
+    default:
+      return NULL;
+    }
+}
+
+void pvs_simd_init(void)
+{
+    const PVS_KERNELS *k = NULL;
+    int level;
+
+    for (level = AOPS_SIMD_LEVELS - 1; level >= 0; level--)
+      if (aops_simd_kernels(level) == aops_kernels) break;
+    for (; level >= 0 && k == NULL; level--)
+      k = pvs_simd_kernels(level);
+    pvs_kernels = k != NULL ? k : &kernels_scalar;
+}
@@ -29,6 +29,7 @@
 #include <math.h>
 #include "csoundCore.h"
 #include "pstream.h"
+#include "pvs_simd.h"
 
         double  besseli(double x);
 static  void    hamming(MYFLT *win, int32_t winLen, int32_t even);
@@ -36,6 +37,8 @@ static  void    vonhann(MYFLT *win, int32_t winLen, int32_t even);
 
 static  void    generate_frame(CSOUND *, PVSANAL *p);
 static  void    process_frame(CSOUND *, PVSYNTH *p);
+static  int32_t pvsanal_deinit(CSOUND *, PVSANAL *p);
+        int32_t pvsanal(CSOUND *, PVSANAL *p);
 
 /* generate half-window */
 
@@ -119,11 +122,25 @@ int32_t pvssanalset(CSOUND *csound, PVSANAL *p)
       csound->AuxAlloc(csound, N*sizeof(MYFLT),&p->input);
     else memset(p->input.auxp, 0, N*sizeof(MYFLT));
     csound->AuxAlloc(csound, NB * sizeof(double), &p->oldInPhase);
-   if (p->analwinbuf.auxp==NULL ||
-        NB*sizeof(CMPLX) > (uint32_t)p->analwinbuf.size)
-      csound->AuxAlloc(csound, NB*sizeof(CMPLX),&p->analwinbuf);
-    else memset(p->analwinbuf.auxp, 0, NB*sizeof(CMPLX));
+    /* the sliding transform, real parts then imaginary */
+    if (p->analwinbuf.auxp==NULL ||
+        2*NB*sizeof(double) > (uint32_t)p->analwinbuf.size)
+      csound->AuxAlloc(csound, 2*NB*sizeof(double),&p->analwinbuf);
+    else memset(p->analwinbuf.auxp, 0, 2*NB*sizeof(double));
+    /* the windowed frame, split for the polar kernel */
+    if (p->polar.auxp==NULL ||
+        2*NB*sizeof(MYFLT) > (uint32_t)p->polar.size)
+      csound->AuxAlloc(csound, 2*NB*sizeof(MYFLT),&p->polar);
     p->inptr = 0;                 /* Pointer in circular buffer */
+    /* The transform slides every sample, but with ihop > 1 the frame is
+       only windowed and converted every ihop samples and held between. */
+    p->sdhop = *p->ihop > FL(1.0) ? (int32_t) MYFLT2LRND(*p->ihop) : 1;
+    if (UNLIKELY(p->sdhop > N/4)) {
+      csound->Warning(csound,
+                      Str("pvsanal: sliding hop too large for window size"));
+      p->sdhop = N/4 > 1 ? N/4 : 1;
+    }
+    p->sdcount = 0;
     p->fsig->NB = p->Ii = NB;
     p->fsig->wintype = wintype;
     p->fsig->format = PVS_AMP_FREQ;      /* only this, for now */
@@ -173,6 +190,16 @@ int32_t pvsanalset(CSOUND *csound, PVSANAL *p)
     int32_t wintype = (int32_t) *p->wintype;
     /* deal with iinit and iformat later on! */
 
+    /* the batch of an earlier init is found again at the first k-cycle */
+    pvsanal_deinit(csound, p);
+    p->leader = NULL;
+    p->kdone = 0;
+    p->batchscan = 0;
+    if (*p->ithreads > FL(1.0))
+      csound->RegisterDeinitCallback(csound, p,
+                                     (int32_t (*)(CSOUND *, void *))
+                                     pvsanal_deinit);
+
     if (overlap<CS_KSMPS || overlap<=10) /* 10 is a guess.... */
       return pvssanalset(csound, p);
     if (UNLIKELY(N <= 32))
@@ -208,6 +235,7 @@ int32_t pvsanalset(CSOUND *csound, PVSANAL *p)
     csound->AuxAlloc(csound, (N+2) * sizeof(MYFLT), &p->analbuf);
     csound->AuxAlloc(csound, (M+Mf) * sizeof(MYFLT), &p->analwinbuf);
     csound->AuxAlloc(csound, nBins * sizeof(MYFLT), &p->oldInPhase);
+    csound->AuxAlloc(csound, 2 * nBins * sizeof(MYFLT), &p->polar);
     csound->AuxAlloc(csound, buflen * sizeof(MYFLT), &p->input);
     /* the signal itself */
     csound->AuxAlloc(csound, (N+2) * sizeof(MYFLT), &p->fsig->frame);
@@ -282,8 +310,8 @@ static void generate_frame(CSOUND *csound, PVSANAL *p)
     MYFLT *input = (MYFLT *) (p->input.auxp);
     MYFLT *analWindow = (MYFLT *) (p->analwinbuf.auxp) + analWinLen;
     MYFLT *oldInPhase = (MYFLT *) (p->oldInPhase.auxp);
-    MYFLT angleDif,real,imag,phase;
-    double rratio;
+    MYFLT *mag = (MYFLT *) (p->polar.auxp), *phase = mag + N2 + 1;
+    MYFLT angleDif;
 
     got = p->fsig->overlap;      /*always assume */
     fp = (MYFLT *) (p->overlapbuf.auxp);
@@ -373,20 +401,20 @@ static void generate_frame(CSOUND *csound, PVSANAL *p)
     }
 #endif
     /*if (format==PVS_AMP_FREQ) {*/
-    for (i=ii=0    /*,i0=anal,i1=anal+1,oi=oldInPhase*/;
-         i <= N2;
-         i++,ii+=2 /*i0+=2,i1+=2, oi++*/) {
-      real = anal[ii] /* *i0 */;
-      imag = anal[ii+1] /* *i1 */;
-      /**i0*/ anal[ii] = HYPOT(real, imag);
+    /* all the bins go through the polar kernel at once */
+    for (i=ii=0; i <= N2; i++,ii+=2) {
+      mag[i] = anal[ii];
+      phase[i] = anal[ii+1];
+    }
+    pvs_kernels->polar(mag, phase, mag, phase, N2 + 1);
+    for (i=ii=0; i <= N2; i++,ii+=2) {
+      anal[ii] = mag[i];
       /* phase unwrapping */
-      /*if (*i0 == 0.)*/
-      if (UNLIKELY(/* *i0 */ anal[ii] < FL(1.0E-10)))
+      if (UNLIKELY(mag[i] < FL(1.0E-10)))
         angleDif = FL(0.0);
       else {
-        rratio =  atan2((double)imag,(double)real);
-        angleDif  = (phase = (MYFLT)rratio) - /**oi*/ oldInPhase[i];
-        /* *oi */ oldInPhase[i] = phase;
+        angleDif  = phase[i] - oldInPhase[i];
+        oldInPhase[i] = phase[i];
       }
 
       if (angleDif > PI_F)
@@ -458,10 +486,14 @@ int32_t pvssanal(CSOUND *csound, PVSANAL *p)
     int32_t NB = p->Ii, loc;
     int32_t N = p->fsig->N;
     MYFLT *data = (MYFLT*)(p->input.auxp);
-    CMPLX *fw = (CMPLX*)(p->analwinbuf.auxp);
+    double *fr = (double*)(p->analwinbuf.auxp), *fi = fr + NB;
+    MYFLT *wr = (MYFLT*)(p->polar.auxp), *wi = wr + NB;
     double *c = p->cosine;
     double *s = p->sine;
     double *h = (double*)p->oldInPhase.auxp;
+    /* expected phase advance per bin over a hop, and frequency scale */
+    double adv = TWOPI*p->sdhop/N;
+    double fscale = csound->esr/(TWOPI*p->sdhop);
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t i, nsmps = CS_KSMPS;
@@ -474,200 +506,380 @@ int32_t pvssanal(CSOUND *csound, PVSANAL *p)
     loc = p->inptr;             /* Circular buffer */
     nsmps -= early;
     for (i=offset; i < nsmps; i++) {
-      MYFLT re, im, dx;
+      double dx;
       CMPLX* ff;
       int32_t j;
 
-/*       printf("%d: in = %f\n", i, *ain); */
       dx = *ain - data[loc];    /* Change in sample */
       data[loc] = *ain++;       /* Remember input sample */
+      loc++; if (UNLIKELY(loc==p->nI)) loc = 0; /* Circular buffer */
+      /* fr, fi is the current frame at this sample */
+      pvs_kernels->slide(fr, fi, c, s, dx, NB);
       /* get the frame for this sample */
       ff = (CMPLX*)(p->fsig->frame.auxp) + i*NB;
-      /* fw is the current frame at this sample */
-      for (j = 0; j < NB; j++) {
-        double ci = c[j], si = s[j];
-        re = fw[j].re + dx;
-        im = fw[j].im;
-        fw[j].re = ci*re - si*im;
-        fw[j].im = ci*im + si*re;
-      }
-      loc++; if (UNLIKELY(loc==p->nI)) loc = 0; /* Circular buffer */
-      /* apply window and transfer to ff buffer*/
-      /* Rectang :Fw_t =     F_t                          */
-      /* Hamming :Fw_t = 0.54F_t - 0.23[ F_{t-1}+F_{t+1}] */
-      /* Hamming :Fw_t = 0.5 F_t - 0.25[ F_{t-1}+F_{t+1}] */
-      /* Blackman:Fw_t = 0.42F_t - 0.25[ F_{t-1}+F_{t+1}]+0.04[F_{t-2}+F_{t+2}] */
-      /* Blackman_exact:Fw_t = 0.42659071367153912296F_t
-         - 0.24828030954428202923 [F_{t-1}+F_{t+1}]
-         + 0.038424333619948409286 [F_{t-2}+F_{t+2}]      */
-      /* Nuttall_C3:Fw_t = 0.375  F_t - 0.25[ F_{t-1}+F_{t+1}] +
-                                      0.0625 [F_{t-2}+F_{t+2}] */
-      /* BHarris_3:Fw_t = 0.44959 F_t - 0.24682[ F_{t-1}+F_{t+1}] +
-                                      0.02838 [F_{t-2}+F_{t+2}] */
-      /* BHarris_min:Fw_t = 0.42323 F_t - 0.2486703 [ F_{t-1}+F_{t+1}] +
-                                      0.0391396 [F_{t-2}+F_{t+2}] */
-      switch (wintype) {
-      case PVS_WIN_HAMMING:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.54)*fw[j].re;
-          ff[j].im = FL(0.54)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.23)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.23)*(fw[j+1].im + fw[j-1].im);
-        }
-        ff[0].re -= FL(0.46)*fw[1].re;
-        ff[NB-1].re -= FL(0.46)*fw[NB-2].re;
-        break;
-      case PVS_WIN_HANN:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.5)*fw[j].re;
-          ff[j].im = FL(0.5)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.25)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.25)*(fw[j+1].im + fw[j-1].im);
-        }
-        ff[0].re -= FL(0.5)*fw[1].re;
-        ff[NB-1].re -= FL(0.5)*fw[NB-2].re;
-        break;
-      default:
-        csound->Warning(csound,
-                        Str("Unknown window type; replaced by rectangular\n"));
-        /* FALLTHRU */
-      case PVS_WIN_RECT:
-        memcpy(ff, fw, NB*sizeof(CMPLX));
-        /* for (j=0; j<NB; j++) { */
-        /*   ff[j].re = fw[j].re; */
-        /*   ff[j].im = fw[j].im; */
-        /* } */
-        break;
-      case PVS_WIN_BLACKMAN:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.42)*fw[j].re;
-          ff[j].im = FL(0.42)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.25)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.25)*(fw[j+1].im + fw[j-1].im);
-        }
-        for (j=2; j<NB-2; j++) {
-          ff[j].re += FL(0.04)*(fw[j+2].re + fw[j-2].re);
-          ff[j].im += FL(0.04)*(fw[j+2].im + fw[j-2].im);
-        }
-        ff[0].re    += -FL(0.5)*fw[1].re + FL(0.08)*fw[2].re;
-        ff[NB-1].re += -FL(0.5)*fw[NB-2].re + FL(0.08)*fw[NB-3].re;
-        ff[1].re    += -FL(0.5)*fw[2].re + FL(0.08)*fw[3].re;
-        ff[NB-2].re += -FL(0.5)*fw[NB-3].re + FL(0.08)*fw[NB-4].re;
-        break;
-    case PVS_WIN_BLACKMAN_EXACT:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.42659071367153912296)*fw[j].re;
-          ff[j].im = FL(0.42659071367153912296)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.49656061908856405847)*FL(0.5)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.49656061908856405847)*FL(0.5)*(fw[j+1].im + fw[j-1].im);
+      if (p->sdcount == 0) {
+        /* apply window and split into wr and wi */
+        /* Rectang :Fw_t =     F_t                          */
+        /* Hamming :Fw_t = 0.54F_t - 0.23[ F_{t-1}+F_{t+1}] */
+        /* Hamming :Fw_t = 0.5 F_t - 0.25[ F_{t-1}+F_{t+1}] */
+        /* Blackman:Fw_t = 0.42F_t - 0.25[ F_{t-1}+F_{t+1}]+0.04[F_{t-2}+F_{t+2}] */
+        /* Blackman_exact:Fw_t = 0.42659071367153912296F_t
+           - 0.24828030954428202923 [F_{t-1}+F_{t+1}]
+           + 0.038424333619948409286 [F_{t-2}+F_{t+2}]      */
+        /* Nuttall_C3:Fw_t = 0.375  F_t - 0.25[ F_{t-1}+F_{t+1}] +
+                                        0.0625 [F_{t-2}+F_{t+2}] */
+        /* BHarris_3:Fw_t = 0.44959 F_t - 0.24682[ F_{t-1}+F_{t+1}] +
+                                        0.02838 [F_{t-2}+F_{t+2}] */
+        /* BHarris_min:Fw_t = 0.42323 F_t - 0.2486703 [ F_{t-1}+F_{t+1}] +
+                                        0.0391396 [F_{t-2}+F_{t+2}] */
+        switch (wintype) {
+        case PVS_WIN_HAMMING:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.54)*fr[j];
+            wi[j] = FL(0.54)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.23)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.23)*(fi[j+1] + fi[j-1]);
+          }
+          wr[0] -= FL(0.46)*fr[1];
+          wr[NB-1] -= FL(0.46)*fr[NB-2];
+          break;
+        case PVS_WIN_HANN:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.5)*fr[j];
+            wi[j] = FL(0.5)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.25)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.25)*(fi[j+1] + fi[j-1]);
+          }
+          wr[0] -= FL(0.5)*fr[1];
+          wr[NB-1] -= FL(0.5)*fr[NB-2];
+          break;
+        default:
+          csound->Warning(csound,
+                          Str("Unknown window type; replaced by rectangular\n"));
+          /* FALLTHRU */
+        case PVS_WIN_RECT:
+          for (j=0; j<NB; j++) {
+            wr[j] = fr[j];
+            wi[j] = fi[j];
+          }
+          break;
+        case PVS_WIN_BLACKMAN:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.42)*fr[j];
+            wi[j] = FL(0.42)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.25)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.25)*(fi[j+1] + fi[j-1]);
+          }
+          for (j=2; j<NB-2; j++) {
+            wr[j] += FL(0.04)*(fr[j+2] + fr[j-2]);
+            wi[j] += FL(0.04)*(fi[j+2] + fi[j-2]);
+          }
+          wr[0]    += -FL(0.5)*fr[1] + FL(0.08)*fr[2];
+          wr[NB-1] += -FL(0.5)*fr[NB-2] + FL(0.08)*fr[NB-3];
+          wr[1]    += -FL(0.5)*fr[2] + FL(0.08)*fr[3];
+          wr[NB-2] += -FL(0.5)*fr[NB-3] + FL(0.08)*fr[NB-4];
+          break;
+      case PVS_WIN_BLACKMAN_EXACT:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.42659071367153912296)*fr[j];
+            wi[j] = FL(0.42659071367153912296)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.49656061908856405847)*FL(0.5)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.49656061908856405847)*FL(0.5)*(fi[j+1] + fi[j-1]);
+          }
+          for (j=2; j<NB-2; j++) {
+            wr[j] += FL(0.076848667239896818573)*FL(0.5)*(fr[j+2] + fr[j-2]);
+            wi[j] += FL(0.076848667239896818573)*FL(0.5)*(fi[j+2] + fi[j-2]);
+          }
+          wr[0]    += -FL(0.49656061908856405847) * fr[1]
+                        + FL(0.076848667239896818573) * fr[2];
+          wr[NB-1] += -FL(0.49656061908856405847) * fr[NB-2]
+                        + FL(0.076848667239896818573) * fr[NB-3];
+          wr[1]    += -FL(0.49656061908856405847) * fr[2]
+                        + FL(0.076848667239896818573) * fr[3];
+          wr[NB-2] += -FL(0.49656061908856405847) * fr[NB-3]
+                        + FL(0.076848667239896818573) * fr[NB-4];
+          break;
+        case PVS_WIN_NUTTALLC3:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.375)*fr[j];
+            wi[j] = FL(0.375)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.5)*FL(0.5)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.5)*FL(0.5)*(fi[j+1] + fi[j-1]);
+          }
+          for (j=2; j<NB-2; j++) {
+            wr[j] += FL(0.125)*FL(0.5)*(fr[j+2] + fr[j-2]);
+            wi[j] += FL(0.125)*FL(0.5)*(fi[j+2] + fi[j-2]);
+          }
+          wr[0]    += -FL(0.5) * fr[1]    + FL(0.125) * fr[2];
+          wr[NB-1] += -FL(0.5) * fr[NB-2] + FL(0.125) * fr[NB-3];
+          wr[1]    += -FL(0.5) * fr[2]    + FL(0.125) * fr[3];
+          wr[NB-2] += -FL(0.5) * fr[NB-3] + FL(0.125) * fr[NB-4];
+          wr[1] = 0.5 * (fr[2] + fr[0]); /* HACK???? */
+          wi[1] = 0.5 * (fi[2] + fi[0]);
+          break;
+        case PVS_WIN_BHARRIS_3:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.44959)*fr[j];
+            wi[j] = FL(0.44959)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.49364)*FL(0.5)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.49364)*FL(0.5)*(fi[j+1] + fi[j-1]);
+          }
+          for (j=2; j<NB-2; j++) {
+            wr[j] += FL(0.05677)*FL(0.5)*(fr[j+2] + fr[j-2]);
+            wi[j] += FL(0.05677)*FL(0.5)*(fi[j+2] + fi[j-2]);
+          }
+          wr[0]    += -FL(0.49364) * fr[1]    + FL(0.05677) * fr[2];
+          wr[NB-1] += -FL(0.49364) * fr[NB-2] + FL(0.05677) * fr[NB-3];
+          wr[1]    += -FL(0.49364) * fr[2]    + FL(0.05677) * fr[3];
+          wr[NB-2] += -FL(0.49364) * fr[NB-3] + FL(0.05677) * fr[NB-4];
+          wr[1] = 0.5 * (fr[2] + fr[0]); /* HACK???? */
+          wi[1] = 0.5 * (fi[2] + fi[0]);
+          break;
+        case PVS_WIN_BHARRIS_MIN:
+          for (j=0; j<NB; j++) {
+            wr[j] = FL(0.42323)*fr[j];
+            wi[j] = FL(0.42323)*fi[j];
+          }
+          for (j=1; j<NB-1; j++) {
+            wr[j] -= FL(0.4973406)*FL(0.5)*(fr[j+1] + fr[j-1]);
+            wi[j] -= FL(0.4973406)*FL(0.5)*(fi[j+1] + fi[j-1]);
+          }
+          for (j=2; j<NB-2; j++) {
+            wr[j] += FL(0.0782793)*FL(0.5)*(fr[j+2] + fr[j-2]);
+            wi[j] += FL(0.0782793)*FL(0.5)*(fi[j+2] + fi[j-2]);
+          }
+          wr[0]    += -FL(0.4973406) * fr[1]    + FL(0.0782793) * fr[2];
+          wr[NB-1] += -FL(0.4973406) * fr[NB-2] + FL(0.0782793) * fr[NB-3];
+          wr[1]    += -FL(0.4973406) * fr[2]    + FL(0.0782793) * fr[3];
+          wr[NB-2] += -FL(0.4973406) * fr[NB-3] + FL(0.0782793) * fr[NB-4];
+          wr[1] = 0.5 * (fr[2] + fr[0]); /* HACK???? */
+          wi[1] = 0.5 * (fi[2] + fi[0]);
+          break;
         }
-        for (j=2; j<NB-2; j++) {
-          ff[j].re += FL(0.076848667239896818573)*FL(0.5)*(fw[j+2].re + fw[j-2].re);
-          ff[j].im += FL(0.076848667239896818573)*FL(0.5)*(fw[j+2].im + fw[j-2].im);
+        /* Convert to AMP_FREQ */
+        pvs_kernels->polar(wr, wi, wr, wi, NB);
+        for (j = 0; j < NB; j++) {
+          double phase = wi[j];
+          double angleDif = phase - h[j] - j*adv;
+          h[j] = phase;
+          /* wrap to (-pi, pi] about the expected difference */
+          angleDif -= TWOPI*ceil(angleDif*(1.0/TWOPI) - 0.5);
+          wi[j] = (MYFLT) (csound->esr*j/N + angleDif*fscale);
         }
-        ff[0].re    += -FL(0.49656061908856405847) * fw[1].re
-                      + FL(0.076848667239896818573) * fw[2].re;
-        ff[NB-1].re += -FL(0.49656061908856405847) * fw[NB-2].re
-                      + FL(0.076848667239896818573) * fw[NB-3].re;
-        ff[1].re    += -FL(0.49656061908856405847) * fw[2].re
-                      + FL(0.076848667239896818573) * fw[3].re;
-        ff[NB-2].re += -FL(0.49656061908856405847) * fw[NB-3].re
-                      + FL(0.076848667239896818573) * fw[NB-4].re;
-        break;
-      case PVS_WIN_NUTTALLC3:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.375)*fw[j].re;
-          ff[j].im = FL(0.375)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.5)*FL(0.5)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.5)*FL(0.5)*(fw[j+1].im + fw[j-1].im);
-        }
-        for (j=2; j<NB-2; j++) {
-          ff[j].re += FL(0.125)*FL(0.5)*(fw[j+2].re + fw[j-2].re);
-          ff[j].im += FL(0.125)*FL(0.5)*(fw[j+2].im + fw[j-2].im);
-        }
-        ff[0].re    += -FL(0.5) * fw[1].re    + FL(0.125) * fw[2].re;
-        ff[NB-1].re += -FL(0.5) * fw[NB-2].re + FL(0.125) * fw[NB-3].re;
-        ff[1].re    += -FL(0.5) * fw[2].re    + FL(0.125) * fw[3].re;
-        ff[NB-2].re += -FL(0.5) * fw[NB-3].re + FL(0.125) * fw[NB-4].re;
-        ff[1].re = 0.5 * (fw[2].re + fw[0].re); /* HACK???? */
-        ff[1].im = 0.5 * (fw[2].im + fw[0].im);
-        break;
-      case PVS_WIN_BHARRIS_3:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.44959)*fw[j].re;
-          ff[j].im = FL(0.44959)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.49364)*FL(0.5)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.49364)*FL(0.5)*(fw[j+1].im + fw[j-1].im);
-        }
-        for (j=2; j<NB-2; j++) {
-          ff[j].re += FL(0.05677)*FL(0.5)*(fw[j+2].re + fw[j-2].re);
-          ff[j].im += FL(0.05677)*FL(0.5)*(fw[j+2].im + fw[j-2].im);
-        }
-        ff[0].re    += -FL(0.49364) * fw[1].re    + FL(0.05677) * fw[2].re;
-        ff[NB-1].re += -FL(0.49364) * fw[NB-2].re + FL(0.05677) * fw[NB-3].re;
-        ff[1].re    += -FL(0.49364) * fw[2].re    + FL(0.05677) * fw[3].re;
-        ff[NB-2].re += -FL(0.49364) * fw[NB-3].re + FL(0.05677) * fw[NB-4].re;
-        ff[1].re = 0.5 * (fw[2].re + fw[0].re); /* HACK???? */
-        ff[1].im = 0.5 * (fw[2].im + fw[0].im);
+        p->sdcount = p->sdhop;
+      }
+      p->sdcount--;
+      for (j = 0; j < NB; j++) {
+        ff[j].re = wr[j];
+        ff[j].im = wi[j];
+      }
+    }
+
+    p->inptr = loc;
+    return OK;
+}
+
+/* Batches.  Consecutive pvsanal opcodes of an instrument with the same
+   fftsize, overlap and window (64 channels of one input, say) have all
+   their input ready when the first of them runs, so that one takes the
+   input of all of them up to their next frame, analyses the frames
+   that are due together, optionally on threads, and then takes the rest
+   of the input; the others find their k-cycle done.  Each frame is
+   still analysed by generate_frame() from the same input, so the output
+   is the same as analysing them one after another.  Opcodes of other
+   instruments or instances cannot join a batch, as what reads their
+   frames runs before they do. */
+
+typedef struct {
+    PVSANAL *p;
+    int32_t k;                  /* frames analysed: k, k + nthreads + 1.. */
+    void    *thread;
+} STFT_WORKER;
+
+typedef struct {
+    int32_t  nmembers, npending;
+    PVSANAL  **members;         /* the leader first */
+    PVSANAL  **pending;         /* members with a frame due */
+    uint32_t *resume;           /* first sample each member has not taken */
+    int32_t  nthreads, quit, warm;
+    void     *barrier;
+    STFT_WORKER *workers;
+} STFT_BATCH;
+
+static int32_t batchable(CSOUND *csound, PVSANAL *p)
+{
+    int32_t overlap = (int32_t) *p->overlap;
+    return (p->input.auxp != NULL && !p->fsig->sliding &&
+            overlap >= (int32_t) CS_KSMPS && overlap >= 10);
+}
+
+static void analyse_shard(CSOUND *csound, STFT_BATCH *b, int32_t k)
+{
+    int32_t i;
+    for (i = k; i < b->npending; i += b->nthreads + 1)
+      generate_frame(csound, b->pending[i]);
+}
+
+static uintptr_t stft_worker(void *data)
+{
+    STFT_WORKER *w = (STFT_WORKER *) data;
+    CSOUND *csound = w->p->h.insdshead->csound;
+    STFT_BATCH *b = (STFT_BATCH *) w->p->batch.auxp;
+
+    while (1) {
+      csound->WaitBarrier(b->barrier);
+      if (b->quit)
         break;
-      case PVS_WIN_BHARRIS_MIN:
-        for (j=0; j<NB; j++) {
-          ff[j].re = FL(0.42323)*fw[j].re;
-          ff[j].im = FL(0.42323)*fw[j].im;
-        }
-        for (j=1; j<NB-1; j++) {
-          ff[j].re -= FL(0.4973406)*FL(0.5)*(fw[j+1].re + fw[j-1].re);
-          ff[j].im -= FL(0.4973406)*FL(0.5)*(fw[j+1].im + fw[j-1].im);
-        }
-        for (j=2; j<NB-2; j++) {
-          ff[j].re += FL(0.0782793)*FL(0.5)*(fw[j+2].re + fw[j-2].re);
-          ff[j].im += FL(0.0782793)*FL(0.5)*(fw[j+2].im + fw[j-2].im);
-        }
-        ff[0].re    += -FL(0.4973406) * fw[1].re    + FL(0.0782793) * fw[2].re;
-        ff[NB-1].re += -FL(0.4973406) * fw[NB-2].re + FL(0.0782793) * fw[NB-3].re;
-        ff[1].re    += -FL(0.4973406) * fw[2].re    + FL(0.0782793) * fw[3].re;
-        ff[NB-2].re += -FL(0.4973406) * fw[NB-3].re + FL(0.0782793) * fw[NB-4].re;
-        ff[1].re = 0.5 * (fw[2].re + fw[0].re); /* HACK???? */
-        ff[1].im = 0.5 * (fw[2].im + fw[0].im);
+      analyse_shard(csound, b, w->k);
+      csound->WaitBarrier(b->barrier);
+    }
+    return 0;
+}
+
+/* stop the first n worker threads */
+static void stop_stft_workers(CSOUND *csound, STFT_BATCH *b, int32_t n)
+{
+    int32_t k;
+
+    b->quit = 1;
+    csound->WaitBarrier(b->barrier);
+    for (k = 0; k < n; k++)
+      csound->JoinThread(b->workers[k].thread);
+    csound->DestroyBarrier(b->barrier);
+    csound->Free(csound, b->workers);
+    b->workers = NULL;
+    b->barrier = NULL;
+    b->nthreads = 0;
+}
+
+static int32_t pvsanal_deinit(CSOUND *csound, PVSANAL *p)
+{
+    STFT_BATCH *b = (STFT_BATCH *) p->batch.auxp;
+    if (b != NULL && b->nthreads > 0)
+      stop_stft_workers(csound, b, b->nthreads);
+    return OK;
+}
+
+/* at the first k-cycle: collect the opcodes after p that can join its
+   batch, and start its threads */
+static void pvsanal_scan(CSOUND *csound, PVSANAL *p)
+{
+    STFT_BATCH *b;
+    OPDS *o;
+    int32_t n = 1, k, nthreads;
+    int32_t N = p->fsig->N;
+
+    p->batchscan = 1;
+    if (p->leader != NULL || !batchable(csound, p))
+      return;
+    for (o = p->h.nxtp; o != NULL && o->opadr == (SUBR) pvsanal;
+         o = o->nxtp) {
+      PVSANAL *q = (PVSANAL *) o;
+      if (!batchable(csound, q) || q->fsig->N != N ||
+          q->fsig->overlap != p->fsig->overlap ||
+          q->fsig->winsize != p->fsig->winsize ||
+          q->fsig->wintype != p->fsig->wintype ||
+          (q->leader != NULL && q->leader != p))
         break;
+      n++;
+    }
+    if (n == 1)
+      return;
+    csound->AuxAlloc(csound, sizeof(STFT_BATCH) + 2 * n * sizeof(PVSANAL *)
+                     + n * sizeof(uint32_t), &p->batch);
+    b = (STFT_BATCH *) p->batch.auxp;
+    b->members = (PVSANAL **) (b + 1);
+    b->pending = b->members + n;
+    b->resume = (uint32_t *) (b->pending + n);
+    b->nmembers = n;
+    for (k = 0, o = &p->h; k < n; k++, o = o->nxtp) {
+      PVSANAL *q = (PVSANAL *) o;
+      b->members[k] = q;
+      if (k > 0) {
+        q->leader = p;
+        q->batchscan = 1;
       }
-/*       if (i==9) { */
-/*         printf("Frame as Amp/Freq %d\n", i); */
-/*         for (j = 0; j < NB; j++) */
-/*           printf("%d: %f\t%f\n", j, ff[j].re, ff[j].im); */
-/*       } */
-      for (j = 0; j < NB; j++) { /* Convert to AMP_FREQ */
-        double thismag = hypot(ff[j].re, ff[j].im);
-        double phase = atan2(ff[j].im, ff[j].re);
-        double angleDif  = phase -  h[j];
-        h[j] = phase;
-            /*subtract expected phase difference */
-        angleDif -= (double)j * TWOPI/N;
-        angleDif =  mod2Pi(angleDif);
-        angleDif =  angleDif * N /TWOPI;
-        ff[j].re = thismag;
-        ff[j].im = csound->esr * (j + angleDif)/N;
+    }
+    /* the FFTs share no work space only when all have their own setups */
+    nthreads = *p->ithreads > FL(1.0) ? (int32_t) *p->ithreads - 1 : 0;
+    if (nthreads > n - 1)
+      nthreads = n - 1;
+    if (nthreads == 0 || (N & (N - 1)))
+      return;
+    b->workers = (STFT_WORKER *) csound->Calloc(csound,
+                                                nthreads * sizeof(STFT_WORKER));
+    b->barrier = csound->CreateBarrier(nthreads + 1);
+    for (k = 0; k < nthreads; k++) {
+      b->workers[k].p = p;
+      b->workers[k].k = k + 1;
+      b->workers[k].thread = csound->CreateThread(stft_worker, &b->workers[k]);
+      if (UNLIKELY(b->workers[k].thread == NULL)) {
+        stop_stft_workers(csound, b, k);
+        csound->Warning(csound, Str("pvsanal: could not start worker "
+                                    "threads, analysing serially"));
+        return;
       }
-/*       if (i==9) { */
-/*         printf("Frame as Amp/Freq %d\n", i); */
-/*         for (j = 0; j < NB; j++) */
-/*           printf("%d: %f\t%f\n", j, ff[j].re, ff[j].im); */
-/*       } */
     }
+    b->nthreads = nthreads;
+}
 
-    p->inptr = loc;
+static int32_t pvsanal_batch(CSOUND *csound, PVSANAL *p,
+                             uint32_t offset, uint32_t nsmps)
+{
+    STFT_BATCH *b = (STFT_BATCH *) p->batch.auxp;
+    int32_t k;
+    uint32_t i;
+
+    b->npending = 0;
+    for (k = 0; k < b->nmembers; k++) {
+      PVSANAL *q = b->members[k];
+      MYFLT *inbuf = (MYFLT *) q->overlapbuf.auxp, *ain = q->ain;
+      int32_t overlap = q->fsig->overlap;
+      /* a member initialised again since goes its own way */
+      if (k > 0 && q->leader != p) {
+        b->resume[k] = nsmps;
+        continue;
+      }
+      for (i = offset; i < nsmps && q->inptr < overlap; i++)
+        inbuf[q->inptr++] = ain[i];
+      b->resume[k] = i;
+      if (i < nsmps)
+        b->pending[b->npending++] = q;
+    }
+    /* the first batch is analysed here, so that FFT tables made on first
+       use are made on one thread */
+    if (b->nthreads > 0 && b->warm && b->npending > 1) {
+      csound->WaitBarrier(b->barrier);
+      analyse_shard(csound, b, 0);
+      csound->WaitBarrier(b->barrier);
+    }
+    else {
+      for (k = 0; k < b->npending; k++)
+        generate_frame(csound, b->pending[k]);
+      b->warm |= (b->npending > 0);
+    }
+    for (k = 0; k < b->npending; k++) {
+      b->pending[k]->fsig->framecount++;
+      b->pending[k]->inptr = 0;
+    }
+    for (k = 0; k < b->nmembers; k++) {
+      PVSANAL *q = b->members[k];
+      for (i = b->resume[k]; i < nsmps; i++)
+        anal_tick(csound, q, q->ain[i]);
+      q->kdone = CS_KCNT;
+    }
     return OK;
 }
 
@@ -689,7 +901,14 @@ int32_t pvsanal(CSOUND *csound, PVSANAL *p)
       if (overlap<(int32_t)nsmps || overlap<10) /* 10 is a guess.... */
         return pvssanal(csound, p);
     }
+    /* already analysed by the batch it is in */
+    if (p->leader != NULL && p->kdone == CS_KCNT)
+      return OK;
+    if (!p->batchscan)
+      pvsanal_scan(csound, p);
     nsmps -= early;
+    if (p->batch.auxp != NULL)
+      return pvsanal_batch(csound, p, offset, nsmps);
     for (i=offset; i < nsmps; i++)
       anal_tick(csound,p,ain[i]);
     return OK;
@@ -742,6 +961,7 @@ int32_t pvsynthset(CSOUND *csound, PVSYNTH *p)
     csound->AuxAlloc(csound, (M+Mf) * sizeof(MYFLT), &p->analwinbuf);
     csound->AuxAlloc(csound, (M+Mf) * sizeof(MYFLT), &p->synwinbuf);
     csound->AuxAlloc(csound, nBins * sizeof(MYFLT), &p->oldOutPhase);
+    csound->AuxAlloc(csound, 3 * nBins * sizeof(MYFLT), &p->polar);
     csound->AuxAlloc(csound, buflen * sizeof(MYFLT), &p->output);
 
 
@@ -861,7 +1081,8 @@ static void process_frame(CSOUND *csound, PVSYNTH *p)
     MYFLT *oldOutPhase = (MYFLT *) (p->oldOutPhase.auxp);
     int32_t N = p->fsig->N;
     MYFLT *obufptr,*outbuf,*synWindow;
-    MYFLT mag,phase,angledif, the_phase;
+    MYFLT *mag, *phase, *cosine;
+    MYFLT angledif, the_phase;
     int32_t synWinLen = p->fsig->winsize / 2;
     int32_t overlap = p->fsig->overlap;
     /*int32 format = p->fsig->format; */
@@ -904,30 +1125,28 @@ static void process_frame(CSOUND *csound, PVSYNTH *p)
     }
     else if (format == PVS_AMP_FREQ) {
 #endif
-      for (i=ii=0 /*, i0=syn, i1=syn+1*/; i<= NO2; i++, ii+=2 /*i0+=2,  i1+=2*/) {
-        mag = syn[ii]; /* *i0; */
-        /* RWD variation to keep phase wrapped within +- TWOPI */
-        /* this is spread across several frame cycles, as the problem does not
-           develop for a while */
-
-        angledif = p->TwoPioverR * ( /* *i1 */ syn[ii+1] - ((MYFLT)i * p->Fexact));
-        the_phase = /* *(oldOutPhase + i) */ oldOutPhase[i] + angledif;
-        if (i== p->bin_index)
-          the_phase = (MYFLT) fmod(the_phase,TWOPI);
-        /* *(oldOutPhase + i) = the_phase; */
-        oldOutPhase[i] = the_phase;
-        phase = the_phase;
-        /* *i0 */ syn[ii]  = (MYFLT)((double)mag * cos((double)phase));
-        /* *i1 */ syn[ii+1] = (MYFLT)((double)mag * sin((double)phase));
+      mag = (MYFLT *) (p->polar.auxp);
+      phase = mag + NO2 + 1;
+      cosine = phase + NO2 + 1;
+      for (i=ii=0; i<= NO2; i++, ii+=2) {
+        mag[i] = syn[ii];
+        angledif = p->TwoPioverR * (syn[ii+1] - ((MYFLT)i * p->Fexact));
+        the_phase = oldOutPhase[i] + angledif;
+        /* keep every phase within 0 .. TWOPI, so that it neither loses
+           precision nor goes beyond what the sine kernel reduces */
+        the_phase -= TWOPI_F * FLOOR(the_phase * (FL(1.0) / TWOPI_F));
+        oldOutPhase[i] = phase[i] = the_phase;
+      }
+      /* all the bins go through the sine/cosine kernel at once */
+      pvs_kernels->sincos(phase, cosine, phase, NO2 + 1);
+      for (i=ii=0; i<= NO2; i++, ii+=2) {
+        syn[ii]  = mag[i] * cosine[i];
+        syn[ii+1] = mag[i] * phase[i];
       }
 #ifdef NOTDEF
     }
 #endif
 
-    /* for phase normalization */
-    if (++(p->bin_index) == NO2+1)
-      p->bin_index = 0;
-
     /* else it must be PVOC_COMPLEX */
 
     /* synthesis: The synthesis subroutine uses the Weighted Overlap-Add
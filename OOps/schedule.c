@@ -461,9 +461,9 @@ static int32_t ktriginstr_(CSOUND *csound, TRIGINSTR *p, int32_t stringname)
         absinsno = get_absinsno(csound, p, stringname);
         if (UNLIKELY(absinsno < 1))
           return NOTOK;
-        ip = &(csound->actanchor);
-        while ((ip = ip->nxtact) != NULL)
-          if (ip->insno == absinsno) numinst++;
+        for (ip = find_active_insno(csound, absinsno);
+             ip != NULL && ip->insno == absinsno; ip = ip->nxtact)
+          numinst++;
         if (numinst >= (int32_t) *p->maxinst)
           return OK;
       }
@@ -0,0 +1,231 @@
+/*
+    tabosc_simd.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Vectorised table oscillators for oscbnk and adsynt.  The phases of
+   the next few samples of one oscillator are stepped together, the
+   table is read with gathers, and the samples are interpolated and
+   added to the output with the same operations, in the same order, as
+   the scalar loop.  Without gathers, as on SSE2 and NEON, reading the
+   table a value at a time leaves nothing to gain, so only AVX2 has a
+   vector set.  The end of a block that does not fill a vector is run
+   by the scalar kernel.                                               */
+
+#include "csoundCore.h"
+#include "tabosc_simd.h"
+
+/* as in aops_simd.c */
+#if (defined(__x86_64__) || defined(_M_X64) ||                         \
+     defined(__i386__) || defined(_M_IX86))
+#  if (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 ||      \
+       (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))) && !defined(__MINGW32__)
+#    define TABOSC_HAVE_AVX2
+#    define AVX2_ATTR __attribute__((target("avx2")))
+#    include <immintrin.h>
+#  elif defined(_MSC_VER) && _MSC_VER >= 1700
+#    define TABOSC_HAVE_AVX2
+#    define AVX2_ATTR
+#    include <immintrin.h>
+#  endif
+#endif
+
+/* scalar kernels */
+
+static uint32 lin_scalar(MYFLT *out, const MYFLT *amp, const TABOSC *t,
+                         uint32 ph, uint32 inc, uint32_t n)
+{
+    const MYFLT *ft = t->ft;
+    uint32  j, lobits = t->lobits, mask = t->mask, phsmsk = t->phsmsk;
+    MYFLT   k, pfrac = t->pfrac;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+      j = ph >> lobits; k = ft[j];
+      k += (ft[j + 1] - k) * (MYFLT) ((int32) (ph & mask)) * pfrac;
+      if (amp != NULL) k *= amp[i];
+      out[i] += k;
+      ph = (ph + inc) & phsmsk;
+    }
+    return ph;
+}
+
+static uint32 trunc_scalar(MYFLT *out, MYFLT amp, const TABOSC *t,
+                           uint32 ph, uint32 inc, uint32_t n)
+{
+    const MYFLT *ft = t->ft;
+    uint32  lobits = t->lobits, phsmsk = t->phsmsk;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+      out[i] += ft[ph >> lobits] * amp;
+      ph = (ph + inc) & phsmsk;
+    }
+    return ph;
+}
+
+static const TABOSC_KERNELS kernels_scalar = {
+    "scalar", lin_scalar, trunc_scalar
+};
+
+#ifdef TABOSC_HAVE_AVX2
+#ifdef USE_DOUBLE
+
+/* four samples a step, phases in an __m128i */
+
+#define TO_LANES    4
+#define TO_INT      __m128i
+#define TO_VEC      __m256d
+#define TO_PHASES(p, d) \
+  _mm_setr_epi32((int) (p), (int) ((p) + (d)), (int) ((p) + 2*(d)), \
+                 (int) ((p) + 3*(d)))
+#define TO_ISET1(x)     _mm_set1_epi32((int) (x))
+#define TO_IADD         _mm_add_epi32
+#define TO_IAND         _mm_and_si128
+#define TO_ISRL(x, c)   _mm_srl_epi32(x, _mm_cvtsi32_si128((int) (c)))
+#define TO_GATHER(p, i) _mm256_i32gather_pd(p, i, 8)
+#define TO_CVT          _mm256_cvtepi32_pd
+#define TO_SET1         _mm256_set1_pd
+#define TO_LOAD         _mm256_loadu_pd
+#define TO_STORE        _mm256_storeu_pd
+#define TO_ADD          _mm256_add_pd
+#define TO_SUB          _mm256_sub_pd
+#define TO_MUL          _mm256_mul_pd
+
+#else
+
+/* eight samples a step */
+
+#define TO_LANES    8
+#define TO_INT      __m256i
+#define TO_VEC      __m256
+#define TO_PHASES(p, d) \
+  _mm256_setr_epi32((int) (p), (int) ((p) + (d)), (int) ((p) + 2*(d)), \
+                    (int) ((p) + 3*(d)), (int) ((p) + 4*(d)),          \
+                    (int) ((p) + 5*(d)), (int) ((p) + 6*(d)),          \
+                    (int) ((p) + 7*(d)))
+#define TO_ISET1(x)     _mm256_set1_epi32((int) (x))
+#define TO_IADD         _mm256_add_epi32
+#define TO_IAND         _mm256_and_si256
+#define TO_ISRL(x, c)   _mm256_srl_epi32(x, _mm_cvtsi32_si128((int) (c)))
+#define TO_GATHER(p, i) _mm256_i32gather_ps(p, i, 4)
+#define TO_CVT          _mm256_cvtepi32_ps
+#define TO_SET1         _mm256_set1_ps
+#define TO_LOAD         _mm256_loadu_ps
+#define TO_STORE        _mm256_storeu_ps
+#define TO_ADD          _mm256_add_ps
+#define TO_SUB          _mm256_sub_ps
+#define TO_MUL          _mm256_mul_ps
+
+#endif
+
+/* No fused multiply-adds: "avx2" does not enable FMA, so the compiler
+   cannot contract these either, and the rounding matches the scalar
+   loop. */
+
+static AVX2_ATTR uint32 lin_avx2(MYFLT *out, const MYFLT *amp,
+                                 const TABOSC *t, uint32 ph, uint32 inc,
+                                 uint32_t n)
+{
+    const MYFLT *ft = t->ft;
+    uint32_t i = 0;
+
+    if (n >= TO_LANES) {
+      TO_INT  phsmsk = TO_ISET1(t->phsmsk), mask = TO_ISET1(t->mask);
+      TO_INT  step = TO_ISET1(inc * TO_LANES);
+      TO_INT  vph = TO_IAND(TO_PHASES(ph, inc), phsmsk);
+      TO_VEC  pfrac = TO_SET1(t->pfrac);
+      uint32  lobits = t->lobits;
+
+      for (; i + TO_LANES <= n; i += TO_LANES) {
+        TO_INT  j = TO_ISRL(vph, lobits);
+        TO_VEC  k = TO_GATHER(ft, j), k1 = TO_GATHER(ft + 1, j);
+        TO_VEC  f = TO_CVT(TO_IAND(vph, mask));
+        k = TO_ADD(k, TO_MUL(TO_MUL(TO_SUB(k1, k), f), pfrac));
+        if (amp != NULL) k = TO_MUL(k, TO_LOAD(amp + i));
+        TO_STORE(out + i, TO_ADD(TO_LOAD(out + i), k));
+        vph = TO_IAND(TO_IADD(vph, step), phsmsk);
+      }
+      ph = (ph + i * inc) & t->phsmsk;
+      /* the scalar tail and the caller are SSE code */
+      _mm256_zeroupper();
+    }
+    return lin_scalar(out + i, amp != NULL ? amp + i : NULL, t, ph, inc,
+                      n - i);
+}
+
+static AVX2_ATTR uint32 trunc_avx2(MYFLT *out, MYFLT amp, const TABOSC *t,
+                                   uint32 ph, uint32 inc, uint32_t n)
+{
+    const MYFLT *ft = t->ft;
+    uint32_t i = 0;
+
+    if (n >= TO_LANES) {
+      TO_INT  phsmsk = TO_ISET1(t->phsmsk);
+      TO_INT  step = TO_ISET1(inc * TO_LANES);
+      TO_INT  vph = TO_IAND(TO_PHASES(ph, inc), phsmsk);
+      TO_VEC  a = TO_SET1(amp);
+      uint32  lobits = t->lobits;
+
+      for (; i + TO_LANES <= n; i += TO_LANES) {
+        TO_VEC  k = TO_GATHER(ft, TO_ISRL(vph, lobits));
+        TO_STORE(out + i, TO_ADD(TO_LOAD(out + i), TO_MUL(k, a)));
+        vph = TO_IAND(TO_IADD(vph, step), phsmsk);
+      }
+      ph = (ph + i * inc) & t->phsmsk;
+      /* the scalar tail and the caller are SSE code */
+      _mm256_zeroupper();
+    }
+    return trunc_scalar(out + i, amp, t, ph, inc, n - i);
+}
+
+static const TABOSC_KERNELS kernels_avx2 = {
+    "avx2", lin_avx2, trunc_avx2
+};
+
+#endif  /* TABOSC_HAVE_AVX2 */
+
+const TABOSC_KERNELS *tabosc_kernels = &kernels_scalar;
+
+const TABOSC_KERNELS *tabosc_simd_kernels(int level)
+{
+    switch (level) {
+    case AOPS_SIMD_SCALAR:
+      return &kernels_scalar;
+#ifdef TABOSC_HAVE_AVX2
+    case AOPS_SIMD_AVX2:
+      /* aops_simd.c knows whether the CPU has it */
+      return aops_simd_kernels(level) != NULL ? &kernels_avx2 : NULL;
+#endif
+    default:
+      return NULL;
+    }
+}
+
+void tabosc_simd_init(void)
+{
+    const TABOSC_KERNELS *k = NULL;
+    int level;
+
+    for (level = AOPS_SIMD_LEVELS - 1; level >= 0; level--)
+      if (aops_simd_kernels(level) == aops_kernels) break;
+    for (; level >= 0 && k == NULL; level--)
+      k = tabosc_simd_kernels(level);
+    tabosc_kernels = k != NULL ? k : &kernels_scalar;
+}
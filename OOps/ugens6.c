@@ -24,6 +24,7 @@
 
 #include "csoundCore.h" /*                              UGENS6.C        */
 #include "ugens6.h"
+#include "aops_simd.h"
 #include <math.h>
 
 #define log001 (-FL(6.9078))    /* log(.001) */
@@ -65,15 +66,14 @@ int32_t upsamp(CSOUND *csound, UPSAMP *p)
     MYFLT *ar = p->ar;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
 
     if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
     if (UNLIKELY(early)) {
       nsmps -= early;
       memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++)
-      ar[n] = kval;
+    aops_kernels->fill(ar, kval, offset, nsmps);
     return OK;
 }
 
@@ -64,8 +64,9 @@ typedef struct {
 } OSCSEND;
 
 
+/* a received message; allocated with room for the listener's arguments
+   only */
 typedef struct osc_pat {
-    struct osc_pat *next;
     union {
       MYFLT number;
       STRINGDAT string;
@@ -73,11 +74,16 @@ typedef struct osc_pat {
     } args[ARG_CNT-1];
 } OSC_PAT;
 
+#define OSC_RING  (256)         /* messages waiting per listener, less one */
+
 typedef struct {
     lo_server_thread thread;
     CSOUND  *csound;
-    void    *mutex_;
-    void    *oplst;             /* list of opcodes listening on this port */
+    void    *mutex_;            /* guards the index */
+    struct osclcommon **index;  /* opcodes listening on this port, hashed
+                                   by path and types */
+    int32_t indexSize, nListeners;
+    volatile long *osccounter;  /* of the globals */
 } OSC_PORT;
 
 /* structure for global variables */
@@ -87,7 +93,7 @@ typedef struct {
     /* for OSCinit/OSClisten */
     int32_t   nPorts;
     OSC_PORT  *ports;
-    int32_t   osccounter;
+    volatile long osccounter;   /* messages received, not yet read */
     void      *mutex_;
 } OSC_GLOBALS;
 
@@ -105,15 +111,23 @@ typedef struct {
     MYFLT   *port;              /* Port number on which to listen */
 } OSCINITM;
 
+/* The messages for a listener are passed from the liblo thread to the
+   opcode through a ring of preallocated OSC_PATs, which only the handler
+   writes and only the opcode reads, so OSClisten takes no lock. */
 typedef struct osclcommon {
     lo_method method;
     char    *saved_path;
     char    saved_types[ARG_CNT];    /* copy of type list */
-    OSC_PAT *patterns;          /* FIFO list of pending messages */
-    OSC_PAT *freePatterns;      /* free message stack */
-    struct osclcomon *nxt;       /* pointer to next opcode on the same port */
+    uint32_t hash;              /* of path and types */
+    char    *ring;              /* OSC_RING messages of patSize bytes */
+    size_t  patSize;
+    volatile long rd, wr;       /* next message to read, to write */
+    long    dropped;            /* messages lost with the ring full */
+    struct osclcommon *nxt;     /* next opcode in the same index slot */
 } OSCLCOMMON;
 
+#define OSC_RING_PAT(o, n)  ((OSC_PAT*) ((o)->ring + (size_t) (n) * (o)->patSize))
+
 typedef struct {
     OPDS        h;                  /* default header */
     MYFLT       *kans;
@@ -400,6 +414,8 @@ static int32_t OSC_reset(CSOUND *csound, OSC_GLOBALS *p)
         lo_server_thread_free(p->ports[i].thread);
         csound->DestroyMutex(p->ports[i].mutex_);
       }
+    for (i = 0; i < p->nPorts; i++)
+      csound->Free(csound, p->ports[i].index);
     csound->DestroyGlobalVariable(csound, "_OSC_globals");
     return OK;
 }
@@ -436,29 +452,100 @@ static CS_NOINLINE OSC_GLOBALS *alloc_globals(CSOUND *csound)
 
  /* ------------------------------------------------------------------------ */
 
-static CS_NOINLINE OSC_PAT *alloc_pattern(CSOUND *csound)
+static uint32_t osc_hash(const char *path, const char *types)
 {
-    OSC_PAT *p;
-    size_t  nbytes;
+    uint32_t h = 2166136261u;
+    for ( ; *path != '\0'; path++)
+      h = (h ^ (unsigned char) *path) * 16777619u;
+    h = (h ^ '/') * 16777619u;
+    for ( ; *types != '\0'; types++)
+      h = (h ^ (unsigned char) *types) * 16777619u;
+    return h;
+}
 
-    /* number of bytes to allocate */
-    nbytes = sizeof(OSC_PAT);
-    /* allocate and initialise structure */
-    p = (OSC_PAT*) csound->Calloc(csound, nbytes);
+/* add a listener to the index of its port, before any other with the same
+   path and types, as these got the messages first; called with the port
+   locked */
+static void osc_index_add(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *o)
+{
+    if (2 * (port->nListeners + 1) > port->indexSize) {
+      int32_t       size = (port->indexSize ? 2 * port->indexSize : 64), i;
+      OSCLCOMMON    **index =
+        (OSCLCOMMON**) csound->Calloc(csound, size * sizeof(OSCLCOMMON*));
+      for (i = 0; i < port->indexSize; i++) {
+        /* move each chain in order, keeping newer listeners first */
+        OSCLCOMMON *q = port->index[i], *nxt;
+        while (q != NULL) {
+          OSCLCOMMON **pq = &index[q->hash & (size - 1)];
+          nxt = q->nxt;
+          while (*pq != NULL) pq = &(*pq)->nxt;
+          q->nxt = NULL;
+          *pq = q;
+          q = nxt;
+        }
+      }
+      csound->Free(csound, port->index);
+      port->index = index;
+      port->indexSize = size;
+    }
+    o->hash = osc_hash(o->saved_path, o->saved_types);
+    o->nxt = port->index[o->hash & (port->indexSize - 1)];
+    port->index[o->hash & (port->indexSize - 1)] = o;
+    port->nListeners++;
+}
 
-    return p;
+/* called with the port locked */
+static void osc_index_remove(OSC_PORT *port, OSCLCOMMON *o)
+{
+    OSCLCOMMON **pq;
+    if (port->index == NULL)
+      return;
+    for (pq = &port->index[o->hash & (port->indexSize - 1)];
+         *pq != NULL; pq = &(*pq)->nxt)
+      if (*pq == o) {
+        *pq = o->nxt;
+        port->nListeners--;
+        break;
+      }
+    o->nxt = NULL;
 }
 
-static inline OSC_PAT *get_pattern(CSOUND *csound,OSCLCOMMON *pp)
+/* the listener a message is for; called with the port locked */
+static inline OSCLCOMMON *osc_find(OSC_PORT *port,
+                                   const char *path, const char *types)
 {
-    OSC_PAT *p;
+    uint32_t    h;
+    OSCLCOMMON  *o;
 
-    if (pp->freePatterns != NULL) {
-      p = pp->freePatterns;
-      pp->freePatterns = p->next;
-      return p;
+    if (UNLIKELY(port->index == NULL))
+      return NULL;
+    h = osc_hash(path, types);
+    for (o = port->index[h & (port->indexSize - 1)]; o != NULL; o = o->nxt)
+      if (o->hash == h && strcmp(o->saved_path, path) == 0 &&
+          strcmp(o->saved_types, types) == 0)
+        return o;
+    return NULL;
+}
+
+/* allocate the ring of a listener with n arguments */
+static void osc_ring_alloc(CSOUND *csound, OSCLCOMMON *o, int32_t n)
+{
+    OSC_PAT *m = NULL;
+    o->patSize = sizeof(m->args[0]) * (n > 0 ? n : 1);
+    o->ring = (char*) csound->Calloc(csound, OSC_RING * o->patSize);
+    o->rd = o->wr = 0;
+    o->dropped = 0;
+}
+
+/* the next message to fill in the ring, or NULL if it is full */
+static inline OSC_PAT *osc_ring_next(OSCLCOMMON *o)
+{
+    long wr = o->wr;
+    if (UNLIKELY((wr + 1) % OSC_RING == ATOMIC_GET(o->rd))) {
+      o->dropped++;
+      return NULL;
     }
-    return alloc_pattern(csound);
+    return OSC_RING_PAT(o, wr);
 }
 
 typedef struct {
@@ -469,7 +556,7 @@ typedef struct {
 static int32_t OSCcounter(CSOUND *csound, OSCcount *p)
 {
     OSC_GLOBALS *g = alloc_globals(csound);
-    *p->ans = (MYFLT)g->osccounter;
+    *p->ans = (MYFLT)ATOMIC_GET(g->osccounter);
     return OK;
 }
 
@@ -483,83 +570,63 @@ static int32_t OSC_handler(const char *path, const char *types,
     int32_t       retval = 1;
 
     pp->csound->LockMutex(pp->mutex_);
-    o = (OSCLCOMMON*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        OSC_GLOBALS *g = alloc_globals(csound);
-        pp->csound->LockMutex(g->mutex_);
-        g->osccounter++;
-        pp->csound->UnlockMutex(g->mutex_);
-        m = get_pattern(csound, o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
-          }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-               m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-               m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-               m->args[i].number= (MYFLT) argv[i]->d; break;
-            case 's':
-              { // ***NO CHECK THAT m->args[i] IS A STRING
-                char  *src = (char*) &(argv[i]->s), *dst = m->args[i].string.data;
-                if (m->args[i].string.size <= (int32_t) strlen(src)) {
-                  if (dst != NULL) csound->Free(csound, dst);
-                  dst = csound->Strdup(csound, src);
-                  // who sets m->args[i].string.size ??
-                  m->args[i].string.data = dst;
-                  m->args[i].string.size = strlen(dst)+1;
-                }
-                else strcpy(dst, src);
-                break;
+    o = osc_find(pp, path, types);
+    if (o != NULL) {
+      /* Message is for this guy */
+      int32_t     i;
+      OSC_PAT *m = osc_ring_next(o);
+      if (m != NULL) {
+        /* copy argument list */
+        for (i = 0; o->saved_types[i] != '\0'; i++) {
+          switch (types[i]) {
+          default:              /* Should not happen */
+          case 'i':
+            m->args[i].number = (MYFLT) argv[i]->i; break;
+          case 'h':
+            m->args[i].number = (MYFLT) argv[i]->i64; break;
+          case 'c':
+             m->args[i].number= (MYFLT) argv[i]->c; break;
+          case 'f':
+             m->args[i].number = (MYFLT) argv[i]->f; break;
+          case 'd':
+             m->args[i].number= (MYFLT) argv[i]->d; break;
+          case 's':
+            { // ***NO CHECK THAT m->args[i] IS A STRING
+              char  *src = (char*) &(argv[i]->s), *dst = m->args[i].string.data;
+              if (m->args[i].string.size <= (int32_t) strlen(src)) {
+                if (dst != NULL) csound->Free(csound, dst);
+                dst = csound->Strdup(csound, src);
+                // who sets m->args[i].string.size ??
+                m->args[i].string.data = dst;
+                m->args[i].string.size = strlen(dst)+1;
               }
-            case 'b':
-              {
-                int32_t len =
-                  lo_blobsize((lo_blob*)argv[i]);
-                m->args[i].blob =
-                  csound->Malloc(csound,len);
-                memcpy(m->args[i].blob, argv[i], len);
+              else strcpy(dst, src);
+              break;
+            }
+          case 'b':
+            {
+              int32_t len =
+                lo_blobsize((lo_blob*)argv[i]);
+              m->args[i].blob =
+                csound->Malloc(csound,len);
+              memcpy(m->args[i].blob, argv[i], len);
 #ifdef OSC_DEBUG
-                {
-                  lo_blob *bb = (lo_blob*)m->args[i].blob;
-                  int32_t size = lo_blob_datasize(bb);
-                  MYFLT *data = lo_blob_dataptr(bb);
-                  int32_t   *idata = (int32_t*)data;
-                  printf("size=%d data=%.8x %.8x ...\n",size, idata[0], idata[1]);
-                }
-#endif
+              {
+                lo_blob *bb = (lo_blob*)m->args[i].blob;
+                int32_t size = lo_blob_datasize(bb);
+                MYFLT *data = lo_blob_dataptr(bb);
+                int32_t   *idata = (int32_t*)data;
+                printf("size=%d data=%.8x %.8x ...\n",size, idata[0], idata[1]);
               }
+#endif
             }
           }
-          retval = 0;
         }
-        break;
+        /* queue message for being read by OSClisten opcode */
+        ATOMIC_SET(o->wr, (o->wr + 1) % OSC_RING);
+        ATOMIC_INCR(*pp->osccounter);
       }
-      o = (OSCLCOMMON*) o->nxt;
+      retval = 0;
     }
 
     pp->csound->UnlockMutex(pp->mutex_);
@@ -602,7 +669,9 @@ static int32_t osc_listener_init(CSOUND *csound, OSCINIT *p)
                                         sizeof(OSC_PORT) * (n + 1));
     ports[n].csound = csound;
     ports[n].mutex_ = csound->Create_Mutex(0);
-    ports[n].oplst = NULL;
+    ports[n].index = NULL;
+    ports[n].indexSize = ports[n].nListeners = 0;
+    ports[n].osccounter = &pp->osccounter;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new(buff, OSC_error);
     if (UNLIKELY(ports[n].thread==NULL))
@@ -637,7 +706,9 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
                                         sizeof(OSC_PORT) * (n + 1));
     ports[n].csound = csound;
     ports[n].mutex_ = csound->Create_Mutex(0);
-    ports[n].oplst = NULL;
+    ports[n].index = NULL;
+    ports[n].indexSize = ports[n].nListeners = 0;
+    ports[n].osccounter = &pp->osccounter;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new_multicast(p->group->data,
                                                      buff, OSC_error);
@@ -663,18 +734,12 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
 
 static int32_t OSC_listendeinit(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *p)
 {
-    OSC_PAT *m;
+    int32_t i;
+    long    n;
 
     if (port->mutex_==NULL) return NOTOK;
     csound->LockMutex(port->mutex_);
-    if (port->oplst == (void*)p)
-      port->oplst = p->nxt;
-    else {
-      OSCLCOMMON *o = (OSCLCOMMON*) port->oplst;
-      for ( ; o->nxt != (void*) p; o = (OSCLCOMMON*) o->nxt)
-        ;
-      o->nxt = p->nxt;
-    }
+    osc_index_remove(port, p);
     csound->UnlockMutex(port->mutex_);
 #ifdef LIBLO29
     //Would like to use this call but requires liblo2.29
@@ -682,23 +747,31 @@ static int32_t OSC_listendeinit(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *p)
 #else
     lo_server_thread_del_method(port->thread, p->saved_path, p->saved_types);
 #endif
+    if (p->dropped > 0)
+      csound->Warning(csound, Str("OSClisten: %ld messages to %s dropped, "
+                                  "not read in time\n"),
+                      p->dropped, p->saved_path);
     csound->Free(csound, p->saved_path);
     p->saved_path = NULL;
-    p->nxt = NULL;
-    m = p->patterns;
-    p->patterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
+    if (p->ring == NULL)
+      return OK;
+    /* blobs of messages not read, and the strings kept by each message */
+    for (n = p->rd; n != p->wr; n = (n + 1) % OSC_RING) {
+      OSC_PAT *m = OSC_RING_PAT(p, n);
+      for (i = 0; p->saved_types[i] != '\0'; i++)
+        if (p->saved_types[i] == 'b' && m->args[i].blob != NULL)
+          csound->Free(csound, m->args[i].blob);
+      ATOMIC_DECR(*port->osccounter);
     }
-    m = p->freePatterns;
-    p->freePatterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
+    for (n = 0; n < OSC_RING; n++) {
+      OSC_PAT *m = OSC_RING_PAT(p, n);
+      for (i = 0; p->saved_types[i] != '\0'; i++)
+        if (p->saved_types[i] == 's' && m->args[i].string.data != NULL)
+          csound->Free(csound, m->args[i].string.data);
     }
+    csound->Free(csound, p->ring);
+    p->ring = NULL;
+    p->rd = p->wr = 0;
     return OK;
 }
 
@@ -772,9 +845,9 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
+    osc_ring_alloc(csound, &p->c, n);
     csound->LockMutex(p->port->mutex_);
-    p->c.nxt = p->port->oplst;
-    p->port->oplst = (void*) &p->c;
+    osc_index_add(csound, p->port, &p->c);
     csound->UnlockMutex(p->port->mutex_);
     p->c.method = lo_server_thread_add_method(p->port->thread,
                                               p->c.saved_path, p->c.saved_types,
@@ -787,19 +860,12 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
 static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
 {
     OSC_PAT *m;
+    long    rd = p->c.rd;
 
-    /* quick check for empty queue */
-    if (p->c.patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->c.patterns;
-    /* check again for thread safety */
-    if (m != NULL) {
+    /* the handler writes wr after the message is complete */
+    if (rd != ATOMIC_GET(p->c.wr)) {
       int32_t i;
-      /* unlink from queue */
-      p->c.patterns = m->next;
+      m = OSC_RING_PAT(&p->c, rd);
       /* copy arguments */
       //printf("copying args\n");
       for (i = 0; p->c.saved_types[i] != '\0'; i++) {
@@ -892,9 +958,11 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
               return csound->PerfError(csound, &(p->h),
                                        "%s", Str("OSC internal error"));
             }
-            if (len > (int32_t)  (ftp->flen*sizeof(MYFLT)))
+            if (len > (int32_t)  (ftp->flen*sizeof(MYFLT))) {
+              csound->FTUnmap(csound, ftp, 0);  /* not ours to ReAlloc */
               ftp->ftable = (MYFLT*)csound->ReAlloc(csound, ftp->ftable,
                                                     len*sizeof(MYFLT));
+            }
             memcpy(ftp->ftable,data,len);
 
 #if 0
@@ -908,10 +976,12 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
 #ifdef OSC_DEBUG
             printf("%d\n", len);
 #endif
-            if (len > ftp->flen*sizeof(MYFLT))
+            if (len > ftp->flen*sizeof(MYFLT)) {
+              csound->FTUnmap(csound, ftp, 0);
               ftp->ftable =
                 (MYFLT*)csound->ReAlloc(csound, ftp->ftable,
                                         len-sizeof(FUNC)+sizeof(MYFLT*));
+            }
 #endif
             {
 #ifdef OSC_DEBUG
@@ -933,22 +1003,18 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
           }
           else return csound->PerfError(csound,  &(p->h), "Oh dear");
           csound->Free(csound, m->args[i].blob);
+          m->args[i].blob = NULL;
         }
         else
           *(p->args[i]) = m->args[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->c.freePatterns;
-      p->c.freePatterns = m;
+      /* hand the message back to the handler */
+      ATOMIC_SET(p->c.rd, (rd + 1) % OSC_RING);
       *p->kans = 1;
-      OSC_GLOBALS *g = alloc_globals(csound);
-      csound->LockMutex(g->mutex_);
-      g->osccounter--;
-      csound->UnlockMutex(g->mutex_);
+      ATOMIC_DECR(*p->port->osccounter);
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
@@ -964,54 +1030,33 @@ static int32_t OSC_ahandler(const char *path, const char *types,
     int32_t   retval = 1;
     //printf("***in ahandler\n");
     csound->LockMutex(pp->mutex_);
-    o = (OSCLCOMMON*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        OSC_GLOBALS *g = alloc_globals(csound);
-        csound->LockMutex(g->mutex_);
-        g->osccounter++;
-        csound->UnlockMutex(g->mutex_);
-        //printf("handler found message\n");
-        m = get_pattern(csound, o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
+    o = osc_find(pp, path, types);
+    if (o != NULL) {
+      /* Message is for this guy */
+      int32_t     i;
+      OSC_PAT *m = osc_ring_next(o);
+      if (m != NULL) {
+        /* copy argument list */
+        for (i = 0; o->saved_types[i] != '\0'; i++) {
+          switch (types[i]) {
+          default:              /* Should not happen */
+          case 'i':
+            m->args[i].number = (MYFLT) argv[i]->i; break;
+          case 'h':
+            m->args[i].number = (MYFLT) argv[i]->i64; break;
+          case 'c':
+            m->args[i].number= (MYFLT) argv[i]->c; break;
+          case 'f':
+            m->args[i].number = (MYFLT) argv[i]->f; break;
+          case 'd':
+            m->args[i].number= (MYFLT) argv[i]->d; break;
           }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-              m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-              m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-              m->args[i].number= (MYFLT) argv[i]->d; break;
-            }
-          }
-          retval = 0;
         }
-        break;
+        /* queue message for being read by OSClisten opcode */
+        ATOMIC_SET(o->wr, (o->wr + 1) % OSC_RING);
+        ATOMIC_INCR(*pp->osccounter);
       }
-      o = (OSCLCOMMON*) o->nxt;
+      retval = 0;
     }
 
     pp->csound->UnlockMutex(pp->mutex_);
@@ -1052,9 +1097,9 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
+    osc_ring_alloc(csound, &p->c, n);
     csound->LockMutex(p->port->mutex_);
-    p->c.nxt = p->port->oplst;
-    p->port->oplst = (void*) &p->c;
+    osc_index_add(csound, p->port, &p->c);
     csound->UnlockMutex(p->port->mutex_);
     p->c.method = lo_server_thread_add_method(p->port->thread,
                                               p->c.saved_path, p->c.saved_types,
@@ -1067,36 +1112,25 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
 static int32_t OSC_alist(CSOUND *csound, OSCLISTENA *p)
 {
     OSC_PAT *m;
-    /* quick check for empty queue */
-    if (p->c.patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->c.patterns;
-    /* check again for thread safety */
-    if (m != NULL) {
+    long    rd = p->c.rd;
+    IGN(csound);
+    /* the handler writes wr after the message is complete */
+    if (rd != ATOMIC_GET(p->c.wr)) {
       int32_t i;
-      /* unlink from queue */
-      p->c.patterns = m->next;
+      m = OSC_RING_PAT(&p->c, rd);
       /* copy arguments */
       //printf("copying args\n");
       for (i = 0; p->c.saved_types[i] != '\0'; i++) {
         //printf("%d: type %c\n", i, p->c.saved_types[i]);
         ((MYFLT*)p->args->data)[i] = m->args[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->c.freePatterns;
-      p->c.freePatterns = m;
+      /* hand the message back to the handler */
+      ATOMIC_SET(p->c.rd, (rd + 1) % OSC_RING);
       *p->kans = 1;
-      OSC_GLOBALS *g = alloc_globals(csound);
-      csound->LockMutex(g->mutex_);
-      g->osccounter--;
-      csound->UnlockMutex(g->mutex_);
+      ATOMIC_DECR(*p->port->osccounter);
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
@@ -22,6 +22,7 @@
 */
 
 #include "stdopcod.h"
+#include "nupconv.h"
 #include <math.h>
 
 #define FTCONV_MAXCHN   8
@@ -35,6 +36,7 @@ typedef struct {
     MYFLT   *iSkipSamples;
     MYFLT   *iTotLen;
     MYFLT   *iSkipInit;
+    MYFLT   *iNonUniform;
  /* ------------------------- */
     int32_t     initDone;
     int32_t     nChannels;
@@ -48,6 +50,7 @@ typedef struct {
     MYFLT   *outBuffers[FTCONV_MAXCHN]; /* output buffer (size=partSize*2)  */
     void  *fwdsetup, *invsetup;
     AUXCH   auxData;
+    NUPCONV *nup;               /* non-uniform engine, or NULL              */
 } FTCONV;
 
 static void multiply_fft_buffers(MYFLT *outBuf, MYFLT *ringBuf,
@@ -148,6 +151,48 @@ static void set_buf_pointers(FTCONV *p,
     }
 }
 
+static int32_t ftconv_deinit(CSOUND *csound, void *p_)
+{
+    FTCONV  *p = (FTCONV*) p_;
+
+    nupconv_destroy(csound, p->nup);
+    p->nup = NULL;
+    p->initDone = 0;
+    return OK;
+}
+
+/* non-uniform partitioned mode: the first partitions are partSize long and
+   convolved here, later ones are longer and convolved by worker threads */
+static int32_t ftconv_init_nu(CSOUND *csound, FTCONV *p, FUNC *ftp,
+                              int32_t n, int32_t skipSamples)
+{
+    int32_t j;
+
+    if (p->nup != NULL) {
+      if (*(p->iSkipInit) != FL(0.0))
+        return OK;  /* skip initialisation if requested */
+      nupconv_destroy(csound, p->nup);
+    }
+    else
+      csound->RegisterDeinitCallback(csound, (void*) p, ftconv_deinit);
+    p->nup = nupconv_create(csound, p->partSize, n, p->nChannels, 1);
+    for (j = 0; j < p->nChannels; j++) {
+      /* frames outside the table stay zero */
+      int32_t start = (skipSamples < 0 ? -skipSamples : 0);
+      int32_t end = ((int32_t) ftp->flen - j + p->nChannels - 1) / p->nChannels;
+      if (end > skipSamples + n)
+        end = skipSamples + n;
+      if (end > skipSamples + start)
+        nupconv_load(p->nup, j,
+                     &(ftp->ftable[(skipSamples + start) * p->nChannels + j]),
+                     p->nChannels, start, end - skipSamples);
+    }
+    p->cnt = 0;
+    p->initDone = 1;
+
+    return OK;
+}
+
 static int32_t ftconv_init(CSOUND *csound, FTCONV *p)
 {
     FUNC    *ftp;
@@ -179,6 +224,12 @@ static int32_t ftconv_init(CSOUND *csound, FTCONV *p)
                                Str("ftconv: invalid length, or insufficient"
                                    " IR data for convolution"));
     }
+    if (*(p->iNonUniform) != FL(0.0))
+      return ftconv_init_nu(csound, p, ftp, n, skipSamples);
+    if (p->nup != NULL) {
+      nupconv_destroy(csound, p->nup);
+      p->nup = NULL;
+    }
     p->nPartitions = (n + (p->partSize - 1)) / p->partSize;
     /* calculate the amount of aux space to allocate (in bytes) */
     nBytes = buf_bytes_alloc(p->nChannels, p->partSize, p->nPartitions);
@@ -256,6 +307,27 @@ static int32_t ftconv_perf(CSOUND *csound, FTCONV *p)
 
     if (p->initDone <= 0) goto err1;
     nSamples = p->partSize;
+    if (p->nup != NULL) {
+      MYFLT *in = nupconv_input(p->nup);
+      if (UNLIKELY(offset))
+        for (n = 0; n < p->nChannels; n++)
+          memset(p->aOut[n], '\0', offset*sizeof(MYFLT));
+      if (UNLIKELY(early)) {
+        nsmps -= early;
+        for (n = 0; n < p->nChannels; n++)
+          memset(&p->aOut[n][nsmps], '\0', early*sizeof(MYFLT));
+      }
+      for (nn = offset; nn < nsmps; nn++) {
+        in[p->cnt] = p->aIn[nn];
+        for (n = 0; n < p->nChannels; n++)
+          p->aOut[n][nn] = nupconv_output(p->nup, n)[p->cnt];
+        if (++p->cnt < nSamples)
+          continue;
+        p->cnt = 0;
+        nupconv_process(csound, p->nup);
+      }
+      return OK;
+    }
     rBuf = &(p->ringBuf[p->rbCnt * (nSamples << 1)]);
     if (UNLIKELY(offset))
       for (n = 0; n < p->nChannels; n++)
@@ -313,7 +385,7 @@ int32_t ftconv_init_(CSOUND *csound)
 {
     return csound->AppendOpcode(csound, "ftconv",
                                 (int32_t) sizeof(FTCONV), TR, 3,
-                                "mmmmmmmm", "aiiooo",
+                                "mmmmmmmm", "aiioooo",
                                 (int32_t (*)(CSOUND *, void *)) ftconv_init,
                                 (int32_t (*)(CSOUND *, void *)) ftconv_perf,
                                 NULL);
@@ -24,6 +24,7 @@
 /* The implementation is indebted to the ftconv opcode by Istvan Varga 2005 */
 
 #include "csdl.h"
+#include "nupconv.h"
 #include <math.h>
 
 /*
@@ -93,6 +94,8 @@ typedef struct {
   MYFLT     *kUpdate;     // Control variable for updating the IR buffer
                           // (+1 is start load, -1 is start unload)
   MYFLT     *kClear;      // Clear output buffers
+  MYFLT     *iNonUniform; // Non-zero: longer partitions for the IR tail,
+                          // convolved by worker threads
 
   /*
   ** Internal state of opcode maintained outside
@@ -115,6 +118,7 @@ typedef struct {
 
   void    *fwdsetup, *invsetup;
   AUXCH   auxData;        /* Aux data buffer allocated in init pass */
+  NUPCONV *nup;           /* Non-uniform engine, or NULL */
 } liveconv_t;
 
 /*
@@ -239,6 +243,40 @@ static void set_buf_pointers(liveconv_t *p, int32_t partSize, int32_t nPartition
     p->loader.begin = (load_t*) ptr;
 }
 
+static int32_t liveconv_deinit(CSOUND *csound, void *p_)
+{
+    liveconv_t  *p = (liveconv_t*) p_;
+
+    nupconv_destroy(csound, p->nup);
+    p->nup = NULL;
+    p->initDone = 0;
+    return OK;
+}
+
+/*
+** Non-uniform mode: the IR lives in the engine, and the auxData buffer only
+** holds the load/unload bookkeeping.
+*/
+static int32_t liveconv_init_nu(CSOUND *csound, liveconv_t *p, int32_t n)
+{
+    int32_t nBytes = (p->nPartitions + 1) * (int32_t) sizeof(load_t);
+
+    if (nBytes != (int32_t) p->auxData.size)
+      csound->AuxAlloc(csound, (int32) nBytes, &(p->auxData));
+    p->loader.begin = (load_t*) p->auxData.auxp;
+    init_load(&p->loader, (p->nPartitions + 1));
+
+    if (p->nup != NULL)
+      nupconv_destroy(csound, p->nup);
+    else
+      csound->RegisterDeinitCallback(csound, (void*) p, liveconv_deinit);
+    /* the IR starts empty, as in the uniform mode */
+    p->nup = nupconv_create(csound, p->partSize, n, 1, 1);
+    p->cnt = 0;
+    p->initDone = 1;
+    return OK;
+}
+
 static int32_t liveconv_init(CSOUND *csound, liveconv_t *p)
 {
     FUNC    *ftp;       // function table
@@ -269,6 +307,13 @@ static int32_t liveconv_init(CSOUND *csound, liveconv_t *p)
     // Compute the number of partitions (total length / partition size)
     p->nPartitions = (n + (p->partSize - 1)) / p->partSize;
 
+    if (*(p->iNonUniform) != FL(0.0))
+      return liveconv_init_nu(csound, p, n);
+    if (p->nup != NULL) {
+      nupconv_destroy(csound, p->nup);
+      p->nup = NULL;
+    }
+
     /*
     ** Calculate the amount of aux space to allocate (in bytes) and
     ** allocate if necessary
@@ -318,11 +363,105 @@ static int32_t liveconv_init(CSOUND *csound, liveconv_t *p)
     return OK;
 }
 
+/*
+** Start a load (+1) or unload (-1) of the IR if requested; shared by both
+** modes.  The load is advanced at the next partition border.
+*/
+static void liveconv_update(liveconv_t *p)
+{
+    load_t      *load_ptr;
+    int32_t     updateIR;
+
+    if (p->loader.available) {
+
+      // The buffer before the head position is the temporary buffer
+      load_ptr = previous_load(&p->loader, p->loader.head);
+      updateIR = MYFLT2LRND(*(p->kUpdate));
+      if (updateIR == 1) {
+        load_ptr->status = LOADING;
+        load_ptr->pos = 0;
+      }
+      else if (updateIR == -1) {
+        load_ptr->status = UNLOADING;
+        load_ptr->pos = 0;
+      }
+      if (load_ptr->status != NO_LOAD) {
+        p->loader.available = 0;
+
+        /* Special case: At a partition border: Make the temporary buffer
+           head position */
+        if (p->cnt == 0)
+          p->loader.head = load_ptr;
+      }
+    }
+}
+
+/*
+** Non-uniform mode: each load/unload in progress passes one partSize
+** chunk of the IR to the engine per partition, in the same order as the
+** uniform mode, so the IR changes along the convolution wavefront.
+*/
+static int32_t liveconv_perf_nu(CSOUND *csound, liveconv_t *p)
+{
+    FUNC        *ftp;
+    MYFLT       *in, *out;
+    load_t      *load_ptr;
+    int32_t     nSamples = p->partSize, from, to;
+    uint32_t    offset = p->h.insdshead->ksmps_offset;
+    uint32_t    early  = p->h.insdshead->ksmps_no_end;
+    uint32_t    nn, nsmps = CS_KSMPS;
+
+    ftp = csound->FTnp2Find(csound, p->iFTNum);
+    if (UNLIKELY(offset))
+      memset(p->aOut, '\0', offset*sizeof(MYFLT));
+    if (UNLIKELY(early)) {
+      nsmps -= early;
+      memset(&p->aOut[nsmps], '\0', early*sizeof(MYFLT));
+    }
+    if (MYFLT2LRND(*(p->kClear))) {
+      nupconv_reset(p->nup);
+      p->cnt = 0;
+    }
+    liveconv_update(p);
+
+    in = nupconv_input(p->nup);
+    out = nupconv_output(p->nup, 0);
+    for (nn = offset; nn < nsmps; nn++) {
+      in[p->cnt] = p->aIn[nn];
+      p->aOut[nn] = out[p->cnt];
+      if (++p->cnt < nSamples)
+        continue;
+
+      load_ptr = p->loader.head;
+      while (load_ptr->status != NO_LOAD) {
+        from = load_ptr->pos;
+        to = from + nSamples;
+        if (load_ptr->status == LOADING && from < (int32_t) ftp->flen)
+          nupconv_load(p->nup, 0, &(ftp->ftable[from]), 1, from,
+                       (to < (int32_t) ftp->flen ? to : (int32_t) ftp->flen));
+        else
+          nupconv_load(p->nup, 0, NULL, 1, from, to);
+        load_ptr->pos += nSamples;
+        if (load_ptr->pos >= p->nPartitions * nSamples)
+          load_ptr->status = NO_LOAD;
+        load_ptr = next_load(&p->loader, load_ptr);
+      }
+      p->loader.available = 1;
+      load_ptr = previous_load(&p->loader, p->loader.head);
+      if (load_ptr->status != NO_LOAD)
+        p->loader.head = load_ptr;
+
+      p->cnt = 0;
+      nupconv_process(csound, p->nup);
+    }
+    return OK;
+}
+
 static int32_t liveconv_perf(CSOUND *csound, liveconv_t *p)
 {
     MYFLT       *x, *rBuf;
     FUNC        *ftp;       // function table
-    int32_t         i, k, n, nSamples, rBufPos, updateIR, clearBuf, nPart, cnt;
+    int32_t         i, k, n, nSamples, rBufPos, clearBuf, nPart, cnt;
 
     load_t      *load_ptr;
     // uint32_t                numLoad = p->nPartitions + 1;
@@ -333,6 +472,8 @@ static int32_t liveconv_perf(CSOUND *csound, liveconv_t *p)
 
     /* Only continue if initialized */
     if (UNLIKELY(p->initDone <= 0)) goto err1;
+    if (p->nup != NULL)
+      return liveconv_perf_nu(csound, p);
 
     ftp = csound->FTnp2Find(csound, p->iFTNum);
     nSamples = p->partSize;   /* Length of partition */
@@ -368,29 +509,7 @@ static int32_t liveconv_perf(CSOUND *csound, liveconv_t *p)
     **      0: Do nothing
     **  1: Gradually load the IR buffer
     */
-
-    if (p->loader.available) {
-
-      // The buffer before the head position is the temporary buffer
-      load_ptr = previous_load(&p->loader, p->loader.head);
-      updateIR = MYFLT2LRND(*(p->kUpdate));
-      if (updateIR == 1) {
-        load_ptr->status = LOADING;
-        load_ptr->pos = 0;
-      }
-      else if (updateIR == -1) {
-        load_ptr->status = UNLOADING;
-        load_ptr->pos = 0;
-      }
-      if (load_ptr->status != NO_LOAD) {
-        p->loader.available = 0;
-
-        /* Special case: At a partition border: Make the temporary buffer
-           head position */
-        if (p->cnt == 0)
-          p->loader.head = load_ptr;
-      }
-    }
+    liveconv_update(p);
 
     /* For each sample in the audio input buffer (length = ksmps) */
     for (nn = offset; nn < nsmps; nn++) {
@@ -512,7 +631,7 @@ static OENTRY localops[] = {
     sizeof(liveconv_t),     // data size of state block
     TR, 3,                  // thread
     "a",                    // output arguments
-    "aiikk",                // input arguments
+    "aiikko",               // input arguments
     (SUBR) liveconv_init,   // init function
     (SUBR) liveconv_perf    // a-rate function
   }
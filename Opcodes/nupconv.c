@@ -0,0 +1,589 @@
+/*
+    nupconv.c:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Non-uniform partitioned convolution engine, see nupconv.h */
+
+#include "csdl.h"
+#include "nupconv.h"
+
+#define NUPCONV_TAILPARTS   (6)     /* partitions per level below the cap */
+#define NUPCONV_MAXLEVELS   (8)
+#define NUPCONV_MAXTHREADS  (8)
+
+enum { JOB_IDLE = 0, JOB_QUEUED, JOB_RUNNING };
+
+typedef struct {
+    int32_t size;           /* partition length L */
+    int32_t offset;         /* first IR sample of this level */
+    int32_t nParts;         /* number of partitions */
+    int32_t period;         /* L / B: blocks between runs */
+    void    *fwd, *inv;     /* FFT setups, 2L */
+    MYFLT   *fdl;           /* spectra of the last nParts input blocks */
+    int32_t fdlPos;         /* slot of the newest spectrum */
+    MYFLT   *irSpec;        /* nChannels * nParts IR spectra, 2L each */
+    MYFLT   *irTime;        /* nChannels * nParts IR partitions, L each */
+    char    *dirty;         /* irTime changed since copied to irSpec */
+    char    *fftPending;    /* irSpec holds time data to be transformed */
+    MYFLT   *in;            /* input block of the current job, 2L */
+    MYFLT   *acc;           /* spectrum accumulator, 2L */
+    MYFLT   *res;           /* nChannels results of the last job, 2L each */
+    MYFLT   *out;           /* nChannels output segments, L each */
+    MYFLT   *tail;          /* nChannels overlap-add tails, L each */
+    /* tail levels only */
+    NUPCONV *owner;
+    int32_t index;          /* level number in owner */
+    volatile int32_t state; /* JOB_* */
+    int64_t deadline;       /* sample time the result is needed at */
+    int32_t heapPos;        /* index in the pool's heap while queued */
+} NUPC_LEVEL;
+
+typedef struct NUPC_POOL_ NUPC_POOL;
+
+typedef struct {
+    NUPC_POOL *pool;
+    void    *thread, *lock;   /* the thread sleeps on lock */
+    volatile int32_t sleeping;
+} NUPC_WORKER;
+
+/* The worker threads of a Csound instance, shared by all its engines and
+   kept in a global variable so that the copies of this file in libcsound
+   and in the liveconv plugin find the same one.  Queued tail levels are
+   in a heap ordered by deadline; the threads run until the next reset. */
+struct NUPC_POOL_ {
+    CSOUND  *csound;
+    void    *mutex;         /* guards the heap, job states and waits */
+    NUPC_LEVEL **heap;
+    int32_t nJobs;          /* queued */
+    int32_t maxJobs;        /* tail levels of all attached engines */
+    int32_t heapSize;
+    int32_t nThreads;
+    volatile int32_t quit;
+    NUPC_WORKER worker[NUPCONV_MAXTHREADS];
+};
+
+struct NUPCONV_ {
+    CSOUND  *csound;
+    int32_t blockSize, irLen, nChannels, nLevels;
+    NUPC_LEVEL level[NUPCONV_MAXLEVELS];
+    MYFLT   *inBlock;       /* B input samples from the caller */
+    MYFLT   *outBlock;      /* nChannels * B output samples */
+    MYFLT   *hist;          /* last histLen input samples */
+    int32_t histLen;
+    uint64_t blocks;        /* blocks processed since the last reset */
+    NUPC_POOL *pool;        /* NULL: the tail is convolved inline */
+    void    *doneLock;      /* notified when waitLevel finishes */
+    volatile int32_t waitLevel;
+};
+
+/* acc += x * h, for spectra in the format of csoundRealFFT2() */
+static void nupc_cmac(MYFLT *acc, const MYFLT *x, const MYFLT *h, int32_t n)
+{
+    int32_t i;
+    acc[0] += x[0] * h[0];          /* DC */
+    acc[1] += x[1] * h[1];          /* Nyquist */
+    for (i = 2; i < n; i += 2) {
+      MYFLT re = x[i] * h[i] - x[i + 1] * h[i + 1];
+      MYFLT im = x[i] * h[i + 1] + x[i + 1] * h[i];
+      acc[i] += re;
+      acc[i + 1] += im;
+    }
+}
+
+/* Transform the input block and any reloaded IR partitions, and convolve.
+   For tail levels this may run in any thread of the pool, which owns
+   everything but out and tail while the job is queued or running. */
+static void nupc_run(CSOUND *csound, NUPCONV *c, NUPC_LEVEL *lv)
+{
+    int32_t n = lv->size << 1, ch, p, k;
+    MYFLT   *x;
+
+    for (k = 0; k < c->nChannels * lv->nParts; k++)
+      if (lv->fftPending[k]) {
+        csound->RealFFT2(csound, lv->fwd, lv->irSpec + (size_t) k * n);
+        lv->fftPending[k] = 0;
+      }
+    if (++lv->fdlPos >= lv->nParts)
+      lv->fdlPos = 0;
+    x = lv->fdl + (size_t) lv->fdlPos * n;
+    memcpy(x, lv->in, n * sizeof(MYFLT));
+    csound->RealFFT2(csound, lv->fwd, x);
+    for (ch = 0; ch < c->nChannels; ch++) {
+      const MYFLT *h = lv->irSpec + (size_t) ch * lv->nParts * n;
+      memset(lv->acc, 0, n * sizeof(MYFLT));
+      for (p = 0, k = lv->fdlPos; p < lv->nParts; p++, h += n) {
+        nupc_cmac(lv->acc, lv->fdl + (size_t) k * n, h, n);
+        if (--k < 0) k = lv->nParts - 1;
+      }
+      csound->RealFFT2(csound, lv->inv, lv->acc);
+      memcpy(lv->res + (size_t) ch * n, lv->acc, n * sizeof(MYFLT));
+    }
+}
+
+/* earliest deadline first; of two due together, the shorter job */
+static int32_t nupc_before(const NUPC_LEVEL *a, const NUPC_LEVEL *b)
+{
+    return (a->deadline < b->deadline ||
+            (a->deadline == b->deadline && a->size < b->size));
+}
+
+static void nupc_heap_set(NUPC_POOL *pool, int32_t i, NUPC_LEVEL *lv)
+{
+    pool->heap[i] = lv;
+    lv->heapPos = i;
+}
+
+static void nupc_push(NUPC_POOL *pool, NUPC_LEVEL *lv)
+{
+    int32_t i = pool->nJobs++;
+    while (i > 0 && nupc_before(lv, pool->heap[(i - 1) >> 1])) {
+      nupc_heap_set(pool, i, pool->heap[(i - 1) >> 1]);
+      i = (i - 1) >> 1;
+    }
+    nupc_heap_set(pool, i, lv);
+}
+
+/* take the job at heap position i out, and mark it running */
+static NUPC_LEVEL *nupc_take(NUPC_POOL *pool, int32_t i)
+{
+    NUPC_LEVEL *lv = pool->heap[i], *last = pool->heap[--pool->nJobs];
+    int32_t j;
+
+    lv->state = JOB_RUNNING;
+    if (i == pool->nJobs)
+      return lv;
+    /* move the last job into the hole, then up or down to its place */
+    while (i > 0 && nupc_before(last, pool->heap[(i - 1) >> 1])) {
+      nupc_heap_set(pool, i, pool->heap[(i - 1) >> 1]);
+      i = (i - 1) >> 1;
+    }
+    while ((j = (i << 1) + 1) < pool->nJobs) {
+      if (j + 1 < pool->nJobs && nupc_before(pool->heap[j + 1], pool->heap[j]))
+        j++;
+      if (!nupc_before(pool->heap[j], last))
+        break;
+      nupc_heap_set(pool, i, pool->heap[j]);
+      i = j;
+    }
+    nupc_heap_set(pool, i, last);
+    return lv;
+}
+
+/* run a job taken from the heap; called and returns with the mutex held */
+static void nupc_run_job(CSOUND *csound, NUPC_POOL *pool, NUPC_LEVEL *lv)
+{
+    NUPCONV *c = lv->owner;
+
+    csound->UnlockMutex(pool->mutex);
+    nupc_run(csound, c, lv);
+    csound->LockMutex(pool->mutex);
+    lv->state = JOB_IDLE;
+    if (c->waitLevel == lv->index) {
+      c->waitLevel = -1;
+      csound->NotifyThreadLock(c->doneLock);
+    }
+}
+
+static uintptr_t nupc_worker(void *arg)
+{
+    NUPC_WORKER *w = (NUPC_WORKER *) arg;
+    NUPC_POOL *pool = w->pool;
+    CSOUND  *csound = pool->csound;
+
+    csound->LockMutex(pool->mutex);
+    while (!pool->quit) {
+      if (pool->nJobs == 0) {
+        w->sleeping = 1;
+        csound->UnlockMutex(pool->mutex);
+        csound->WaitThreadLockNoTimeout(w->lock);
+        csound->LockMutex(pool->mutex);
+        continue;
+      }
+      nupc_run_job(csound, pool, nupc_take(pool, 0));
+    }
+    csound->UnlockMutex(pool->mutex);
+    return 0;
+}
+
+static int32_t nupc_pool_reset(CSOUND *csound, void *p)
+{
+    NUPC_POOL *pool = (NUPC_POOL *) p;
+    int32_t i;
+
+    csound->LockMutex(pool->mutex);
+    pool->quit = 1;
+    for (i = 0; i < pool->nThreads; i++)
+      if (pool->worker[i].sleeping) {
+        pool->worker[i].sleeping = 0;
+        csound->NotifyThreadLock(pool->worker[i].lock);
+      }
+    csound->UnlockMutex(pool->mutex);
+    for (i = 0; i < pool->nThreads; i++) {
+      csound->JoinThread(pool->worker[i].thread);
+      csound->DestroyThreadLock(pool->worker[i].lock);
+    }
+    pool->nThreads = 0;
+    csound->DestroyMutex(pool->mutex);
+    pool->mutex = NULL;
+    return OK;
+}
+
+/* the pool of this Csound instance, started with one thread per -j (at
+   least one); NULL if no thread could be started */
+static NUPC_POOL *nupc_pool(CSOUND *csound)
+{
+    NUPC_POOL *pool;
+    OPARMS  oparms;
+    int32_t i, n;
+
+    pool = (NUPC_POOL *) csound->QueryGlobalVariable(csound, "::nupconv");
+    if (pool != NULL)
+      return (pool->nThreads > 0 ? pool : NULL);
+    if (csound->CreateGlobalVariable(csound, "::nupconv",
+                                     sizeof(NUPC_POOL)) != 0)
+      return NULL;
+    pool = (NUPC_POOL *) csound->QueryGlobalVariable(csound, "::nupconv");
+    pool->csound = csound;
+    if ((pool->mutex = csound->Create_Mutex(0)) == NULL)
+      return NULL;
+    csound->GetOParms(csound, &oparms);
+    n = oparms.numThreads;
+    n = (n < 1 ? 1 : (n > NUPCONV_MAXTHREADS ? NUPCONV_MAXTHREADS : n));
+    for (i = 0; i < n; i++) {
+      NUPC_WORKER *w = &pool->worker[i];
+      w->pool = pool;
+      if ((w->lock = csound->CreateThreadLock()) == NULL)
+        break;
+      /* starts taken: the first wait blocks until notified */
+      csound->WaitThreadLock(w->lock, (size_t) 0);
+      if ((w->thread = csound->CreateThread(nupc_worker, (void *) w)) == NULL) {
+        csound->DestroyThreadLock(w->lock);
+        break;
+      }
+      pool->nThreads++;
+    }
+    csound->RegisterResetCallback(csound, (void *) pool, nupc_pool_reset);
+    return (pool->nThreads > 0 ? pool : NULL);
+}
+
+/* join the pool, with room in its heap for all our tail levels */
+static void nupc_attach(CSOUND *csound, NUPCONV *c)
+{
+    NUPC_POOL *pool = nupc_pool(csound);
+
+    if (pool == NULL || (c->doneLock = csound->CreateThreadLock()) == NULL) {
+      csound->Warning(csound, "%s", Str("nupconv: could not start worker "
+                                        "thread, convolving in the audio "
+                                        "thread"));
+      return;
+    }
+    csound->WaitThreadLock(c->doneLock, (size_t) 0);
+    csound->LockMutex(pool->mutex);
+    pool->maxJobs += c->nLevels - 1;
+    if (pool->maxJobs > pool->heapSize) {
+      pool->heapSize = pool->maxJobs + 16;
+      pool->heap = (NUPC_LEVEL **)
+        csound->ReAlloc(csound, pool->heap,
+                        pool->heapSize * sizeof(NUPC_LEVEL *));
+    }
+    csound->UnlockMutex(pool->mutex);
+    c->pool = pool;
+}
+
+static void nupc_submit(CSOUND *csound, NUPCONV *c, int32_t l)
+{
+    NUPC_POOL *pool = c->pool;
+    NUPC_LEVEL *lv = &c->level[l];
+    int32_t i;
+
+    if (pool == NULL) {
+      nupc_run(csound, c, lv);
+      return;
+    }
+    /* due when the level is next collected, one period from now */
+    lv->deadline = csound->GetCurrentTimeSamples(csound)
+                   + (int64_t) lv->period * c->blockSize;
+    csound->LockMutex(pool->mutex);
+    lv->state = JOB_QUEUED;
+    nupc_push(pool, lv);
+    for (i = 0; i < pool->nThreads; i++)
+      if (pool->worker[i].sleeping) {
+        pool->worker[i].sleeping = 0;
+        csound->NotifyThreadLock(pool->worker[i].lock);
+        break;
+      }
+    csound->UnlockMutex(pool->mutex);
+}
+
+/* Wait for level l.  Rather than block, run it here if no worker has
+   taken it yet, and while it runs help with any job due no later. */
+static void nupc_wait(CSOUND *csound, NUPCONV *c, int32_t l)
+{
+    NUPC_POOL *pool = c->pool;
+    NUPC_LEVEL *lv = &c->level[l];
+
+    if (pool == NULL) return;
+    csound->LockMutex(pool->mutex);
+    while (lv->state != JOB_IDLE) {
+      if (lv->state == JOB_QUEUED)
+        nupc_run_job(csound, pool, nupc_take(pool, lv->heapPos));
+      else if (pool->nJobs > 0 && !nupc_before(lv, pool->heap[0]))
+        nupc_run_job(csound, pool, nupc_take(pool, 0));
+      else {
+        c->waitLevel = l;
+        csound->UnlockMutex(pool->mutex);
+        csound->WaitThreadLockNoTimeout(c->doneLock);
+        csound->LockMutex(pool->mutex);
+      }
+    }
+    csound->UnlockMutex(pool->mutex);
+}
+
+/* copy reloaded IR partitions into their spectrum slots */
+static void nupc_stage_ir(NUPCONV *c, NUPC_LEVEL *lv)
+{
+    int32_t k, L = lv->size;
+    for (k = 0; k < c->nChannels * lv->nParts; k++)
+      if (lv->dirty[k]) {
+        MYFLT *s = lv->irSpec + (size_t) k * (L << 1);
+        memcpy(s, lv->irTime + (size_t) k * L, L * sizeof(MYFLT));
+        memset(s + L, 0, L * sizeof(MYFLT));
+        lv->fftPending[k] = 1;
+        lv->dirty[k] = 0;
+      }
+}
+
+NUPCONV *nupconv_create(CSOUND *csound, int32_t blockSize, int32_t irLen,
+                        int32_t nChannels, int32_t threaded)
+{
+    NUPCONV *c;
+    int32_t l, L, covered, nch = nChannels;
+
+    c = (NUPCONV *) csound->Calloc(csound, sizeof(NUPCONV));
+    c->csound = csound;
+    c->blockSize = blockSize;
+    c->irLen = irLen;
+    c->nChannels = nch;
+    c->waitLevel = -1;
+    /* lay out the levels: the head, then 4x longer partitions each
+       starting at 2L - B, until the IR is covered */
+    for (l = 0, L = blockSize, covered = 0;
+         covered < irLen && l < NUPCONV_MAXLEVELS; l++, L <<= 2) {
+      NUPC_LEVEL *lv = &c->level[l];
+      int32_t n;
+      lv->size = L;
+      lv->offset = covered;
+      n = (irLen - covered + L - 1) / L;
+      if ((L << 2) <= NUPCONV_MAXPART && l + 1 < NUPCONV_MAXLEVELS)
+        n = (n < (l ? NUPCONV_TAILPARTS : NUPCONV_HEADPARTS) ?
+             n : (l ? NUPCONV_TAILPARTS : NUPCONV_HEADPARTS));
+      lv->nParts = n;
+      lv->period = L / blockSize;
+      covered += n * L;
+    }
+    c->nLevels = l;
+    c->histLen = c->level[l - 1].size;
+    for (l = 0; l < c->nLevels; l++) {
+      NUPC_LEVEL *lv = &c->level[l];
+      size_t  n = (size_t) lv->size << 1;
+      lv->fwd = csound->RealFFT2Setup(csound, (int32_t) n, FFT_FWD);
+      lv->inv = csound->RealFFT2Setup(csound, (int32_t) n, FFT_INV);
+      lv->fdl = (MYFLT *) csound->Calloc(csound, n * lv->nParts * sizeof(MYFLT));
+      lv->irSpec = (MYFLT *)
+        csound->Calloc(csound, n * lv->nParts * nch * sizeof(MYFLT));
+      lv->irTime = (MYFLT *)
+        csound->Calloc(csound, (n >> 1) * lv->nParts * nch * sizeof(MYFLT));
+      lv->dirty = (char *) csound->Calloc(csound, lv->nParts * nch);
+      lv->fftPending = (char *) csound->Calloc(csound, lv->nParts * nch);
+      lv->in = (MYFLT *) csound->Calloc(csound, n * sizeof(MYFLT));
+      lv->acc = (MYFLT *) csound->Calloc(csound, n * sizeof(MYFLT));
+      lv->res = (MYFLT *) csound->Calloc(csound, n * nch * sizeof(MYFLT));
+      lv->out = (MYFLT *) csound->Calloc(csound, (n >> 1) * nch * sizeof(MYFLT));
+      lv->tail = (MYFLT *) csound->Calloc(csound, (n >> 1) * nch * sizeof(MYFLT));
+      lv->fdlPos = lv->nParts - 1;
+      /* build any FFT tables now, not in the worker */
+      csound->RealFFT2(csound, lv->fwd, lv->acc);
+      csound->RealFFT2(csound, lv->inv, lv->acc);
+    }
+    c->inBlock = (MYFLT *) csound->Calloc(csound, blockSize * sizeof(MYFLT));
+    c->outBlock = (MYFLT *)
+      csound->Calloc(csound, (size_t) blockSize * nch * sizeof(MYFLT));
+    c->hist = (MYFLT *) csound->Calloc(csound, c->histLen * sizeof(MYFLT));
+
+    for (l = 1; l < c->nLevels; l++) {
+      c->level[l].owner = c;
+      c->level[l].index = l;
+    }
+    if (threaded && c->nLevels > 1)
+      nupc_attach(csound, c);
+    return c;
+}
+
+void nupconv_destroy(CSOUND *csound, NUPCONV *c)
+{
+    int32_t l;
+
+    if (c == NULL) return;
+    if (c->pool != NULL) {
+      /* no job of ours may be left for the pool */
+      for (l = 1; l < c->nLevels; l++)
+        nupc_wait(csound, c, l);
+      csound->LockMutex(c->pool->mutex);
+      c->pool->maxJobs -= c->nLevels - 1;
+      csound->UnlockMutex(c->pool->mutex);
+      csound->DestroyThreadLock(c->doneLock);
+    }
+    for (l = 0; l < c->nLevels; l++) {
+      NUPC_LEVEL *lv = &c->level[l];
+      csound->Free(csound, lv->fdl);
+      csound->Free(csound, lv->irSpec);
+      csound->Free(csound, lv->irTime);
+      csound->Free(csound, lv->dirty);
+      csound->Free(csound, lv->fftPending);
+      csound->Free(csound, lv->in);
+      csound->Free(csound, lv->acc);
+      csound->Free(csound, lv->res);
+      csound->Free(csound, lv->out);
+      csound->Free(csound, lv->tail);
+    }
+    csound->Free(csound, c->inBlock);
+    csound->Free(csound, c->outBlock);
+    csound->Free(csound, c->hist);
+    csound->Free(csound, c);
+}
+
+void nupconv_load(NUPCONV *c, int32_t ch, const MYFLT *src,
+                  int32_t stride, int32_t from, int32_t to)
+{
+    int32_t l;
+
+    if (from < 0) {
+      if (src != NULL) src -= (intptr_t) from * stride;
+      from = 0;
+    }
+    for (l = 0; l < c->nLevels && from < to; l++) {
+      NUPC_LEVEL *lv = &c->level[l];
+      int32_t end = lv->offset + lv->nParts * lv->size;
+      while (from < to && from < end) {
+        int32_t p = (from - lv->offset) / lv->size;
+        int32_t i = (from - lv->offset) - p * lv->size;
+        int32_t n = lv->size - i, k = ch * lv->nParts + p;
+        MYFLT   *dst = lv->irTime + (size_t) k * lv->size + i;
+        if (n > to - from) n = to - from;
+        if (src == NULL)
+          memset(dst, 0, n * sizeof(MYFLT));
+        else {
+          int32_t j;
+          for (j = 0; j < n; j++, src += stride)
+            dst[j] = *src;
+        }
+        lv->dirty[k] = 1;
+        from += n;
+      }
+    }
+}
+
+void nupconv_reset(NUPCONV *c)
+{
+    int32_t l;
+    for (l = 1; l < c->nLevels; l++)
+      nupc_wait(c->csound, c, l);
+    for (l = 0; l < c->nLevels; l++) {
+      NUPC_LEVEL *lv = &c->level[l];
+      size_t  n = (size_t) lv->size << 1;
+      memset(lv->fdl, 0, n * lv->nParts * sizeof(MYFLT));
+      memset(lv->res, 0, n * c->nChannels * sizeof(MYFLT));
+      memset(lv->out, 0, (n >> 1) * c->nChannels * sizeof(MYFLT));
+      memset(lv->tail, 0, (n >> 1) * c->nChannels * sizeof(MYFLT));
+    }
+    memset(c->hist, 0, c->histLen * sizeof(MYFLT));
+    memset(c->outBlock, 0, (size_t) c->blockSize * c->nChannels * sizeof(MYFLT));
+    c->blocks = 0;
+}
+
+MYFLT *nupconv_input(NUPCONV *c)
+{
+    return c->inBlock;
+}
+
+MYFLT *nupconv_output(NUPCONV *c, int32_t ch)
+{
+    return c->outBlock + (size_t) ch * c->blockSize;
+}
+
+void nupconv_process(CSOUND *csound, NUPCONV *c)
+{
+    int32_t B = c->blockSize, ch, l, i;
+    NUPC_LEVEL *lv = &c->level[0];
+    MYFLT   *hist;
+
+    /* keep the input for the tail levels */
+    hist = c->hist + (size_t) ((c->blocks * B) % c->histLen);
+    memcpy(hist, c->inBlock, B * sizeof(MYFLT));
+    c->blocks++;
+
+    /* the head: output starts with the first half of this block */
+    nupc_stage_ir(c, lv);
+    memcpy(lv->in, c->inBlock, B * sizeof(MYFLT));
+    memset(lv->in + B, 0, B * sizeof(MYFLT));
+    nupc_run(csound, c, lv);
+    for (ch = 0; ch < c->nChannels; ch++) {
+      MYFLT *r = lv->res + (size_t) ch * (B << 1);
+      MYFLT *t = lv->tail + (size_t) ch * B;
+      MYFLT *o = c->outBlock + (size_t) ch * B;
+      for (i = 0; i < B; i++) {
+        o[i] = r[i] + t[i];
+        t[i] = r[i + B];
+      }
+    }
+
+    /* the tail: collect each level whose input block is complete, which
+       gives its next L output samples, and start it on the new block */
+    for (l = 1; l < c->nLevels; l++) {
+      int32_t L, pos;
+      lv = &c->level[l];
+      L = lv->size;
+      pos = (int32_t) ((c->blocks % lv->period) * B);
+      if (pos == 0) {
+        nupc_wait(csound, c, l);
+        for (ch = 0; ch < c->nChannels; ch++) {
+          MYFLT *r = lv->res + (size_t) ch * (L << 1);
+          MYFLT *t = lv->tail + (size_t) ch * L;
+          MYFLT *o = lv->out + (size_t) ch * L;
+          for (i = 0; i < L; i++) {
+            o[i] = r[i] + t[i];
+            t[i] = r[i + L];
+          }
+        }
+        memcpy(lv->in,
+               c->hist + (size_t) (((c->blocks - lv->period) * B) % c->histLen),
+               L * sizeof(MYFLT));
+        memset(lv->in + L, 0, L * sizeof(MYFLT));
+        nupc_stage_ir(c, lv);
+        nupc_submit(csound, c, l);
+      }
+      for (ch = 0; ch < c->nChannels; ch++) {
+        MYFLT *o = c->outBlock + (size_t) ch * B;
+        MYFLT *s = lv->out + (size_t) ch * L + pos;
+        for (i = 0; i < B; i++)
+          o[i] += s[i];
+      }
+    }
+}
@@ -0,0 +1,73 @@
+/*
+    nupconv.h:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef NUPCONV_H
+#define NUPCONV_H
+
+/*
+  Non-uniform partitioned convolution, shared by ftconv and liveconv.
+
+  The impulse response is split into a head of NUPCONV_HEADPARTS
+  partitions of the block size B, which is convolved in the audio
+  thread, followed by levels of partitions 4, 16, 64 ... times longer
+  (up to NUPCONV_MAXPART samples).  A level with partition length L
+  starts 2L - B samples into the IR, so its result is not needed until
+  one partition after its input block is complete: the tail levels are
+  computed in that time by a pool of worker threads, one per -j thread
+  (at least one), shared by all engines of the Csound instance and
+  serving the level due first.  A level that is late is not dropped:
+  the audio thread convolves it itself if no worker has started it, or
+  waits for it, helping with jobs due no later.  So the output is always
+  the same as a uniform convolution with partition length B, with the
+  same latency of B samples.
+
+  Usage: fill nupconv_input() with B input samples, call
+  nupconv_process(), then read B output samples per channel from
+  nupconv_output().  The engine is not reentrant; each opcode instance
+  owns one.
+*/
+
+#define NUPCONV_HEADPARTS   (7)
+#define NUPCONV_MAXPART     (16384)
+
+typedef struct NUPCONV_ NUPCONV;
+
+/* Create an engine with block size blockSize (a power of two, at least
+   4) for nChannels impulse responses of irLen samples each; the IRs are
+   all zero until loaded.  If threaded is zero, or the worker pool cannot
+   be started, the tail is computed in nupconv_process(). */
+NUPCONV *nupconv_create(CSOUND *csound, int32_t blockSize, int32_t irLen,
+                        int32_t nChannels, int32_t threaded);
+void    nupconv_destroy(CSOUND *csound, NUPCONV *c);
+
+/* Set samples from .. to - 1 of the IR of channel ch to src[0],
+   src[stride] ..., or to zero if src is NULL.  The change reaches each
+   partition at the next block that partition is used in. */
+void    nupconv_load(NUPCONV *c, int32_t ch, const MYFLT *src,
+                     int32_t stride, int32_t from, int32_t to);
+/* clear the input history and pending output, keeping the IRs */
+void    nupconv_reset(NUPCONV *c);
+
+MYFLT   *nupconv_input(NUPCONV *c);
+MYFLT   *nupconv_output(NUPCONV *c, int32_t ch);
+void    nupconv_process(CSOUND *csound, NUPCONV *c);
+
+#endif  /* NUPCONV_H */
@@ -23,6 +23,7 @@
 
 #include "stdopcod.h"
 #include "oscbnk.h"
+#include "tabosc_simd.h"
 #include <math.h>
 
 static inline STDOPCOD_GLOBALS *get_oscbnk_globals(CSOUND *csound)
@@ -412,10 +413,12 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
     MYFLT   k, a_d = FL(0.0), a1_d = FL(0.0), a2_d = FL(0.0),
               b0_d = FL(0.0), b1_d = FL(0.0), b2_d = FL(0.0);
     MYFLT   yn, xnm1 = FL(0.0), xnm2 = FL(0.0), ynm1 = FL(0.0), ynm2 = FL(0.0);
+    MYFLT   amp[OSCBNK_BLOCK];                  /* AM ramp      */
+    TABOSC  tab;
     OSCBNK_OSC      *o;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t nn, nsmps = CS_KSMPS;
+    uint32_t nn, blk, nsmps = CS_KSMPS;
 
     /* clear output signal */
     memset(p->args[0], '\0', nsmps*sizeof(MYFLT));
@@ -431,6 +434,8 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
     if (UNLIKELY((ftp == NULL) || ((ft = ftp->ftable) == NULL)))
       return NOTOK;
     oscbnk_flen_setup(ftp->flen, &(mask), &(lobits), &(pfrac));
+    tab.ft = ft; tab.lobits = lobits; tab.mask = mask; tab.pfrac = pfrac;
+    tab.phsmsk = OSCBNK_PHSMSK;
 
     /* some constants */
     pm_enabled = (p->ilfomode & 0x22 ? 1 : 0);
@@ -473,17 +478,15 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
         }
         f_i = OSCBNK_PHS2INT(f);
         if (am_enabled) a_d = (o->osc_amp - a)  / (nsmps-offset);
-        /* oscillator */
-        for (nn = offset; nn < nsmps; nn++) {
-          /* read from table */
-          n = ph >> lobits; k = ft[n++];
-          k += (ft[n] - k) * (MYFLT) ((int32) (ph & mask)) * pfrac;
+        /* oscillator, OSCBNK_BLOCK samples at a time */
+        for (nn = offset; nn < nsmps; nn += blk) {
+          blk = nsmps - nn;
+          if (blk > OSCBNK_BLOCK) blk = OSCBNK_BLOCK;
           /* amplitude modulation */
-          if (am_enabled) k *= (a += a_d);
-          /* mix to output */
-          p->args[0][nn] += k;
-          /* update phase */
-          ph = (ph + f_i) & OSCBNK_PHSMSK;
+          if (am_enabled)
+            for (n = 0; n < blk; n++) amp[n] = (a += a_d);
+          ph = tabosc_kernels->lin(p->args[0] + nn, am_enabled ? amp : NULL,
+                                   &tab, ph, f_i, blk);
         }
       }
       else {                        /* EQ enabled */
@@ -43,6 +43,7 @@
 
 #define OSCBNK_PHSMAX   0x80000000UL    /* max. phase   */
 #define OSCBNK_PHSMSK   0x7FFFFFFFUL    /* phase mask   */
+#define OSCBNK_BLOCK    256             /* samples per kernel call */
 #define OSCBNK_RNDPHS   0               /* 31 bit rand -> phase bit shift */
 
 /* convert floating point phase value to integer */
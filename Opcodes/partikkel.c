@@ -217,6 +217,8 @@ static inline MYFLT dsf(FUNC *tab, GRAIN *grain, double beta, MYFLT zscale,
     return result;
 }
 
+static int32_t setup_render(CSOUND *csound, PARTIKKEL *p);
+
 static int32_t partikkel_init(CSOUND *csound, PARTIKKEL *p)
 {
     uint32_t size;
@@ -303,17 +305,12 @@ static int32_t partikkel_init(CSOUND *csound, PARTIKKEL *p)
     p->synced = 0;
     p->graininc = 0.0;
 
-    /* allocate memory for the grain mix buffer */
-    size = CS_KSMPS*sizeof(MYFLT);
-    if (p->aux.auxp == NULL || p->aux.size < size)
-        csound->AuxAlloc(csound, size, &p->aux);
-    else
-      memset(p->aux.auxp, 0, size);
-
     /* allocate memory for the grain pool and initialize it*/
     if (UNLIKELY(*p->max_grains < FL(1.0)))
         return INITERROR("maximum number of grains needs to be non-zero "
                          "and positive");
+    if ((ret = setup_render(csound, p)) != OK)
+        return ret;
     size = ((uint32_t)*p->max_grains)*sizeof(NODE);
     if (p->aux2.auxp == NULL || p->aux2.size < size)
         csound->AuxAlloc(csound, size, &p->aux2);
@@ -659,82 +656,118 @@ static int32_t schedule_grains(CSOUND *csound, PARTIKKEL *p)
 }
 
 /* Main synthesis loops */
-/* NOTE: the main synthesis loop is duplicated for both wavetable and
- * trainlet synthesis for speed */
-static inline void render_wave(PARTIKKEL *p, GRAIN *grain, WAVEDATA *wav,
-                               MYFLT *buf, uint32_t stop)
+/* Each grain is rendered a kperiod at a time.  The phase recurrences are
+ * run first, so the table lookups and interpolation that follow are
+ * independent per sample and can be vectorised by the compiler.  The
+ * arithmetic per sample is the same as rendering sample by sample, so the
+ * output is bit-identical to it. */
+
+/* scratch memory per rendering thread */
+typedef struct {
+    double *phase;              /* wave phase per sample */
+    MYFLT *fmenv;               /* fm envelope per sample */
+    MYFLT *buf;                 /* sum of the waves, kept zeroed */
+    MYFLT *row;                 /* grain output */
+} SCRATCH;
+
+static inline void get_scratch(PARTIKKEL *p, uint32_t k, SCRATCH *sc)
+{
+    const uint32_t ksmps = p->h.insdshead->ksmps;
+    char *mem = p->scratch + k*p->scratchsize;
+
+    sc->phase = (double *)mem;
+    sc->fmenv = (MYFLT *)(sc->phase + ksmps);
+    sc->buf = sc->fmenv + ksmps;
+    sc->row = sc->buf + ksmps;
+}
+
+/* fm envelope for this kperiod, shared by all the waves of a grain */
+static inline void grain_fmenv(GRAIN *grain, MYFLT *fmenv, uint32_t stop)
 {
     uint32_t n;
     double fmenvphase = grain->envphase;
+    const MYFLT *fmtab = grain->fmenvtab->ftable;
+    const int32_t lobits = grain->fmenvtab->lobits;
 
-    /* wavetable synthesis */
     for (n = grain->start; n < stop; ++n) {
-        double tablen = (double)wav->table->flen;
-        uint32_t x0;
-        MYFLT frac, fmenv;
+        fmenv[n] = fmtab[(size_t)(fmenvphase*FMAXLEN) >> lobits];
+        fmenvphase += grain->envinc;
+    }
+}
 
+/* run the phase accumulator of a wave, wrapping it to 0..wrap */
+static inline void wave_phases(PARTIKKEL *p, GRAIN *grain, WAVEDATA *wav,
+                               const SCRATCH *sc, uint32_t stop, double wrap)
+{
+    uint32_t n;
+    double phase = wav->phase, delta = wav->delta;
+    const double sweepdecay = wav->sweepdecay, sweepoffset = wav->sweepoffset;
+    const MYFLT fmamp = grain->fmamp;
+    const MYFLT *fm = p->fm;
+
+    for (n = grain->start; n < stop; ++n) {
         /* make sure phase accumulator stays within bounds */
-        while (UNLIKELY(wav->phase >= tablen))
-            wav->phase -= tablen;
-        while (UNLIKELY(wav->phase < 0.0))
-            wav->phase += tablen;
+        while (UNLIKELY(phase >= wrap))
+            phase -= wrap;
+        while (UNLIKELY(phase < 0.0))
+            phase += wrap;
+        sc->phase[n] = phase;
+        phase += delta + delta*fm[n]*fmamp*sc->fmenv[n];
+        /* apply sweep */
+        delta = delta*sweepdecay + sweepoffset;
+    }
+    wav->phase = phase;
+    wav->delta = delta;
+}
 
+static inline void render_wave(PARTIKKEL *p, GRAIN *grain, WAVEDATA *wav,
+                               const SCRATCH *sc, uint32_t stop)
+{
+    uint32_t n;
+    const MYFLT *ftable = wav->table->ftable;
+    const MYFLT gain = wav->gain;
+    const double *phase = sc->phase;
+    MYFLT *buf = sc->buf;
+
+    /* wavetable synthesis */
+    wave_phases(p, grain, wav, sc, stop, (double)wav->table->flen);
+    for (n = grain->start; n < stop; ++n) {
         /* sample table lookup with linear interpolation */
-        x0 = (uint32_t)wav->phase;
-        frac = (MYFLT)(wav->phase - x0);
-        buf[n] += lrp(wav->table->ftable[x0], wav->table->ftable[x0 + 1],
-                      frac)*wav->gain;
+        const uint32_t x0 = (uint32_t)phase[n];
+        const MYFLT frac = (MYFLT)(phase[n] - x0);
 
-        fmenv = grain->fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
-                                        >> grain->fmenvtab->lobits];
-        fmenvphase += grain->envinc;
-        wav->phase += wav->delta + wav->delta*p->fm[n]*grain->fmamp*fmenv;
-        /* apply sweep */
-        wav->delta = wav->delta*wav->sweepdecay + wav->sweepoffset;
-     }
+        buf[n] += lrp(ftable[x0], ftable[x0 + 1], frac)*gain;
+    }
 }
 
 static inline void render_trainlet(PARTIKKEL *p, GRAIN *grain, WAVEDATA *wav,
-                                   MYFLT *buf, uint32_t stop)
+                                   const SCRATCH *sc, uint32_t stop)
 {
     uint32_t n;
-    double fmenvphase = grain->envphase;
+    const MYFLT gain = wav->gain;
+    const double *phase = sc->phase;
+    MYFLT *buf = sc->buf;
 
     /* trainlet synthesis */
-    for (n = grain->start; n < stop; ++n) {
-        MYFLT fmenv;
-
-        while (UNLIKELY(wav->phase >= 1.0))
-            wav->phase -= 1.0;
-        while (UNLIKELY(wav->phase < 0.0))
-            wav->phase += 1.0;
-
+    wave_phases(p, grain, wav, sc, stop, 1.0);
+    for (n = grain->start; n < stop; ++n)
         /* dsf/trainlet synthesis */
-        buf[n] += wav->gain*dsf(p->costab, grain, wav->phase, p->zscale,
-                                p->cosineshift);
-
-        fmenv = grain->fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
-                                        >> grain->fmenvtab->lobits];
-        fmenvphase += grain->envinc;
-        wav->phase += wav->delta + wav->delta*p->fm[n]*grain->fmamp*fmenv;
-        wav->delta = wav->delta*wav->sweepdecay + wav->sweepoffset;
-    }
+        buf[n] += gain*dsf(p->costab, grain, phase[n], p->zscale,
+                           p->cosineshift);
 }
 
-/* do the actual waveform synthesis */
-static inline void render_grain(CSOUND *csound, PARTIKKEL *p, GRAIN *grain)
+/* render the waveforms and envelopes of a grain for this kperiod to out,
+ * from grain->start to the returned stop */
+static uint32_t render_grain(PARTIKKEL *p, GRAIN *grain, const SCRATCH *sc,
+                             MYFLT *out)
 {
-    IGN(csound);
     int32_t i;
     uint32_t n;
-    MYFLT *out1 = *(&(p->output1) + grain->chan1);
-    MYFLT *out2 = *(&(p->output1) + grain->chan2);
-    uint32_t stop = grain->stop > CS_KSMPS
-                    ? CS_KSMPS : grain->stop;
-    MYFLT *buf = (MYFLT *)p->aux.auxp;
+    const uint32_t ksmps = p->h.insdshead->ksmps;
+    uint32_t stop = grain->stop > ksmps ? ksmps : grain->stop;
+    MYFLT *buf = sc->buf;
 
-    if (grain->start >= CS_KSMPS)
-        return; /* grain starts at a later kperiod */
+    grain_fmenv(grain, sc->fmenv, stop);
     for (i = 0; i < 5; ++i) {
         WAVEDATA *curwav = &grain->wav[i];
 
@@ -743,14 +776,14 @@ static inline void render_grain(CSOUND *csound, PARTIKKEL *p, GRAIN *grain)
             continue;
 
         if (i != WAV_TRAINLET)
-            render_wave(p, grain, curwav, buf, stop);
+            render_wave(p, grain, curwav, sc, stop);
         else
-            render_trainlet(p, grain, curwav, buf, stop);
+            render_trainlet(p, grain, curwav, sc, stop);
     }
 
     /* apply envelopes */
     for (n = grain->start; n < stop; ++n) {
-        MYFLT env, env2, output;
+        MYFLT env, env2;
         double envphase;
         FUNC *envtable;
 
@@ -781,21 +814,145 @@ static inline void render_grain(CSOUND *csound, PARTIKKEL *p, GRAIN *grain)
         env2 = FL(1.0) - grain->env2amount + grain->env2amount*env2;
         grain->envphase += grain->envinc;
         /* generate grain output sample */
-        output = buf[n]*env*env2;
-        /* now distribute this grain to the output channels it's supposed to
-         * end up in, as decided by the channel mask */
-        out1[n] += output*grain->gain1;
-        out2[n] += output*grain->gain2;
+        out[n] = buf[n]*env*env2;
     }
     /* now clear the area we just worked in */
     memset(buf + grain->start, 0, (stop - grain->start)*sizeof(MYFLT));
+    return stop;
+}
+
+/* now distribute the output of a grain to the output channels it's
+ * supposed to end up in, as decided by the channel mask */
+static inline void mix_grain(PARTIKKEL *p, GRAIN *grain, const MYFLT *out,
+                             uint32_t stop)
+{
+    uint32_t n;
+    MYFLT *out1 = *(&(p->output1) + grain->chan1);
+    MYFLT *out2 = *(&(p->output1) + grain->chan2);
+    const MYFLT gain1 = grain->gain1, gain2 = grain->gain2;
+
+    for (n = grain->start; n < stop; ++n) {
+        out1[n] += out[n]*gain1;
+        out2[n] += out[n]*gain2;
+    }
+}
+
+/* render the active grains k, k + nthreads + 1, ... to their rows */
+static void render_shard(PARTIKKEL *p, uint32_t k)
+{
+    const uint32_t ksmps = p->h.insdshead->ksmps;
+    uint32_t i;
+    SCRATCH sc;
+
+    get_scratch(p, k, &sc);
+    for (i = k; i < p->nactive; i += p->nthreads + 1)
+        render_grain(p, &p->active[i]->grain, &sc, p->rows + (size_t)i*ksmps);
+}
+
+typedef struct {
+    PARTIKKEL *p;
+    uint32_t k;                 /* shard rendered, 1..nthreads */
+    void *thread;
+} WORKER;
+
+static uintptr_t partikkel_worker(void *data)
+{
+    WORKER *w = (WORKER *)data;
+    PARTIKKEL *p = w->p;
+    CSOUND *csound = p->h.insdshead->csound;
+
+    while (1) {
+        csound->WaitBarrier(p->barrier);
+        if (p->quit)
+            break;
+        render_shard(p, w->k);
+        csound->WaitBarrier(p->barrier);
+    }
+    return 0;
+}
+
+/* stop the first n worker threads */
+static void stop_workers(CSOUND *csound, PARTIKKEL *p, uint32_t n)
+{
+    WORKER *w = (WORKER *)p->workers;
+    uint32_t k;
+
+    p->quit = 1;
+    csound->WaitBarrier(p->barrier);
+    for (k = 0; k < n; ++k)
+        csound->JoinThread(w[k].thread);
+    csound->DestroyBarrier(p->barrier);
+    csound->Free(csound, p->workers);
+    p->workers = NULL;
+    p->barrier = NULL;
+    p->nthreads = 0;
+}
+
+static int32_t partikkel_deinit(CSOUND *csound, PARTIKKEL *p)
+{
+    if (p->nthreads > 0)
+        stop_workers(csound, p, p->nthreads);
+    return OK;
+}
+
+/* allocate the rendering memory and start any worker threads */
+static int32_t setup_render(CSOUND *csound, PARTIKKEL *p)
+{
+    const uint32_t ksmps = CS_KSMPS;
+    const uint32_t max_grains = (uint32_t)*p->max_grains;
+    uint32_t k, nthreads = *p->threads > FL(1.0) ? (uint32_t)*p->threads - 1
+                                                  : 0;
+    size_t size, rowsize;
+    char *mem;
+    WORKER *w;
+
+    /* threads of an earlier init of this instance are stopped first */
+    partikkel_deinit(csound, p);
+    p->scratchsize = (ksmps*(sizeof(double) + 3*sizeof(MYFLT)) + 63) & ~63;
+    rowsize = nthreads ? (size_t)max_grains*ksmps*sizeof(MYFLT) : 0;
+    size = (nthreads + 1)*p->scratchsize + rowsize
+           + (size_t)max_grains*sizeof(NODE *);
+    if (p->aux.auxp == NULL || p->aux.size < size)
+        csound->AuxAlloc(csound, size, &p->aux);
+    else
+        memset(p->aux.auxp, 0, size);
+    mem = (char *)p->aux.auxp;
+    p->scratch = mem;
+    mem += (nthreads + 1)*p->scratchsize;
+    p->rows = rowsize ? (MYFLT *)mem : NULL;
+    mem += rowsize;
+    p->active = (NODE **)mem;
+    p->nactive = 0;
+    if (nthreads == 0)
+        return OK;
+
+    w = (WORKER *)csound->Calloc(csound, nthreads*sizeof(WORKER));
+    p->workers = w;
+    p->barrier = csound->CreateBarrier(nthreads + 1);
+    p->quit = 0;
+    for (k = 0; k < nthreads; ++k) {
+        w[k].p = p;
+        w[k].k = k + 1;
+        w[k].thread = csound->CreateThread(partikkel_worker, &w[k]);
+        if (UNLIKELY(w[k].thread == NULL)) {
+            /* the memory for thread 0 is all the serial renderer needs */
+            stop_workers(csound, p, k);
+            WARNING("could not start worker threads, rendering serially");
+            return OK;
+        }
+    }
+    p->nthreads = nthreads;
+    csound->RegisterDeinitCallback(csound, p,
+                                   (int32_t (*)(CSOUND *, void *))
+                                   partikkel_deinit);
+    return OK;
 }
 
 static int32_t partikkel(CSOUND *csound, PARTIKKEL *p)
 {
     int32_t ret;
-    uint32_t n;
-    NODE **nodeptr;
+    uint32_t n, i;
+    NODE **nodeptr, *node;
     MYFLT **outputs = &p->output1;
 
     if (UNLIKELY(p->aux.auxp == NULL || p->aux2.auxp == NULL))
@@ -808,13 +965,38 @@ static int32_t partikkel(CSOUND *csound, PARTIKKEL *p)
     for (n = 0; n < p->num_outputs; ++n)
         memset(outputs[n], 0, sizeof(MYFLT)*CS_KSMPS);
 
+    /* grains starting at a later kperiod are not rendered */
+    p->nactive = 0;
+    for (node = p->grainroot; node != NULL; node = node->next)
+        if (node->grain.start < CS_KSMPS)
+            p->active[p->nactive++] = node;
+
+    if (p->nthreads > 0 && p->nactive > p->nthreads) {
+        /* render to a row per grain on all threads, then mix the rows in
+         * list order, as the serial renderer does */
+        csound->WaitBarrier(p->barrier);
+        render_shard(p, 0);
+        csound->WaitBarrier(p->barrier);
+        for (i = 0; i < p->nactive; ++i) {
+            GRAIN *grain = &p->active[i]->grain;
+            mix_grain(p, grain, p->rows + (size_t)i*CS_KSMPS,
+                      grain->stop > CS_KSMPS ? CS_KSMPS : grain->stop);
+        }
+    } else {
+        SCRATCH sc;
+
+        get_scratch(p, 0, &sc);
+        for (i = 0; i < p->nactive; ++i) {
+            GRAIN *grain = &p->active[i]->grain;
+            mix_grain(p, grain, sc.row, render_grain(p, grain, &sc, sc.row));
+        }
+    }
+
     /* prepare to traverse grain list */
     nodeptr = &p->grainroot;
     while (*nodeptr) {
         GRAIN *grain = &((*nodeptr)->grain);
 
-        /* render current grain to outputs */
-        render_grain(csound, p, grain);
         /* check if grain is finished */
         if (grain->stop <= CS_KSMPS) {
             /* grain is finished, deactivate it */
@@ -964,7 +1146,7 @@ static OENTRY partikkel_localops[] = {
     {
      "partikkel", sizeof(PARTIKKEL), TR, 3,
         "ammmmmmm",
-        "xkiakiiikkkkikkiiaikikkkikkkkkiaaaakkkkioj",
+        "xkiakiiikkkkikkiiaikikkkikkkkkiaaaakkkkiojo",
         (SUBR)partikkel_init,
         (SUBR)partikkel
     },
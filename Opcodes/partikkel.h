@@ -117,6 +117,7 @@ typedef struct PARTIKKEL {
     MYFLT *max_grains;
     MYFLT *opcodeid;
     MYFLT *pantable;
+    MYFLT *threads;
 
     /* internal variables */
     PARTIKKEL_GLOBALS *globals;
@@ -150,6 +151,18 @@ typedef struct PARTIKKEL {
     uint32_t wavgainindex;
     double grainphase, graininc;
     FUNC *pantab;
+    /* block rendering, all in aux: scratch per thread, with worker threads
+     * one row of output per active grain, and the grains active this
+     * kperiod */
+    NODE **active;
+    uint32_t nactive;
+    MYFLT *rows;
+    char *scratch;
+    size_t scratchsize;
+    uint32_t nthreads;          /* worker threads besides the perf thread */
+    void *workers;
+    void *barrier;
+    volatile int32_t quit;
 } PARTIKKEL;
 
 typedef struct {
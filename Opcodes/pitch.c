@@ -31,6 +31,7 @@
 #include "spectra.h"
 #include "pitch.h"
 #include "uggab.h"
+#include "tabosc_simd.h"
 #include <inttypes.h>
 
 #define STARTING  1
@@ -683,11 +684,12 @@ int32_t adsynt(CSOUND *csound, ADSYNT *p)
     FUNC    *ftp, *freqtp, *amptp;
     MYFLT   *ar, *ftbl, *freqtbl, *amptbl;
     MYFLT    amp0, amp, cps0, cps;
-    int32    phs, inc, lobits;
+    int32    inc, lobits;
     int32   *lphs;
+    TABOSC   tab;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
     int32_t      c, count;
 
     if (UNLIKELY(p->inerr)) {
@@ -702,6 +704,9 @@ int32_t adsynt(CSOUND *csound, ADSYNT *p)
     amptp = p->amptp;
     amptbl = amptp->ftable;
     lphs = (int32*)p->lphs.auxp;
+    tab.ft = ftbl; tab.lobits = lobits;
+    tab.mask = 0; tab.pfrac = FL(0.0);          /* not interpolated */
+    tab.phsmsk = PHMASK;
 
     cps0 = *p->kcps;
     amp0 = *p->kamp;
@@ -710,18 +715,15 @@ int32_t adsynt(CSOUND *csound, ADSYNT *p)
     ar = p->sr;
     memset(ar, 0, nsmps*sizeof(MYFLT));
     if (UNLIKELY(early)) nsmps -= early;
+    if (UNLIKELY(offset >= nsmps)) return OK;
 
     for (c=0; c<count; c++) {
       amp = amptbl[c] * amp0;
       cps = freqtbl[c] * cps0;
       inc = (int32) (cps * csound->sicvt);
-      phs = lphs[c];
-      for (n=offset; n<nsmps; n++) {
-        ar[n] += *(ftbl + (phs >> lobits)) * amp;
-        phs += inc;
-        phs &= PHMASK;
-      }
-      lphs[c] = phs;
+      lphs[c] = (int32) tabosc_kernels->trunc(ar + offset, amp, &tab,
+                                              (uint32) lphs[c], (uint32) inc,
+                                              nsmps - offset);
     }
     return OK;
 }
@@ -125,6 +125,8 @@ struct _SFBANK {
         instrType *instr;
         SHORT *sampleData;
         CHUNKS chunk;
+        size_t mapped;  /* size of the file mapping main_chunk is in, or
+                           0 if it was read into memory */
 } PACKED;
 typedef struct _SFBANK SFBANK;
 
@@ -39,12 +39,25 @@
 #include <errno.h>
 #include "sfenum.h"
 #include "sfont.h"
+/* On little-endian POSIX systems a SoundFont is mapped rather than read,
+   as nothing in it needs converting: only the pages of the preset data
+   and of the samples actually played are read from the file, and they
+   are shared with any other process using the same file. */
+#if !defined(WIN32) && !defined(WORDS_BIGENDIAN)
+#define SFONT_MMAP
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #define s2d(x)  *((DWORD *) (x))
 
 
 
 static int32_t chunk_read(CSOUND *, FILE *f, CHUNK *chunk);
+#ifdef SFONT_MMAP
+static size_t chunk_map(FILE *f, CHUNK *chunk);
+#endif
 static void fill_SfPointers(CSOUND *);
 static int32_t  fill_SfStruct(CSOUND *);
 static void layerDefaults(layerType *layer);
@@ -88,6 +101,11 @@ int32_t sfont_ModuleDestroy(CSOUND *csound)
         csound->Free(csound, sfArray[j].instr[l].split);
       }
       csound->Free(csound, sfArray[j].instr);
+#ifdef SFONT_MMAP
+      if (sfArray[j].mapped)
+        munmap(sfArray[j].chunk.main_chunk.ckDATA - 8, sfArray[j].mapped);
+      else
+#endif
       csound->Free(csound, sfArray[j].chunk.main_chunk.ckDATA);
     }
     csound->Free(csound, sfArray);
@@ -122,6 +140,11 @@ static void SoundFontLoad(CSOUND *csound, char *fname)
     /* } */
     strNcpy(soundFont->name, csound->GetFileName(fd), 256);
     //soundFont->name[255]='\0';
+    soundFont->mapped = 0;
+#ifdef SFONT_MMAP
+    soundFont->mapped = chunk_map(fil, &soundFont->chunk.main_chunk);
+    if (!soundFont->mapped)
+#endif
     if (UNLIKELY(chunk_read(csound, fil, &soundFont->chunk.main_chunk)<0))
       csound->Message(csound, Str("sfont: failed to read file\n"));
     csound->FileClose(csound, fd);
@@ -2048,6 +2071,36 @@ static int32_t chunk_read(CSOUND *csound, FILE *fil, CHUNK *chunk)
     return fread(chunk->ckDATA,1,chunk->ckSize,fil);
 }
 
+#ifdef SFONT_MMAP
+/* Map the whole file copy-on-write and point the chunk into it, so the
+   offsets fill_SfPointers() finds are as if it had been read.  Returns
+   the size mapped, or 0 to have the file read instead. */
+static size_t chunk_map(FILE *fil, CHUNK *chunk)
+{
+    struct stat st;
+    size_t  size;
+    BYTE    *base;
+    DWORD   ckSize;
+
+    if (fstat(fileno(fil), &st) != 0 || st.st_size < 8 ||
+        (uint64_t) st.st_size > (uint64_t) ((size_t) -1))
+      return 0;
+    size = (size_t) st.st_size;
+    base = (BYTE *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fileno(fil), 0);
+    if (base == (BYTE *) MAP_FAILED)
+      return 0;
+    memcpy(chunk->ckID, base, 4);
+    memcpy(&ckSize, base + 4, 4);
+    /* a short file would otherwise be walked off the end of the map */
+    if (ckSize > size - 8)
+      ckSize = (DWORD) (size - 8);
+    chunk->ckSize = ckSize;
+    chunk->ckDATA = base + 8;
+    return size;
+}
+#endif
+
 static DWORD dword(char *p)
 {
     union cheat {
@@ -126,6 +126,7 @@ static const char *shortUsageList[] = {
   Str_noop("-U unam     run utility program unam"),
   Str_noop("-C          use Cscore processing of scorefile"),
   Str_noop("-j N        use N threads in performance"),
+  Str_noop("--dispatcher=ws  use work-stealing thread dispatcher with -j"),
   Str_noop("-I          I-time only orch run"),
   Str_noop("-n          no sound onto disk"),
   Str_noop("-i fnam     sound input filename"),
@@ -204,6 +205,9 @@ static const char *longUsageList[] = {
   " ",
   Str_noop("--defer-gen1            defer GEN01 soundfile loads until "
                                    "performance time"),
+  Str_noop("--gen01-cache=DIR       keep GEN01 tables in DIR and map them "
+           "from there"),
+  Str_noop("                          on later runs"),
   Str_noop("--iobufsamps=N          sample frames (or -kprds) per software "
                                     "sound I/O buffer"),
   Str_noop("--hardwarebufsamps=N    samples per hardware sound I/O buffer"),
@@ -255,6 +259,23 @@ static const char *longUsageList[] = {
                                    "ORC/SCO-relative line #s"),
   Str_noop("--extract-score=FNAME   extract from score.srt using extract file"),
   Str_noop("--keep-sorted-score"),
+  Str_noop("--no-binary-score       sort the score to text, not binary events"),
+  Str_noop("--save-sorted-score=FNAME"),
+  Str_noop("                          save the binary sorted score to FNAME"),
+  Str_noop("--sorted-score=FNAME    play a score saved by --save-sorted-score,"),
+  Str_noop("                          skipping the score sort"),
+  Str_noop("--score-sort-memory=N   sort score sections larger than N MB "
+           "through"),
+  Str_noop("                          a temporary file (default 64, 0=never)"),
+  Str_noop("--score-sort-threads=N  sort score sections on N threads while "
+           "reading"),
+  Str_noop("                          the next ones (default 0=none)"),
+  Str_noop("--async-write[=N]       write the output file from a thread "
+           "through an"),
+  Str_noop("                          N MB buffer (default 16)"),
+  Str_noop("--io-threads=N          threads reading and writing files for "
+           "realtime"),
+  Str_noop("                          opcodes (default 2)"),
   Str_noop("--env:NAME=VALUE        set environment variable NAME to VALUE"),
   Str_noop("--env:NAME+=VALUE       append VALUE to environment variable NAME"),
   Str_noop("--strsetN=VALUE         set strset table at index N to VALUE"),
@@ -287,7 +308,13 @@ static const char *longUsageList[] = {
   Str_noop("--midi-velocity-amp=N   route MIDI note on message"),
   Str_noop("                          velocity number to pfield N as amplitude"),
   Str_noop("--no-default-paths      turn off relative paths from CSD/ORC/SCO"),
+  Str_noop("--no-fuse               compile a-rate expressions one opcode per "
+                                   "operator"),
   Str_noop("--sample-accurate       use sample-accurate timing of score events"),
+  Str_noop("--num-threads=N         use N threads in performance (same as -j)"),
+  Str_noop("--dispatcher=dag|ws     how -j threads share instruments: scan the "
+                                   "task DAG (default)\n"
+           "                        or work-stealing queues that sleep when idle"),
   Str_noop("--realtime              realtime priority mode"),
   Str_noop("--nchnls=N              override number of audio channels"),
   Str_noop("--nchnls_i=N            override number of input audio channels"),
@@ -590,6 +617,17 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->gen01defer = 1;                /* defer GEN01 sample loads */
       return 1;                         /*   until performance time */
     }
+    else if (!(strncmp (s, "gen01-cache=", 12))) {
+      s += 12;
+      if (UNLIKELY(*s=='\0')) dieu(csound, Str("no GEN01 cache directory"));
+#if defined(WIN32)
+      csound->Warning(csound, Str("--gen01-cache is not supported on this "
+                                  "platform"));
+#else
+      csound->gen01_cache = cs_strdup(csound, s);
+#endif
+      return 1;
+    }
     else if (!(strncmp (s, "midifile=", 9))) {
       s += 9;
       if (*s==3) s++;           /* skip ETX */
@@ -884,6 +922,46 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       csound->keep_tmp = 2;
       return 1;
     }
+    else if (!(strcmp (s, "no-binary-score"))) {
+      O->noBinaryScore = 1;
+      return 1;
+    }
+    else if (!(strncmp (s, "save-sorted-score=", 18))) {
+      s += 18;
+      if (UNLIKELY(*s=='\0')) dieu(csound, Str("no sorted score name"));
+      csound->scobin_out = cs_strdup(csound, s);
+      return 1;
+    }
+    else if (!(strncmp (s, "sorted-score=", 13))) {
+      s += 13;
+      if (UNLIKELY(*s=='\0')) dieu(csound, Str("no sorted score name"));
+      csound->scobin_in = cs_strdup(csound, s);
+      return 1;
+    }
+    else if (!(strncmp (s, "score-sort-memory=", 18))) {
+      s += 18;
+      O->scoreSortMem = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp (s, "score-sort-threads=", 19))) {
+      s += 19;
+      O->scoreSortThreads = atoi(s);
+      return 1;
+    }
+    else if (!(strcmp (s, "async-write"))) {
+      O->asyncWrite = 16;
+      return 1;
+    }
+    else if (!(strncmp (s, "async-write=", 12))) {
+      s += 12;
+      O->asyncWrite = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp (s, "io-threads=", 11))) {
+      s += 11;
+      O->ioThreads = atoi(s);
+      return 1;
+    }
     /* IV - Jan 27 2005: --expression-opt */
     /* NOTE these do nothing */
     else if (!(strcmp (s, "expression-opt"))) {
@@ -1025,11 +1103,25 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->noDefaultPaths = 1;
       return 1;
     }
+    else if (!(strcmp(s, "no-fuse"))) {
+      O->noFuse = 1;
+      return 1;
+    }
     else if (!(strncmp (s, "num-threads=", 12))) {
       s += 12 ;
       O->numThreads = atoi(s);
       return 1;
     }
+    else if (!(strncmp (s, "dispatcher=", 11))) {
+      s += 11;
+      if (!strcmp(s, "ws")) O->dispatcher = DISPATCH_WS;
+      else if (!strcmp(s, "dag")) O->dispatcher = DISPATCH_DAG;
+      else {
+        csound->Warning(csound, Str("unknown dispatcher %s, using dag\n"), s);
+        O->dispatcher = DISPATCH_DAG;
+      }
+      return 1;
+    }
     else if (!(strcmp (s, "syntax-check-only"))) {
       O->syntaxCheckOnly = 1;
       return 1;
@@ -67,6 +67,9 @@
 #include "csound_standard_types.h"
 
 #include "csdebug.h"
+#include "aops_simd.h"
+#include "pvs_simd.h"
+#include "tabosc_simd.h"
 #include <time.h>
 
 extern void allocate_message_queue(CSOUND *csound);
@@ -502,11 +505,21 @@ static const CSOUND cenviron_ = {
     csoundGetZaBounds,
     find_opcode_new,
     find_opcode_exact,
+    csoundCreateRingBuffer,
+    csoundReadRingBuffer,
+    csoundWriteRingBuffer,
+    csoundReserveRingBuffer,
+    csoundCommitRingBuffer,
+    csoundAcquireRingBuffer,
+    csoundReleaseRingBuffer,
+    csoundWaitRingBuffer,
+    csoundWakeRingBuffer,
+    csoundDestroyRingBuffer,
+    gen01_cache_unmap,
     {
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-      NULL, NULL
+      NULL, NULL, NULL
     },
     /* ------- private data (not to be used by hosts or externals) ------- */
     /* callback function pointers */
@@ -742,9 +755,7 @@ static const CSOUND cenviron_ = {
     NULL,           /*  FFT_table_2         */
     NULL, NULL, NULL, /* tseg, tpsave, unused */
     (MYFLT*) NULL,  /*  gbloffbas           */
-    NULL,           /* file_io_thread    */
-    0,              /* file_io_start   */
-    NULL,           /* file_io_threadlock */
+    NULL,           /* asyncio */
     0,              /* realtime_audio_flag */
     NULL,           /* init pass thread */
     0,              /* init pass loop  */
@@ -815,6 +826,7 @@ static const CSOUND cenviron_ = {
       1U,           /*  nframes             */
       NULL, NULL,   /*  pin, pout           */
       0,            /*dither                */
+      NULL          /*  writer              */
     },
     0,              /*  warped              */
     0,              /*  sstrlen             */
@@ -909,7 +921,14 @@ static const CSOUND cenviron_ = {
       0.4,          /*    vbr quality  */
       0,            /*    ksmps_override */
       0,             /*    fft_lib */
-      0
+      0,             /*    echo */
+      DISPATCH_DAG,  /*    dispatcher */
+      0,             /*    noFuse */
+      0,             /*    noBinaryScore */
+      64,            /*    scoreSortMem */
+      0,             /*    scoreSortThreads */
+      0,             /*    asyncWrite */
+      0              /*    ioThreads */
     },
 
     {0, 0, {0}}, /* REMOT_BUF */
@@ -935,8 +954,10 @@ static const CSOUND cenviron_ = {
     NULL,           /* dag_task_status */
     NULL,           /* dag_task_watch */
     NULL,           /* dag_wlmm */
-    NULL,           /* dag_task_dep */
+    NULL,           /* dag_task_group */
     100,            /* dag_task_max_size */
+    NULL,           /* dag_groups */
+    0,              /* dag_num_groups */
     0,              /* tempStatus */
     1,              /* orcLineOffset */
     0,              /* scoLineOffset */
@@ -965,10 +986,10 @@ static const CSOUND cenviron_ = {
     0,              /* unusedint */
     1,              /* inZero */
     NULL,           /* msg_queue */
-    0,              /* msg_queue_wget */
+    0,              /* msg_queue_wget (unused) */
     0,              /* msg_queue_wput */
     0,              /* msg_queue_rstart */
-    0,              /* msg_queue_items */
+    0,              /* msg_queue_items (unused) */
     127,            /* aftouch */
     NULL,           /* directory for corfiles */
     NULL,           /* alloc_queue */
@@ -981,7 +1002,22 @@ static const CSOUND cenviron_ = {
     0,              /* message_string_queue_items */
     0,              /* message_string_queue_wp */
     NULL,            /* message_string_queue */
-    0                /* io_initialised */
+    0,               /* io_initialised */
+    NULL,            /* dag_ws */
+    NULL,            /* dag_conflicts */
+    0,               /* dag_conflicts_size */
+    NULL,            /* msg_arena */
+    NULL,            /* mem_pool */
+    NULL,            /* p1_index */
+    0, 0,            /* p1_index_size, p1_index_count */
+    NULL,            /* p1_links */
+    NULL,            /* act_first */
+    0,               /* act_first_size */
+    NULL,            /* scobin */
+    NULL, NULL,      /* scobin_out, scobin_in */
+    NULL,            /* sortrun */
+    NULL,            /* gen01_cache */
+    NULL             /* gen01maps */
     /*, NULL */      /* self-reference */
 };
 
@@ -1274,6 +1310,9 @@ PUBLIC int csoundInitialize(int flags)
       csoundUnLock();
       return -1;
     }
+    aops_simd_init();
+    pvs_simd_init();
+    tabosc_simd_init();
     if (!(flags & CSOUNDINIT_NO_SIGNAL_HANDLER)) {
       install_signal_handler();
     }
@@ -1488,6 +1527,9 @@ int dag_get_task(CSOUND *csound, int index, int numThreads, int next_task);
 int dag_end_task(CSOUND *csound, int task);
 void dag_build(CSOUND *csound, INSDS *chain);
 void dag_reinit(CSOUND *csound);
+void dag_ws_prepare(CSOUND *csound, INSDS *chain);
+int dag_ws_get_task(CSOUND *csound, int index, int next_task);
+int dag_ws_end_task(CSOUND *csound, int index, int task);
 
 inline static int nodePerf(CSOUND *csound, int index, int numThreads)
 {
@@ -1500,11 +1542,13 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
 #define INVALID (-1)
 #define WAIT    (-2)
     int next_task = INVALID;
+    int steal = (csound->oparms->dispatcher == DISPATCH_WS);
     IGN(index);
 
     while (1) {
       int done;
-      which_task = dag_get_task(csound, index, numThreads, next_task);
+      which_task = steal ? dag_ws_get_task(csound, index, next_task) :
+        dag_get_task(csound, index, numThreads, next_task);
       //printf("******** Select task %d\n", which_task);
       if (which_task==WAIT) continue;
       if (which_task==INVALID) return played_count;
@@ -1574,7 +1618,8 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
           played_count++;
         }
         //printf("******** finished task %d\n", which_task);
-        next_task = dag_end_task(csound, which_task);
+        next_task = steal ? dag_ws_end_task(csound, index, which_task) :
+          dag_end_task(csound, which_task);
     }
     return played_count;
 }
@@ -1687,7 +1732,9 @@ int kperf_nodebug(CSOUND *csound)
       /* There are 2 partitions of work: 1st by inso,
          2nd by inso count / thread count. */
       if (csound->multiThreadedThreadInfo != NULL) {
-        if (csound->dag_changed) dag_build(csound, ip);
+        if (csound->oparms->dispatcher == DISPATCH_WS)
+          dag_ws_prepare(csound, ip);
+        else if (csound->dag_changed) dag_build(csound, ip);
         else dag_reinit(csound);     /* set to initial state */
 
         /* process this partition */
@@ -1942,7 +1989,9 @@ int kperf_debug(CSOUND *csound)
       /* There are 2 partitions of work: 1st by inso,
          2nd by inso count / thread count. */
       if (csound->multiThreadedThreadInfo != NULL) {
-        if (csound->dag_changed) dag_build(csound, ip);
+        if (csound->oparms->dispatcher == DISPATCH_WS)
+          dag_ws_prepare(csound, ip);
+        else if (csound->dag_changed) dag_build(csound, ip);
         else dag_reinit(csound);     /* set to initial state */
 
         /* process this partition */
@@ -2088,7 +2137,7 @@ int csoundReadScoreInternal(CSOUND *csound, const char *str)
     corfile_flush(csound, csound->scorestr);
     /* copy sorted score name */
     if (csound->scstr == NULL && (csound->engineStatus & CS_STATE_COMP) == 0) {
-      scsortstr(csound, csound->scorestr);
+      scsortbin(csound, csound->scorestr);
       O->playscore = csound->scstr;
       //corfile_rm(csound, &(csound->scorestr));
       //printf("%s\n", O->playscore->body);
@@ -3243,6 +3292,7 @@ static void reset(CSOUND *csound)
     /* delete temporary files created by this Csound instance */
     remove_tmpfiles(csound);
     rlsmemfiles(csound);
+    gen01_cache_release(csound);
 
      while (csound->filedir[n])        /* Clear source directory */
        csound->Free(csound,csound->filedir[n++]);
@@ -26,6 +26,7 @@
 #include "soundio.h"
 #include "csmodule.h"
 #include "corfile.h"
+#include "scobin.h"
 
 #include "csound_orc.h"
 
@@ -330,7 +331,22 @@ PUBLIC int csoundCompileArgs(CSOUND *csound, int argc, const char **argv)
       return -1;
     /* IV - Oct 31 2002: now we can read and sort the score */
 
-    if (csound->scorename != NULL &&
+    if (csound->scobin_in != NULL) {            /* binary sorted score */
+      csound->Message(csound, Str("using sorted score %s\n"),
+                      csound->scobin_in);
+      if (UNLIKELY((csound->scobin =
+                    scobin_load(csound, csound->scobin_in)) == NULL))
+        csoundDie(csound, Str("cannot load sorted score %s"),
+                  csound->scobin_in);
+      csound->scstr = corfile_create_w(csound);
+      corfile_flush(csound, csound->scstr);
+      if (csound->xfilename != NULL) {
+        csound->Warning(csound, Str("cannot extract from a binary sorted "
+                                    "score, ignoring %s"), csound->xfilename);
+        csound->xfilename = NULL;
+      }
+    }
+    else if (csound->scorename != NULL &&
         (n = strlen(csound->scorename)) > 4 &&  /* if score ?.srt or ?.xtr */
         (!strcmp(csound->scorename + (n - 4), ".srt") ||
          !strcmp(csound->scorename + (n - 4), ".xtr"))) {
@@ -348,7 +364,7 @@ PUBLIC int csoundCompileArgs(CSOUND *csound, int argc, const char **argv)
       }
       csound->Message(csound, Str("sorting score ...\n"));
       //printf("score:\n%s", corfile_current(csound->scorestr));
-      scsortstr(csound, csound->scorestr);
+      scsortbin(csound, csound->scorestr);
       if (csound->keep_tmp) {
         FILE *ff = fopen("score.srt", "w");
         if (csound->keep_tmp==1)
@@ -585,7 +601,7 @@ PUBLIC int csoundCompileCsdText(CSOUND *csound, const char *csd_text)
             csoundInputMessage(csound, (const char *) sc);
           }
         } else {
-            scsortstr(csound, csound->scorestr);
+            scsortbin(csound, csound->scorestr);
             if(csound->oparms->odebug)
               csound->Message(csound,
                               Str("Compiled score "
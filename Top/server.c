@@ -23,8 +23,12 @@
 #ifdef NACL
 typedef unsigned int u_int32_t;
 #endif
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* for recvmmsg() */
+#endif
 
 #include "csoundCore.h"
+#include <ctype.h>
 #if defined(WIN32) && !defined(__CYGWIN__)
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -32,8 +36,28 @@ typedef unsigned int u_int32_t;
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <sys/select.h>
+#endif
 #endif
 
+#ifdef USE_DOUBLE
+#  define MYFLT_INT_TYPE int64_t
+#else
+#  define MYFLT_INT_TYPE int32_t
+#endif
+
+/* a control channel set by '@' messages, looked up once by name */
+typedef struct {
+  char    *name;
+  uint32_t hash;
+  MYFLT   *data;
+  spin_lock_t *lock;
+} UDPCHN;
+
 typedef struct {
   int port;
   int     sock;
@@ -42,9 +66,18 @@ typedef struct {
   void  *cb;
   struct sockaddr_in server_addr;
   unsigned char status;
+#ifdef __linux__
+  int     epfd;           /* epoll set of sock and wakefd */
+  int     wakefd;         /* eventfd written to stop the server thread */
+#endif
+  UDPCHN  *chn;           /* hash table of channels, used by the server
+                             thread only */
+  int     chnsize, chncount;
 } UDPCOM;
 
 #define MAXSTR 1048576 /* 1MB */
+#define UDP_BATCH 16   /* datagrams received per wakeup */
+#define UDP_DGRAM 65536 /* room for any datagram */
 
 static void udp_socksend(CSOUND *csound, int *sock, const char *addr,
                          int port, const char *msg) {
@@ -97,69 +130,203 @@ static void udp_socksend(CSOUND *csound, int *sock, const char *addr,
 }
 
 
+/* copy the next word of s to tok, of size bytes, and return the rest */
+static char *udp_word(char *s, char *tok, size_t size)
+{
+  size_t n = 0;
+  while (isspace((unsigned char) *s)) s++;
+  while (*s != '\0' && !isspace((unsigned char) *s)) {
+    if (n < size - 1) tok[n++] = *s;
+    s++;
+  }
+  tok[n] = '\0';
+  return s;
+}
+
+static uint32_t udp_hash(const char *s)
+{
+  uint32_t h = 2166136261u;
+  while (*s != '\0')
+    h = (h ^ (unsigned char) *s++) * 16777619u;
+  return h;
+}
+
+/* the control channel of this name, resolved on first use */
+static UDPCHN *udp_channel(CSOUND *csound, UDPCOM *p, const char *name)
+{
+  uint32_t h = udp_hash(name), i, mask;
+  MYFLT   *data;
+
+  if (p->chncount * 2 >= p->chnsize) {
+    UDPCHN *old = p->chn;
+    int oldsize = p->chnsize, j;
+    p->chnsize = oldsize ? oldsize << 1 : 64;
+    p->chn = (UDPCHN *) csound->Calloc(csound, p->chnsize * sizeof(UDPCHN));
+    mask = p->chnsize - 1;
+    for (j = 0; j < oldsize; j++)
+      if (old[j].name != NULL) {
+        for (i = old[j].hash & mask; p->chn[i].name != NULL; i = (i+1) & mask)
+          ;
+        p->chn[i] = old[j];
+      }
+    csound->Free(csound, old);
+  }
+  mask = p->chnsize - 1;
+  for (i = h & mask; p->chn[i].name != NULL; i = (i + 1) & mask)
+    if (p->chn[i].hash == h && strcmp(p->chn[i].name, name) == 0)
+      return &p->chn[i];
+  if (csoundGetChannelPtr(csound, &data, name,
+                          CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL)
+      != CSOUND_SUCCESS)
+    return NULL;
+  p->chn[i].name = cs_strdup(csound, (char *) name);
+  p->chn[i].hash = h;
+  p->chn[i].data = data;
+  p->chn[i].lock = (spin_lock_t *) csoundGetChannelLock(csound, name);
+  p->chncount++;
+  return &p->chn[i];
+}
+
+/* forget the channels: new orchestra code may chnexport one of them */
+static void udp_channels_clear(CSOUND *csound, UDPCOM *p)
+{
+  int i;
+  for (i = 0; i < p->chnsize; i++)
+    if (p->chn[i].name != NULL)
+      csound->Free(csound, p->chn[i].name);
+  csound->Free(csound, p->chn);
+  p->chn = NULL;
+  p->chnsize = p->chncount = 0;
+}
+
+/* as csoundSetControlChannel() */
+static void udp_set_control(UDPCHN *chn, MYFLT val)
+{
+#if defined(MSVC) || defined(HAVE_ATOMIC_BUILTIN)
+  union {
+    MYFLT d;
+    MYFLT_INT_TYPE i;
+  } x;
+  x.d = val;
+#endif
+#if defined(MSVC)
+  InterlockedExchange64((MYFLT_INT_TYPE *) chn->data, x.i);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+  __atomic_store_n((MYFLT_INT_TYPE *) chn->data, x.i, __ATOMIC_SEQ_CST);
+#else
+  csoundSpinLock(chn->lock);
+  *chn->data = val;
+  csoundSpinUnLock(chn->lock);
+#endif
+}
+
+/* wait for datagrams and receive up to UDP_BATCH of them, the i-th at
+   buf + i * UDP_DGRAM with its length in len[i]; returns how many were
+   received, or -1 when the server is stopped */
+static int udp_wait(UDPCOM *p, char *buf, int *len)
+{
+#ifdef __linux__
+  struct mmsghdr msgs[UDP_BATCH];
+  struct iovec iov[UDP_BATCH];
+  struct epoll_event ev[2];
+  int i, n;
+
+  n = epoll_wait(p->epfd, ev, 2, -1);
+  if (n < 0)
+    return (errno == EINTR ? 0 : -1);
+  for (i = 0; i < n; i++)
+    if (ev[i].data.fd == p->wakefd)
+      return -1;
+  memset(msgs, 0, sizeof(msgs));
+  for (i = 0; i < UDP_BATCH; i++) {
+    iov[i].iov_base = buf + i * UDP_DGRAM;
+    iov[i].iov_len = UDP_DGRAM - 1;
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  if ((n = recvmmsg(p->sock, msgs, UDP_BATCH, MSG_DONTWAIT, NULL)) <= 0)
+    return 0;
+  for (i = 0; i < n; i++)
+    len[i] = (int) msgs[i].msg_len;
+  return n;
+#else
+  fd_set  rd;
+  struct timeval tv;
+  int     received;
+
+  FD_ZERO(&rd);
+  FD_SET(p->sock, &rd);
+  tv.tv_sec = 0;
+  tv.tv_usec = 100000;            /* to see the status change */
+  if (select(p->sock + 1, &rd, NULL, NULL, &tv) <= 0)
+    return p->status ? 0 : -1;
+  if ((received = recvfrom(p->sock, buf, UDP_DGRAM - 1, 0, NULL, NULL)) <= 0)
+    return 0;
+  len[0] = received;
+  return 1;
+#endif
+}
+
 static uintptr_t udp_recv(void *pdata){
-  struct sockaddr from;
-  socklen_t clilen = sizeof(from);
   UDPCOM *p = (UDPCOM *) pdata;
   CSOUND *csound = p->cs;
   int port = p->port;
   char *orchestra = csound->Calloc(csound, MAXSTR);
+  char *buf = csound->Malloc(csound, UDP_BATCH * UDP_DGRAM);
+  int len[UDP_BATCH];
   int sock = 0;
-  int received, cont = 0;
-  char *start = orchestra;
-  size_t timout = (size_t) lround(1000/csound->GetKr(csound));
+  int received, cont = 0, i, n;
+  size_t orclen = 0;
+  char *msg;
 
   csound->Message(csound, Str("UDP server started on port %d\n"),port);
-  while (p->status) {
-    if ((received =
-         recvfrom(p->sock, (void *)orchestra, MAXSTR, 0, &from, &clilen)) <= 0) {
-      csoundSleep(timout ? timout : 1);
-      continue;
-    }
-    else {
-      orchestra[received] = '\0'; // terminate string
-      if(strlen(orchestra) < 2) continue;
+  while (p->status && (n = udp_wait(p, buf, len)) >= 0) {
+    for (i = 0; i < n; i++) {
+      msg = buf + i * UDP_DGRAM;
+      received = len[i];
+      msg[received] = '\0'; // terminate string
+      if(strlen(msg) < 2) continue;
       if (csound->oparms->echo)
-        csound->Message(csound, "%s", orchestra);
-      if (strncmp("!!close!!",orchestra,9)==0 ||
-          strncmp("##close##",orchestra,9)==0) {
+        csound->Message(csound, "%s", msg);
+      if (strncmp("!!close!!",msg,9)==0 ||
+          strncmp("##close##",msg,9)==0) {
         csoundInputMessageAsync(csound, "e 0 0");
-        break;
+        goto stop;
       }
-      if(*orchestra == '&') {
-        csoundInputMessageAsync(csound, orchestra+1);
+      if(*msg == '&') {
+        csoundInputMessageAsync(csound, msg+1);
       }
-      else if(*orchestra == '$') {
-        csoundReadScoreAsync(csound, orchestra+1);
+      else if(*msg == '$') {
+        csoundReadScoreAsync(csound, msg+1);
       }
-      else if(*orchestra == '@') {
+      else if(*msg == '@') {
         char chn[128];
-        MYFLT val;
-        sscanf(orchestra+1, "%s", chn);
-        val = atof(orchestra+1+strlen(chn));
-        csoundSetControlChannel(csound, chn, val);
+        UDPCHN *c;
+        char *val = udp_word(msg+1, chn, sizeof(chn));
+        if ((c = udp_channel(csound, p, chn)) != NULL)
+          udp_set_control(c, (MYFLT) cs_strtod(val, NULL));
       }
-      else if(*orchestra == '%') {
+      else if(*msg == '%') {
         char chn[128];
         char *str;
-        sscanf(orchestra+1, "%s", chn);
-        str = cs_strdup(csound, orchestra+1+strlen(chn));
+        str = cs_strdup(csound, udp_word(msg+1, chn, sizeof(chn)));
         csoundSetStringChannel(csound, chn, str);
         csound->Free(csound, str);
       }
-      else if(*orchestra == ':') {
-        char addr[128], chn[128], *msg;
+      else if(*msg == ':') {
+        char addr[128], chn[128], port_s[32], *rep, *rest;
         int sport, err = 0;
         MYFLT val;
-        sscanf(orchestra+2, "%s", chn);
-        sscanf(orchestra+2+strlen(chn), "%s", addr);
-        sport = atoi(orchestra+3+strlen(addr)+strlen(chn));
-        if(*(orchestra+1) == '@') {
+        rest = udp_word(msg+2, chn, sizeof(chn));
+        rest = udp_word(rest, addr, sizeof(addr));
+        udp_word(rest, port_s, sizeof(port_s));
+        sport = atoi(port_s);
+        if(*(msg+1) == '@') {
           val = csoundGetControlChannel(csound, chn, &err);
-          msg = (char *) csound->Calloc(csound, strlen(chn) + 32);
-          sprintf(msg, "%s::%f", chn, val);
+          rep = (char *) csound->Calloc(csound, strlen(chn) + 32);
+          sprintf(rep, "%s::%f", chn, val);
         }
-        else if (*(orchestra+1) == '%') {
+        else if (*(msg+1) == '%') {
           MYFLT  *pstring;
           if (csoundGetChannelPtr(csound, &pstring, chn,
                                   CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL)
@@ -168,51 +335,62 @@ static uintptr_t udp_recv(void *pdata){
             int size = stringdat->size;
             spin_lock_t *lock =
               (spin_lock_t *) csoundGetChannelLock(csound, (char*) chn);
-            msg = (char *) csound->Calloc(csound, strlen(chn) + size);
+            rep = (char *) csound->Calloc(csound, strlen(chn) + size);
             if (lock != NULL)
               csoundSpinLock(lock);
-            sprintf(msg, "%s::%s", chn, stringdat->data);
+            sprintf(rep, "%s::%s", chn, stringdat->data);
             if (lock != NULL)
               csoundSpinUnLock(lock);
           } else err = -1;
         }
         else err = -1;
         if(!err) {
-          udp_socksend(csound, &sock, addr, sport,msg);
-          csound->Free(csound, msg);
+          udp_socksend(csound, &sock, addr, sport,rep);
+          csound->Free(csound, rep);
         }
         else
           csound->Warning(csound, Str("could not retrieve channel %s"), chn);
       }
-      else if(*orchestra == '{' || cont) {
-        char *cp;
-        if((cp = strrchr(orchestra, '}')) != NULL) {
-          if(*(cp-1) != '}') {
-            *cp = '\0';
-            cont = 0;
-          }  else {
-            orchestra += received;
-            cont = 1;
-          }
+      else if(*msg == '{' || cont) {
+        /* orchestra code up to a single '}', possibly over several
+           datagrams */
+        char *cp, *part = orchestra + orclen;
+        size_t size = strlen(msg);
+        if (UNLIKELY(orclen + size >= MAXSTR)) {
+          csound->Warning(csound, Str("UDP: orchestra code too long, "
+                                      "discarded"));
+          orclen = 0;
+          cont = 0;
+          continue;
+        }
+        memcpy(part, msg, size + 1);
+        if((cp = strrchr(part, '}')) != NULL && *(cp-1) != '}') {
+          *cp = '\0';
+          cont = 0;
         }
         else {
-          orchestra += received;
+          orclen += size;
           cont = 1;
         }
         if(!cont) {
-          orchestra = start;
+          orclen = 0;
           //csound->Message(csound, "%s\n", orchestra+1);
           csoundCompileOrcAsync(csound, orchestra+1);
+          udp_channels_clear(csound, p);
         }
       }
       else {
-        //csound->Message(csound, "%s\n", orchestra);
-        csoundCompileOrcAsync(csound, orchestra);
+        //csound->Message(csound, "%s\n", msg);
+        csoundCompileOrcAsync(csound, msg);
+        udp_channels_clear(csound, p);
       }
     }
   }
+ stop:
   csound->Message(csound, Str("UDP server on port %d stopped\n"),port);
-  csound->Free(csound, start);
+  csound->Free(csound, orchestra);
+  csound->Free(csound, buf);
+  udp_channels_clear(csound, p);
   // csound->Message(csound, "orchestra dealloc\n");
   if(sock > 0)
 #ifndef WIN32
@@ -274,6 +452,26 @@ static int udp_start(CSOUND *csound, UDPCOM *p)
 #endif
     return CSOUND_ERROR;
   }
+#ifdef __linux__
+  {
+    struct epoll_event ev;
+    p->epfd = epoll_create1(0);
+    p->wakefd = eventfd(0, EFD_NONBLOCK);
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = p->sock;
+    if (UNLIKELY(p->epfd < 0 || p->wakefd < 0 ||
+                 epoll_ctl(p->epfd, EPOLL_CTL_ADD, p->sock, &ev) < 0 ||
+                 (ev.data.fd = p->wakefd,
+                  epoll_ctl(p->epfd, EPOLL_CTL_ADD, p->wakefd, &ev)) < 0)) {
+      csound->Warning(csound, Str("UDP Server: cannot wait for messages"));
+      if (p->epfd >= 0) close(p->epfd);
+      if (p->wakefd >= 0) close(p->wakefd);
+      close(p->sock);
+      return CSOUND_ERROR;
+    }
+  }
+#endif
   /* set status flag */
   p->status = 1;
   /* create thread */
@@ -287,10 +485,21 @@ int csoundUDPServerClose(CSOUND *csound)
   if (p != NULL) {
     /* unset status flag */
     p->status = 0;
+#ifdef __linux__
+    {
+      uint64_t one = 1;
+      if (write(p->wakefd, &one, sizeof(one)) < 0)
+        csound->Warning(csound, Str("UDP Server: cannot stop"));
+    }
+#endif
     /* wait for server thread to close */
     csoundJoinThread(p->thrid);
     /* close socket */
 #ifndef WIN32
+#ifdef __linux__
+    close(p->epfd);
+    close(p->wakefd);
+#endif
     close(p->sock);
 #else
     closesocket(p->sock);
@@ -35,7 +35,7 @@ int csoundCompileTreeInternal(CSOUND *csound, TREE *root, int async);
 int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async);
 void merge_state(CSOUND *csound, ENGINE_STATE *engineState,
                  TYPE_TABLE* typetable, OPDS *ids);
-void killInstance(CSOUND *csound, MYFLT instr, int insno, INSDS *ip,
+void killInstance(CSOUND *csound, MYFLT instr, int insno,
                   int mode, int allow_release);
 void csoundInputMessageInternal(CSOUND *csound, const char *message);
 int csoundReadScoreInternal(CSOUND *csound, const char *message);
@@ -53,28 +53,50 @@ void set_channel_data_ptr(CSOUND *csound, const char *name,
 enum {INPUT_MESSAGE=1, READ_SCORE, SCORE_EVENT, SCORE_EVENT_ABS,
       TABLE_COPY_OUT, TABLE_COPY_IN, TABLE_SET, MERGE_STATE, KILL_INSTANCE};
 
-/* MAX QUEUE SIZE */
+/* MAX QUEUE SIZE (must be a power of two) */
 #define API_MAX_QUEUE 1024
 /* ARG LIST ALIGNMENT */
 #define ARG_ALIGN 8
-
-/* Message queue structure */
+/* size of the argument space preallocated in each slot */
+#define ARG_INLINE 256
+/* size of the overflow arena for larger payloads (power of two) */
+#define API_ARENA_SIZE (1 << 20)
+
+/* where the args of a slot live */
+enum {ARGS_INLINE = 0, ARGS_ARENA, ARGS_HEAP};
+
+/* Message queue slot: a bounded MPSC ring in the manner of D. Vyukov.
+   seq == pos means the slot is free for the producer claiming position pos,
+   seq == pos+1 means the message at pos is published for the consumer.
+   Positions are unsigned and wrap (at 2^32 where long is 32 bits), so
+   they are only ever compared through their difference.
+*/
 typedef struct _message_queue {
-  int64_t message;  /* message id */
-  char *args;   /* args, arg pointers */
-  int64_t rtn;  /* return value */
+  volatile unsigned long seq;  /* slot sequence number */
+  int32_t message;    /* message id */
+  int32_t where;      /* ARGS_INLINE, ARGS_ARENA or ARGS_HEAP */
+  char *args;         /* args, arg pointers */
+  int64_t rtn;        /* return value */
+  int64_t data[ARG_INLINE/sizeof(int64_t)]; /* inline args */
 } message_queue_t;
 
+/* Overflow arena: a byte ring shared by all producers. Chunks are
+   claimed with a CAS on head and given back by the consumer, which
+   advances tail over consecutive freed chunks.
+*/
+typedef struct {
+  volatile long size;   /* chunk size including header, 0 = unwritten */
+  volatile long freed;  /* set once the message has been consumed */
+} arena_chunk_t;
 
-/* atomicGetAndIncrementWithModulus */
-static long atomicGet_Incr_Mod(volatile long* val, long mod) {
-  volatile long oldVal, newVal;
-  do {
-    oldVal = *val;
-    newVal = (oldVal + 1) % mod;
-  } while (ATOMIC_CMP_XCH(val, newVal, oldVal));
-  return oldVal;
-}
+#define ARENA_HDR \
+  ((sizeof(arena_chunk_t) + ARG_ALIGN - 1) & ~((size_t) ARG_ALIGN - 1))
+
+typedef struct _message_arena {
+  volatile unsigned long head;  /* producers */
+  volatile unsigned long tail;  /* consumer */
+  char *buf;
+} message_arena_t;
 
 /* called by csoundCreate() at the start
    and also by csoundStart() to cover de-allocation
@@ -83,44 +105,151 @@ static long atomicGet_Incr_Mod(volatile long* val, long mod) {
 void allocate_message_queue(CSOUND *csound) {
   if (csound->msg_queue == NULL) {
     int i;
-    csound->msg_queue = (message_queue_t **)
-      csound->Calloc(csound, sizeof(message_queue_t*)*API_MAX_QUEUE);
-    for (i = 0; i < API_MAX_QUEUE; i++) {
-      csound->msg_queue[i] =
-        (message_queue_t*)
-        csound->Calloc(csound, sizeof(message_queue_t));
-    }
+    message_arena_t *arena;
+    csound->msg_queue = (message_queue_t *)
+      csound->Calloc(csound, sizeof(message_queue_t)*API_MAX_QUEUE);
+    for (i = 0; i < API_MAX_QUEUE; i++)
+      csound->msg_queue[i].seq = i;
+    csound->msg_queue_wput = 0;
+    csound->msg_queue_rstart = 0;
+    arena = (message_arena_t *) csound->Calloc(csound, sizeof(message_arena_t));
+    arena->buf = (char *) csound->Calloc(csound, API_ARENA_SIZE);
+    csound->msg_arena = arena;
   }
 }
 
+/* claim size bytes in the overflow arena; returns NULL if it is full */
+static char *arena_alloc(message_arena_t *arena, int size) {
+  unsigned long h, t, nh, off, pad;
+  /* sizes are whole headers so that a pad chunk always has room for one */
+  unsigned long need = (unsigned long) ((ARENA_HDR + size + ARENA_HDR - 1) &
+                                        ~((size_t) ARENA_HDR - 1));
+  arena_chunk_t *c;
+  do {
+    t = ATOMIC_GET(arena->tail);
+    h = ATOMIC_GET(arena->head);
+    off = h & (API_ARENA_SIZE - 1);
+    /* a chunk never wraps: pad to the end of the buffer instead */
+    pad = (off + need > API_ARENA_SIZE) ? API_ARENA_SIZE - off : 0;
+    if (h + pad + need - t > API_ARENA_SIZE)
+      return NULL;
+    nh = h + pad + need;
+  } while (ATOMIC_CMP_XCH(&arena->head, nh, h));
+  if (pad) {
+    c = (arena_chunk_t *) (arena->buf + off);
+    c->freed = 1;
+    ATOMIC_SET(c->size, (long) pad);
+    off = 0;
+  }
+  c = (arena_chunk_t *) (arena->buf + off);
+  c->freed = 0;
+  ATOMIC_SET(c->size, (long) need);
+  return (char *) c + ARENA_HDR;
+}
+
+static inline void arena_free(char *p) {
+  arena_chunk_t *c = (arena_chunk_t *) (p - ARENA_HDR);
+  ATOMIC_SET(c->freed, 1);
+}
+
+/* consumer side: give consecutive freed chunks back to the producers */
+static void arena_reclaim(message_arena_t *arena) {
+  unsigned long t = arena->tail;
+  for (;;) {
+    arena_chunk_t *c =
+      (arena_chunk_t *) (arena->buf + (t & (API_ARENA_SIZE - 1)));
+    long size = ATOMIC_GET(c->size);
+    if (size == 0 || !ATOMIC_GET(c->freed)) break;
+    /* clear the whole chunk: any of its bytes may hold a header next
+       time round, and size == 0 is how we tell one is not written yet */
+    memset(c, 0, size);
+    t += size;
+    ATOMIC_SET(arena->tail, t);
+  }
+}
 
-/* enqueue should be called by the relevant API function */
-void *message_enqueue(CSOUND *csound, int32_t message, char *args,
-                      int argsiz) {
-  if(csound->msg_queue != NULL) {
-    int64_t *rtn;
-    volatile long items;
-
-    /* block if queue is full */
-    do {
-      items = ATOMIC_GET(csound->msg_queue_items);
-    } while(items >= API_MAX_QUEUE);
-
-    message_queue_t* msg =
-      csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wget,
-                                           API_MAX_QUEUE)];
-    msg->message = message;
-    if(msg->args != NULL)
-      csound->Free(csound, msg->args);
-    msg->args = (char *)csound->Calloc(csound, argsiz);
-    memcpy(msg->args, args, argsiz);
-    rtn = &msg->rtn;
-    csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wput,
-                                         API_MAX_QUEUE)] = msg;
-    ATOMIC_INCR(csound->msg_queue_items);
-    return (void *) rtn;
+/* wait for the consumer to make room; timeout is in ms,
+   0 does not wait and a negative value waits forever */
+static int queue_wait(int *waited, int timeout) {
+  if (timeout == 0 || (timeout > 0 && *waited >= timeout))
+    return 0;
+  csoundSleep(1);
+  (*waited)++;
+  return 1;
+}
+
+/* enqueue should be called by the relevant API function;
+   the payload is args followed by extra (which may be NULL);
+   returns CSOUND_SUCCESS or CSOUND_ERROR if the queue stayed full
+*/
+static int message_enqueue_timed(CSOUND *csound, int32_t message,
+                                 char *args, int argsiz,
+                                 const void *extra, int extrasiz,
+                                 int timeout) {
+  message_queue_t *msg;
+  char *dest = NULL;
+  int where = ARGS_INLINE, waited = 0, size = argsiz + extrasiz;
+  unsigned long pos;
+  long dif;
+
+  if (UNLIKELY(csound->msg_queue == NULL))
+    return CSOUND_ERROR;
+
+  if (size > ARG_INLINE) {
+    if (size <= API_ARENA_SIZE/4) {
+      where = ARGS_ARENA;
+      while ((dest = arena_alloc(csound->msg_arena, size)) == NULL)
+        if (!queue_wait(&waited, timeout))
+          return CSOUND_ERROR;
+    }
+    else {
+      /* too large for the arena: rare enough to use the heap */
+      where = ARGS_HEAP;
+      dest = (char *) csound->Malloc(csound, size);
+    }
+    memcpy(dest, args, argsiz);
+    if (extrasiz)
+      memcpy(dest + argsiz, extra, extrasiz);
+  }
+
+  /* claim a slot: a single CAS on the write position */
+  for (;;) {
+    pos = ATOMIC_GET(csound->msg_queue_wput);
+    msg = &csound->msg_queue[pos & (API_MAX_QUEUE - 1)];
+    dif = (long) (ATOMIC_GET(msg->seq) - pos);
+    if (dif == 0) {
+      unsigned long npos = pos + 1;
+      if (!ATOMIC_CMP_XCH(&csound->msg_queue_wput, npos, pos))
+        break;
+    }
+    else if (dif < 0) {
+      /* queue full */
+      if (!queue_wait(&waited, timeout)) {
+        if (where == ARGS_ARENA) arena_free(dest);
+        else if (where == ARGS_HEAP) csound->Free(csound, dest);
+        return CSOUND_ERROR;
+      }
+    }
+  }
+
+  msg->message = message;
+  msg->where = where;
+  msg->rtn = 0;
+  if (where == ARGS_INLINE) {
+    memcpy(msg->data, args, argsiz);
+    if (extrasiz)
+      memcpy((char *) msg->data + argsiz, extra, extrasiz);
+    msg->args = (char *) msg->data;
   }
-  else return NULL;
+  else msg->args = dest;
+  /* publish */
+  ATOMIC_SET(msg->seq, pos + 1);
+  return CSOUND_SUCCESS;
+}
+
+static inline int message_enqueue(CSOUND *csound, int32_t message,
+                                  char *args, int argsiz) {
+  return message_enqueue_timed(csound, message, args, argsiz, NULL, 0, -1);
 }
 
 /* dequeue should be called by kperf_*()
@@ -128,12 +257,14 @@ void *message_enqueue(CSOUND *csound, int32_t message, char *args,
 */
 void message_dequeue(CSOUND *csound) {
   if(csound->msg_queue != NULL) {
-    long rp = csound->msg_queue_rstart;
-    long items = csound->msg_queue_items;
-    long rend = rp + items;
+    unsigned long rp = csound->msg_queue_rstart;
+    unsigned long rend = rp + API_MAX_QUEUE;
+    int arena_used = 0;
 
-    while(rp < rend) {
-      message_queue_t* msg = csound->msg_queue[rp % API_MAX_QUEUE];
+    while(rp != rend) {
+      message_queue_t* msg = &csound->msg_queue[rp & (API_MAX_QUEUE - 1)];
+      if (ATOMIC_GET(msg->seq) != rp + 1)
+        break;
       switch(msg->message) {
       case INPUT_MESSAGE:
         {
@@ -154,10 +285,10 @@ void message_dequeue(CSOUND *csound) {
           const MYFLT *pfields;
           long numFields;
           type = msg->args[0];
-          memcpy(&pfields, msg->args + ARG_ALIGN,
-                 sizeof(MYFLT *));
-          memcpy(&numFields, msg->args + ARG_ALIGN*2,
+          memcpy(&numFields, msg->args + ARG_ALIGN,
                  sizeof(long));
+          /* pfields were copied in after the header */
+          pfields = (const MYFLT *) (msg->args + ARG_ALIGN*2);
 
           csoundScoreEventInternal(csound, type, pfields, numFields);
         }
@@ -169,12 +300,11 @@ void message_dequeue(CSOUND *csound) {
           long numFields;
           double ofs;
           type = msg->args[0];
-          memcpy(&pfields, msg->args + ARG_ALIGN,
-                 sizeof(MYFLT *));
-          memcpy(&numFields, msg->args + ARG_ALIGN*2,
+          memcpy(&numFields, msg->args + ARG_ALIGN,
                  sizeof(long));
-          memcpy(&ofs, msg->args + ARG_ALIGN*3,
+          memcpy(&ofs, msg->args + ARG_ALIGN*2,
                  sizeof(double));
+          pfields = (const MYFLT *) (msg->args + ARG_ALIGN*3);
 
           csoundScoreEventAbsoluteInternal(csound, type, pfields, numFields,
                                              ofs);
@@ -229,35 +359,43 @@ void message_dequeue(CSOUND *csound) {
         {
           MYFLT instr;
           int mode, insno, rls;
-          INSDS *ip;
           memcpy(&instr, msg->args, sizeof(MYFLT));
           memcpy(&insno, msg->args + ARG_ALIGN,
                  sizeof(int));
-          memcpy(&ip, msg->args + ARG_ALIGN*2,
-                 sizeof(INSDS *));
-          memcpy(&mode, msg->args + ARG_ALIGN*3,
+          memcpy(&mode, msg->args + ARG_ALIGN*2,
                  sizeof(int));
-          memcpy(&rls, msg->args  + ARG_ALIGN*4,
+          memcpy(&rls, msg->args  + ARG_ALIGN*3,
                  sizeof(int));
-          killInstance(csound, instr, insno, ip, mode, rls);
+          killInstance(csound, instr, insno, mode, rls);
         }
         break;
       }
       msg->message = 0;
+      if (msg->where == ARGS_ARENA) {
+        arena_free(msg->args);
+        arena_used = 1;
+      }
+      else if (msg->where == ARGS_HEAP)
+        csound->Free(csound, msg->args);
+      msg->args = NULL;
+      /* hand the slot back to the producers */
+      ATOMIC_SET(msg->seq, rp + API_MAX_QUEUE);
       rp += 1;
     }
-    ATOMIC_SUB(csound->msg_queue_items, items);
-    csound->msg_queue_rstart = rp % API_MAX_QUEUE;
+    csound->msg_queue_rstart = rp;
+    if (arena_used)
+      arena_reclaim(csound->msg_arena);
   }
 }
 
 /* these are the message enqueueing functions for each relevant API function */
-static inline void csoundInputMessage_enqueue(CSOUND *csound,
-                                              const char *str){
-  message_enqueue(csound,INPUT_MESSAGE, (char *) str, strlen(str)+1);
+static inline int csoundInputMessage_enqueue(CSOUND *csound,
+                                             const char *str, int timeout){
+  return message_enqueue_timed(csound, INPUT_MESSAGE, (char *) str,
+                               strlen(str)+1, NULL, 0, timeout);
 }
 
-static inline int64_t *csoundReadScore_enqueue(CSOUND *csound, const char *str){
+static inline int csoundReadScore_enqueue(CSOUND *csound, const char *str){
   return message_enqueue(csound, READ_SCORE, (char *) str, strlen(str)+1);
 }
 
@@ -291,46 +429,51 @@ static inline void csoundTableSet_enqueue(CSOUND *csound, int table, int index,
 }
 
 
-static inline int64_t *csoundScoreEvent_enqueue(CSOUND *csound, char type,
-                                                const MYFLT *pfields,
-                                                long numFields)
+/* score events carry a copy of their pfields after the header,
+   so the caller's array need not outlive the call */
+static inline int csoundScoreEvent_enqueue(CSOUND *csound, char type,
+                                           const MYFLT *pfields,
+                                           long numFields, int timeout)
 {
-  const int argsize = ARG_ALIGN*3;
-  char args[ARG_ALIGN*3];
+  const int argsize = ARG_ALIGN*2;
+  char args[ARG_ALIGN*2];
+  if (numFields < 0) numFields = 0;
   args[0] = type;
-  memcpy(args+ARG_ALIGN, &pfields, sizeof(MYFLT *));
-  memcpy(args+2*ARG_ALIGN, &numFields, sizeof(long));
-  return message_enqueue(csound,SCORE_EVENT, args, argsize);
+  memcpy(args+ARG_ALIGN, &numFields, sizeof(long));
+  return message_enqueue_timed(csound, SCORE_EVENT, args, argsize,
+                               pfields, (int) (numFields*sizeof(MYFLT)),
+                               timeout);
 }
 
 
-static inline int64_t *csoundScoreEventAbsolute_enqueue(CSOUND *csound, char type,
-                                                        const MYFLT *pfields,
-                                                        long numFields,
-                                                        double time_ofs)
+static inline int csoundScoreEventAbsolute_enqueue(CSOUND *csound, char type,
+                                                   const MYFLT *pfields,
+                                                   long numFields,
+                                                   double time_ofs,
+                                                   int timeout)
 {
-  const int argsize = ARG_ALIGN*4;
-  char args[ARG_ALIGN*4];
+  const int argsize = ARG_ALIGN*3;
+  char args[ARG_ALIGN*3];
+  if (numFields < 0) numFields = 0;
   args[0] = type;
-  memcpy(args+ARG_ALIGN, &pfields, sizeof(MYFLT *));
-  memcpy(args+2*ARG_ALIGN, &numFields, sizeof(long));
-  memcpy(args+3*ARG_ALIGN, &time_ofs, sizeof(double));
-  return message_enqueue(csound,SCORE_EVENT_ABS, args, argsize);
+  memcpy(args+ARG_ALIGN, &numFields, sizeof(long));
+  memcpy(args+2*ARG_ALIGN, &time_ofs, sizeof(double));
+  return message_enqueue_timed(csound, SCORE_EVENT_ABS, args, argsize,
+                               pfields, (int) (numFields*sizeof(MYFLT)),
+                               timeout);
 }
 
 /* this is to be called from
    csoundKillInstanceInternal() in insert.c
 */
 void killInstance_enqueue(CSOUND *csound, MYFLT instr, int insno,
-                          INSDS *ip, int mode,
-                          int allow_release) {
-  const int argsize = ARG_ALIGN*5;
-  char args[ARG_ALIGN*5];
-  memcpy(args, &instr, sizeof(int));
+                          int mode, int allow_release) {
+  const int argsize = ARG_ALIGN*4;
+  char args[ARG_ALIGN*4];
+  memcpy(args, &instr, sizeof(MYFLT));
   memcpy(args+ARG_ALIGN, &insno, sizeof(int));
-  memcpy(args+ARG_ALIGN*2, &ip, sizeof(INSDS *));
-  memcpy(args+ARG_ALIGN*3, &mode, sizeof(int));
-  memcpy(args+ARG_ALIGN*4, &allow_release, sizeof(int));
+  memcpy(args+ARG_ALIGN*2, &mode, sizeof(int));
+  memcpy(args+ARG_ALIGN*3, &allow_release, sizeof(int));
   message_enqueue(csound,KILL_INSTANCE,args,argsize);
 }
 
@@ -445,7 +588,7 @@ MYFLT csoundEvalCode(CSOUND *csound, const char *str)
     To be removed once everything is made async
 */
 void csoundInputMessageAsync(CSOUND *csound, const char *message){
-  csoundInputMessage_enqueue(csound, message);
+  csoundInputMessage_enqueue(csound, message, -1);
 }
 
 void csoundReadScoreAsync(CSOUND *csound, const char *message){
@@ -468,7 +611,7 @@ void csoundTableSetAsync(CSOUND *csound, int table, int index, MYFLT value)
 void csoundScoreEventAsync(CSOUND *csound, char type,
                            const MYFLT *pfields, long numFields)
 {
-  csoundScoreEvent_enqueue(csound, type, pfields, numFields);
+  csoundScoreEvent_enqueue(csound, type, pfields, numFields, -1);
 }
 
 void csoundScoreEventAbsoluteAsync(CSOUND *csound, char type,
@@ -476,7 +619,28 @@ void csoundScoreEventAbsoluteAsync(CSOUND *csound, char type,
                                    double time_ofs)
 {
 
-  csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields, time_ofs);
+  csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields, time_ofs,
+                                   -1);
+}
+
+int csoundInputMessageAsyncTimed(CSOUND *csound, const char *message,
+                                 int timeout){
+  return csoundInputMessage_enqueue(csound, message, timeout);
+}
+
+int csoundScoreEventAsyncTimed(CSOUND *csound, char type,
+                               const MYFLT *pfields, long numFields,
+                               int timeout)
+{
+  return csoundScoreEvent_enqueue(csound, type, pfields, numFields, timeout);
+}
+
+int csoundScoreEventAbsoluteAsyncTimed(CSOUND *csound, char type,
+                                       const MYFLT *pfields, long numFields,
+                                       double time_ofs, int timeout)
+{
+  return csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields,
+                                          time_ofs, timeout);
 }
 
 int csoundCompileTreeAsync(CSOUND *csound, TREE *root) {
@@ -47,6 +47,10 @@ struct instr_semantics_t;
 
 typedef int taskID;
 
+/* Dispatchers selectable with --dispatcher */
+#define DISPATCH_DAG (0)    /* scan task status array (cs_new_dispatch.c) */
+#define DISPATCH_WS  (1)    /* work-stealing deques (cs_ws_dispatch.c) */
+
 /* Each task has a status */
 enum state { WAITING = 3,          /* Dependencies have not been finished */
              AVAILABLE = 2,        /* Dependencies met, ready to be run */
@@ -67,4 +71,14 @@ typedef struct _watchList {
                      sizeof(struct _watchList *))) / sizeof(uint8_t)];
 } watchList;
 
+/* Consecutive tasks of one instrument.  Whether a task waits on an
+   earlier one only depends on their instruments, so dependencies are
+   worked out per run rather than per pair of tasks. */
+typedef struct _dagGroup {
+  int insno;
+  int first, cnt;           /* tasks first .. first+cnt-1 */
+  int wait;                 /* a task of an earlier run to wait on, or -1 */
+  int self;                 /* the tasks wait on each other */
+} dagGroup;
+
 #endif
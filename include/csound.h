@@ -1839,6 +1839,16 @@ extern "C" {
   PUBLIC void csoundScoreEventAsync(CSOUND *,
                               char type, const MYFLT *pFields, long numFields);
 
+  /**
+   *  Like csoundScoreEventAsync(), but gives up if the message queue
+   *  is still full after timeout milliseconds. A timeout of 0 never
+   *  waits and a negative timeout waits for as long as it takes.
+   *  Returns CSOUND_SUCCESS, or CSOUND_ERROR if the event was not queued.
+   */
+  PUBLIC int csoundScoreEventAsyncTimed(CSOUND *,
+                              char type, const MYFLT *pFields, long numFields,
+                              int timeout);
+
   /**
    * Like csoundScoreEvent(), this function inserts a score event, but
    * at absolute time with respect to the start of performance, or from an
@@ -1852,6 +1862,14 @@ extern "C" {
    */
   PUBLIC void csoundScoreEventAbsoluteAsync(CSOUND *,
                  char type, const MYFLT *pfields, long numFields, double time_ofs);
+
+  /**
+   *  Version of csoundScoreEventAbsoluteAsync() with a timeout, as
+   *  in csoundScoreEventAsyncTimed().
+   */
+  PUBLIC int csoundScoreEventAbsoluteAsyncTimed(CSOUND *,
+                 char type, const MYFLT *pfields, long numFields, double time_ofs,
+                 int timeout);
   /**
    * Input a NULL-terminated string (as if from a console),
    * used for line events.
@@ -1863,6 +1881,13 @@ extern "C" {
    */
   PUBLIC void csoundInputMessageAsync(CSOUND *, const char *message);
 
+  /**
+   * Version of csoundInputMessageAsync() with a timeout, as
+   * in csoundScoreEventAsyncTimed().
+   */
+  PUBLIC int csoundInputMessageAsyncTimed(CSOUND *, const char *message,
+                                          int timeout);
+
   /**
    * Kills off one or more running instances of an instrument identified
    * by instr (number) or instrName (name). If instrName is NULL, the
@@ -2522,6 +2547,81 @@ extern "C" {
    */
   PUBLIC void csoundDestroyCircularBuffer(CSOUND *csound, void *circularbuffer);
 
+  /**
+   * Create a ring buffer holding up to numelem elements of elemsize bytes,
+   * for one thread writing and one thread reading. Reads and writes copy
+   * whole spans at a time, and a reader can wait for data with
+   * csoundWaitRingBuffer(). Returns NULL on failure.
+   *@code
+   * void *rb = csoundCreateRingBuffer(csound, 4096, sizeof(MYFLT));
+   *@endcode
+   */
+  PUBLIC void *csoundCreateRingBuffer(CSOUND *csound,
+                                      int numelem, int elemsize);
+
+  /**
+   * Read up to items elements from the ring buffer rb into out.
+   * Returns the number of elements read. csound is ignored.
+   */
+  PUBLIC int csoundReadRingBuffer(CSOUND *csound, void *rb,
+                                  void *out, int items);
+
+  /**
+   * Write up to items elements from in to the ring buffer rb.
+   * Returns the number of elements written. csound is ignored.
+   */
+  PUBLIC int csoundWriteRingBuffer(CSOUND *csound, void *rb,
+                                   const void *in, int items);
+
+  /**
+   * Get space to write to in place: sets *data to the next free element
+   * and returns how many of up to items can be written there
+   * contiguously. The space wraps at the end of the buffer, so a further
+   * call after csoundCommitRingBuffer() may return more.
+   */
+  PUBLIC int csoundReserveRingBuffer(CSOUND *csound, void *rb,
+                                     void **data, int items);
+
+  /**
+   * Make items elements written after csoundReserveRingBuffer() visible
+   * to the reader.
+   */
+  PUBLIC void csoundCommitRingBuffer(CSOUND *csound, void *rb, int items);
+
+  /**
+   * Get data to read in place: sets *data to the next element and returns
+   * how many of up to items are there contiguously.
+   */
+  PUBLIC int csoundAcquireRingBuffer(CSOUND *csound, void *rb,
+                                     void **data, int items);
+
+  /**
+   * Give items elements read after csoundAcquireRingBuffer() back to the
+   * writer.
+   */
+  PUBLIC void csoundReleaseRingBuffer(CSOUND *csound, void *rb, int items);
+
+  /**
+   * Wait until at least items elements can be read, for up to timeout
+   * milliseconds, or without limit if timeout is negative. Returns the
+   * number of elements that can be read, which may be fewer than items
+   * after the timeout or csoundWakeRingBuffer(). items is limited to the
+   * size of the buffer. Only the reader may call this.
+   */
+  PUBLIC int csoundWaitRingBuffer(CSOUND *csound, void *rb,
+                                  int items, int timeout);
+
+  /**
+   * Make the reader return from csoundWaitRingBuffer(), e.g. to stop it.
+   * If it is not waiting, its next wait returns at once.
+   */
+  PUBLIC void csoundWakeRingBuffer(CSOUND *csound, void *rb);
+
+  /**
+   * Free a ring buffer.
+   */
+  PUBLIC void csoundDestroyRingBuffer(CSOUND *csound, void *rb);
+
   /**
    * Platform-independent function to load a shared library.
    */
@@ -262,6 +262,13 @@ typedef struct CORFIL {
     int     ksmps_override;
     int     fft_lib;
     int     echo;
+    int     dispatcher;     /* DAG dispatcher for -j, DISPATCH_DAG or _WS */
+    int     noFuse;         /* keep a-rate expressions as separate opcodes */
+    int     noBinaryScore;  /* sort the score to text, not binary records */
+    int     scoreSortMem;   /* MB of a section sorted in memory, 0: any */
+    int     scoreSortThreads; /* threads sorting score sections, 0: none */
+    int     asyncWrite;     /* MB queued for the disk writer thread, 0: none */
+    int     ioThreads;      /* async file I/O workers, 0: default */
   } OPARMS;
 
   typedef struct arglst {
@@ -345,6 +352,7 @@ typedef struct CORFIL {
     int     instcnt;                /* Count number of instances ever */
     int     isNew;                  /* is this a new definition */
     int     nocheckpcnt;            /* Control checks on pcnt */
+    void    *image;                 /* prebuilt instance, see instance() */
   } INSTRTXT;
 
   typedef struct namedInstr {
@@ -689,6 +697,7 @@ typedef struct CORFIL {
     int32   flen;
     int     fno, guardreq;
     EVTBLK  e;
+    void    *gen01cache;        /* GEN01 cache entry in use, fgens.c */
   } FGDATA;
 
   typedef struct {
@@ -1379,11 +1388,25 @@ typedef struct _message_queue_t_ {
                                char* , char*);
     OENTRY* (*find_opcode_exact)(CSOUND*, char*,
                                char* , char*);
+    void *(*CreateRingBuffer)(CSOUND *, int, int);
+    int (*ReadRingBuffer)(CSOUND *, void *, void *, int);
+    int (*WriteRingBuffer)(CSOUND *, void *, const void *, int);
+    int (*ReserveRingBuffer)(CSOUND *, void *, void **, int);
+    void (*CommitRingBuffer)(CSOUND *, void *, int);
+    int (*AcquireRingBuffer)(CSOUND *, void *, void **, int);
+    void (*ReleaseRingBuffer)(CSOUND *, void *, int);
+    int (*WaitRingBuffer)(CSOUND *, void *, int, int);
+    void (*WakeRingBuffer)(CSOUND *, void *);
+    void (*DestroyRingBuffer)(CSOUND *, void *);
+    /* Give ftp table data of its own, copied if copy is non-zero, if it
+       is mapped from the GEN01 cache; call before reallocating or freeing
+       ftp->ftable.  Returns non-zero if it was mapped. */
+    int (*FTUnmap)(CSOUND *, FUNC *ftp, int copy);
        /**@}*/
     /** @name Placeholders
         To allow the API to grow while maintining backward binary compatibility. */
     /**@{ */
-    SUBR dummyfn_2[34];
+    SUBR dummyfn_2[23];
     /**@}*/
 #ifdef __BUILDING_LIBCSOUND
     /* ------- private data (not to be used by hosts or externals) ------- */
@@ -1562,9 +1585,7 @@ typedef struct _message_queue_t_ {
     void          *tseg, *tpsave, *unused_int0;
     /* Statics from express.c */
     MYFLT         *gbloffbas;       /* was static in oload.c */
-    void          *file_io_thread;
-    int           file_io_start;
-    void          *file_io_threadlock;
+    struct asyncio_s *asyncio;      /* async file I/O workers, asyncio.c */
     int           realtime_audio_flag;
     void          *event_insert_thread;
     int           event_insert_loop;
@@ -1654,6 +1675,7 @@ typedef struct _message_queue_t_ {
       uint32        nframes               /* = 1UL */;
       FILE          *pin, *pout;
       int           dither;
+      void          *writer;              /* disk writer thread, or NULL  */
     } libsndStatics;
 
     int           warped;               /* rdscor.c */
@@ -1750,8 +1772,10 @@ typedef struct _message_queue_t_ {
     volatile stateWithPadding    *dag_task_status;
     watchList     * volatile *dag_task_watch;
     watchList     *dag_wlmm;
-    char          **dag_task_dep;
+    int           *dag_task_group; /* index in dag_groups of each task */
     int           dag_task_max_size;
+    dagGroup      *dag_groups;    /* runs of tasks of one instrument */
+    int           dag_num_groups;
     uint32_t      tempStatus;    /* keeps track of which files are temps */
     int           orcLineOffset; /* 1 less than 1st orch line in the CSD */
     int           scoLineOffset; /* 1 less than 1st score line in the CSD */
@@ -1781,11 +1805,11 @@ typedef struct _message_queue_t_ {
     CS_HASH_TABLE* symbtab;
     int           unused_int1;
     int           inZero;       /* flag compilation of instr0 */
-    struct _message_queue **msg_queue;
-    volatile long msg_queue_wget; /* Writer - Get index */
-    volatile long msg_queue_wput; /* Writer - Put Index */
-    volatile long msg_queue_rstart; /* Reader - start index */
-    volatile long msg_queue_items;
+    struct _message_queue *msg_queue;
+    volatile long msg_queue_wget; /* unused */
+    volatile unsigned long msg_queue_wput; /* Writer - Put Index */
+    volatile unsigned long msg_queue_rstart; /* Reader - start index */
+    volatile long msg_queue_items; /* unused */
     int      aftouch;
     void     *directory;
     ALLOC_DATA *alloc_queue;
@@ -1801,6 +1825,22 @@ typedef struct _message_queue_t_ {
     unsigned long message_string_queue_wp;
     message_string_queue_t *message_string_queue;
     int io_initialised;
+    struct ws_dispatch_t *dag_ws;  /* work-stealing dispatcher state */
+    char          **dag_conflicts;   /* memoised instrument dependencies */
+    int           dag_conflicts_size;
+    struct _message_arena *msg_arena; /* overflow args for msg_queue */
+    void          *mem_pool;      /* size-class allocator, memalloc.c */
+    INSDS         **p1_index;     /* active instances hashed on p1 */
+    int           p1_index_size, p1_index_count;
+    void          *p1_links;      /* their bucket links, by INSDS address */
+    INSDS         **act_first;    /* first active instance of each insno */
+    int           act_first_size;
+    struct scobin_s *scobin;     /* sorted score as binary records */
+    char          *scobin_out;   /* --save-sorted-score file name */
+    char          *scobin_in;    /* --sorted-score file name */
+    struct sortrun_s *sortrun;   /* runs of sections too large to sort */
+    char          *gen01_cache;  /* --gen01-cache directory */
+    struct gen01map_s *gen01maps; /* tables mapped from it, fgens.c */
     /*struct CSOUND_ **self;*/
     /**@}*/
 #endif  /* __BUILDING_LIBCSOUND */
@@ -127,6 +127,8 @@ typedef struct {
         MYFLT   *wintype;
         MYFLT   *format;                /* always PVS_AMP_FREQ at present */
         MYFLT   *init;                  /* not yet implemented */
+        MYFLT   *ithreads;              /* threads for a batch it leads */
+        MYFLT   *ihop;                  /* sliding: samples per new frame */
         /* internal */
         int32    buflen;
         float   fund,arate;
@@ -143,6 +145,13 @@ typedef struct {
         AUXCH           trig;
         double          *cosine, *sine;
         void    *setup;
+        AUXCH   polar;          /* bins split for the polar kernels */
+        /* frames analysed together with the pvsanal opcodes after it */
+        AUXCH   batch;          /* the batch this one leads */
+        void    *leader;        /* the pvsanal whose batch this one is in */
+        uint64_t kdone;         /* k-cycle it was last analysed in a batch */
+        int32   batchscan;      /* 1 once the batch has been looked for */
+        int32   sdhop, sdcount; /* sliding: frame hop, samples to next one */
 } PVSANAL;
 
 typedef struct {
@@ -171,6 +180,7 @@ typedef struct {
         AUXCH   oldOutPhase;
 
         void    *setup;
+        AUXCH   polar;          /* bins split for the polar kernels */
 } PVSYNTH;
 
 /* for pvadsyn */
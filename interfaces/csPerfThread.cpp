@@ -128,25 +128,28 @@ extern "C" {
     recordData_t *recordData = (recordData_t *)recordData_;
     int retval = 0;
     const int bufsize = 4096;
-    MYFLT buf[bufsize];
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
-    while (recordData->running) {
-                csoundLockMutex (recordData->mutex);
-        csoundCondWait(recordData->condvar, recordData->mutex);
+    bool running;
+    do {
+        // the performance thread wakes us once the samples are there;
+        // after StopRecord write what is left
+        running = recordData->running;
+        if (running)
+          csoundWaitRingBuffer(NULL, recordData->cbuf, bufsize, 100);
+        void *buf;
         int sampsread;
-        do {
-            sampsread = csoundReadCircularBuffer(NULL, recordData->cbuf,
-                                                 buf, bufsize);
+        while ((sampsread = csoundAcquireRingBuffer(NULL, recordData->cbuf,
+                                                    &buf, bufsize)) != 0) {
 #ifdef USE_DOUBLE
             sf_write_double((SNDFILE *) recordData->sfile,
-                            buf, sampsread);
+                            (MYFLT *) buf, sampsread);
 #else
             sf_write_float((SNDFILE *) recordData->sfile,
-                           buf, sampsread);
+                           (MYFLT *) buf, sampsread);
 #endif
-        } while(sampsread != 0);
-                csoundUnlockMutex (recordData->mutex);
-    }
+            csoundReleaseRingBuffer(NULL, recordData->cbuf, sampsread);
+        }
+    } while (running);
     return (uintptr_t) ((unsigned int) retval);
   }
 }
@@ -172,9 +175,9 @@ public:
         }
         int bufsize = csoundGetOutputBufferSize(csound)
                 * csoundGetNchnls(csound) * numbufs;
-        recordData->cbuf = csoundCreateCircularBuffer(csound,
-                                                 bufsize,
-                                                 sizeof(MYFLT));
+        recordData->cbuf = csoundCreateRingBuffer(csound,
+                                                  bufsize,
+                                                  sizeof(MYFLT));
 
         if (!recordData->cbuf) {
           csoundMessage(csound, "Could create recording buffer.");
@@ -204,7 +207,8 @@ public:
                                                  &sf_info);
         if (!recordData->sfile) {
           csoundMessage(csound, "Could not open file for recording.");
-          csoundDestroyCircularBuffer(csound, recordData->cbuf);
+          csoundDestroyRingBuffer(csound, recordData->cbuf);
+          recordData->cbuf = NULL;
           return;
         }
         sf_command((SNDFILE *) recordData->sfile, SFC_SET_CLIPPING,
@@ -238,8 +242,11 @@ public:
       recordData_t *recordData = CsoundPerformanceThreadMessage::getRecordData();
       if (recordData->running) {
           recordData->running = false;
+          csoundWakeRingBuffer(NULL, recordData->cbuf);
           csoundJoinThread(recordData->thread);
           sf_close((SNDFILE *) recordData->sfile);
+          csoundDestroyRingBuffer(pt_->GetCsound(), recordData->cbuf);
+          recordData->cbuf = NULL;
       }
 
       CsoundPerformanceThreadMessage::unlockRecord();
@@ -433,24 +440,26 @@ int CsoundPerformanceThread::Perform()
            processcallback(cdata);
       retval = csoundPerformKsmps(csound);
       if (recordData.running) {
-          MYFLT *spout = csoundGetSpout(csound);
+          const MYFLT *spout = csoundGetSpout(csound);
           int len = csoundGetKsmps(csound) * csoundGetNchnls(csound);
-          if (csoundGet0dBFS(csound) != 1.0) {
-              MYFLT zdbfs = csoundGet0dBFS(csound);
-              MYFLT *modspout = spout;
-              for (int i = 0; i < len; i++) {
-                  *modspout /= zdbfs;
-                  modspout++;
+          MYFLT scal = (MYFLT) (1.0 / csoundGet0dBFS(csound));
+          // scale straight into the ring, in at most two spans
+          while (len > 0) {
+              void *data;
+              int n = csoundReserveRingBuffer(NULL, recordData.cbuf,
+                                              &data, len);
+              if (n == 0) {
+                  csoundMessage(csound, "perfThread record buffer overrun.\n");
+                  break;
               }
-          }
-          int written = csoundWriteCircularBuffer(NULL, recordData.cbuf,
-                                                  spout, len);
-          if (written != len) {
-              csoundMessage(csound, "perfThread record buffer overrun.\n");
+              MYFLT *dst = (MYFLT *) data;
+              for (int i = 0; i < n; i++)
+                  dst[i] = spout[i] * scal;
+              csoundCommitRingBuffer(NULL, recordData.cbuf, n);
+              spout += n;
+              len -= n;
           }
       }
-      csoundCondSignal(recordData.condvar); // Needs to be outside the if
-                              // for the case where stop record was requested
     } while (!retval);
  endOfPerf:
     status = retval;
@@ -542,9 +551,6 @@ void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
     recordData.thread = NULL;
     recordData.running = false;
 
-        recordData.mutex = csoundCreateMutex (0);
-        recordData.condvar = csoundCreateCondVar();
-
     perfThread = csoundCreateThread(csoundPerformanceThread_, (void*) this);
     if (perfThread) {
       status = 0;
@@ -678,7 +684,7 @@ int CsoundPerformanceThread::Join()
 
     if (recordData.running) {
         recordData.running = false;
-        csoundCondSignal(recordData.condvar);
+        csoundWakeRingBuffer(NULL, recordData.cbuf);
         csoundJoinThread(recordData.thread);
     }
     if (perfThread) {
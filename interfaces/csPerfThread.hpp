@@ -112,8 +112,6 @@ typedef struct {
     void *sfile;
     void *thread;
     bool running;
-    void* condvar;
-    void* mutex;
 } recordData_t;
 
 class PUBLIC CsoundPerformanceThread {
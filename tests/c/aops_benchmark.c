@@ -0,0 +1,117 @@
+/*
+ * aops_benchmark.c
+ *
+ * Times the a-rate arithmetic opcodes of OOps/aops.c with each kernel set
+ * the CPU supports, over a range of ksmps values.  Not run by ctest;
+ * usage: aopsBenchmark [seconds-per-case]
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "csoundCore.h"
+#include "aops.h"
+#include "aops_simd.h"
+
+extern int32_t addaa(CSOUND *, void *), subaa(CSOUND *, void *);
+extern int32_t mulaa(CSOUND *, void *), divaa(CSOUND *, void *);
+extern int32_t addak(CSOUND *, void *), mulak(CSOUND *, void *);
+extern int32_t divak(CSOUND *, void *);
+extern int32_t addka(CSOUND *, void *), mulka(CSOUND *, void *);
+extern int32_t divka(CSOUND *, void *);
+
+static const struct {
+    const char  *name;
+    int32_t     (*fn)(CSOUND *, void *);
+} opcodes[] = {
+    { "addaa", addaa }, { "subaa", subaa }, { "mulaa", mulaa },
+    { "divaa", divaa }, { "addak", addak }, { "mulak", mulak },
+    { "divak", divak }, { "addka", addka }, { "mulka", mulka },
+    { "divka", divka }
+};
+
+static const uint32_t ksmps_list[] = { 1, 8, 10, 16, 32, 64, 100, 128, 256,
+                                       1024 };
+
+#define NOPCODES  (sizeof(opcodes) / sizeof(opcodes[0]))
+#define NKSMPS    (sizeof(ksmps_list) / sizeof(ksmps_list[0]))
+
+/* ns per sample for one opcode at one ksmps, run for about 'secs' */
+static double time_opcode(CSOUND *csound, int32_t (*fn)(CSOUND *, void *),
+                          AOP *p, uint32_t ksmps, double secs)
+{
+    RTCLOCK clk;
+    double  t = 0.0;
+    long    reps = 0, batch = 1 + 262144 / ksmps, i;
+
+    fn(csound, p);                      /* warm up */
+    csoundInitTimerStruct(&clk);
+    do {
+      for (i = 0; i < batch; i++)
+        fn(csound, p);
+      reps += batch;
+      t = csoundGetRealTime(&clk);
+    } while (t < secs);
+    return t * 1.0e9 / ((double) reps * ksmps);
+}
+
+int main(int argc, char **argv)
+{
+    CSOUND  *csound;
+    INSDS   *ip;
+    AOP     p;
+    MYFLT   *r, *a, *b, k = FL(1.0001);
+    double  secs = argc > 1 ? atof(argv[1]) : 0.1;
+    const AOPS_KERNELS *levels[AOPS_SIMD_LEVELS];
+    const AOPS_KERNELS *active;
+    int     nlevels = 0, l;
+    uint32_t i, j, maxk = ksmps_list[NKSMPS - 1];
+
+    csoundInitialize(CSOUNDINIT_NO_ATEXIT | CSOUNDINIT_NO_SIGNAL_HANDLER);
+    csound = csoundCreate(NULL);
+    active = aops_kernels;
+    for (l = 0; l < AOPS_SIMD_LEVELS; l++)
+      if ((levels[nlevels] = aops_simd_kernels(l)) != NULL)
+        nlevels++;
+
+    ip = (INSDS *) calloc(1, sizeof(INSDS));
+    r = (MYFLT *) malloc(maxk * sizeof(MYFLT));
+    a = (MYFLT *) malloc(maxk * sizeof(MYFLT));
+    b = (MYFLT *) malloc(maxk * sizeof(MYFLT));
+    for (i = 0; i < maxk; i++) {
+      a[i] = FL(0.5) + (MYFLT) i / maxk;
+      b[i] = FL(1.5) - (MYFLT) i / maxk;
+    }
+    memset(&p, 0, sizeof(AOP));
+    p.h.insdshead = ip;
+    p.r = r;
+
+    printf("MYFLT is %d bytes, default kernels: %s\n",
+           (int) sizeof(MYFLT), active->name);
+    printf("%-8s %6s", "opcode", "ksmps");
+    for (l = 0; l < nlevels; l++)
+      printf(" %10s", levels[l]->name);
+    printf("   (ns/sample)\n");
+    for (i = 0; i < NOPCODES; i++) {
+      const char *nm = opcodes[i].name;
+      /* the k-rate operand is the single value k */
+      p.a = (nm[3] == 'k' && nm[4] == 'a') ? &k : a;
+      p.b = (nm[4] == 'k') ? &k : b;
+      for (j = 0; j < NKSMPS; j++) {
+        ip->ksmps = ksmps_list[j];
+        printf("%-8s %6u", nm, ksmps_list[j]);
+        for (l = 0; l < nlevels; l++) {
+          aops_kernels = levels[l];
+          printf(" %10.3f",
+                 time_opcode(csound, opcodes[i].fn, &p, ksmps_list[j], secs));
+        }
+        printf("\n");
+      }
+    }
+    aops_kernels = active;
+
+    free(r); free(a); free(b); free(ip);
+    csoundDestroy(csound);
+    return 0;
+}
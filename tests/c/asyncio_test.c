@@ -0,0 +1,220 @@
+/*
+ * asyncio_test.c
+ *
+ * Streams sound files through the asynchronous file API (FileOpenAsync,
+ * ReadAsync, WriteAsync and FSeekAsync), which is served by the I/O
+ * worker threads of Engine/asyncio.c.  A file is written with requests
+ * of irregular sizes, read back the same way with seeks in the middle,
+ * and checked sample by sample; closing a write stream must write out
+ * everything still in its ring.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "CUnit/Basic.h"
+
+#define SND_FILE    "asyncio_test.wav"
+#define NFRAMES     200000
+#define BUFSIZE     4096
+#define MAXTRIES    100000      /* 1 ms sleeps before giving up */
+
+/* request sizes, from single samples to more than the ring holds */
+static const int sizes[] = {
+    1, 17, 300, 1023, 64, 5000, 2, 777, 40000, 128, 9, 4096, 256, 3
+};
+
+#define NSIZES      ((int) (sizeof(sizes) / sizeof(sizes[0])))
+
+/* the sample at frame k; exact in a float file */
+static MYFLT sample(int k)
+{
+    return (MYFLT) (((k * 7) % 65536) - 32768) / FL(32768.0);
+}
+
+static void *open_async(CSOUND *csound, int write, SF_INFO *sfinfo)
+{
+    SNDFILE *sf = NULL;
+
+    memset(sfinfo, 0, sizeof(SF_INFO));
+    if (write) {
+      sfinfo->samplerate = 44100;
+      sfinfo->channels = 1;
+      sfinfo->format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    }
+    return csound->FileOpenAsync(csound, &sf,
+                                 write ? CSFILE_SND_W : CSFILE_SND_R,
+                                 SND_FILE, sfinfo, NULL,
+                                 write ? CSFTYPE_WAVE : CSFTYPE_UNKNOWN_AUDIO,
+                                 BUFSIZE, 0);
+}
+
+/* write frames from .. to - 1 in requests of irregular sizes, waiting
+   whenever the ring is full */
+static int write_frames(CSOUND *csound, void *fd, int from, int to)
+{
+    MYFLT   buf[40000];
+    int     i = 0, n, m, k, tries = 0;
+
+    while (from < to && tries < MAXTRIES) {
+      n = sizes[i++ % NSIZES];
+      if (n > to - from) n = to - from;
+      for (k = 0; k < n; k++)
+        buf[k] = sample(from + k);
+      m = (int) csound->WriteAsync(csound, fd, buf, n);
+      from += m;
+      if (m < n) {
+        csoundSleep(1);
+        tries++;
+      }
+    }
+    return from;
+}
+
+/* read from frame pos until frame 'until' (or the end of the file) in
+   requests of irregular sizes, checking every sample; returns the frame
+   reached, or -1 on a wrong sample */
+static int read_frames(CSOUND *csound, void *fd, int pos, int until)
+{
+    MYFLT   buf[40000];
+    int     i = 0, n, m, k, tries = 0;
+
+    while (pos < until && tries < MAXTRIES) {
+      n = sizes[i++ % NSIZES];
+      if (n > until - pos) n = until - pos;
+      m = (int) csound->ReadAsync(csound, fd, buf, n);
+      for (k = 0; k < m; k++)
+        if (buf[k] != sample(pos + k))
+          return -1;
+      pos += m;
+      if (m < n) {
+        if (pos >= NFRAMES)
+          break;
+        csoundSleep(1);
+        tries++;
+      }
+    }
+    return pos;
+}
+
+/* the frames of the file as written, checked with libsndfile directly */
+static int check_file(int nframes)
+{
+    SF_INFO sfinfo;
+    SNDFILE *sf;
+    double  *buf;
+    int     k, ok;
+
+    memset(&sfinfo, 0, sizeof(SF_INFO));
+    if ((sf = sf_open(SND_FILE, SFM_READ, &sfinfo)) == NULL)
+      return 0;
+    ok = (sfinfo.frames == nframes && sfinfo.channels == 1);
+    buf = (double *) malloc((nframes + 1) * sizeof(double));
+    if (ok && sf_read_double(sf, buf, nframes + 1) == nframes) {
+      for (k = 0; k < nframes; k++)
+        if (buf[k] != (double) sample(k))
+          ok = 0;
+    }
+    else
+      ok = 0;
+    free(buf);
+    sf_close(sf);
+    return ok;
+}
+
+void test_write_stream(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    SF_INFO sfinfo;
+    void    *fd;
+
+    csoundSetOption(csound, "--io-threads=2");
+    fd = open_async(csound, 1, &sfinfo);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fd);
+    CU_ASSERT_EQUAL(write_frames(csound, fd, 0, NFRAMES), NFRAMES);
+    /* what is still in the ring is written out by the close */
+    CU_ASSERT_EQUAL(csound->FileClose(csound, fd), 0);
+    CU_ASSERT(check_file(NFRAMES));
+    csoundDestroy(csound);
+}
+
+void test_close_flushes(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    SF_INFO sfinfo;
+    void    *fd;
+
+    fd = open_async(csound, 1, &sfinfo);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fd);
+    /* less than a write's worth: no worker has written any of it */
+    CU_ASSERT_EQUAL(write_frames(csound, fd, 0, BUFSIZE / 2), BUFSIZE / 2);
+    CU_ASSERT_EQUAL(csound->FileClose(csound, fd), 0);
+    CU_ASSERT(check_file(BUFSIZE / 2));
+    csoundDestroy(csound);
+}
+
+void test_read_stream(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    SF_INFO sfinfo;
+    void    *fd;
+
+    /* the file to read */
+    fd = open_async(csound, 1, &sfinfo);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fd);
+    write_frames(csound, fd, 0, NFRAMES);
+    csound->FileClose(csound, fd);
+    CU_ASSERT_FATAL(check_file(NFRAMES));
+
+    fd = open_async(csound, 0, &sfinfo);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fd);
+    CU_ASSERT_EQUAL(sfinfo.frames, NFRAMES);
+    CU_ASSERT_EQUAL(read_frames(csound, fd, 0, 70000), 70000);
+    /* forward past what was read ahead, then back to near the start */
+    CU_ASSERT_EQUAL(csound->FSeekAsync(csound, fd, 150000, SEEK_SET), 150000);
+    CU_ASSERT_EQUAL(read_frames(csound, fd, 150000, 160000), 160000);
+    CU_ASSERT_EQUAL(csound->FSeekAsync(csound, fd, 1000, SEEK_SET), 1000);
+    CU_ASSERT_EQUAL(read_frames(csound, fd, 1000, NFRAMES), NFRAMES);
+    /* nothing past the end */
+    CU_ASSERT_EQUAL(read_frames(csound, fd, NFRAMES, NFRAMES + 1), NFRAMES);
+    CU_ASSERT_EQUAL(csound->FileClose(csound, fd), 0);
+    csoundDestroy(csound);
+    remove(SND_FILE);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Asynchronous file I/O tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Write stream", test_write_stream))
+        || (NULL == CU_add_test(pSuite, "Closing flushes a write stream",
+                                test_close_flushes))
+        || (NULL == CU_add_test(pSuite, "Read stream with seeks",
+                                test_read_stream))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
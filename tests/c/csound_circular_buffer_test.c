@@ -133,6 +133,164 @@ void test_wrap(void) {
 }
 
 
+void test_ring_read_write(void) {
+    int i, n, in[128], out[128];
+    CSOUND* csound = csoundCreate(NULL);
+    void *rb = csoundCreateRingBuffer(csound, 100, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(rb);
+    for (i = 0; i < 128; i++) in[i] = i;
+    /* empty, then more than fits */
+    CU_ASSERT_EQUAL(csoundReadRingBuffer(csound, rb, out, 10), 0);
+    CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, in, 128), 100);
+    CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, in, 1), 0);
+    CU_ASSERT_EQUAL(csoundReadRingBuffer(csound, rb, out, 128), 100);
+    for (i = 0; i < 100; i++)
+        CU_ASSERT_EQUAL(out[i], i);
+    /* spans that wrap round the end */
+    CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, in, 60), 60);
+    CU_ASSERT_EQUAL(csoundReadRingBuffer(csound, rb, out, 40), 40);
+    CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, in + 60, 68), 68);
+    n = csoundReadRingBuffer(csound, rb, out + 40, 128);
+    CU_ASSERT_EQUAL(n, 88);
+    for (i = 0; i < 128; i++)
+        CU_ASSERT_EQUAL(out[i], i);
+    csoundDestroyRingBuffer(csound, rb);
+    csoundDestroy(csound);
+}
+
+void test_ring_reserve_acquire(void) {
+    int i, j, k, n, next = 0, expect = 0;
+    int *data;
+    CSOUND* csound = csoundCreate(NULL);
+    void *rb = csoundCreateRingBuffer(csound, 50, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(rb);
+    for (j = 0; j < 40; j++) {
+        /* write 17 in place, in as many contiguous pieces as it takes */
+        for (i = 0; i < 17; i += n) {
+            n = csoundReserveRingBuffer(csound, rb, (void **) &data, 17 - i);
+            CU_ASSERT(n > 0);
+            if (n <= 0) break;
+            for (k = 0; k < n; k++) data[k] = next++;
+            csoundCommitRingBuffer(csound, rb, n);
+        }
+        /* nothing is readable beyond what was committed */
+        n = csoundAcquireRingBuffer(csound, rb, (void **) &data, 50);
+        CU_ASSERT(n > 0 && n <= 17);
+        /* read it back in place */
+        for (i = 0; i < 17; i += n) {
+            n = csoundAcquireRingBuffer(csound, rb, (void **) &data, 17 - i);
+            CU_ASSERT(n > 0);
+            if (n <= 0) break;
+            for (k = 0; k < n; k++)
+                CU_ASSERT_EQUAL(data[k], expect++);
+            csoundReleaseRingBuffer(csound, rb, n);
+        }
+    }
+    CU_ASSERT_EQUAL(csoundAcquireRingBuffer(csound, rb, (void **) &data, 1), 0);
+    /* a full ring has no space to reserve */
+    for (i = 0; i < 50; i += n) {
+        n = csoundReserveRingBuffer(csound, rb, (void **) &data, 50 - i);
+        csoundCommitRingBuffer(csound, rb, n);
+    }
+    CU_ASSERT_EQUAL(csoundReserveRingBuffer(csound, rb, (void **) &data, 1), 0);
+    csoundDestroyRingBuffer(csound, rb);
+    csoundDestroy(csound);
+}
+
+typedef struct {
+    CSOUND *csound;
+    void   *rb;
+    int    items, timeout, count, result;
+} RING_TEST;
+
+/* writes count elements one at a time, a millisecond apart */
+static void *ring_trickle(void *arg) {
+    RING_TEST *t = (RING_TEST *) arg;
+    int i;
+    for (i = 0; i < t->count; i++) {
+        while (csoundWriteRingBuffer(t->csound, t->rb, &i, 1) == 0)
+            csoundSleep(1);
+        csoundSleep(1);
+    }
+    return NULL;
+}
+
+static void *ring_wait(void *arg) {
+    RING_TEST *t = (RING_TEST *) arg;
+    t->result = csoundWaitRingBuffer(t->csound, t->rb, t->items, t->timeout);
+    return NULL;
+}
+
+void test_ring_wait(void) {
+    int i, n, got = 0, out[64];
+    RTCLOCK clk;
+    double elapsed;
+    pthread_t writer;
+    RING_TEST t;
+    CSOUND* csound = csoundCreate(NULL);
+    void *rb = csoundCreateRingBuffer(csound, 256, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(rb);
+    t.csound = csound;
+    t.rb = rb;
+    /* nothing comes: returns after the timeout, or at once without one */
+    CU_ASSERT_EQUAL(csoundWaitRingBuffer(csound, rb, 10, 0), 0);
+    csoundInitTimerStruct(&clk);
+    CU_ASSERT_EQUAL(csoundWaitRingBuffer(csound, rb, 10, 50), 0);
+    elapsed = csoundGetRealTime(&clk);
+    CU_ASSERT(elapsed >= 0.045 && elapsed < 1.0);
+    /* items are collected over many small writes, not returned after
+       the first of them */
+    t.count = 200;
+    pthread_create(&writer, NULL, ring_trickle, &t);
+    while (got < 200) {
+        int want = 200 - got < 64 ? 200 - got : 64;
+        n = csoundWaitRingBuffer(csound, rb, want, 2000);
+        CU_ASSERT(n >= want);
+        CU_ASSERT_EQUAL(csoundReadRingBuffer(csound, rb, out, want), want);
+        for (i = 0; i < want; i++)
+            CU_ASSERT_EQUAL(out[i], got + i);
+        got += want;
+    }
+    pthread_join(writer, NULL);
+    /* more than fit is limited to the size of the ring */
+    CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, out, 64), 64);
+    for (i = 0; i < 3; i++)
+        CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, out, 64), 64);
+    CU_ASSERT_EQUAL(csoundWaitRingBuffer(csound, rb, 1000, -1), 256);
+    csoundDestroyRingBuffer(csound, rb);
+    csoundDestroy(csound);
+}
+
+void test_ring_wake(void) {
+    pthread_t reader;
+    RING_TEST t;
+    int x = 0;
+    CSOUND* csound = csoundCreate(NULL);
+    void *rb = csoundCreateRingBuffer(csound, 64, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(rb);
+    t.csound = csound;
+    t.rb = rb;
+    t.items = 10;
+    t.timeout = -1;
+    t.result = -1;
+    /* a reader waiting without limit returns when woken */
+    pthread_create(&reader, NULL, ring_wait, &t);
+    csoundSleep(20);
+    CU_ASSERT_EQUAL(csoundWriteRingBuffer(csound, rb, &x, 1), 1);
+    csoundSleep(20);
+    CU_ASSERT_EQUAL(t.result, -1);
+    csoundWakeRingBuffer(csound, rb);
+    pthread_join(reader, NULL);
+    CU_ASSERT_EQUAL(t.result, 1);
+    /* a wake before the wait is not lost, and is used up by it */
+    csoundWakeRingBuffer(csound, rb);
+    CU_ASSERT_EQUAL(csoundWaitRingBuffer(csound, rb, 10, -1), 1);
+    CU_ASSERT_EQUAL(csoundWaitRingBuffer(csound, rb, 10, 20), 1);
+    csoundDestroyRingBuffer(csound, rb);
+    csoundDestroy(csound);
+}
+
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -152,6 +310,10 @@ int main()
             || (NULL == CU_add_test(pSuite, "Test read and write diff sizes", test_read_write_diff_size))
             || (NULL == CU_add_test(pSuite, "Test peek", test_peek))
             || (NULL == CU_add_test(pSuite, "Test wrap", test_wrap))
+            || (NULL == CU_add_test(pSuite, "Test ring read and write", test_ring_read_write))
+            || (NULL == CU_add_test(pSuite, "Test ring reserve and acquire", test_ring_reserve_acquire))
+            || (NULL == CU_add_test(pSuite, "Test ring wait", test_ring_wait))
+            || (NULL == CU_add_test(pSuite, "Test ring wake", test_ring_wake))
         )
     {
         CU_cleanup_registry();
@@ -63,6 +63,121 @@ void test_buffer_run(void)
     csoundDestroy(csound);
 }
 
+/* both count their events and add up their last p-field */
+static const char *count_orc =
+    "instr 1\n"
+    "icount chnget \"count\"\n"
+    "chnset icount + 1, \"count\"\n"
+    "isum chnget \"sum\"\n"
+    "chnset isum + p4, \"sum\"\n"
+    "endin\n"
+    "instr 2\n"
+    "icount chnget \"count\"\n"
+    "chnset icount + 1, \"count\"\n"
+    "isum chnget \"sum\"\n"
+    "chnset isum + p1000, \"sum\"\n"
+    "endin\n";
+
+static CSOUND *start_counting(void)
+{
+    CSOUND *csound = csoundCreate(0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    csoundCompileOrc(csound, count_orc);
+    csoundStart(csound);
+    return csound;
+}
+
+/* a few k-cycles: the queue is read at the start of each */
+static void drain(CSOUND *csound)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        csoundPerformKsmps(csound);
+}
+
+void test_async_timed(void)
+{
+    MYFLT pf[4] = { 1, 0, 0.001, 0 };
+    int i, n = 0, ret;
+    CSOUND *csound = start_counting();
+
+    /* nothing reads the queue until a k-cycle runs */
+    for (i = 0; i < 4096; i++) {
+        pf[3] = (MYFLT) i;
+        if (csoundScoreEventAsyncTimed(csound, 'i', pf, 4, 0) != CSOUND_SUCCESS)
+            break;
+        n++;
+    }
+    CU_ASSERT(n > 0);
+    CU_ASSERT(n < 4096);
+    /* still full: a short timeout gives up too */
+    ret = csoundScoreEventAbsoluteAsyncTimed(csound, 'i', pf, 4, 0.0, 5);
+    CU_ASSERT_EQUAL(ret, CSOUND_ERROR);
+    ret = csoundInputMessageAsyncTimed(csound, "i 1 0 0.001 0", 0);
+    CU_ASSERT_EQUAL(ret, CSOUND_ERROR);
+
+    drain(csound);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "count", NULL), n);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "sum", NULL),
+                    (MYFLT) n * (n - 1) / 2);
+
+    /* room again, for each kind of timed message */
+    pf[3] = 1;
+    CU_ASSERT_EQUAL(csoundScoreEventAsyncTimed(csound, 'i', pf, 4, 0),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundScoreEventAbsoluteAsyncTimed(csound, 'i', pf, 4,
+                                                       0.0, 0),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundInputMessageAsyncTimed(csound, "i 1 0 0.001 1", 0),
+                    CSOUND_SUCCESS);
+    drain(csound);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "count", NULL), n + 3);
+
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+}
+
+/* events too large for a queue slot go through the overflow arena */
+#define BIG_EVENT 1000
+
+void test_async_arena(void)
+{
+    static MYFLT pf[BIG_EVENT];
+    int i, round, n, total = 0;
+    double sum = 0.0;
+    CSOUND *csound = start_counting();
+
+    pf[0] = 2; pf[1] = 0; pf[2] = 0.001;
+    /* several rounds, so that the arena wraps and is given back */
+    for (round = 0; round < 3; round++) {
+        n = 0;
+        for (i = 0; i < 1024; i++) {
+            pf[BIG_EVENT - 1] = (MYFLT) (round * 1024 + i);
+            if (csoundScoreEventAsyncTimed(csound, 'i', pf, BIG_EVENT, 0)
+                != CSOUND_SUCCESS)
+                break;
+            sum += pf[BIG_EVENT - 1];
+            n++;
+        }
+        /* the arena fills up long before the queue does */
+        CU_ASSERT(n > 0);
+        CU_ASSERT(n < 1024);
+        CU_ASSERT_EQUAL(csoundScoreEventAsyncTimed(csound, 'i', pf,
+                                                   BIG_EVENT, 5),
+                        CSOUND_ERROR);
+        drain(csound);
+        total += n;
+        CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "count", NULL),
+                        total);
+        CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "sum", NULL), sum);
+    }
+
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+}
+
 int main()
 {
    CU_pSuite pSuite = NULL;
@@ -81,6 +196,10 @@ int main()
    /* add the tests to the suite */
    if ((NULL == CU_add_test(pSuite, "Create Message Buffer", test_create_buffer))
            || (NULL == CU_add_test(pSuite, "Test run", test_buffer_run))
+           || (NULL == CU_add_test(pSuite, "Timed async messages",
+                                   test_async_timed))
+           || (NULL == CU_add_test(pSuite, "Async overflow arena",
+                                   test_async_arena))
            )
    {
       CU_cleanup_registry();
@@ -166,6 +166,67 @@ void test_linenum(void)
 }
 
 
+static int run_fused_orc(const char *option, MYFLT *out, int n)
+{
+    CSOUND  *csound;
+    MYFLT   *chn;
+    int     i, result;
+    char  *instrument =
+            "ksmps = 10 \n"
+            "instr 1 \n"
+            "a1 oscili 0.5, 441 \n"
+            "a2 oscili 0.25, 882 \n"
+            "a3 = (a1*p4 + sin(a2)) / (a2 + 2) - a1 \n"
+            "chnset a3, \"out\" \n"
+            "endin \n";
+
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    if (option != NULL)
+      csoundSetOption(csound, option);
+    result = csoundCompileOrc(csound, instrument);
+    CU_ASSERT(result == 0);
+    csoundReadScore(csound, "i 1 0 1 0.7\n");
+    csoundStart(csound);
+    csoundGetChannelPtr(csound, &chn, "out",
+                        CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    for (i = 0; i < n && csoundPerformKsmps(csound) == 0; i++)
+      memcpy(out + i * 10, chn, 10 * sizeof(MYFLT));
+    csoundDestroy(csound);
+    return i;
+}
+
+void test_fused(void)
+{
+    CSOUND  *csound;
+    TREE    *tree, *stmt;
+    int     nfused = 0, nstmt = 0, n1, n2;
+    MYFLT   fused[500], unfused[500];
+    char  *instrument =
+            "instr 1 \n"
+            "a1 oscili 0.5, 440 \n"
+            "a2 = (a1*0.5 + sin(a1)) / (a1 + 2) \n"
+            "out a2 \n"
+            "endin \n";
+
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    tree = csoundParseOrc(csound, instrument);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    for (stmt = tree->next->right; stmt != NULL; stmt = stmt->next, nstmt++)
+      if (!strcmp(stmt->value->lexeme, "##fused"))
+        nfused++;
+    /* the expression collapses into one opcode between oscili and out */
+    CU_ASSERT_EQUAL(nfused, 1);
+    CU_ASSERT_EQUAL(nstmt, 3);
+    csoundDestroy(csound);
+
+    n1 = run_fused_orc(NULL, fused, 50);
+    n2 = run_fused_orc("--no-fuse", unfused, 50);
+    CU_ASSERT_EQUAL(n1, n2);
+    CU_ASSERT(memcmp(fused, unfused, n1 * 10 * sizeof(MYFLT)) == 0);
+}
+
 
 int main() {
     CU_pSuite pSuite = NULL;
@@ -186,7 +247,8 @@ int main() {
             (NULL == CU_add_test(pSuite, "Test splitArgs", test_split_args)) ||
             (NULL == CU_add_test(pSuite, "Test Compilation", test_compile)) ||
             (NULL == CU_add_test(pSuite, "Test Reuse Instance", test_reuse)) ||
-        (NULL == CU_add_test(pSuite, "Test Line Numbers", test_linenum))) {
+        (NULL == CU_add_test(pSuite, "Test Line Numbers", test_linenum)) ||
+        (NULL == CU_add_test(pSuite, "Test Expression Fusion", test_fused))) {
         CU_cleanup_registry();
         return CU_get_error();
     }
@@ -0,0 +1,389 @@
+/*
+ * dispatch_test.c
+ *
+ * Renders the same orchestra and score with one thread and with several,
+ * and checks that the output is bit-identical.  Several instruments write
+ * the same global and zak variables through a nonlinearity, so the output
+ * changes if the dispatcher runs them out of order.  The default
+ * dispatcher's graph is also run directly on chains that are not sorted
+ * by instrument.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "CUnit/Basic.h"
+
+void dag_build(CSOUND *csound, INSDS *chain);
+void dag_reinit(CSOUND *csound);
+int dag_get_task(CSOUND *csound, int index, int numThreads, int next_task);
+int dag_end_task(CSOUND *csound, int task);
+int dag_instr_conflict(CSOUND *csound, int a, int b);
+
+static const char *orc =
+    "sr = 44100\n"
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "zakinit 4, 4\n"
+    "ga1 init 0\n"
+    "ga2 init 0\n"
+    "gamix init 0\n"
+    "gkcount init 0\n"
+    /* independent voices, each with a global of its own */
+    "instr 1\n"
+    "a1 oscili p4, p5\n"
+    "ga1 = ga1 + a1\n"
+    "endin\n"
+    "instr 2\n"
+    "a1 oscili p4, p5\n"
+    "a2 butlp a1, 2000\n"
+    "ga2 = ga2 + a2\n"
+    "endin\n"
+    /* the same global */
+    "instr 3\n"
+    "a1 oscili p4, p5\n"
+    "gamix = tanh(gamix + a1)\n"
+    "endin\n"
+    "instr 4\n"
+    "a1 oscili p4, p5 * 1.5\n"
+    "gamix = tanh(gamix * 0.9 + a1)\n"
+    "endin\n"
+    /* the same zak channel, and a k-rate global */
+    "instr 5\n"
+    "a0 zar 1\n"
+    "a1 oscili p4, p5\n"
+    "zaw tanh(a0 + a1), 1\n"
+    "endin\n"
+    "instr 6\n"
+    "a0 zar 1\n"
+    "a1 oscili p4, p5\n"
+    "zaw tanh(a0 * 0.8 - a1), 1\n"
+    "gkcount = gkcount * 0.5 + p4\n"
+    "endin\n"
+    /* starts short notes while performing */
+    "instr 7\n"
+    "kt metro p4\n"
+    "if kt == 1 then\n"
+    "event \"i\", 3, 0.0037, 0.02, 0.15, 440\n"
+    "event \"i\", 5, 0.0011, 0.031, 0.1, 220\n"
+    "endif\n"
+    "endin\n"
+    /* stops itself before its p3 is up */
+    "instr 8\n"
+    "a1 oscili 0.2, p5\n"
+    "ga2 = tanh(ga2 + a1)\n"
+    "if timeinsts() >= p4 then\n"
+    "turnoff\n"
+    "endif\n"
+    "endin\n"
+    /* the only output, after all of the above */
+    "instr 20\n"
+    "a0 zar 1\n"
+    "out ga1 * 0.1 + ga2 * 0.1 + gamix * 0.2 + a0 * 0.2 + gkcount * 0.01\n"
+    "ga1 = 0\n"
+    "ga2 = 0\n"
+    "gamix = 0\n"
+    "zacl 0, 3\n"
+    "endin\n";
+
+#define NNOTES  240
+
+/* overlapping notes of every instrument, starting and ending between
+   k-cycles */
+static char *make_score(void)
+{
+    char    *sco = (char *) malloc(NNOTES * 64 + 64);
+    size_t  len = 0;
+    int     i;
+
+    for (i = 0; i < NNOTES; i++)
+      len += sprintf(sco + len, "i %d %.4f %.4f %.3f %d\n", 1 + i % 6,
+                     i * 0.0093, 0.05 + (i % 7) * 0.031,
+                     0.1 + (i % 5) * 0.05, 110 * (1 + i % 11));
+    sprintf(sco + len, "i 20 0 2.6\ne\n");
+    return sco;
+}
+
+/* the output samples; *n is set to their number */
+static MYFLT *render(const char *opt1, const char *opt2, const char *sco,
+                     size_t *n)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    MYFLT   *out = NULL;
+    size_t  len = 0, block;
+    int     res;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    if (opt1 != NULL) csoundSetOption(csound, opt1);
+    if (opt2 != NULL) csoundSetOption(csound, opt2);
+    res = csoundCompileOrc(csound, orc);
+    CU_ASSERT_EQUAL(res, 0);
+    if (res == 0) {
+      csoundStart(csound);
+      csoundReadScore(csound, sco);
+      block = csoundGetKsmps(csound) * csoundGetNchnls(csound);
+      while (csoundPerformKsmps(csound) == 0) {
+        out = (MYFLT *) realloc(out, (len + block) * sizeof(MYFLT));
+        memcpy(out + len, csoundGetSpout(csound), block * sizeof(MYFLT));
+        len += block;
+      }
+    }
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+    *n = len;
+    return out;
+}
+
+static int silent(const MYFLT *out, size_t n)
+{
+    size_t  i;
+
+    for (i = 0; i < n; i++)
+      if (out[i] != 0.0)
+        return 0;
+    return 1;
+}
+
+/* renders sco with opt1/opt2 several times and compares with ref */
+static void compare_renders(const char *opt1, const char *opt2,
+                            const char *sco, const MYFLT *ref, size_t nref)
+{
+    MYFLT   *out;
+    size_t  n;
+    int     i;
+
+    for (i = 0; i < 3; i++) {
+      out = render(opt1, opt2, sco, &n);
+      CU_ASSERT_EQUAL(n, nref);
+      CU_ASSERT(n == nref && memcmp(out, ref, n * sizeof(MYFLT)) == 0);
+      free(out);
+    }
+}
+
+/* notes started by other instruments, held notes turned off from the
+   score and notes that turn themselves off, all mid-performance */
+static char *make_changing_score(void)
+{
+    char    *sco = (char *) malloc(NNOTES * 64 + 1024);
+    size_t  len = 0;
+    int     i;
+
+    len += sprintf(sco + len,
+                   "i 7 0.1 1.9 23\n"
+                   "i 7 0.5 0.7 41\n"
+                   "i 1.1 0.2 -1 0.1 330\n"
+                   "i 1.2 0.33 -1 0.1 495\n"
+                   "i 4.5 0.41 -1 0.2 275\n"
+                   "i -1.2 0.9013 0\n"
+                   "i -1.1 1.3007 0\n"
+                   "i -4.5 1.7 0\n"
+                   "i 8 0.25 2 0.3103 660\n"
+                   "i 8 0.8 2 0.1219 770\n"
+                   "i 8 1.0 2 0.4441 880\n");
+    for (i = 0; i < NNOTES / 2; i++)
+      len += sprintf(sco + len, "i %d %.4f %.4f %.3f %d\n", 1 + i % 6,
+                     i * 0.0171, 0.03 + (i % 5) * 0.043,
+                     0.1 + (i % 3) * 0.05, 110 * (1 + i % 7));
+    sprintf(sco + len, "i 20 0 2.6\ne\n");
+    return sco;
+}
+
+void test_ws_dispatcher(void)
+{
+    char    *sco = make_score();
+    MYFLT   *ref;
+    size_t  nref;
+
+    ref = render("-j1", NULL, sco, &nref);
+    CU_ASSERT(nref > 0);
+    CU_ASSERT(!silent(ref, nref));
+    compare_renders("-j4", "--dispatcher=ws", sco, ref, nref);
+    compare_renders("-j2", "--dispatcher=ws", sco, ref, nref);
+    free(ref);
+    free(sco);
+}
+
+void test_changing_chain(void)
+{
+    char    *sco = make_changing_score();
+    MYFLT   *ref;
+    size_t  nref;
+
+    ref = render("-j1", NULL, sco, &nref);
+    CU_ASSERT(nref > 0);
+    CU_ASSERT(!silent(ref, nref));
+    compare_renders("-j4", NULL, sco, ref, nref);
+    compare_renders("-j3", "--dispatcher=dag", sco, ref, nref);
+    compare_renders("-j4", "--dispatcher=ws", sco, ref, nref);
+    free(ref);
+    free(sco);
+}
+
+#define NTHREADS    4
+#define MAXTASKS    64
+#define NINSTRS     8
+
+static const int instrs[NINSTRS] = { 1, 2, 3, 4, 5, 6, 8, 20 };
+
+/* the tasks of one k-cycle, and the conflicts between them */
+typedef struct {
+    CSOUND  *csound;
+    spin_lock_t lock;
+    int     ntasks, nthreads, errors;
+    int     state[MAXTASKS];            /* 0 waiting, 1 running, 2 done */
+    char    conflict[MAXTASKS][MAXTASKS];
+} DAG_RUN;
+
+/* a thread of kperf's loop, checking that every task it is given comes
+   after the earlier tasks it conflicts with have ended */
+static uintptr_t dag_worker(void *data)
+{
+    DAG_RUN *r = (DAG_RUN *) data;
+    int     index, task, next = -1, k;
+
+    csoundSpinLock(&r->lock);
+    index = r->nthreads++;
+    csoundSpinUnLock(&r->lock);
+    while (1) {
+      task = dag_get_task(r->csound, index, NTHREADS, next);
+      if (task == -1)                   /* none left */
+        break;
+      if (task == -2) {                 /* none ready yet */
+        csoundSleep(0);
+        continue;
+      }
+      csoundSpinLock(&r->lock);
+      for (k = 0; k < task; k++)
+        if (r->conflict[k][task] && r->state[k] != 2)
+          r->errors++;
+      if (r->state[task] != 0)
+        r->errors++;
+      r->state[task] = 1;
+      csoundSpinUnLock(&r->lock);
+      csoundSleep(0);                   /* give the others a chance */
+      csoundSpinLock(&r->lock);
+      r->state[task] = 2;
+      csoundSpinUnLock(&r->lock);
+      next = dag_end_task(r->csound, task);
+    }
+    return 0;
+}
+
+static void run_cycle(DAG_RUN *r)
+{
+    void    *t[NTHREADS];
+    int     i;
+
+    memset(r->state, 0, sizeof(r->state));
+    r->nthreads = 0;
+    for (i = 1; i < NTHREADS; i++)
+      t[i] = csoundCreateThread(dag_worker, r);
+    /* the thread numbers are taken in order, so this one may not be 0 */
+    dag_worker(r);
+    for (i = 1; i < NTHREADS; i++)
+      csoundJoinThread(t[i]);
+    for (i = 0; i < r->ntasks; i++)
+      CU_ASSERT_EQUAL(r->state[i], 2);
+}
+
+/* Chains where one instrument comes up as several runs, as they would if
+   notes were linked in out of instrument order, built and then run for
+   two k-cycles as kperf does. */
+void test_split_runs(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    INSDS   *ins = (INSDS *) calloc(MAXTASKS, sizeof(INSDS));
+    DAG_RUN *r = (DAG_RUN *) calloc(1, sizeof(DAG_RUN));
+    int     chain, i, k, n;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, "-j4");
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, orc), 0);
+    r->csound = csound;
+    csoundSpinLockInit(&r->lock);
+    srand(11);
+    for (chain = 0; chain < 200; chain++) {
+      /* a few runs of each instrument, in random order */
+      n = 1 + rand() % MAXTASKS;
+      k = instrs[rand() % NINSTRS];
+      for (i = 0; i < n; i++) {
+        if (rand() % 3 == 0)
+          k = instrs[rand() % NINSTRS];
+        ins[i].insno = (int16) k;
+        ins[i].nxtact = i + 1 < n ? &ins[i + 1] : NULL;
+      }
+      if (chain == 0) {                 /* 1 1 3 1 5 5 6 5 20 1 */
+        static const int fixed[] = { 1, 1, 3, 1, 5, 5, 6, 5, 20, 1 };
+        n = (int) (sizeof(fixed) / sizeof(fixed[0]));
+        for (i = 0; i < n; i++) {
+          ins[i].insno = (int16) fixed[i];
+          ins[i].nxtact = i + 1 < n ? &ins[i + 1] : NULL;
+        }
+      }
+      r->ntasks = n;
+      for (i = 0; i < n; i++)
+        for (k = i + 1; k < n; k++)
+          r->conflict[i][k] =
+            (char) dag_instr_conflict(csound, ins[i].insno, ins[k].insno);
+      dag_build(csound, ins);
+      CU_ASSERT_EQUAL(csound->dag_num_active, n);
+      for (i = 0; i < n; i++)
+        CU_ASSERT_PTR_EQUAL(csound->dag_task_map[i], &ins[i]);
+      run_cycle(r);
+      dag_reinit(csound);
+      run_cycle(r);
+    }
+    /* the orchestra's conflicts are the ones described above */
+    CU_ASSERT(dag_instr_conflict(csound, 1, 1));
+    CU_ASSERT(!dag_instr_conflict(csound, 1, 3));
+    CU_ASSERT(dag_instr_conflict(csound, 3, 4));
+    CU_ASSERT(dag_instr_conflict(csound, 5, 6));
+    CU_ASSERT(dag_instr_conflict(csound, 1, 20));
+    CU_ASSERT_EQUAL(r->errors, 0);
+    free(r);
+    free(ins);
+    csoundDestroy(csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Multithreaded dispatch tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Work-stealing dispatcher against -j1",
+                             test_ws_dispatcher))
+        || (NULL == CU_add_test(pSuite, "Notes starting and stopping with -jN",
+                                test_changing_chain))
+        || (NULL == CU_add_test(pSuite, "Instruments in several runs",
+                                test_split_runs))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,178 @@
+/*
+ * ftconv_test.c
+ *
+ * Renders ftconv with uniform partitions and with non-uniform ones
+ * (iNonUniform) on the same impulse responses, and checks that the
+ * outputs match within floating point tolerance.  The impulse responses
+ * are longer than the largest non-uniform partition, and several
+ * instances, some starting mid-performance, share the tail workers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "CUnit/Basic.h"
+#include "csound.h"
+
+static const char *orc =
+    "sr = 44100\n"
+    "ksmps = 32\n"
+    "nchnls = 2\n"
+    "0dbfs = 1\n"
+    /* a mono and a stereo (interleaved) response, filled by instr 1 */
+    "gi1 ftgen 1, 0, -200000, -7, 0, 200000, 0\n"
+    "gi2 ftgen 2, 0, -180000, -7, 0, 180000, 0\n"
+    /* decaying noise from a fixed generator */
+    "instr 1\n"
+    "iseed = 12345\n"
+    "it = 1\n"
+    "while it <= 2 do\n"
+    "ilen = ftlen(it)\n"
+    "ii = 0\n"
+    "while ii < ilen do\n"
+    "iseed = (iseed * 16807) % 2147483647\n"
+    "tabw_i (iseed / 2147483647 - 0.5) * exp(-ii / (ilen / 4)), ii, it\n"
+    "ii += 1\n"
+    "od\n"
+    "it += 1\n"
+    "od\n"
+    "endin\n"
+    /* p4: non-uniform, p5: partition length, p6: IR length, p7: seed */
+    "instr 2\n"
+    "ain rand 0.3, p7\n"
+    "a1 ftconv ain, 1, p5, 0, p6, 0, p4\n"
+    "outs a1, a1 * 0.5\n"
+    "endin\n"
+    "instr 3\n"
+    "ain rand 0.3, p7\n"
+    "aL, aR ftconv ain, 2, p5, 0, p6, 0, p4\n"
+    "outs aL, aR\n"
+    "endin\n";
+
+static char *make_score(int nonuniform)
+{
+    char    *sco = (char *) malloc(1024);
+
+    snprintf(sco, 1024,
+             "i 1 0 0.01\n"
+             "i 2 0.01 6 %d 256 0 0.11\n"
+             "i 2 0.01 6 %d 128 0 0.23\n"
+             "i 2 0.01 5 %d 512 60000 0.37\n"
+             "i 3 0.01 6 %d 256 0 0.41\n"
+             "i 2 2.5 3.5 %d 256 0 0.53\n"
+             "i 3 3.1 2 %d 64 20000 0.67\n"
+             "e 6.5\n",
+             nonuniform, nonuniform, nonuniform,
+             nonuniform, nonuniform, nonuniform);
+    return sco;
+}
+
+static MYFLT *render(const char *opt, const char *sco, size_t *n)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    MYFLT   *out = NULL;
+    size_t  len = 0, block;
+    int     res;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    if (opt != NULL) csoundSetOption(csound, opt);
+    res = csoundCompileOrc(csound, orc);
+    CU_ASSERT_EQUAL(res, 0);
+    if (res == 0) {
+      csoundStart(csound);
+      csoundReadScore(csound, sco);
+      block = csoundGetKsmps(csound) * csoundGetNchnls(csound);
+      while (csoundPerformKsmps(csound) == 0) {
+        out = (MYFLT *) realloc(out, (len + block) * sizeof(MYFLT));
+        memcpy(out + len, csoundGetSpout(csound), block * sizeof(MYFLT));
+        len += block;
+      }
+    }
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+    *n = len;
+    return out;
+}
+
+static int silent(const MYFLT *out, size_t n)
+{
+    size_t  i;
+
+    for (i = 0; i < n; i++)
+      if (out[i] != 0.0)
+        return 0;
+    return 1;
+}
+
+/* the largest difference, relative to the peak of ref */
+static double max_error(const MYFLT *out, const MYFLT *ref, size_t n)
+{
+    double  peak = 0.0, err = 0.0;
+    size_t  i;
+
+    for (i = 0; i < n; i++) {
+      if (fabs((double) ref[i]) > peak)
+        peak = fabs((double) ref[i]);
+      if (fabs((double) (out[i] - ref[i])) > err)
+        err = fabs((double) (out[i] - ref[i]));
+    }
+    return (peak > 0.0 ? err / peak : 1.0);
+}
+
+void test_nonuniform(void)
+{
+    char    *uni = make_score(0), *nonuni = make_score(1);
+    MYFLT   *ref, *out;
+    size_t  nref, n;
+    double  tol = (sizeof(MYFLT) == sizeof(double) ? 1.0e-9 : 1.0e-4);
+    const char *opts[] = { NULL, "-j4" };
+    int     i;
+
+    ref = render(NULL, uni, &nref);
+    CU_ASSERT(nref > 0);
+    /* still sounding once the input reaches the end of the responses */
+    CU_ASSERT(nref > 2 * 250000 && !silent(ref + 2 * 250000, 2 * 10000));
+    for (i = 0; i < 2; i++) {
+      out = render(opts[i], nonuni, &n);
+      CU_ASSERT_EQUAL(n, nref);
+      CU_ASSERT(n == nref && max_error(out, ref, n) < tol);
+      free(out);
+    }
+    free(ref);
+    free(uni);
+    free(nonuni);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("ftconv tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Non-uniform partitions",
+                             test_nonuniform))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
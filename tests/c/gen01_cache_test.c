@@ -0,0 +1,310 @@
+/*
+ * gen01_cache_test.c
+ *
+ * Loads a GEN01 table with --gen01-cache twice and checks that the
+ * second run maps it from the cache with the same data, that a changed
+ * sound file (modification time) or changed GEN01 arguments (skip time,
+ * format, normalisation) miss the cache, and that writing to a mapped
+ * table or replacing it leaves the cache file as it was.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include <sndfile.h>
+#include "CUnit/Basic.h"
+#include "csound.h"
+
+#define SND_FILE    "gen01_cache_test.wav"
+#define NSAMPS      1000
+#define TABLEN      1024
+
+static char cache_dir[] = "gen01_cache_XXXXXX";
+
+/* the samples of the sound file, exact in float, with a peak of 0.25 */
+static double sample(int i)
+{
+    return (double) (((i * 37) % 513) - 256) / 1024.0;
+}
+
+static void write_sound(void)
+{
+    SF_INFO sfinfo;
+    SNDFILE *sf;
+    double  buf[NSAMPS];
+    int     i;
+
+    memset(&sfinfo, 0, sizeof(SF_INFO));
+    sfinfo.samplerate = 44100;
+    sfinfo.channels = 1;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    sf = sf_open(SND_FILE, SFM_WRITE, &sfinfo);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(sf);
+    for (i = 0; i < NSAMPS; i++)
+      buf[i] = sample(i);
+    CU_ASSERT_EQUAL(sf_write_double(sf, buf, NSAMPS), NSAMPS);
+    sf_close(sf);
+}
+
+typedef struct {
+    char    *data;              /* the name and contents of each file */
+    size_t  size;
+    int     count;              /* the number of files */
+} SNAPSHOT;
+
+/* the files in the cache, in name order */
+static void cache_files(SNAPSHOT *snap)
+{
+    struct dirent **names;
+    char    path[1024];
+    size_t  n;
+    FILE    *f;
+    int     i, nnames;
+
+    memset(snap, 0, sizeof(SNAPSHOT));
+    nnames = scandir(cache_dir, &names, NULL, alphasort);
+    for (i = 0; i < nnames; i++) {
+      snprintf(path, sizeof(path), "%s/%s", cache_dir, names[i]->d_name);
+      if (names[i]->d_name[0] != '.' && (f = fopen(path, "rb")) != NULL) {
+        fseek(f, 0L, SEEK_END);
+        n = (size_t) ftell(f);
+        fseek(f, 0L, SEEK_SET);
+        snap->data = (char *) realloc(snap->data,
+                                      snap->size + strlen(path) + 1 + n);
+        strcpy(snap->data + snap->size, path);
+        snap->size += strlen(path) + 1;
+        snap->size += fread(snap->data + snap->size, 1, n, f);
+        fclose(f);
+        snap->count++;
+      }
+      free(names[i]);
+    }
+    if (nnames >= 0)
+      free(names);
+}
+
+static int same_files(const SNAPSHOT *a, const SNAPSHOT *b)
+{
+    return (a->count == b->count && a->size == b->size &&
+            memcmp(a->data, b->data, a->size) == 0);
+}
+
+/* Runs an orchestra loading table 1 with ftgen_args, and instr 1 for a
+   few k-cycles if instr is given, and copies table 1 to tab.  Returns 1
+   if the table was mapped from the cache. */
+static int load_table(const char *ftgen_args, const char *instr, MYFLT *tab)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    char    orc[1024], opt[64];
+    MYFLT   *t;
+    int     res, mapped = 0, i;
+
+    snprintf(orc, sizeof(orc),
+             "sr = 44100\n"
+             "ksmps = 32\n"
+             "nchnls = 1\n"
+             "0dbfs = 1\n"
+             "gi1 ftgen 1, 0, %d, %s\n"
+             "%s",
+             TABLEN, ftgen_args, instr != NULL ? instr : "");
+    snprintf(opt, sizeof(opt), "--gen01-cache=%s", cache_dir);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m7");
+    csoundSetOption(csound, opt);
+    res = csoundCompileOrc(csound, orc);
+    CU_ASSERT_EQUAL(res, 0);
+    if (res == 0) {
+      csoundStart(csound);
+      if (instr != NULL) {
+        csoundReadScore(csound, "i 1 0 0.01\n");
+        for (i = 0; i < 20; i++)
+          csoundPerformKsmps(csound);
+      }
+      res = csoundGetTable(csound, &t, 1);
+      CU_ASSERT_EQUAL(res, TABLEN);
+      if (res == TABLEN)
+        memcpy(tab, t, TABLEN * sizeof(MYFLT));
+    }
+    while (csoundGetMessageCnt(csound) > 0) {
+      if (strstr(csoundGetFirstMessage(csound), "mapped from") != NULL)
+        mapped = 1;
+      csoundPopFirstMessage(csound);
+    }
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    return mapped;
+}
+
+/* whether tab holds the sound file from sample skip, times scale */
+static int check_table(const MYFLT *tab, int skip, double scale)
+{
+    int     i;
+
+    for (i = 0; i < TABLEN; i++)
+      if ((double) tab[i] != (i + skip < NSAMPS ? sample(i + skip) * scale
+                                                : 0.0))
+        return 0;
+    return 1;
+}
+
+static const char *args = "1, \"" SND_FILE "\", 0, 0, 0";
+
+void test_cache_hit(void)
+{
+    MYFLT   first[TABLEN], second[TABLEN];
+    SNAPSHOT files, again;
+
+    write_sound();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(cache_dir));
+    CU_ASSERT_EQUAL(load_table(args, NULL, first), 0);
+    cache_files(&files);
+    CU_ASSERT_EQUAL(files.count, 1);
+    /* rescaled to a peak of 1 */
+    CU_ASSERT(check_table(first, 0, 4.0));
+    CU_ASSERT_EQUAL(load_table(args, NULL, second), 1);
+    CU_ASSERT(memcmp(first, second, sizeof(first)) == 0);
+    cache_files(&again);
+    CU_ASSERT(same_files(&files, &again));
+    free(files.data);
+    free(again.data);
+}
+
+void test_cache_miss(void)
+{
+    MYFLT   tab[TABLEN];
+    SNAPSHOT files;
+    struct stat st;
+    struct utimbuf times;
+    int     n;
+
+    cache_files(&files);
+    n = files.count;
+    free(files.data);
+    /* each of these is a new entry, and the second time is mapped */
+    CU_ASSERT_EQUAL(load_table("1, \"" SND_FILE "\", 0.001, 0, 0",
+                               NULL, tab), 0);
+    CU_ASSERT(check_table(tab, 44, 4.0));
+    /* read by the header all the same */
+    CU_ASSERT_EQUAL(load_table("1, \"" SND_FILE "\", 0, 4, 0", NULL, tab), 0);
+    CU_ASSERT(check_table(tab, 0, 4.0));
+    CU_ASSERT_EQUAL(load_table("-1, \"" SND_FILE "\", 0, 0, 0",
+                               NULL, tab), 0);
+    CU_ASSERT(check_table(tab, 0, 1.0));
+    CU_ASSERT_EQUAL(load_table("-1, \"" SND_FILE "\", 0, 0, 0",
+                               NULL, tab), 1);
+    CU_ASSERT(check_table(tab, 0, 1.0));
+    cache_files(&files);
+    CU_ASSERT_EQUAL(files.count, n + 3);
+    n = files.count;
+    free(files.data);
+    /* the same samples, but the file has changed since */
+    CU_ASSERT_FATAL(stat(SND_FILE, &st) == 0);
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime + 100;
+    CU_ASSERT_FATAL(utime(SND_FILE, &times) == 0);
+    CU_ASSERT_EQUAL(load_table(args, NULL, tab), 0);
+    CU_ASSERT(check_table(tab, 0, 4.0));
+    CU_ASSERT_EQUAL(load_table(args, NULL, tab), 1);
+    cache_files(&files);
+    CU_ASSERT_EQUAL(files.count, n + 1);
+    free(files.data);
+}
+
+void test_cache_unchanged(void)
+{
+    MYFLT   tab[TABLEN], orig[TABLEN];
+    SNAPSHOT files, after;
+    int     i;
+
+    CU_ASSERT_EQUAL(load_table(args, NULL, orig), 1);
+    cache_files(&files);
+    /* written through the mapping at i-time and at k-time */
+    CU_ASSERT_EQUAL(load_table(args,
+                               "instr 1\n"
+                               "tableiw 0.75, 10, 1\n"
+                               "tablew k(0.5), 11, 1\n"
+                               "endin\n", tab), 1);
+    CU_ASSERT_EQUAL(tab[10], 0.75);
+    CU_ASSERT_EQUAL(tab[11], 0.5);
+    cache_files(&after);
+    CU_ASSERT(same_files(&files, &after));
+    free(after.data);
+    /* replaced by another table of the same size */
+    CU_ASSERT_EQUAL(load_table(args,
+                               "instr 1\n"
+                               "gi2 ftgen 1, 0, 1024, -7, 0.125, 1024, 0.125\n"
+                               "endin\n", tab), 1);
+    for (i = 0; i < TABLEN && tab[i] == 0.125; i++)
+      ;
+    CU_ASSERT_EQUAL(i, TABLEN);
+    cache_files(&after);
+    CU_ASSERT(same_files(&files, &after));
+    free(after.data);
+    /* and what the next run maps is the original */
+    CU_ASSERT_EQUAL(load_table(args, NULL, tab), 1);
+    CU_ASSERT(memcmp(tab, orig, sizeof(tab)) == 0);
+    free(files.data);
+}
+
+/* the cache directory and the sound file go */
+static void remove_files(void)
+{
+    struct dirent **names;
+    char    path[1024];
+    int     i, n;
+
+    n = scandir(cache_dir, &names, NULL, alphasort);
+    for (i = 0; i < n; i++) {
+      snprintf(path, sizeof(path), "%s/%s", cache_dir, names[i]->d_name);
+      if (names[i]->d_name[0] != '.')
+        remove(path);
+      free(names[i]);
+    }
+    if (n >= 0)
+      free(names);
+    rmdir(cache_dir);
+    remove(SND_FILE);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("GEN01 cache tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Table mapped from the cache",
+                             test_cache_hit))
+        || (NULL == CU_add_test(pSuite, "Changed file or arguments",
+                                test_cache_miss))
+        || (NULL == CU_add_test(pSuite, "Cache file left unchanged",
+                                test_cache_unchanged))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    remove_files();
+    return CU_get_error();
+}
@@ -0,0 +1,266 @@
+/*
+ * insert_test.c
+ *
+ * Checks how instances are found and built by Engine/insert.c: tied
+ * notes continue the held instance with the same fractional p1, a
+ * negative p1 turns off only the matching held note, turnoff2 selects
+ * instances by instrument number or exact p1, and instances built from
+ * the instrument's image (fresh or reused) keep their own state through
+ * reinit.  The instruments report through control channels, which are
+ * read between k-cycles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+#include "csound.h"
+
+static const char *orc =
+    "sr = 1000\n"
+    "ksmps = 10\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    /* a held note; a tie keeps kc counting and updates p4 */
+    "instr 1\n"
+    "Sn sprintf \"%d\", int(frac(p1) * 100 + 0.5)\n"
+    "itie tival\n"
+    "chnset itie, strcat(\"t\", Sn)\n"
+    "chnset p4, strcat(\"p\", Sn)\n"
+    "tigoto tied\n"
+    "kc init 0\n"
+    "tied:\n"
+    "kc += 1\n"
+    "chnset kc, strcat(\"k\", Sn)\n"
+    "endin\n"
+    /* counts its init passes on channel r<p4>, reinitialising twice */
+    "instr 2\n"
+    "Sch sprintf \"r%d\", p4\n"
+    "Sk sprintf \"n%d\", p4\n"
+    "kc init 0\n"
+    "kc += 1\n"
+    "chnset kc, Sk\n"
+    "if kc == 5 || kc == 12 then\n"
+    "reinit again\n"
+    "endif\n"
+    "again:\n"
+    "icnt chnget Sch\n"
+    "chnset icnt + 1, Sch\n"
+    "Sv strcat Sch, \"v\"\n"
+    "chnset p4, Sv\n"
+    "rireturn\n"
+    "endin\n"
+    /* counts k-cycles on channel c<p4> */
+    "instr 3\n"
+    "Sch sprintf \"c%d\", p4\n"
+    "kc init 0\n"
+    "kc += 1\n"
+    "chnset kc, Sch\n"
+    "endin\n"
+    /* turnoff2 p4, p5 */
+    "instr 8\n"
+    "turnoff2 p4, p5, 0\n"
+    "endin\n"
+    "instr 9\n"
+    "chnset active:k(1), \"active1\"\n"
+    "chnset active:k(3), \"active3\"\n"
+    "endin\n";
+
+static CSOUND *start(const char *sco)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    int     res;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    res = csoundCompileOrc(csound, orc);
+    CU_ASSERT_EQUAL(res, 0);
+    if (res == 0) {
+      csoundStart(csound);
+      csoundReadScore(csound, sco);
+    }
+    return csound;
+}
+
+/* perform k-cycles until the score time reaches t */
+static void perform_until(CSOUND *csound, double t)
+{
+    while (csoundGetScoreTime(csound) < t - 1.0e-9 &&
+           csoundPerformKsmps(csound) == 0)
+      ;
+}
+
+static MYFLT chn(CSOUND *csound, const char *name)
+{
+    int     err;
+    MYFLT   value = csoundGetControlChannel(csound, name, &err);
+
+    CU_ASSERT_EQUAL(err, CSOUND_SUCCESS);
+    return value;
+}
+
+static void stop(CSOUND *csound)
+{
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+}
+
+void test_ties(void)
+{
+    CSOUND  *csound = start("i 9 0 1\n"
+                            "i 1.1 0 -1 1\n"
+                            "i 1.2 0 -1 2\n"
+                            "i 1.1 0.1 -1 3\n"
+                            "i 1.1 0.2 0.1 4\n"
+                            "i -1.2 0.25 0\n"
+                            "e 1\n");
+    MYFLT   k1, k2;
+
+    perform_until(csound, 0.05);
+    CU_ASSERT_EQUAL(chn(csound, "active1"), 2);
+    CU_ASSERT_EQUAL(chn(csound, "t10"), 0);
+    CU_ASSERT_EQUAL(chn(csound, "p10"), 1);
+    CU_ASSERT(chn(csound, "k10") <= 6);
+    /* tied to 1.1, which goes on counting */
+    perform_until(csound, 0.15);
+    CU_ASSERT_EQUAL(chn(csound, "active1"), 2);
+    CU_ASSERT_EQUAL(chn(csound, "t10"), 1);
+    CU_ASSERT_EQUAL(chn(csound, "p10"), 3);
+    CU_ASSERT(chn(csound, "k10") >= 12);
+    perform_until(csound, 0.22);
+    CU_ASSERT_EQUAL(chn(csound, "active1"), 2);
+    CU_ASSERT_EQUAL(chn(csound, "p10"), 4);
+    CU_ASSERT(chn(csound, "k10") >= 19);
+    /* 1.2 was never tied */
+    CU_ASSERT_EQUAL(chn(csound, "t20"), 0);
+    CU_ASSERT_EQUAL(chn(csound, "p20"), 2);
+    /* -1.2 turns off 1.2 only */
+    perform_until(csound, 0.27);
+    CU_ASSERT_EQUAL(chn(csound, "active1"), 1);
+    k1 = chn(csound, "k10");
+    k2 = chn(csound, "k20");
+    perform_until(csound, 0.29);
+    CU_ASSERT(chn(csound, "k10") > k1);
+    CU_ASSERT_EQUAL(chn(csound, "k20"), k2);
+    /* and the last tie gave 1.1 an end */
+    perform_until(csound, 0.35);
+    CU_ASSERT_EQUAL(chn(csound, "active1"), 0);
+    stop(csound);
+}
+
+/* which of instr 3 with p4 = 1 .. 4 are still counting */
+static int running(CSOUND *csound, double t)
+{
+    MYFLT   c[4];
+    char    name[8];
+    int     i, mask = 0;
+
+    for (i = 0; i < 4; i++) {
+      snprintf(name, 8, "c%d", i + 1);
+      c[i] = chn(csound, name);
+    }
+    perform_until(csound, t);
+    for (i = 0; i < 4; i++) {
+      snprintf(name, 8, "c%d", i + 1);
+      if (chn(csound, name) > c[i])
+        mask |= 1 << i;
+    }
+    return mask;
+}
+
+void test_turnoff2(void)
+{
+    CSOUND  *csound = start("i 9 0 1\n"
+                            "i 3.1 0 -1 1\n"
+                            "i 3.2 0 -1 2\n"
+                            "i 3.3 0 1 3\n"
+                            "i 3 0 -1 4\n"
+                            "i 8 0.1 0.02 3.2 4\n"
+                            "i 8 0.2 0.02 3 4\n"
+                            "i 8 0.3 0.02 3 8\n"
+                            "i 8 0.4 0.02 3 0\n"
+                            "e 1\n");
+
+    perform_until(csound, 0.05);
+    CU_ASSERT_EQUAL(chn(csound, "active3"), 4);
+    CU_ASSERT_EQUAL(running(csound, 0.08), 15);
+    /* mode 4: p1 must match exactly */
+    perform_until(csound, 0.15);
+    CU_ASSERT_EQUAL(chn(csound, "active3"), 3);
+    CU_ASSERT_EQUAL(running(csound, 0.18), 1 | 4 | 8);
+    perform_until(csound, 0.25);
+    CU_ASSERT_EQUAL(chn(csound, "active3"), 2);
+    CU_ASSERT_EQUAL(running(csound, 0.28), 1 | 4);
+    /* mode 8: only held notes */
+    perform_until(csound, 0.35);
+    CU_ASSERT_EQUAL(chn(csound, "active3"), 1);
+    CU_ASSERT_EQUAL(running(csound, 0.38), 4);
+    /* mode 0: all of instr 3 */
+    perform_until(csound, 0.45);
+    CU_ASSERT_EQUAL(chn(csound, "active3"), 0);
+    CU_ASSERT_EQUAL(running(csound, 0.48), 0);
+    stop(csound);
+}
+
+void test_reinit(void)
+{
+    /* the fourth takes over the instance the first leaves */
+    CSOUND  *csound = start("i 2 0 0.25 1\n"
+                            "i 2 0.05 0.45 2\n"
+                            "i 2 0.1 0.4 3\n"
+                            "i 2 0.3 0.2 4\n"
+                            "e 1\n");
+    char    name[8];
+    MYFLT   d;
+    int     i;
+
+    perform_until(csound, 0.45);
+    for (i = 1; i <= 4; i++) {
+      /* the first init pass and two reinits */
+      snprintf(name, 8, "r%d", i);
+      CU_ASSERT_EQUAL(chn(csound, name), 3);
+      snprintf(name, 8, "r%dv", i);
+      CU_ASSERT_EQUAL(chn(csound, name), i);
+    }
+    /* each counting from its own start, to within a k-cycle */
+    d = chn(csound, "n2") - chn(csound, "n3");
+    CU_ASSERT(d >= 4 && d <= 6);
+    d = chn(csound, "n3") - chn(csound, "n4");
+    CU_ASSERT(d >= 19 && d <= 21);
+    stop(csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Instance insert tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Tied notes and negative p1", test_ties))
+        || (NULL == CU_add_test(pSuite, "turnoff2 by instrument and p1",
+                                test_turnoff2))
+        || (NULL == CU_add_test(pSuite, "Reinit of instances from the image",
+                                test_reinit))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
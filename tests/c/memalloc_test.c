@@ -0,0 +1,359 @@
+/*
+ * memalloc_test.c
+ *
+ * Tests of csound->Malloc and friends (Engine/memalloc.c): blocks of up to
+ * 8 kB come from the size-class pool and larger ones from malloc(), and
+ * both kinds go through the same Free, ReAlloc and memRESET.  Each block
+ * is filled with a pattern that is checked before it is freed.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "CUnit/Basic.h"
+
+extern void memRESET(CSOUND *);
+
+#define POOL_MAX    8192        /* largest pooled request, as in memalloc.c */
+#define NBLOCKS     300
+
+/* every third block is too large for the pool */
+static size_t block_size(int i)
+{
+    return (i % 3 == 2) ? POOL_MAX + 1 + (size_t) i * 37
+                        : 1 + ((size_t) i * 41) % POOL_MAX;
+}
+
+static void fill(void *p, size_t n, int seed)
+{
+    unsigned char *c = (unsigned char *) p;
+    size_t  i;
+
+    for (i = 0; i < n; i++)
+      c[i] = (unsigned char) (seed * 31 + i * 7);
+}
+
+static int check(const void *p, size_t n, int seed)
+{
+    const unsigned char *c = (const unsigned char *) p;
+    size_t  i;
+
+    for (i = 0; i < n; i++)
+      if (c[i] != (unsigned char) (seed * 31 + i * 7))
+        return 0;
+    return 1;
+}
+
+static int check_zero(const void *p, size_t n)
+{
+    const unsigned char *c = (const unsigned char *) p;
+    size_t  i;
+
+    for (i = 0; i < n; i++)
+      if (c[i] != 0)
+        return 0;
+    return 1;
+}
+
+/* allocates blocks[0..n-1], alternating Malloc and Calloc */
+static void alloc_blocks(CSOUND *csound, void **blocks, int n, int seed)
+{
+    int     i;
+
+    for (i = 0; i < n; i++) {
+      size_t size = block_size(i);
+      if (i & 1) {
+        blocks[i] = csound->Calloc(csound, size);
+        CU_ASSERT(check_zero(blocks[i], size));
+      }
+      else
+        blocks[i] = csound->Malloc(csound, size);
+      fill(blocks[i], size, seed + i);
+    }
+}
+
+static int check_blocks(void **blocks, int n, int seed)
+{
+    int     i, ok = 1;
+
+    for (i = 0; i < n; i++)
+      if (blocks[i] != NULL && !check(blocks[i], block_size(i), seed + i))
+        ok = 0;
+    return ok;
+}
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+void test_mixed_free(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    void    *blocks[NBLOCKS], *db, *p, *q;
+    int     i;
+
+    db = csound->memalloc_db;
+    alloc_blocks(csound, blocks, NBLOCKS, 0);
+    /* the heap blocks are on the chain */
+    CU_ASSERT_PTR_NOT_EQUAL(csound->memalloc_db, db);
+    /* free every other block, newest first, then the rest oldest first */
+    for (i = NBLOCKS - 1; i >= 0; i -= 2) {
+      CU_ASSERT(check(blocks[i], block_size(i), i));
+      csound->Free(csound, blocks[i]);
+      blocks[i] = NULL;
+    }
+    CU_ASSERT(check_blocks(blocks, NBLOCKS, 0));
+    for (i = 0; i < NBLOCKS; i++) {
+      if (blocks[i] == NULL)
+        continue;
+      CU_ASSERT(check(blocks[i], block_size(i), i));
+      csound->Free(csound, blocks[i]);
+    }
+    /* every heap block was unlinked again */
+    CU_ASSERT_PTR_EQUAL(csound->memalloc_db, db);
+    /* a freed pooled block is handed out again */
+    p = csound->Malloc(csound, 100);
+    csound->Free(csound, p);
+    q = csound->Malloc(csound, 100);
+    CU_ASSERT_PTR_EQUAL(p, q);
+    csound->Free(csound, q);
+    csound->Free(csound, NULL);
+    csoundDestroy(csound);
+}
+
+void test_realloc(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    void    *db, *p, *q;
+
+    db = csound->memalloc_db;
+    /* within the pool: shrinking keeps the block, growing moves it */
+    p = csound->Malloc(csound, 1000);
+    fill(p, 1000, 1);
+    q = csound->ReAlloc(csound, p, 10);
+    CU_ASSERT_PTR_EQUAL(p, q);
+    CU_ASSERT(check(q, 10, 1));
+    fill(q, 10, 2);
+    p = csound->ReAlloc(csound, q, 5000);
+    CU_ASSERT(check(p, 10, 2));
+    CU_ASSERT_PTR_EQUAL(csound->memalloc_db, db);
+    fill(p, 5000, 3);
+    /* from the pool into the heap */
+    q = csound->ReAlloc(csound, p, 100000);
+    CU_ASSERT(check(q, 5000, 3));
+    CU_ASSERT_PTR_NOT_EQUAL(csound->memalloc_db, db);
+    fill(q, 100000, 4);
+    /* and back down to a pooled size */
+    p = csound->ReAlloc(csound, q, 50);
+    CU_ASSERT(check(p, 50, 4));
+    fill(p, 50, 5);
+    q = csound->ReAlloc(csound, p, 60000);
+    CU_ASSERT(check(q, 50, 5));
+    csound->Free(csound, q);
+    CU_ASSERT_PTR_EQUAL(csound->memalloc_db, db);
+    /* ReAlloc of NULL allocates, and to zero bytes frees */
+    p = csound->ReAlloc(csound, NULL, 200);
+    CU_ASSERT_PTR_NOT_NULL(p);
+    fill(p, 200, 6);
+    CU_ASSERT_PTR_NULL(csound->ReAlloc(csound, p, 0));
+    csoundDestroy(csound);
+}
+
+typedef struct {
+    CSOUND  *csound;
+    void    **blocks;
+    int     n, seed, ok;
+} THREAD_JOB;
+
+/* checks and frees the blocks another thread allocated, then allocates
+   a set that the other thread frees */
+static uintptr_t free_and_alloc(void *data)
+{
+    THREAD_JOB *job = (THREAD_JOB *) data;
+    CSOUND  *csound = job->csound;
+    int     i;
+
+    job->ok = check_blocks(job->blocks, job->n, job->seed);
+    for (i = 0; i < job->n; i++)
+      csound->Free(csound, job->blocks[i]);
+    job->seed += 1000;
+    alloc_blocks(csound, job->blocks, job->n, job->seed);
+    return 0;
+}
+
+/* allocates and frees on its own, at the same time as the main thread */
+static uintptr_t churn(void *data)
+{
+    THREAD_JOB *job = (THREAD_JOB *) data;
+    CSOUND  *csound = job->csound;
+    void    *blocks[NBLOCKS];
+    int     i, j;
+
+    job->ok = 1;
+    for (j = 0; j < 20; j++) {
+      alloc_blocks(csound, blocks, NBLOCKS, j);
+      if (!check_blocks(blocks, NBLOCKS, j))
+        job->ok = 0;
+      for (i = 0; i < NBLOCKS; i++)
+        csound->Free(csound, blocks[i]);
+    }
+    return 0;
+}
+
+void test_other_thread(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    void    *blocks[NBLOCKS], *mine[NBLOCKS], *db, *t;
+    THREAD_JOB job;
+    int     i, j, ok = 1;
+
+    db = csound->memalloc_db;
+    alloc_blocks(csound, blocks, NBLOCKS, 0);
+    job.csound = csound;
+    job.blocks = blocks;
+    job.n = NBLOCKS;
+    job.seed = 0;
+    job.ok = 0;
+    t = csoundCreateThread(free_and_alloc, &job);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(t);
+    csoundJoinThread(t);
+    CU_ASSERT(job.ok);
+    /* the pooled blocks freed there can be allocated here */
+    alloc_blocks(csound, mine, NBLOCKS, 2000);
+    CU_ASSERT(check_blocks(blocks, NBLOCKS, 1000));
+    for (i = 0; i < NBLOCKS; i++)
+      csound->Free(csound, blocks[i]);
+    CU_ASSERT(check_blocks(mine, NBLOCKS, 2000));
+    for (i = 0; i < NBLOCKS; i++)
+      csound->Free(csound, mine[i]);
+    CU_ASSERT_PTR_EQUAL(csound->memalloc_db, db);
+
+    /* both threads allocating and freeing at once */
+    t = csoundCreateThread(churn, &job);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(t);
+    for (j = 0; j < 20; j++) {
+      alloc_blocks(csound, mine, NBLOCKS, 3000 + j);
+      if (!check_blocks(mine, NBLOCKS, 3000 + j))
+        ok = 0;
+      for (i = 0; i < NBLOCKS; i++)
+        csound->Free(csound, mine[i]);
+    }
+    csoundJoinThread(t);
+    CU_ASSERT(ok);
+    CU_ASSERT(job.ok);
+    CU_ASSERT_PTR_EQUAL(csound->memalloc_db, db);
+    csoundDestroy(csound);
+}
+
+/* keeps the blocks it allocates; they are released by memRESET */
+static uintptr_t alloc_only(void *data)
+{
+    THREAD_JOB *job = (THREAD_JOB *) data;
+
+    alloc_blocks(job->csound, job->blocks, job->n, job->seed);
+    return 0;
+}
+
+/* memRESET on an instance of its own: on one made by csoundCreate() it
+   would also free the blocks the rest of the instance still holds */
+void test_reset(void)
+{
+    CSOUND  *csound = (CSOUND *) calloc(1, sizeof(CSOUND));
+    void    *blocks[NBLOCKS], *theirs[NBLOCKS], *t, *p;
+    THREAD_JOB job;
+    int     i, round;
+    size_t  n;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(csound);
+    csound->Malloc = mmalloc;
+    csound->Calloc = mcalloc;
+    csound->ReAlloc = mrealloc;
+    csound->Free = mfree;
+    csoundSpinLockInit(&csound->memlock);
+    for (round = 0; round < 3; round++) {
+      /* live blocks from both paths, some freed, some moved */
+      alloc_blocks(csound, blocks, NBLOCKS, 0);
+      for (i = 0; i < NBLOCKS; i += 5) {
+        csound->Free(csound, blocks[i]);
+        blocks[i] = NULL;
+      }
+      for (i = 1; i < NBLOCKS; i += 7) {
+        if (blocks[i] == NULL)
+          continue;
+        n = block_size(i) < block_size(i + 1) ? block_size(i)
+                                              : block_size(i + 1);
+        blocks[i] = csound->ReAlloc(csound, blocks[i], block_size(i + 1));
+        CU_ASSERT(check(blocks[i], n, i));
+      }
+      /* and blocks from another thread's cache */
+      job.csound = csound;
+      job.blocks = theirs;
+      job.n = NBLOCKS;
+      job.seed = 500;
+      t = csoundCreateThread(alloc_only, &job);
+      CU_ASSERT_PTR_NOT_NULL_FATAL(t);
+      csoundJoinThread(t);
+      CU_ASSERT(check_blocks(theirs, NBLOCKS, 500));
+      for (i = 0; i < NBLOCKS; i += 2)
+        csound->Free(csound, theirs[i]);
+      CU_ASSERT_PTR_NOT_NULL(csound->memalloc_db);
+      CU_ASSERT_PTR_NOT_NULL(csound->mem_pool);
+      memRESET(csound);
+      CU_ASSERT_PTR_NULL(csound->memalloc_db);
+      CU_ASSERT_PTR_NULL(csound->mem_pool);
+      /* the instance allocates again after a reset */
+      p = csound->Malloc(csound, 64);
+      fill(p, 64, round);
+      CU_ASSERT(check(p, 64, round));
+      csound->Free(csound, p);
+    }
+    memRESET(csound);
+    free(csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Memory allocator tests", init_suite1,
+                          clean_suite1);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Pooled and heap blocks freed together",
+                             test_mixed_free))
+        || (NULL == CU_add_test(pSuite, "ReAlloc across the pool limit",
+                                test_realloc))
+        || (NULL == CU_add_test(pSuite, "Free on another thread",
+                                test_other_thread))
+        || (NULL == CU_add_test(pSuite, "memRESET with live blocks",
+                                test_reset))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,163 @@
+/*
+ * pvs_benchmark.c
+ *
+ * Times the rectangular/polar conversion kernels used by pvsanal, pvsynth
+ * and pvadsyn, and the sliding DFT step of pvsanal, with each kernel set
+ * the CPU supports, over a range of frame sizes, and reports how far each
+ * set is from the scalar (libm) results.  Not run by ctest; usage: pvsBenchmark [seconds-per-case]
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "pvs_simd.h"
+
+static const int32_t bins_list[] = { 129, 257, 513, 1025, 2049, 4097 };
+
+#define NBINS     (sizeof(bins_list) / sizeof(bins_list[0]))
+#define MAXBINS   4097
+
+enum { K_POLAR = 0, K_SINCOS, K_SIN, K_SLIDE, NKERNELS };
+
+static const char *kernel_names[NKERNELS] = {
+    "polar", "sincos", "sin", "slide"
+};
+
+/* a sliding transform and the rotations of its bins */
+static double sre[MAXBINS], sim[MAXBINS], sc[MAXBINS], ss[MAXBINS];
+
+static void run(const PVS_KERNELS *k, int kernel, MYFLT *o1, MYFLT *o2,
+                const MYFLT *a, const MYFLT *b, int32_t n)
+{
+    switch (kernel) {
+    case K_POLAR:  k->polar(o1, o2, a, b, n); break;
+    case K_SINCOS: k->sincos(o1, o2, a, n); break;
+    case K_SIN:    k->sin(o1, a, n); break;
+    default:       k->slide(sre, sim, sc, ss, (double) a[0], n); break;
+    }
+}
+
+/* slide a cleared transform by 64 samples of a and leave it in o1, o2 */
+static void slide_from_zero(const PVS_KERNELS *k, MYFLT *o1, MYFLT *o2,
+                            const MYFLT *a, int32_t n)
+{
+    int32_t i;
+
+    memset(sre, 0, sizeof(sre));
+    memset(sim, 0, sizeof(sim));
+    for (i = 0; i < 64; i++)
+      k->slide(sre, sim, sc, ss, (double) a[i], n);
+    for (i = 0; i < n; i++) {
+      o1[i] = (MYFLT) sre[i];
+      o2[i] = (MYFLT) sim[i];
+    }
+}
+
+/* ns per bin for one kernel at one frame size, run for about 'secs' */
+static double time_kernel(const PVS_KERNELS *k, int kernel, MYFLT *o1,
+                          MYFLT *o2, const MYFLT *a, const MYFLT *b,
+                          int32_t n, double secs)
+{
+    RTCLOCK clk;
+    double  t = 0.0;
+    long    reps = 0, batch = 1 + 65536 / n, i;
+
+    run(k, kernel, o1, o2, a, b, n);    /* warm up */
+    csoundInitTimerStruct(&clk);
+    do {
+      for (i = 0; i < batch; i++)
+        run(k, kernel, o1, o2, a, b, n);
+      reps += batch;
+      t = csoundGetRealTime(&clk);
+    } while (t < secs);
+    return t * 1.0e9 / ((double) reps * n);
+}
+
+/* largest difference from the scalar kernels, relative for magnitudes */
+static double max_error(const PVS_KERNELS *k, const PVS_KERNELS *ref,
+                        int kernel, const MYFLT *a, const MYFLT *b,
+                        int32_t n)
+{
+    MYFLT   o1[MAXBINS], o2[MAXBINS], r1[MAXBINS], r2[MAXBINS];
+    double  e = 0.0, d;
+    int32_t i;
+
+    if (kernel == K_SLIDE) {
+      slide_from_zero(k, o1, o2, a, n);
+      slide_from_zero(ref, r1, r2, a, n);
+    }
+    else {
+      run(k, kernel, o1, o2, a, b, n);
+      run(ref, kernel, r1, r2, a, b, n);
+    }
+    for (i = 0; i < n; i++) {
+      if (kernel == K_POLAR) {
+        d = fabs((double) (o1[i] - r1[i]));
+        if (r1[i] > FL(0.0)) d /= (double) r1[i];
+      }
+      else
+        d = fabs((double) (o1[i] - r1[i]));
+      if (d > e) e = d;
+      if (kernel != K_SIN && fabs((double) (o2[i] - r2[i])) > e)
+        e = fabs((double) (o2[i] - r2[i]));
+    }
+    return e;
+}
+
+int main(int argc, char **argv)
+{
+    double  secs = argc > 1 ? atof(argv[1]) : 0.1;
+    const PVS_KERNELS *levels[AOPS_SIMD_LEVELS];
+    MYFLT   *re, *im, *ph, *o1, *o2;
+    int     nlevels = 0, l, kernel;
+    uint32_t i, j;
+
+    csoundInitialize(CSOUNDINIT_NO_ATEXIT | CSOUNDINIT_NO_SIGNAL_HANDLER);
+    for (l = 0; l < AOPS_SIMD_LEVELS; l++)
+      if ((levels[nlevels] = pvs_simd_kernels(l)) != NULL)
+        nlevels++;
+
+    /* a spectrum of random bins, and phases as pvsynth passes them */
+    re = (MYFLT *) malloc(MAXBINS * sizeof(MYFLT));
+    im = (MYFLT *) malloc(MAXBINS * sizeof(MYFLT));
+    ph = (MYFLT *) malloc(MAXBINS * sizeof(MYFLT));
+    o1 = (MYFLT *) malloc(MAXBINS * sizeof(MYFLT));
+    o2 = (MYFLT *) malloc(MAXBINS * sizeof(MYFLT));
+    srand(1);
+    for (i = 0; i < MAXBINS; i++) {
+      re[i] = (MYFLT) (rand() - RAND_MAX / 2) / RAND_MAX;
+      im[i] = (MYFLT) (rand() - RAND_MAX / 2) / RAND_MAX;
+      ph[i] = (MYFLT) (TWOPI * rand() / RAND_MAX);
+      sc[i] = cos(TWOPI * i / (2 * (MAXBINS - 1)));
+      ss[i] = sin(TWOPI * i / (2 * (MAXBINS - 1)));
+    }
+
+    printf("MYFLT is %d bytes, default kernels: %s\n",
+           (int) sizeof(MYFLT), pvs_kernels->name);
+    printf("%-8s %6s", "kernel", "bins");
+    for (l = 0; l < nlevels; l++)
+      printf(" %10s", levels[l]->name);
+    printf("   (ns/bin)\n");
+    for (kernel = 0; kernel < NKERNELS; kernel++) {
+      const MYFLT *a = kernel == K_POLAR || kernel == K_SLIDE ? re : ph;
+      for (j = 0; j < NBINS; j++) {
+        printf("%-8s %6d", kernel_names[kernel], bins_list[j]);
+        for (l = 0; l < nlevels; l++)
+          printf(" %10.3f", time_kernel(levels[l], kernel, o1, o2, a, im,
+                                        bins_list[j], secs));
+        printf("\n");
+      }
+      printf("%-8s %6s", kernel_names[kernel], "error");
+      for (l = 0; l < nlevels; l++)
+        printf(" %10.3g", max_error(levels[l], levels[0], kernel, a, im,
+                                    MAXBINS));
+      printf("\n");
+    }
+
+    free(re); free(im); free(ph); free(o1); free(o2);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * pvsanal_test.c
+ *
+ * Renders a run of pvsanal opcodes, which is analysed as one batch, and
+ * the same opcodes with a pvsout after each, which keeps them apart, and
+ * checks that every channel gets the same frames.  The first of the run
+ * is jumped over by kgoto for a while, and one in the middle is
+ * initialised again on its own by reinit.  The frames are read from the
+ * pvs bus after each k-cycle.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+#include "csound.h"
+
+#define NCHANS      6
+#define FFTSIZE     1024
+
+typedef struct {
+    float   *data;              /* framecount, then the bins, per frame */
+    int     nframes;
+} FRAMES;
+
+/* the orchestra, with the pvsanal opcodes in one run (batched) or each
+   followed by its pvsout; ithreads is given to the first */
+static char *make_orc(int batched, int ithreads)
+{
+    char    *orc = (char *) malloc(8192);
+    int     n, i;
+
+    n = sprintf(orc,
+                "sr = 44100\n"
+                "ksmps = 64\n"
+                "nchnls = 1\n"
+                "0dbfs = 1\n"
+                "instr 1\n");
+    for (i = 1; i <= NCHANS; i++)
+      n += sprintf(orc + n, "a%d = rand(0.3, 0.%d) + oscili(0.3, %d)\n",
+                   i, i, 110 * i);
+    n += sprintf(orc + n,
+                 "kt timeinsts\n"
+                 "kr metro 3\n"
+                 "if kr == 1 then\n"
+                 "reinit again\n"
+                 "endif\n"
+                 "if kt >= 0.5 && kt < 0.8 kgoto skip\n");
+    for (i = 1; i <= NCHANS; i++) {
+      if (i == 2) n += sprintf(orc + n, "skip:\n");
+      if (i == 3) n += sprintf(orc + n, "again:\n");
+      n += sprintf(orc + n, "f%d pvsanal a%d, %d, 256, %d, 1",
+                   i, i, FFTSIZE, FFTSIZE);
+      n += (i == 1 ? sprintf(orc + n, ", 0, 0, %d\n", ithreads)
+                   : sprintf(orc + n, "\n"));
+      if (!batched)
+        n += sprintf(orc + n, "pvsout f%d, %d\n", i, i);
+      if (i == 3) n += sprintf(orc + n, "rireturn\n");
+    }
+    for (i = 1; i <= NCHANS && batched; i++)
+      n += sprintf(orc + n, "pvsout f%d, %d\n", i, i);
+    sprintf(orc + n, "endin\n");
+    return orc;
+}
+
+/* the new frames of each channel, checked after every k-cycle */
+static void render(int batched, int ithreads, FRAMES *frames)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    char    *orc = make_orc(batched, ithreads);
+    PVSDATEXT pvs;
+    float   buf[FFTSIZE + 2];
+    uint32  last[NCHANS];
+    char    name[16];
+    size_t  size = (FFTSIZE + 1) * sizeof(float);
+    int     res, i;
+
+    memset(frames, 0, NCHANS * sizeof(FRAMES));
+    memset(last, 0, sizeof(last));
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    res = csoundCompileOrc(csound, orc);
+    CU_ASSERT_EQUAL(res, 0);
+    if (res == 0) {
+      csoundStart(csound);
+      csoundReadScore(csound, "i 1 0 2\n");
+      while (csoundPerformKsmps(csound) == 0) {
+        for (i = 0; i < NCHANS; i++) {
+          FRAMES *f = &frames[i];
+          memset(&pvs, 0, sizeof(PVSDATEXT));
+          pvs.frame = buf;
+          snprintf(name, 16, "%d", i + 1);
+          if (csoundGetPvsChannel(csound, &pvs, name) != CSOUND_SUCCESS ||
+              pvs.framecount == last[i])
+            continue;
+          last[i] = pvs.framecount;
+          f->data = (float *) realloc(f->data, (f->nframes + 1) * size);
+          f->data[(size_t) f->nframes * (FFTSIZE + 1)] =
+            (float) pvs.framecount;
+          memcpy(f->data + (size_t) f->nframes * (FFTSIZE + 1) + 1, buf,
+                 FFTSIZE * sizeof(float));
+          f->nframes++;
+        }
+      }
+    }
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+    free(orc);
+}
+
+static void free_frames(FRAMES *frames)
+{
+    int     i;
+
+    for (i = 0; i < NCHANS; i++)
+      free(frames[i].data);
+}
+
+static void compare_frames(const FRAMES *out, const FRAMES *ref)
+{
+    size_t  size = (FFTSIZE + 1) * sizeof(float);
+    int     i, k;
+
+    for (i = 0; i < NCHANS; i++) {
+      CU_ASSERT(ref[i].nframes > 0);
+      CU_ASSERT_EQUAL(out[i].nframes, ref[i].nframes);
+      if (out[i].nframes != ref[i].nframes)
+        continue;
+      for (k = 0; k < ref[i].nframes; k++)
+        if (memcmp(out[i].data + (size_t) k * (FFTSIZE + 1),
+                   ref[i].data + (size_t) k * (FFTSIZE + 1), size) != 0)
+          break;
+      CU_ASSERT_EQUAL(k, ref[i].nframes);
+    }
+}
+
+void test_batch(void)
+{
+    FRAMES  ref[NCHANS], out[NCHANS];
+
+    render(0, 0, ref);
+    /* the first was jumped over, so it made fewer frames */
+    CU_ASSERT(ref[0].nframes < ref[1].nframes);
+    render(1, 0, out);
+    compare_frames(out, ref);
+    free_frames(out);
+    render(1, 4, out);
+    compare_frames(out, ref);
+    free_frames(out);
+    free_frames(ref);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("pvsanal tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Batched pvsanal frames", test_batch))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,322 @@
+/*
+ * score_sort_test.c
+ *
+ * Renders scores with different score sorting options and checks that
+ * the instruments see the same events.  Each instrument prints its
+ * p-fields on a line starting with "EV", and the lines of two renders
+ * are compared.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+#include "csound.h"
+
+#define ORC_FILE    "score_sort_test.orc"
+#define SCO_FILE    "score_sort_test.sco"
+#define SRT_FILE    "score_sort_test.bin"
+
+static const char *orc =
+    "sr = 44100\n"
+    "ksmps = 100\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    /* numbers: all the p-fields there are */
+    "instr 1\n"
+    "ip pcount\n"
+    "Sl sprintf \"EV1 %.9g %.9g %.9g %d\", p1, p2, p3, ip\n"
+    "ix = 4\n"
+    "while ix <= ip do\n"
+    "Sl strcat Sl, sprintf(\" %.9g\", pindex(ix))\n"
+    "ix += 1\n"
+    "od\n"
+    "printf_i \"%s\\n\", 1, Sl\n"
+    "endin\n"
+    /* a string p-field */
+    "instr 2\n"
+    "Sv strget p4\n"
+    "printf_i \"EV2 %.9g %.9g %.9g <%s> %.9g\\n\", 1, p1, p2, p3, Sv, p5\n"
+    "endin\n"
+    /* more p-fields than PMAX: the count and the last ones kept */
+    "instr 3\n"
+    "ip pcount\n"
+    "printf_i \"EV3 %.9g %.9g %.9g %d %.9g %.9g\\n\", 1, "
+    "p1, p2, p3, ip, p4, p1998\n"
+    "endin\n";
+
+static void write_file(const char *name, const char *text)
+{
+    FILE *f = fopen(name, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    fputs(text, f);
+    fclose(f);
+}
+
+/* a score with string p-fields, carried and ramped values, tempo
+   warped sections and an event with more p-fields than PMAX */
+static void write_score(const char *name)
+{
+    FILE *f = fopen(name, "w");
+    int i;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    fputs("t 0 120 2 90\n"
+          "i 2 0.5 1 \"alpha\" 7\n"
+          "i 1 0 1 10 20.5 -3\n"
+          "i 2 1.5 . \"beta gamma\" 8\n"
+          "i 1 1 1 0.125 1e3\n"
+          "i 1 + . 4\n"
+          "i 1 ^+0.25 0.5 5 < 7\n"
+          "i 1 3 . 6 < 8\n"
+          "i 1 4 . 8 . 9\n"
+          "i 2 2.25 0.25 \"alpha\" 9\n", f);
+    fputs("i 3 2 1", f);
+    for (i = 4; i <= 2005; i++)
+      fprintf(f, " %d", i);
+    fputs("\ns\n"
+          "i 1 0 2 1 2 3\n"
+          "i 2 0.75 1 \"x y\" 1\n"
+          "i 1 0.5 1 0.5\n"
+          "s\n"
+          "t 0 60 1 240\n"
+          "i 1 0.5 0.5 2\n"
+          "i 1 0 0.5 1\n"
+          "i 2 1 0.25 \"delta\" 2\n"
+          "e\n", f);
+    fclose(f);
+}
+
+/* the EV lines printed while performing, in order; *found is set if
+   another message contains look_for */
+static char *render(const char *opt1, const char *opt2, const char *sco,
+                    const char *look_for, int *found)
+{
+    const char *argv[8];
+    int     argc = 0, res;
+    size_t  len = 0, n;
+    char    *out = NULL;
+    CSOUND  *csound = csoundCreate(0);
+
+    csoundCreateMessageBuffer(csound, 0);
+    argv[argc++] = "csound";
+    argv[argc++] = "-n";
+    argv[argc++] = "-d";
+    if (opt1 != NULL) argv[argc++] = opt1;
+    if (opt2 != NULL) argv[argc++] = opt2;
+    argv[argc++] = ORC_FILE;
+    if (sco != NULL) argv[argc++] = sco;
+    res = csoundCompile(csound, argc, argv);
+    CU_ASSERT_EQUAL(res, 0);
+    if (res == 0)
+      csoundPerform(csound);
+    csoundCleanup(csound);
+    out = (char *) calloc(1, 1);
+    while (csoundGetMessageCnt(csound) > 0) {
+      const char *msg = csoundGetFirstMessage(csound);
+      if (strncmp(msg, "EV", 2) == 0) {
+        n = strlen(msg);
+        out = (char *) realloc(out, len + n + 1);
+        memcpy(out + len, msg, n + 1);
+        len += n;
+      }
+      else if (look_for != NULL && strstr(msg, look_for) != NULL)
+        *found = 1;
+      csoundPopFirstMessage(csound);
+    }
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    return out;
+}
+
+static int count_lines(const char *s)
+{
+    int n = 0;
+    for (; *s != '\0'; s++)
+      if (*s == '\n') n++;
+    return n;
+}
+
+void test_binary_score(void)
+{
+    char *text, *bin;
+
+    write_file(ORC_FILE, orc);
+    write_score(SCO_FILE);
+    text = render("--no-binary-score", NULL, SCO_FILE, NULL, NULL);
+    bin = render(NULL, NULL, SCO_FILE, NULL, NULL);
+    /* every note of the score was played */
+    CU_ASSERT_EQUAL(count_lines(text), 16);
+    CU_ASSERT_STRING_EQUAL(text, bin);
+    CU_ASSERT_PTR_NOT_NULL(strstr(bin, "<beta gamma>"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(bin, " 2005 4 1998\n"));
+    free(text);
+    free(bin);
+}
+
+void test_saved_score(void)
+{
+    char *text, *saved, *loaded;
+
+    write_file(ORC_FILE, orc);
+    write_score(SCO_FILE);
+    text = render("--no-binary-score", NULL, SCO_FILE, NULL, NULL);
+    remove(SRT_FILE);
+    saved = render("--save-sorted-score=" SRT_FILE, NULL, SCO_FILE,
+                   NULL, NULL);
+    /* no score file: the events can only come from the saved one */
+    remove(SCO_FILE);
+    loaded = render("--sorted-score=" SRT_FILE, NULL, NULL, NULL, NULL);
+    CU_ASSERT_STRING_EQUAL(text, saved);
+    CU_ASSERT_STRING_EQUAL(text, loaded);
+    free(text);
+    free(saved);
+    free(loaded);
+    remove(SRT_FILE);
+}
+
+/* a warped section of n notes in random order, with ties, carried
+   p-fields and strings, then a small one */
+static void write_big_score(const char *name, int n)
+{
+    FILE *f = fopen(name, "w");
+    int i, r;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    srand(7);
+    fputs("t 0 90\n", f);
+    for (i = 0; i < n; i++) {
+      r = rand();
+      if (i % 50 == 0)
+        fprintf(f, "i 2 %.3f 0.001 \"s%d\" %d\n", (r % 2000) * 0.001,
+                r % 10, i);
+      else if (i % 3 == 0)
+        fprintf(f, "i 1 %.3f . %d\n", (r % 2000) * 0.001, i);
+      else
+        fprintf(f, "i 1 %.3f 0.001 %d %d\n", (r % 2000) * 0.001, i,
+                r % 100);
+    }
+    fputs("s\n"
+          "i 1 0.5 0.01 2\n"
+          "i 1 0 0.01 1\n"
+          "e\n", f);
+    fclose(f);
+}
+
+#define BIG_SCORE   40000
+
+void test_spilled_sort(void)
+{
+    char *mem, *runs;
+    int spilled = 0, never = 0;
+
+    write_file(ORC_FILE, orc);
+    write_big_score(SCO_FILE, BIG_SCORE);
+    /* 0: always sorted in memory; 1 MB is a fraction of the section */
+    mem = render("--score-sort-memory=0", NULL, SCO_FILE,
+                 "sorted in", &never);
+    runs = render("--score-sort-memory=1", NULL, SCO_FILE,
+                  "sorted in", &spilled);
+    CU_ASSERT_EQUAL(never, 0);
+    CU_ASSERT_EQUAL(spilled, 1);
+    CU_ASSERT_EQUAL(count_lines(mem), BIG_SCORE + 2);
+    CU_ASSERT_STRING_EQUAL(mem, runs);
+    free(mem);
+    free(runs);
+}
+
+/* many short sections, some empty, some with random '~' ramps, whose
+   values depend on the order the sections are written in; returns the
+   number of notes */
+static int write_sections(const char *name, int nsect)
+{
+    FILE *f = fopen(name, "w");
+    int i, j, notes = 0;
+
+    CU_ASSERT_PTR_NOT_NULL(f);
+    if (f == NULL)
+      return 0;
+    fputs("y 42\n", f);
+    for (i = 0; i < nsect; i++) {
+      if (i % 7 == 3) {                 /* empty section */
+        fputs("s\n", f);
+        continue;
+      }
+      if (i % 2 == 0)
+        fprintf(f, "t 0 %d 1 %d\n", 60 + i, 120 - i);
+      for (j = 5; j >= 0; j--)
+        fprintf(f, "i 1 %.2f 0.01 %d %d\n", j * 0.05, i, j);
+      notes += 6;
+      if (i % 5 == 1) {                 /* random ramp */
+        fputs("i 1 0.3 0.01 0 0\n"
+              "i 1 0.35 0.01 0 ~\n"
+              "i 1 0.4 0.01 0 ~\n"
+              "i 1 0.45 0.01 0 100\n", f);
+        notes += 4;
+      }
+      fprintf(f, "i 2 0.1 0.01 \"sect%d\" %d\n", i, i);
+      notes++;
+      fputs("s\n", f);
+    }
+    fputs("e\n", f);
+    fclose(f);
+    return notes;
+}
+
+#define SECTIONS    60
+
+void test_threaded_sort(void)
+{
+    char *plain, *par, *partext;
+    int notes;
+
+    write_file(ORC_FILE, orc);
+    notes = write_sections(SCO_FILE, SECTIONS);
+    plain = render(NULL, NULL, SCO_FILE, NULL, NULL);
+    par = render("--score-sort-threads=4", NULL, SCO_FILE, NULL, NULL);
+    partext = render("--score-sort-threads=4", "--no-binary-score",
+                     SCO_FILE, NULL, NULL);
+    CU_ASSERT_EQUAL(count_lines(plain), notes);
+    CU_ASSERT_STRING_EQUAL(plain, par);
+    CU_ASSERT_STRING_EQUAL(plain, partext);
+    free(plain);
+    free(par);
+    free(partext);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Score sort tests", NULL, NULL);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Binary and text sorted scores",
+                             test_binary_score))
+        || (NULL == CU_add_test(pSuite, "Saved sorted score",
+                                test_saved_score))
+        || (NULL == CU_add_test(pSuite, "Score sorted in runs",
+                                test_spilled_sort))
+        || (NULL == CU_add_test(pSuite, "Sections sorted on threads",
+                                test_threaded_sort))
+        )
+    {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,135 @@
+/*
+ * server_benchmark.c
+ *
+ * Times the UDP server started by --port: how long a control channel
+ * message takes to be seen by the host, and how many such messages per
+ * second get through in bursts.  Not run by ctest;
+ * usage: serverBenchmark [messages] [port]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csound.h"
+#if defined(WIN32) && !defined(__CYGWIN__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#define BURST 64
+
+static int sock;
+static struct sockaddr_in server_addr;
+
+static int udp_open(int port)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+    WSADATA wsaData = {0};
+    if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0)
+      return -1;
+#endif
+    if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+      return -1;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    server_addr.sin_port = htons((int) port);
+    return 0;
+}
+
+static void udp_send(const char *msg)
+{
+    sendto(sock, (void *) msg, strlen(msg) + 1, 0,
+           (const struct sockaddr *) &server_addr, sizeof(server_addr));
+}
+
+/* wait until the channel holds val; 0 if it does not within a second */
+static int wait_value(CSOUND *csound, RTCLOCK *clk, double val)
+{
+    double  t0 = csoundGetRealTime(clk);
+    while (csoundGetControlChannel(csound, "bench", NULL) != val)
+      if (csoundGetRealTime(clk) - t0 > 1.0)
+        return 0;
+    return 1;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    int     n = (argc > 1 ? atoi(argv[1]) : 1000);
+    int     port = (argc > 2 ? atoi(argv[2]) : 44200);
+    char    opt[32], msg[64];
+    double  *lat, t, val = 0.0;
+    int     i, j, sent = 0, lost = 0;
+    RTCLOCK clk;
+    CSOUND  *csound;
+
+    if (n < BURST) n = BURST;
+    csoundInitialize(CSOUNDINIT_NO_SIGNAL_HANDLER);
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    snprintf(opt, sizeof(opt), "--port=%d", port);
+    csoundSetOption(csound, opt);
+    csoundCompileOrc(csound, "sr = 44100\nksmps = 64\nnchnls = 1\n"
+                             "chn_k \"bench\", 1\n");
+    if (csoundStart(csound) != 0 || udp_open(port) != 0) {
+      fprintf(stderr, "cannot start the server\n");
+      return 1;
+    }
+    csoundInitTimerStruct(&clk);
+    udp_send("@bench -1");              /* resolve the channel */
+    wait_value(csound, &clk, -1.0);
+
+    /* latency: one message at a time */
+    lat = (double *) malloc(n * sizeof(double));
+    for (i = 0; i < n; i++) {
+      val += 1.0;
+      snprintf(msg, sizeof(msg), "@bench %d", (int) val);
+      t = csoundGetRealTime(&clk);
+      udp_send(msg);
+      if (!wait_value(csound, &clk, val)) {
+        lost++;
+        lat[i] = 1.0;
+        continue;
+      }
+      lat[i] = csoundGetRealTime(&clk) - t;
+    }
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("latency: median %.1f us, 99%% %.1f us, max %.1f us, %d lost\n",
+           lat[n / 2] * 1.0e6, lat[(n * 99) / 100] * 1.0e6,
+           lat[n - 1] * 1.0e6, lost);
+
+    /* throughput: bursts of messages, waiting for the last of each */
+    lost = 0;
+    t = csoundGetRealTime(&clk);
+    for (i = 0; i < n; i += BURST) {
+      for (j = 0; j < BURST; j++) {
+        val += 1.0;
+        snprintf(msg, sizeof(msg), "@bench %d", (int) val);
+        udp_send(msg);
+        sent++;
+      }
+      if (!wait_value(csound, &clk, val))
+        lost++;
+    }
+    t = csoundGetRealTime(&clk) - t;
+    printf("throughput: %.0f messages/s in bursts of %d, %d bursts lost\n",
+           sent / t, BURST, lost);
+
+    free(lat);
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * tabosc_benchmark.c
+ *
+ * Times the table oscillator kernels used by oscbnk and adsynt with each
+ * kernel set the CPU supports, rendering a bank of oscillators one k-cycle
+ * at a time, and checks that every set gives the same samples and phases
+ * as the scalar one.  Not run by ctest; usage: taboscBenchmark [seconds-per-case]
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "tabosc_simd.h"
+
+#define FLEN      4096
+#define NOSC      500
+#define MAXSMPS   256
+#define OSC_PHSMSK 0x7FFFFFFFUL   /* oscbnk's 31 bit phases */
+
+static const uint32_t ksmps_list[] = { 10, 32, 64, 256 };
+
+#define NKSMPS    (sizeof(ksmps_list) / sizeof(ksmps_list[0]))
+
+enum { K_LIN = 0, K_LIN_AM, K_TRUNC, NKERNELS };
+
+static const char *kernel_names[NKERNELS] = {
+    "lin", "lin+am", "trunc"
+};
+
+static MYFLT  table[FLEN + 1], amp[MAXSMPS];
+static uint32 inc[NOSC];
+static TABOSC osc_tab, adsynt_tab;
+
+/* one k-cycle of the whole bank, as oscbnk (lin) or adsynt (trunc) */
+static void run(const TABOSC_KERNELS *k, int kernel, MYFLT *out,
+                uint32 *phs, uint32_t n)
+{
+    int i;
+
+    memset(out, 0, n * sizeof(MYFLT));
+    for (i = 0; i < NOSC; i++) {
+      switch (kernel) {
+      case K_LIN:
+        phs[i] = k->lin(out, NULL, &osc_tab, phs[i], inc[i], n);
+        break;
+      case K_LIN_AM:
+        phs[i] = k->lin(out, amp, &osc_tab, phs[i], inc[i], n);
+        break;
+      default:
+        phs[i] = k->trunc(out, FL(1.0) / NOSC, &adsynt_tab, phs[i],
+                          inc[i] >> 7, n);
+        break;
+      }
+    }
+}
+
+static void start_phases(uint32 *phs, uint32 phsmsk)
+{
+    int i;
+
+    srand(1);
+    for (i = 0; i < NOSC; i++)
+      phs[i] = (uint32) rand() & phsmsk;
+}
+
+/* ns per oscillator and sample, run for about 'secs' */
+static double time_kernel(const TABOSC_KERNELS *k, int kernel, MYFLT *out,
+                          uint32_t n, double secs)
+{
+    uint32  phs[NOSC];
+    RTCLOCK clk;
+    double  t = 0.0;
+    long    reps = 0, batch = 1 + 4096 / n, i;
+
+    start_phases(phs, kernel == K_TRUNC ? PHMASK : OSC_PHSMSK);
+    run(k, kernel, out, phs, n);        /* warm up */
+    csoundInitTimerStruct(&clk);
+    do {
+      for (i = 0; i < batch; i++)
+        run(k, kernel, out, phs, n);
+      reps += batch;
+      t = csoundGetRealTime(&clk);
+    } while (t < secs);
+    return t * 1.0e9 / ((double) reps * n * NOSC);
+}
+
+/* whether k renders 100 k-cycles exactly as ref does */
+static int same_output(const TABOSC_KERNELS *k, const TABOSC_KERNELS *ref,
+                       int kernel, uint32_t n)
+{
+    MYFLT   o1[MAXSMPS], o2[MAXSMPS];
+    uint32  p1[NOSC], p2[NOSC];
+    int     i;
+
+    start_phases(p1, kernel == K_TRUNC ? PHMASK : OSC_PHSMSK);
+    start_phases(p2, kernel == K_TRUNC ? PHMASK : OSC_PHSMSK);
+    for (i = 0; i < 100; i++) {
+      run(k, kernel, o1, p1, n);
+      run(ref, kernel, o2, p2, n);
+      if (memcmp(o1, o2, n * sizeof(MYFLT)) != 0 ||
+          memcmp(p1, p2, sizeof(p1)) != 0)
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    double  secs = argc > 1 ? atof(argv[1]) : 0.1;
+    const TABOSC_KERNELS *levels[AOPS_SIMD_LEVELS];
+    MYFLT   out[MAXSMPS];
+    int     nlevels = 0, l, kernel, i;
+    uint32_t j;
+
+    csoundInitialize(CSOUNDINIT_NO_ATEXIT | CSOUNDINIT_NO_SIGNAL_HANDLER);
+    for (l = 0; l < AOPS_SIMD_LEVELS; l++)
+      if ((levels[nlevels] = tabosc_simd_kernels(l)) != NULL)
+        nlevels++;
+
+    /* a sine, read as oscbnk does (31 bit phases) and as adsynt does */
+    for (i = 0; i <= FLEN; i++)
+      table[i] = SIN(TWOPI * i / FLEN);
+    osc_tab.ft = adsynt_tab.ft = table;
+    osc_tab.lobits = 31 - 12;
+    osc_tab.mask = (1UL << osc_tab.lobits) - 1UL;
+    osc_tab.pfrac = FL(1.0) / (MYFLT) (1UL << osc_tab.lobits);
+    osc_tab.phsmsk = OSC_PHSMSK;
+    adsynt_tab.lobits = 30 - 12;
+    adsynt_tab.phsmsk = PHMASK;
+    /* partials of 55 Hz at 44.1 kHz, and a ramp as from oscbnk's AM */
+    for (i = 0; i < NOSC; i++)
+      inc[i] = (uint32) ((i + 1) * 55.0 / 44100.0 * 2147483648.0)
+               & OSC_PHSMSK;
+    for (j = 0; j < MAXSMPS; j++)
+      amp[j] = FL(0.5) + (MYFLT) j / (2 * MAXSMPS);
+
+    printf("MYFLT is %d bytes, %d oscillators, default kernels: %s\n",
+           (int) sizeof(MYFLT), NOSC, tabosc_kernels->name);
+    printf("%-8s %6s", "kernel", "ksmps");
+    for (l = 0; l < nlevels; l++)
+      printf(" %10s", levels[l]->name);
+    printf("   (ns/oscillator/sample)\n");
+    for (kernel = 0; kernel < NKERNELS; kernel++) {
+      for (j = 0; j < NKSMPS; j++) {
+        printf("%-8s %6u", kernel_names[kernel], ksmps_list[j]);
+        for (l = 0; l < nlevels; l++)
+          printf(" %10.3f", time_kernel(levels[l], kernel, out,
+                                        ksmps_list[j], secs));
+        printf("\n");
+      }
+      printf("%-8s %6s", kernel_names[kernel], "exact");
+      for (l = 0; l < nlevels; l++)
+        printf(" %10s", same_output(levels[l], levels[0], kernel, 61) ?
+               "yes" : "NO");
+      printf("\n");
+    }
+    return 0;
+}